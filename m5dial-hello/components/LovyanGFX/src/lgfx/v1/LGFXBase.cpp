@@ -1142,6 +1142,38 @@ namespace lgfx
     endWrite();
   }
 
+  /// 角度の境界 x <= (y + width) * slope を、y に対する一次式 x <= (y * slope16 + offset16) >> 16 に変換する;
+  static void arc_edge_fixed(float slope, float width, int32_t* slope16, int32_t* offset16)
+  {
+    // 描画範囲を十分に超える値で頭打ちにする。(無限大を含む);
+    static constexpr float limit = 16384.0f;
+    if (!(slope <  limit)) { slope =  limit; }
+    if (!(slope > -limit)) { slope = -limit; }
+    float offset = width * slope;
+    if (offset >  limit) { offset =  limit; }
+    if (offset < -limit) { offset = -limit; }
+    *slope16  = (int32_t)floorf(slope  * 65536.0f);
+    *offset16 = (int32_t)floorf(offset * 65536.0f);
+  }
+
+  /// 区間 [xs, xe] のうち、角度の条件を満たす部分を水平線として描画する;
+  /// exclude が false の場合は [lo, hi] の範囲のみを、true の場合は [lo, hi] 以外の範囲を描画する;
+  static void write_arc_span(LGFXBase* gfx, int32_t cx, int32_t y, int32_t xs, int32_t xe, int32_t lo, int32_t hi, bool exclude)
+  {
+    if (exclude && lo <= hi && lo <= xe && xs <= hi)
+    {
+      if (xs < lo) { gfx->writeFastHLine(cx + xs, y, lo - xs); }
+      if (hi < xe) { gfx->writeFastHLine(cx + hi + 1, y, xe - hi); }
+      return;
+    }
+    if (!exclude)
+    {
+      if (xs < lo) { xs = lo; }
+      if (xe > hi) { xe = hi; }
+    }
+    if (xs <= xe) { gfx->writeFastHLine(cx + xs, y, xe - xs + 1); }
+  }
+
   void LGFXBase::fill_arc_helper(int32_t cx, int32_t cy, int32_t oradius_x, int32_t iradius_x, int32_t oradius_y, int32_t iradius_y, float start, float end)
   {
     float s_cos = (cosf(start * deg_to_rad));
@@ -1152,6 +1184,11 @@ namespace lgfx
     float swidth =  0.5f / s_cos;
     float ewidth = -0.5f / e_cos;
 
+    // 角度の境界は行ごとに固定小数の一次式で求め、画素ごとの浮動小数演算を行わない;
+    int32_t sslope16, soffset16, eslope16, eoffset16;
+    arc_edge_fixed(sslope, swidth, &sslope16, &soffset16);
+    arc_edge_fixed(eslope, ewidth, &eslope16, &eoffset16);
+
     bool start180 = !(start < 180);
     bool end180 = end < 180;
     bool reversed = start + 180 < end || (end < start && start < end + 180);
@@ -1177,12 +1214,14 @@ namespace lgfx
 
     int32_t iradius_y2 = iradius_y * (iradius_y - 1);
     int32_t iradius_x2 = iradius_x * (iradius_x - 1);
-    float irad_rate = iradius_x2 && iradius_y2 ? (float)iradius_x2 / (float)iradius_y2 : 0;
 
     int32_t oradius_y2 = oradius_y * (oradius_y + 1);
     int32_t oradius_x2 = oradius_x * (oradius_x + 1);
-    float orad_rate = oradius_x2 && oradius_y2 ? (float)oradius_x2 / (float)oradius_y2 : 0;
 
+    // 外周は x*x < compare_o を満たす最大の xo、内周は x*x >= compare_i を満たす最小の xi;
+    // 行の変化に対し xo, xi は少しずつしか変化しないため、前の行の値から増減させて求める;
+    int32_t xo = -1;
+    int32_t xi = 0;
     do
     {
       int32_t y2 = y * y;
@@ -1190,40 +1229,38 @@ namespace lgfx
       int32_t compare_i = iradius_y2 - y2;
       if (!trueCircle)
       {
-        compare_i = floorf(compare_i * irad_rate);
-        compare_o = ceilf (compare_o * orad_rate);
+        compare_i = (compare_i > 0 && iradius_x2 && iradius_y2) ? (int32_t)(((int64_t)compare_i * iradius_x2) / iradius_y2) : 0;
+        compare_o = (compare_o > 0 && oradius_x2 && oradius_y2) ? (int32_t)(((int64_t)compare_o * oradius_x2 + oradius_y2 - 1) / oradius_y2) : 0;
       }
-      int32_t xe = ceilf(sqrtf(compare_o));
-      int32_t x = 1 - xe;
-
-      if ( x < xleft )  x = xleft;
-      if (xe > xright) xe = xright;
-      float ysslope = (y + swidth) * sslope;
-      float yeslope = (y + ewidth) * eslope;
-      int len = 0;
-      do
+      while (xo >= 0 && xo * xo >= compare_o) { --xo; }
+      while ((xo + 1) * (xo + 1) < compare_o) { ++xo; }
+      if (xo < 0) { continue; }
+      while (xi > 0 && (xi - 1) * (xi - 1) >= compare_i) { --xi; }
+      while (xi * xi < compare_i) { ++xi; }
+      if (xi > xo) { continue; }
+
+      // 始点側・終点側それぞれ x <= ts, x <= te を境に判定が反転する;
+      int32_t ts = ((int64_t)y * sslope16 + soffset16) >> 16;
+      int32_t te = ((int64_t)y * eslope16 + eoffset16) >> 16;
+
+      // 通常は両方の条件を満たす範囲を描画し、反転時はどちらも満たさない範囲を除外する;
+      bool s_low = (start180 == reversed);
+      bool e_low = (  end180 == reversed);
+      int32_t lo = std::max(s_low ? INT32_MIN : ts + 1, e_low ? INT32_MIN : te + 1);
+      int32_t hi = std::min(s_low ? ts : INT32_MAX, e_low ? te : INT32_MAX);
+
+      int32_t xl = std::max(xleft, -xo);
+      int32_t xr = std::min(xright - 1, xo);
+      int32_t py = cy + y;
+      if (xi == 0)
       {
-        bool flg1 = start180 != (x <= ysslope);
-        bool flg2 =   end180 != (x <= yeslope);
-        int32_t x2 = x * x;
-        if (x2 >= compare_i
-         && ((flg1 && flg2) || (reversed && (flg1 || flg2)))
-         && x != xe
-         && x2 < compare_o)
-        {
-          ++len;
-        }
-        else
-        {
-          if (len)
-          {
-            writeFastHLine(cx + x - len, cy + y, len);
-            len = 0;
-          }
-          if (x2 >= compare_o) break;
-          if (x < 0 && x2 < compare_i) { x = -x; }
-        }
-      } while (++x <= xe);
+        write_arc_span(this, cx, py, xl, xr, lo, hi, reversed);
+      }
+      else
+      {
+        write_arc_span(this, cx, py, xl, std::min(xr, -xi), lo, hi, reversed);
+        write_arc_span(this, cx, py, std::max(xl, xi), xr, lo, hi, reversed);
+      }
     } while (++y <= ye);
   }
 
@@ -2166,7 +2203,7 @@ namespace lgfx
           } while (uniCode < 0x20 && *++string);
           if (uniCode < 0x20) break;
         }
-        sumX += font->drawChar(this, x + sumX, y, uniCode, &_text_style, &metrics, dummy_filled_x);
+        sumX += draw_char(font, x + sumX, y, uniCode, &metrics, dummy_filled_x);
       } while (*(++string));
     }
     this->endWrite();
@@ -2174,6 +2211,16 @@ namespace lgfx
     return sumX;
   }
 
+  size_t LGFXBase::draw_char(const IFont* font, int32_t x, int32_t y, uint16_t uniCode, FontMetrics* metrics, int32_t& filled_x)
+  {
+    size_t x_advance;
+    if (_glyph_cache && _glyph_cache->drawChar(this, font, x, y, uniCode, &_text_style, metrics, &x_advance))
+    {
+      return x_advance;
+    }
+    return font->drawChar(this, x, y, uniCode, &_text_style, metrics, filled_x);
+  }
+
   size_t LGFXBase::write(uint8_t utf8)
   {
     if (utf8 == '\r') return 1;
@@ -2238,7 +2285,7 @@ namespace lgfx
 
       if (y <= _clip_b + h)
       {
-        _cursor_x += _font->drawChar(this, _cursor_x, y, uniCode, &_text_style, &_font_metrics, _filled_x);
+        _cursor_x += draw_char(_font, _cursor_x, y, uniCode, &_font_metrics, _filled_x);
       }
       else
       {
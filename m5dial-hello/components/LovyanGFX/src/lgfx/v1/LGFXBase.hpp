@@ -29,6 +29,7 @@ Contributors:
 #include "misc/colortype.hpp"
 #include "misc/pixelcopy.hpp"
 #include "misc/DataWrapper.hpp"
+#include "misc/GlyphCache.hpp"
 #include "lgfx_fonts.hpp"
 #include "Touch.hpp"
 #include "panel/Panel_Device.hpp"
@@ -641,6 +642,10 @@ namespace lgfx
 
     void setFont(const IFont* font);
 
+    /// 文字の描画に使用するキャッシュを設定する。nullptrで使用しない;
+    LGFX_INLINE void setGlyphCache(GlyphCache* cache) { _glyph_cache = cache; }
+    LGFX_INLINE GlyphCache* getGlyphCache(void) const { return _glyph_cache; }
+
     /// load VLW font
     bool loadFont(const uint8_t* array);
 
@@ -814,6 +819,7 @@ namespace lgfx
     TextStyle _text_style;
     FontMetrics _font_metrics = { 6, 6, 0, 8, 8, 0, 7 }; // Font0 default metric
     const IFont* _font = &fonts::Font0;
+    GlyphCache* _glyph_cache = nullptr;
 
     std::shared_ptr<RunTimeFont> _runtime_font;  // run-time generated font
     std::shared_ptr<DataWrapper> _font_file;  // run-time font file
@@ -1120,6 +1126,7 @@ namespace lgfx
     size_t printNumber(unsigned long n, uint8_t base);
     size_t printFloat(double number, uint8_t digits);
     size_t draw_string(const char *string, int32_t x, int32_t y, textdatum_t datum, const IFont* font = nullptr);
+    size_t draw_char(const IFont* font, int32_t x, int32_t y, uint16_t uniCode, FontMetrics* metrics, int32_t& filled_x);
     int32_t text_width(const char *string, const IFont* font, FontMetrics* metrics);
     bool load_font(lgfx::DataWrapper* data);
 
@@ -0,0 +1,680 @@
+/*----------------------------------------------------------------------------/
+  Lovyan GFX - Graphics library for embedded devices.
+
+Original Source:
+ https://github.com/lovyan03/LovyanGFX/
+
+Licence:
+ [FreeBSD](https://github.com/lovyan03/LovyanGFX/blob/master/license.txt)
+
+Author:
+ [lovyan03](https://twitter.com/lovyan03)
+
+Contributors:
+ [ciniml](https://github.com/ciniml)
+ [mongonta0716](https://github.com/mongonta0716)
+ [tobozo](https://github.com/tobozo)
+/----------------------------------------------------------------------------*/
+#include "LGFX_DisplayList.hpp"
+
+#include "misc/common_function.hpp"
+
+#ifdef min
+#undef min
+#endif
+#ifdef max
+#undef max
+#endif
+
+namespace lgfx
+{
+ inline namespace v1
+ {
+//----------------------------------------------------------------------------
+
+  static constexpr size_t align4(size_t length) { return (length + 3) & ~3u; }
+
+  bool Panel_DisplayList::createList(int32_t w, int32_t h, size_t capacity)
+  {
+    deleteList();
+    if (w < 1 || h < 1) { return false; }
+    if (!_reserve(capacity)) { return false; }
+
+    _width = w;
+    _height = h;
+    setWindow(0, 0, w - 1, h - 1);
+    clearList();
+    return true;
+  }
+
+  void Panel_DisplayList::deleteList(void)
+  {
+    if (_list) { heap_free(_list); }
+    _list = nullptr;
+    _capacity = 0;
+    _width = _height = 0;
+    clearList();
+  }
+
+  bool Panel_DisplayList::_reserve(size_t length)
+  {
+    size_t need = _length + length;
+    if (need <= _capacity) { return true; }
+
+    size_t capacity = std::max(need, _capacity << 1);
+    auto list = (uint8_t*)heap_alloc(capacity);
+    if (list == nullptr) { return false; }
+    if (_list)
+    {
+      memcpy(list, _list, _length);
+      heap_free(_list);
+    }
+    _list = list;
+    _capacity = capacity;
+    return true;
+  }
+
+  Panel_DisplayList::command_t* Panel_DisplayList::_add_command(uint8_t type, size_t payload)
+  {
+    size_t size = align4(sizeof(command_t) + payload);
+    if (!_reserve(size))
+    {
+      _overflow = true;
+      return nullptr;
+    }
+    auto cmd = (command_t*)&_list[_length];
+    cmd->type = type;
+    cmd->reserved = 0;
+    cmd->count = 0;
+    cmd->size = size;
+    _last_cmd = _length;
+    _length += size;
+    return cmd;
+  }
+
+  Panel_DisplayList::command_t* Panel_DisplayList::_last_command(uint8_t type) const
+  {
+    if (_length == 0) { return nullptr; }
+    auto cmd = (command_t*)&_list[_last_cmd];
+    return (cmd->type == type) ? cmd : nullptr;
+  }
+
+  color_depth_t Panel_DisplayList::setColorDepth(color_depth_t depth)
+  {
+    // 記録する画素はByte単位で扱うため、1Byte未満の色深度とパレットは使用しない;
+    auto bits = depth & color_depth_t::bit_mask;
+    depth = (bits > 16) ? rgb888_3Byte
+          : (bits >  8) ? rgb565_2Byte
+                        : rgb332_1Byte;
+    _write_depth = depth;
+    _read_depth = depth;
+    clearList();
+    return depth;
+  }
+
+  void Panel_DisplayList::setWindow(uint_fast16_t xs, uint_fast16_t ys, uint_fast16_t xe, uint_fast16_t ye)
+  {
+    _xpos = xs;
+    _ypos = ys;
+    _xs = xs;
+    _ys = ys;
+    _xe = xe;
+    _ye = ye;
+  }
+
+  void Panel_DisplayList::drawPixelPreclipped(uint_fast16_t x, uint_fast16_t y, uint32_t rawcolor)
+  {
+    // 同じ色の点が続く場合は一つのコマンドにまとめる;
+    auto cmd = _last_command(cmd_pixels);
+    if (cmd && cmd->color == rawcolor && cmd->count < UINT16_MAX)
+    {
+      if (!_reserve(4))
+      {
+        _overflow = true;
+        return;
+      }
+      cmd = (command_t*)&_list[_last_cmd];
+      auto pos = (uint16_t*)&_list[_length];
+      pos[0] = x;
+      pos[1] = y;
+      _length += 4;
+      cmd->size += 4;
+      ++cmd->count;
+      if (x < cmd->x) { cmd->w += cmd->x - x; cmd->x = x; }
+      else if (x >= cmd->x + cmd->w) { cmd->w = x - cmd->x + 1; }
+      if (y < cmd->y) { cmd->h += cmd->y - y; cmd->y = y; }
+      else if (y >= cmd->y + cmd->h) { cmd->h = y - cmd->y + 1; }
+      return;
+    }
+
+    cmd = _add_command(cmd_pixels, 4);
+    if (cmd == nullptr) { return; }
+    cmd->count = 1;
+    cmd->x = x;
+    cmd->y = y;
+    cmd->w = 1;
+    cmd->h = 1;
+    cmd->color = rawcolor;
+    auto pos = (uint16_t*)&cmd[1];
+    pos[0] = x;
+    pos[1] = y;
+  }
+
+  void Panel_DisplayList::writeFillRectPreclipped(uint_fast16_t x, uint_fast16_t y, uint_fast16_t w, uint_fast16_t h, uint32_t rawcolor)
+  {
+    // 全面を塗り潰す場合、それ以前の記録は不要になる;
+    if (x == 0 && y == 0 && w >= _width && h >= _height)
+    {
+      clearList();
+    }
+    else
+    {
+      // 直前の塗り潰しと縦に連続する場合は統合する;
+      auto cmd = _last_command(cmd_fill);
+      if (cmd && cmd->color == rawcolor && cmd->x == x && cmd->w == w && cmd->y + cmd->h == y)
+      {
+        cmd->h += h;
+        return;
+      }
+    }
+
+    auto cmd = _add_command(cmd_fill, 0);
+    if (cmd == nullptr) { return; }
+    cmd->x = x;
+    cmd->y = y;
+    cmd->w = w;
+    cmd->h = h;
+    cmd->color = rawcolor;
+  }
+
+  void Panel_DisplayList::writeFillRectAlphaPreclipped(uint_fast16_t x, uint_fast16_t y, uint_fast16_t w, uint_fast16_t h, uint32_t argb8888)
+  {
+    auto cmd = _add_command(cmd_fill_alpha, 0);
+    if (cmd == nullptr) { return; }
+    cmd->x = x;
+    cmd->y = y;
+    cmd->w = w;
+    cmd->h = h;
+    cmd->color = argb8888;
+  }
+
+  void Panel_DisplayList::writeBlock(uint32_t rawcolor, uint32_t length)
+  {
+    do
+    {
+      uint32_t h = 1;
+      auto w = std::min<uint32_t>(length, _xe + 1 - _xpos);
+      if (length >= (w << 1) && _xpos == _xs)
+      {
+        h = std::min<uint32_t>(length / w, _ye + 1 - _ypos);
+      }
+      writeFillRectPreclipped(_xpos, _ypos, w, h, rawcolor);
+      if ((_xpos += w) <= _xe) return;
+      _xpos = _xs;
+      if (_ye < (_ypos += h)) { _ypos = _ys; }
+      length -= w * h;
+    } while (length);
+  }
+
+  void Panel_DisplayList::writePixels(pixelcopy_t* param, uint32_t length, bool use_dma)
+  {
+    (void)use_dma;
+    size_t bytes = _write_bits >> 3;
+    uint32_t w;
+    do
+    {
+      w = std::min<uint32_t>(length, _xe + 1 - _xpos);
+      size_t linebytes = w * bytes;
+
+      // ウィンドウの次の行へ続く場合は直前の画像に行を追加する;
+      uint8_t* dst = nullptr;
+      auto cmd = _last_command(cmd_image);
+      if (cmd && cmd->x == _xpos && cmd->w == w && cmd->y + cmd->h == _ypos)
+      {
+        size_t used = sizeof(command_t) + cmd->w * cmd->h * bytes;
+        size_t size = align4(used + linebytes);
+        if (!_reserve(size - cmd->size))
+        {
+          _overflow = true;
+          return;
+        }
+        cmd = (command_t*)&_list[_last_cmd];
+        _length += size - cmd->size;
+        cmd->size = size;
+        ++cmd->h;
+        dst = &_list[_last_cmd + used];
+      }
+      else
+      {
+        cmd = _add_command(cmd_image, linebytes);
+        if (cmd == nullptr) { return; }
+        cmd->x = _xpos;
+        cmd->y = _ypos;
+        cmd->w = w;
+        cmd->h = 1;
+        dst = (uint8_t*)&cmd[1];
+      }
+      param->fp_copy(dst, 0, w, param);
+
+      if ((_xpos += w) > _xe)
+      {
+        _xpos = _xs;
+        if (_ye < ++_ypos) { _ypos = _ys; }
+      }
+    } while (length -= w);
+  }
+
+  void Panel_DisplayList::writeImage(uint_fast16_t x, uint_fast16_t y, uint_fast16_t w, uint_fast16_t h, pixelcopy_t* param, bool use_dma)
+  {
+    (void)use_dma;
+    // 元の画像は転送時まで残っているとは限らないため、変換済みの画素を記録する;
+    size_t bytes = _write_bits >> 3;
+    auto sx32 = param->src_x32;
+    auto sy32 = param->src_y32;
+    static constexpr uint32_t nexty = 1 << pixelcopy_t::FP_SCALE;
+
+    if (param->transp == pixelcopy_t::NON_TRANSP)
+    {
+      auto cmd = _add_command(cmd_image, w * h * bytes);
+      if (cmd == nullptr) { return; }
+      cmd->x = x;
+      cmd->y = y;
+      cmd->w = w;
+      cmd->h = h;
+      auto dst = (uint8_t*)&cmd[1];
+      for (uint_fast16_t i = 0; i < h; ++i)
+      {
+        param->src_x32 = sx32;
+        param->src_y32 = sy32 + i * nexty;
+        param->fp_copy(dst, 0, w, param);
+        dst += w * bytes;
+      }
+      return;
+    }
+
+    // 透過色を含む場合は行ごとに不透明な区間だけを記録する;
+    for (uint_fast16_t i = 0; i < h; ++i)
+    {
+      param->src_x32 = sx32;
+      param->src_y32 = sy32 + i * nexty;
+      uint32_t xs = 0;
+      while (w != (xs = param->fp_skip(xs, w, param)))
+      {
+        auto cmd = _add_command(cmd_image, (w - xs) * bytes);
+        if (cmd == nullptr) { return; }
+        uint32_t len = param->fp_copy(&cmd[1], 0, w - xs, param);
+        cmd->x = x + xs;
+        cmd->y = y + i;
+        cmd->w = len;
+        cmd->h = 1;
+        cmd->size = align4(sizeof(command_t) + len * bytes);
+        _length = _last_cmd + cmd->size;
+        if (w == (xs += len)) { break; }
+      }
+    }
+  }
+
+  void Panel_DisplayList::writeImageARGB(uint_fast16_t x, uint_fast16_t y, uint_fast16_t w, uint_fast16_t h, pixelcopy_t* param)
+  {
+    // 合成は転送先の画素が必要なため、合成方法(pixelcopy_t)と元の画素を記録して再生時に合成する;
+    static constexpr size_t pc_size = align4(sizeof(pixelcopy_t));
+    auto cmd = _add_command(cmd_image_argb, pc_size + w * h * sizeof(argb8888_t));
+    if (cmd == nullptr) { return; }
+    cmd->x = x;
+    cmd->y = y;
+    cmd->w = w;
+    cmd->h = h;
+    auto payload = (uint8_t*)&cmd[1];
+    memcpy(payload, param, sizeof(pixelcopy_t));
+
+    auto src = (const argb8888_t*)param->src_data;
+    auto dst = (argb8888_t*)&payload[pc_size];
+    uint32_t sx = param->src_x32 >> pixelcopy_t::FP_SCALE;
+    uint32_t sy = param->src_y32 >> pixelcopy_t::FP_SCALE;
+    for (uint_fast16_t i = 0; i < h; ++i)
+    {
+      memcpy(dst, &src[sx + (sy + i) * param->src_bitwidth], w * sizeof(argb8888_t));
+      dst += w;
+    }
+  }
+
+  void Panel_DisplayList::readRect(uint_fast16_t x, uint_fast16_t y, uint_fast16_t w, uint_fast16_t h, void* dst, pixelcopy_t* param)
+  {
+    (void)x;
+    (void)y;
+    memset(dst, 0, w * h * (param->dst_bits >> 3));
+  }
+
+  bool Panel_DisplayList::appendList(const Panel_DisplayList& src, uint_fast16_t x, uint_fast16_t y)
+  {
+    if (src._write_depth != _write_depth) { return false; }
+    if (src._length == 0) { return true; }
+
+    // 先頭が全面の塗り潰しであれば、それ以前の記録は不要になる;
+    auto first = (const command_t*)src._list;
+    if (first->type == cmd_fill && first->x + x == 0 && first->y + y == 0
+     && first->w >= _width && first->h >= _height)
+    {
+      clearList();
+    }
+
+    if (!_reserve(src._length))
+    {
+      _overflow = true;
+      return false;
+    }
+
+    size_t pos = _length;
+    memcpy(&_list[pos], src._list, src._length);
+    _length += src._length;
+
+    // 複写したコマンドの座標をずらす。点の集まりは個々の座標も持つ;
+    while (pos < _length)
+    {
+      auto cmd = (command_t*)&_list[pos];
+      _last_cmd = pos;
+      pos += cmd->size;
+      if ((x | y) == 0) { continue; }
+      cmd->x += x;
+      cmd->y += y;
+      if (cmd->type == cmd_pixels)
+      {
+        auto p = (uint16_t*)&cmd[1];
+        for (size_t i = 0; i < cmd->count; ++i, p += 2)
+        {
+          p[0] += x;
+          p[1] += y;
+        }
+      }
+    }
+    return true;
+  }
+
+  void Panel_DisplayList::replay(IPanel* dst, uint_fast16_t top, uint_fast16_t h) const
+  {
+    // 先頭が全面の塗り潰しでなければ、記録の無い部分は黒とする;
+    auto first = (const command_t*)_list;
+    if (_length == 0 || first->type != cmd_fill || first->x != 0 || first->y != 0
+     || first->w < _width || first->h < _height)
+    {
+      dst->writeFillRectPreclipped(0, 0, _width, h, 0);
+    }
+    _replay(dst, 0, -(int32_t)top, top, top + h);
+  }
+
+  void Panel_DisplayList::draw(IPanel* dst, uint_fast16_t x, uint_fast16_t y) const
+  {
+    _replay(dst, x, y, 0, _height);
+  }
+
+  void Panel_DisplayList::_replay(IPanel* dst, int32_t dx, int32_t dy, uint_fast16_t top, uint_fast16_t bottom) const
+  {
+    auto depth = _write_depth;
+    size_t pos = 0;
+    while (pos < _length)
+    {
+      auto cmd = (const command_t*)&_list[pos];
+      pos += cmd->size;
+
+      uint_fast16_t ys = cmd->y;
+      uint_fast16_t ye = ys + cmd->h;
+      if (ye <= top || bottom <= ys) { continue; }
+      uint_fast16_t offset = 0;
+      if (ys < top) { offset = top - ys; ys = top; }
+      if (ye > bottom) { ye = bottom; }
+
+      switch (cmd->type)
+      {
+      case cmd_fill:
+        dst->writeFillRectPreclipped(cmd->x + dx, ys + dy, cmd->w, ye - ys, cmd->color);
+        break;
+
+      case cmd_fill_alpha:
+        dst->writeFillRectAlphaPreclipped(cmd->x + dx, ys + dy, cmd->w, ye - ys, cmd->color);
+        break;
+
+      case cmd_pixels:
+        {
+          auto p = (const uint16_t*)&cmd[1];
+          for (size_t i = 0; i < cmd->count; ++i, p += 2)
+          {
+            uint_fast16_t py = p[1];
+            if (top <= py && py < bottom)
+            {
+              dst->drawPixelPreclipped(p[0] + dx, py + dy, cmd->color);
+            }
+          }
+        }
+        break;
+
+      case cmd_image:
+        {
+          pixelcopy_t pc(&cmd[1], depth, depth);
+          pc.src_bitwidth = cmd->w;
+          pc.src_width = cmd->w;
+          pc.src_height = cmd->h;
+          pc.src_y = offset;
+          dst->writeImage(cmd->x + dx, ys + dy, cmd->w, ye - ys, &pc, false);
+        }
+        break;
+
+      case cmd_image_argb:
+        {
+          static constexpr size_t pc_size = align4(sizeof(pixelcopy_t));
+          pixelcopy_t pc;
+          memcpy((void*)&pc, &cmd[1], sizeof(pixelcopy_t));
+          pc.src_data = &((const uint8_t*)&cmd[1])[pc_size];
+          pc.src_bitwidth = cmd->w;
+          pc.src_width = cmd->w;
+          pc.src_height = cmd->h;
+          pc.src_x32_add = 1 << pixelcopy_t::FP_SCALE;
+          pc.src_y32_add = 0;
+          pc.src_x32 = 0;
+          pc.src_y32 = 0;
+          pc.src_y = offset;
+          dst->writeImageARGB(cmd->x + dx, ys + dy, cmd->w, ye - ys, &pc);
+        }
+        break;
+
+      default:
+        break;
+      }
+    }
+  }
+
+  static uint32_t hash_data(uint32_t hash, const void* data, size_t length)
+  {
+    // FNV-1a を4Byte単位で適用する。記録は4Byteに整列しているため端数は末尾にのみ生じる;
+    auto p = (const uint32_t*)data;
+    for (; length >= 4; length -= 4)
+    {
+      hash = (hash ^ *p++) * 16777619u;
+    }
+    if (length)
+    {
+      uint32_t last = 0;
+      memcpy(&last, p, length);
+      hash = (hash ^ last) * 16777619u;
+    }
+    return hash;
+  }
+
+  uint32_t Panel_DisplayList::_hash_command(const command_t* cmd) const
+  {
+    // 整列用の余白や、再生時に使用しないポインタ類は不定値のためハッシュに含めない;
+    uint32_t hash = hash_data(2166136261u, cmd, sizeof(command_t) - sizeof(cmd->size));
+    auto payload = (const uint8_t*)&cmd[1];
+    switch (cmd->type)
+    {
+    case cmd_pixels:
+      hash = hash_data(hash, payload, cmd->count * 4);
+      break;
+
+    case cmd_image:
+      hash = hash_data(hash, payload, cmd->w * cmd->h * (_write_bits >> 3));
+      break;
+
+    case cmd_image_argb:
+      {
+        static constexpr size_t pc_size = align4(sizeof(pixelcopy_t));
+        auto fp_copy = ((const pixelcopy_t*)payload)->fp_copy;
+        hash = hash_data(hash, &fp_copy, sizeof(fp_copy));
+        hash = hash_data(hash, &payload[pc_size], cmd->w * cmd->h * sizeof(argb8888_t));
+      }
+      break;
+
+    default:
+      break;
+    }
+    return hash;
+  }
+
+  void Panel_DisplayList::hashBands(uint32_t* hashes, size_t bands, uint_fast16_t band_height) const
+  {
+    for (size_t i = 0; i < bands; ++i) { hashes[i] = 2166136261u; }
+
+    // コマンド毎に一度だけハッシュを求め、掛かっているバンドへ記録順に畳み込む;
+    size_t pos = 0;
+    while (pos < _length)
+    {
+      auto cmd = (const command_t*)&_list[pos];
+      pos += cmd->size;
+      if (cmd->h == 0) { continue; }
+
+      size_t first = cmd->y / band_height;
+      size_t last = std::min<size_t>((cmd->y + cmd->h - 1) / band_height, bands - 1);
+      if (first >= bands) { continue; }
+
+      uint32_t hash = _hash_command(cmd);
+      for (size_t i = first; i <= last; ++i)
+      {
+        hashes[i] = (hashes[i] ^ hash) * 16777619u;
+      }
+    }
+  }
+
+//----------------------------------------------------------------------------
+
+  bool LGFX_DisplayList::createList(int32_t w, int32_t h, uint_fast16_t band_height, size_t capacity)
+  {
+    deleteList();
+    if (w < 1 || h < 1 || band_height < 1) { return false; }
+    if ((int32_t)band_height > h) { band_height = h; }
+
+    if (!_panel_list.createList(w, h, capacity)) { return false; }
+    for (auto& band : _band)
+    {
+      band.setColorDepth(_write_conv.depth);
+      if (band.createSprite(w, band_height, &_write_conv, false) == nullptr)
+      {
+        deleteList();
+        return false;
+      }
+    }
+    _band_height = band_height;
+
+    _band_count = (h + band_height - 1) / band_height;
+    _band_hash = (uint32_t*)heap_alloc(_band_count * 2 * sizeof(uint32_t));
+    if (_band_hash == nullptr)
+    {
+      deleteList();
+      return false;
+    }
+    invalidate();
+
+    clearClipRect();
+    clearScrollRect();
+    return true;
+  }
+
+  void LGFX_DisplayList::deleteList(void)
+  {
+    _band[0].deleteSprite();
+    _band[1].deleteSprite();
+    _panel_list.deleteList();
+    _band_height = 0;
+    if (_band_hash) { heap_free(_band_hash); }
+    _band_hash = nullptr;
+    _band_count = 0;
+    invalidate();
+    clearClipRect();
+    clearScrollRect();
+  }
+
+  void LGFX_DisplayList::setColorDepth(color_depth_t depth)
+  {
+    LovyanGFX::setColorDepth(depth);
+    if (_band_height == 0) { return; }
+    invalidate();
+    for (auto& band : _band)
+    {
+      band.setColorDepth(_write_conv.depth);
+      if (band.createSprite(width(), _band_height, &_write_conv, false) == nullptr)
+      {
+        deleteList();
+        return;
+      }
+    }
+  }
+
+  bool LGFX_DisplayList::appendList(const Panel_DisplayList& src, int32_t x, int32_t y)
+  {
+    if (x < 0 || y < 0 || x + src.width() > width() || y + src.height() > height()) { return false; }
+    return _panel_list.appendList(src, x, y);
+  }
+
+  void LGFX_DisplayList::push_list(LovyanGFX* dst, int32_t x, int32_t y)
+  {
+    if (dst == nullptr || _band_height == 0) { return; }
+
+    int32_t w = width();
+    int32_t h = height();
+
+    // 前回と同じ転送先・位置であれば、記録内容が前回と同じバンドは画面も同じ内容なので省略できる;
+    // 記録が溢れた場合は内容が欠けているため、差分判定を行わず次回も全体を送る;
+    bool valid = (_last_dst == dst && _last_x == x && _last_y == y);
+    bool overflow = _panel_list.isOverflow();
+    pixelcopy_t p(nullptr, dst->getColorDepth(), getColorDepth(), dst->hasPalette());
+
+    // 後半に今回のハッシュ値を求め、前半の前回の値と比較する;
+    auto prev_hash = _band_hash;
+    auto hash = &_band_hash[_band_count];
+    _panel_list.hashBands(hash, _band_count, _band_height);
+
+    // 送信はバンド単位のDMAで行い、その間にもう一方のバッファへ次のバンドを再生する;
+    // 次のバンドの送信開始時には前のバンドの送信が完了しているため、再生先のバッファは空いている;
+    // 変化したバンドが一つも無ければ、トランザクション自体を開始しない;
+    bool writing = false;
+    size_t idx = 0;
+    for (size_t i = 0; i < _band_count; ++i)
+    {
+      if (valid && !overflow && prev_hash[i] == hash[i]) { continue; }
+
+      if (!writing)
+      {
+        writing = true;
+        dst->startWrite();
+      }
+      int32_t top = i * _band_height;
+      int32_t rows = std::min<int32_t>(_band_height, h - top);
+      auto& band = _band[idx];
+      idx ^= 1;
+      _panel_list.replay(&band, top, rows);
+
+      p.src_data = band.getBuffer();
+      p.src_x32 = 0;
+      p.src_y32 = 0;
+      dst->pushImage(x, y + top, w, rows, &p, true);
+    }
+    if (writing) { dst->endWrite(); }
+    memcpy(prev_hash, hash, _band_count * sizeof(uint32_t));
+
+    _last_dst = overflow ? nullptr : dst;
+    _last_x = x;
+    _last_y = y;
+    _panel_list.clearList();
+  }
+
+//----------------------------------------------------------------------------
+ }
+}
@@ -0,0 +1,215 @@
+/*----------------------------------------------------------------------------/
+  Lovyan GFX - Graphics library for embedded devices.
+
+Original Source:
+ https://github.com/lovyan03/LovyanGFX/
+
+Licence:
+ [FreeBSD](https://github.com/lovyan03/LovyanGFX/blob/master/license.txt)
+
+Author:
+ [lovyan03](https://twitter.com/lovyan03)
+
+Contributors:
+ [ciniml](https://github.com/ciniml)
+ [mongonta0716](https://github.com/mongonta0716)
+ [tobozo](https://github.com/tobozo)
+/----------------------------------------------------------------------------*/
+#pragma once
+
+#include "LGFX_Sprite.hpp"
+
+namespace lgfx
+{
+ inline namespace v1
+ {
+
+#if defined ( _MSVC_LANG )
+#define LGFX_INLINE inline
+#else
+#define LGFX_INLINE __attribute__ ((always_inline)) inline
+#endif
+
+//----------------------------------------------------------------------------
+
+  /// 描画命令を画素に展開せずコマンド列として記録するパネル。;
+  /// 記録した内容はreplayで帯状(バンド)のスプライトへ再生する。;
+  struct Panel_DisplayList : public IPanel
+  {
+    enum command_type_t : uint8_t
+    {
+      cmd_fill,       // 矩形塗り潰し;
+      cmd_fill_alpha, // 半透明の矩形塗り潰し (colorはargb8888);
+      cmd_pixels,     // 同じ色の点の集まり。後続に (x,y) の組をcount個持つ;
+      cmd_image,      // 画像。後続にパネルの色形式に変換済みの画素を持つ;
+      cmd_image_argb, // ARGB画像。後続に pixelcopy_t と argb8888 の画素を持つ;
+    };
+
+    /// コマンドのヘッダ。x,y,w,h は影響する範囲を表し、バンドとの交差判定に使用する。;
+    struct command_t
+    {
+      uint8_t type;
+      uint8_t reserved;
+      uint16_t count;
+      uint16_t x;
+      uint16_t y;
+      uint16_t w;
+      uint16_t h;
+      uint32_t color;
+      uint32_t size;  // ヘッダを含むコマンド全体のバイト数 (4の倍数);
+    };
+
+    Panel_DisplayList(void) { _start_count = INT32_MAX; }
+    virtual ~Panel_DisplayList(void) { deleteList(); }
+
+    void beginTransaction(void) override {}
+    void endTransaction(void) override {}
+    void setInvert(bool) override {}
+    void setSleep(bool) override {}
+    void setPowerSave(bool) override {}
+    void writeCommand(uint32_t, uint_fast8_t) override {}
+    void writeData(uint32_t, uint_fast8_t) override {}
+    void initDMA(void) override {}
+    void waitDMA(void) override {}
+    bool dmaBusy(void) override { return false; }
+    void waitDisplay(void) override {}
+    bool displayBusy(void) override { return false; }
+    void display(uint_fast16_t, uint_fast16_t, uint_fast16_t, uint_fast16_t) override {}
+    bool isReadable(void) const override { return false; }
+    bool isBusShared(void) const override { return false; }
+
+    uint32_t readCommand(uint_fast16_t, uint_fast8_t, uint_fast8_t) override { return 0; }
+    uint32_t readData(uint_fast8_t, uint_fast8_t) override { return 0; }
+
+    /// 記録領域を確保する。capacityは初期容量で、不足した場合は拡張される。;
+    bool createList(int32_t w, int32_t h, size_t capacity);
+    void deleteList(void);
+
+    /// 記録済みのコマンドを破棄する。確保済みの領域は維持する。;
+    void clearList(void) { _length = 0; _last_cmd = 0; _overflow = false; }
+
+    LGFX_INLINE const uint8_t* getList(void) const { return _list; }
+    LGFX_INLINE size_t getListLength(void) const { return _length; }
+    /// 領域の拡張に失敗し、記録できなかったコマンドがある場合true;
+    LGFX_INLINE bool isOverflow(void) const { return _overflow; }
+
+    /// 記録したコマンドのうち、y座標が top から top+h-1 の範囲に掛かるものを dst へ再生する。;
+    /// dst の座標 (x, y-top) に描画される。dst は記録時と同じ色深度であること。;
+    void replay(IPanel* dst, uint_fast16_t top, uint_fast16_t h) const;
+
+    /// 記録したコマンドを全て dst の座標 (x, y) を原点として再生する。背景の塗り潰しは行わない。;
+    /// 記録範囲全体が dst に収まっていること。;
+    void draw(IPanel* dst, uint_fast16_t x, uint_fast16_t y) const;
+
+    /// src に記録されたコマンドを座標を (x, y) ずらして複写し、末尾へ追加する。;
+    /// src は同じ色深度で、ずらした後の記録範囲全体がこのリストに収まっていること。;
+    bool appendList(const Panel_DisplayList& src, uint_fast16_t x, uint_fast16_t y);
+
+    /// 記録したコマンドをband_height行ごとのバンドに振り分け、バンドごとのハッシュ値を hashes[bands] に求める。;
+    /// 同じ描画を同じ順序で記録したバンドは同じ値となる。;
+    void hashBands(uint32_t* hashes, size_t bands, uint_fast16_t band_height) const;
+
+    color_depth_t setColorDepth(color_depth_t depth) override;
+    void setRotation(uint_fast8_t) override { _rotation = 0; }
+
+    void setWindow(uint_fast16_t xs, uint_fast16_t ys, uint_fast16_t xe, uint_fast16_t ye) override;
+    void drawPixelPreclipped(uint_fast16_t x, uint_fast16_t y, uint32_t rawcolor) override;
+    void writeFillRectPreclipped(uint_fast16_t x, uint_fast16_t y, uint_fast16_t w, uint_fast16_t h, uint32_t rawcolor) override;
+    void writeFillRectAlphaPreclipped(uint_fast16_t x, uint_fast16_t y, uint_fast16_t w, uint_fast16_t h, uint32_t argb8888) override;
+    void writeBlock(uint32_t rawcolor, uint32_t len) override;
+    void writePixels(pixelcopy_t* param, uint32_t len, bool use_dma) override;
+    void writeImage(uint_fast16_t x, uint_fast16_t y, uint_fast16_t w, uint_fast16_t h, pixelcopy_t* param, bool use_dma) override;
+    void writeImageARGB(uint_fast16_t x, uint_fast16_t y, uint_fast16_t w, uint_fast16_t h, pixelcopy_t* param) override;
+
+    /// 画素を保持しないため読出しは常に0となる。;
+    void readRect(uint_fast16_t x, uint_fast16_t y, uint_fast16_t w, uint_fast16_t h, void* dst, pixelcopy_t* param) override;
+    /// 画素を保持しないため未対応。;
+    void copyRect(uint_fast16_t, uint_fast16_t, uint_fast16_t, uint_fast16_t, uint_fast16_t, uint_fast16_t) override {}
+
+  protected:
+    command_t* _add_command(uint8_t type, size_t payload);
+    command_t* _last_command(uint8_t type) const;
+    uint32_t _hash_command(const command_t* cmd) const;
+    void _replay(IPanel* dst, int32_t dx, int32_t dy, uint_fast16_t top, uint_fast16_t bottom) const;
+    bool _reserve(size_t length);
+
+    uint8_t* _list = nullptr;
+    size_t _length = 0;
+    size_t _capacity = 0;
+    size_t _last_cmd = 0;   // 最後に追加したコマンドの位置;
+    bool _overflow = false;
+
+    uint_fast16_t _xpos = 0;
+    uint_fast16_t _ypos = 0;
+  };
+
+//----------------------------------------------------------------------------
+
+  /// 描画内容をコマンド列として記録し、転送時に帯状の小さなバッファへ再生しながら送るキャンバス。;
+  /// 全画面のスプライトに比べ、バンド2本分と記録領域だけのメモリで同等のちらつきの無い描画ができる。;
+  /// 記録は転送ごとに破棄されるため、毎フレーム全体を描き直すこと。;
+  /// 前回の転送時と記録内容が同じバンドは再生・転送を省略し、全バンドが同じ場合は転送自体を行わない。;
+  /// 画素を保持しないため readPixel 等の読出しや、読出しを伴う描画(copyRect, scroll等)には対応しない。;
+  class LGFX_DisplayList : public LovyanGFX
+  {
+  public:
+
+    LGFX_DisplayList(LovyanGFX* parent = nullptr)
+    : LovyanGFX()
+    , _parent(parent)
+    {
+      _panel = &_panel_list;
+      LovyanGFX::setColorDepth(_write_conv.depth);
+    }
+
+    virtual ~LGFX_DisplayList(void) { deleteList(); }
+
+    LGFX_INLINE LovyanGFX* getParent(void) const { return _parent; }
+
+    /// 描画領域の大きさとバンドの高さを指定して、バンド2本分のバッファと記録領域を確保する。;
+    bool createList(int32_t w, int32_t h, uint_fast16_t band_height = 24, size_t capacity = 4096);
+    void deleteList(void);
+
+    /// バンドを新しい色深度で確保し直す。確保できなかった場合は createList と同じく全て解放し、getBandHeight() が0になる。;
+    void setColorDepth(int bits) { setColorDepth((color_depth_t)(bits & color_depth_t::bit_mask)); }
+    void setColorDepth(color_depth_t depth);
+
+    LGFX_INLINE void clearList(void) { _panel_list.clearList(); }
+
+    /// 別に記録したコマンド列を (x, y) の位置へ複写して追加する。範囲外や色深度が異なる場合はfalse;
+    bool appendList(const Panel_DisplayList& src, int32_t x, int32_t y);
+    LGFX_INLINE size_t getListLength(void) const { return _panel_list.getListLength(); }
+    LGFX_INLINE uint_fast16_t getBandHeight(void) const { return _band_height; }
+
+    /// 前回の転送内容を破棄し、次回のpushListで全バンドを転送させる。;
+    /// 転送先へ直接描画した場合など、画面の内容が前回の転送と異なる場合に使用する。;
+    void invalidate(void) { _last_dst = nullptr; }
+
+    /// 記録した内容をバンドごとに再生して転送し、記録を破棄する。;
+    /// 転送中のバンドをDMAで送りながら、もう一方のバッファへ次のバンドを再生する。;
+    LGFX_INLINE void pushList(                int32_t x, int32_t y) { push_list(_parent, x, y); }
+    LGFX_INLINE void pushList(LovyanGFX* dst, int32_t x, int32_t y) { push_list(    dst, x, y); }
+
+  protected:
+    void push_list(LovyanGFX* dst, int32_t x, int32_t y);
+
+    Panel_DisplayList _panel_list;
+    Panel_Sprite _band[2];
+    LovyanGFX* _parent;
+    uint_fast16_t _band_height = 0;
+
+    // バンドごとのハッシュ値 (前半が前回転送時、後半が今回) と前回の転送先;
+    uint32_t* _band_hash = nullptr;
+    size_t _band_count = 0;
+    LovyanGFX* _last_dst = nullptr;
+    int32_t _last_x = 0;
+    int32_t _last_y = 0;
+  };
+
+//----------------------------------------------------------------------------
+#undef LGFX_INLINE
+
+ }
+}
+
+using LGFX_DisplayList = lgfx::LGFX_DisplayList;
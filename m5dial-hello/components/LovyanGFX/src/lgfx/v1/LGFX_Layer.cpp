@@ -0,0 +1,76 @@
+/*----------------------------------------------------------------------------/
+  Lovyan GFX - Graphics library for embedded devices.
+
+Original Source:
+ https://github.com/lovyan03/LovyanGFX/
+
+Licence:
+ [FreeBSD](https://github.com/lovyan03/LovyanGFX/blob/master/license.txt)
+
+Author:
+ [lovyan03](https://twitter.com/lovyan03)
+
+Contributors:
+ [ciniml](https://github.com/ciniml)
+ [mongonta0716](https://github.com/mongonta0716)
+ [tobozo](https://github.com/tobozo)
+/----------------------------------------------------------------------------*/
+#include "LGFX_Layer.hpp"
+
+namespace lgfx
+{
+ inline namespace v1
+ {
+//----------------------------------------------------------------------------
+
+  bool LGFX_Layer::createLayer(int32_t w, int32_t h, size_t capacity)
+  {
+    _valid = false;
+    if (!_panel_list.createList(w, h, capacity)) { return false; }
+    clearClipRect();
+    clearScrollRect();
+    return true;
+  }
+
+  void LGFX_Layer::deleteLayer(void)
+  {
+    _valid = false;
+    _panel_list.deleteList();
+    clearClipRect();
+    clearScrollRect();
+  }
+
+  void LGFX_Layer::setColorDepth(color_depth_t depth)
+  {
+    LovyanGFX::setColorDepth(depth);
+    _valid = false;
+  }
+
+  bool LGFX_Layer::isChanged(uint32_t key)
+  {
+    // 記録が溢れていた場合は内容が欠けているため、描き直させる;
+    if (_valid && _key == key && !_panel_list.isOverflow()) { return false; }
+    _panel_list.clearList();
+    _key = key;
+    _valid = true;
+    return true;
+  }
+
+  bool LGFX_Layer::pushLayer(LGFX_DisplayList* dst, int32_t x, int32_t y)
+  {
+    if (dst == nullptr || dst->getColorDepth() != getColorDepth()) { return false; }
+    return dst->appendList(_panel_list, x, y);
+  }
+
+  bool LGFX_Layer::pushLayer(LGFX_Sprite* dst, int32_t x, int32_t y)
+  {
+    if (dst == nullptr || dst->getColorDepth() != getColorDepth() || dst->getRotation() != 0) { return false; }
+    if (x < 0 || y < 0 || x + width() > dst->width() || y + height() > dst->height()) { return false; }
+
+    _panel_list.draw(&dst->_panel_sprite, x, y);
+    return true;
+  }
+
+//----------------------------------------------------------------------------
+ }
+}
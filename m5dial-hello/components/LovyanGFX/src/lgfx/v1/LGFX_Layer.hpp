@@ -0,0 +1,84 @@
+/*----------------------------------------------------------------------------/
+  Lovyan GFX - Graphics library for embedded devices.
+
+Original Source:
+ https://github.com/lovyan03/LovyanGFX/
+
+Licence:
+ [FreeBSD](https://github.com/lovyan03/LovyanGFX/blob/master/license.txt)
+
+Author:
+ [lovyan03](https://twitter.com/lovyan03)
+
+Contributors:
+ [ciniml](https://github.com/ciniml)
+ [mongonta0716](https://github.com/mongonta0716)
+ [tobozo](https://github.com/tobozo)
+/----------------------------------------------------------------------------*/
+#pragma once
+
+#include "LGFX_DisplayList.hpp"
+
+namespace lgfx
+{
+ inline namespace v1
+ {
+
+#if defined ( _MSVC_LANG )
+#define LGFX_INLINE inline
+#else
+#define LGFX_INLINE __attribute__ ((always_inline)) inline
+#endif
+
+//----------------------------------------------------------------------------
+
+  /// 描画内容をコマンド列として保持し、入力が変わるまで再利用するレイヤー。;
+  /// isChanged(key)で前回の描画時と入力(key)を比較し、変化していれば記録を破棄してtrueを返すので、;
+  /// その時だけレイヤーへ描画し直す。pushLayerで描画先へ合成する。;
+  /// 描画先がLGFX_DisplayListの場合はコマンド列の複写のみで、画素の展開は転送時に行われる。;
+  /// スプライトへはコマンド列を再生して描画するため、座標計算等の描画前の処理のみが省略される。;
+  class LGFX_Layer : public LovyanGFX
+  {
+  public:
+
+    LGFX_Layer(void) : LovyanGFX()
+    {
+      _panel = &_panel_list;
+      LovyanGFX::setColorDepth(_write_conv.depth);
+    }
+
+    virtual ~LGFX_Layer(void) { deleteLayer(); }
+
+    /// レイヤーの大きさを指定して記録領域を確保する。capacityは初期容量で、不足した場合は拡張される。;
+    bool createLayer(int32_t w, int32_t h, size_t capacity = 1024);
+    void deleteLayer(void);
+
+    void setColorDepth(int bits) { setColorDepth((color_depth_t)(bits & color_depth_t::bit_mask)); }
+    void setColorDepth(color_depth_t depth);
+
+    /// keyが前回の呼出し時と異なるか、invalidate後であれば記録を破棄してtrueを返す。;
+    bool isChanged(uint32_t key);
+
+    /// 次回のisChangedで必ずtrueを返させる。;
+    LGFX_INLINE void invalidate(void) { _valid = false; }
+
+    LGFX_INLINE size_t getListLength(void) const { return _panel_list.getListLength(); }
+
+    /// レイヤーの内容を描画先の (x, y) へ合成する。レイヤー全体が描画先に収まらない場合はfalse;
+    /// 描画先は同じ色深度で、回転させていないこと。;
+    bool pushLayer(LGFX_DisplayList* dst, int32_t x = 0, int32_t y = 0);
+    bool pushLayer(LGFX_Sprite* dst, int32_t x = 0, int32_t y = 0);
+
+  protected:
+    Panel_DisplayList _panel_list;
+    uint32_t _key = 0;
+    bool _valid = false;
+  };
+
+//----------------------------------------------------------------------------
+#undef LGFX_INLINE
+
+ }
+}
+
+using LGFX_Layer = lgfx::LGFX_Layer;
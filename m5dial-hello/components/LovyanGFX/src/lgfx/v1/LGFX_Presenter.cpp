@@ -0,0 +1,184 @@
+/*----------------------------------------------------------------------------/
+  Lovyan GFX - Graphics library for embedded devices.
+
+Original Source:
+ https://github.com/lovyan03/LovyanGFX/
+
+Licence:
+ [FreeBSD](https://github.com/lovyan03/LovyanGFX/blob/master/license.txt)
+
+Author:
+ [lovyan03](https://twitter.com/lovyan03)
+
+Contributors:
+ [ciniml](https://github.com/ciniml)
+ [mongonta0716](https://github.com/mongonta0716)
+ [tobozo](https://github.com/tobozo)
+/----------------------------------------------------------------------------*/
+#include "LGFX_Presenter.hpp"
+
+#if defined (ESP_PLATFORM)
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#endif
+
+#include <string.h>
+
+namespace lgfx
+{
+ inline namespace v1
+ {
+//----------------------------------------------------------------------------
+
+  bool LGFX_Presenter::begin(void)
+  {
+    end();
+#if defined (ESP_PLATFORM)
+    if (_canvas == nullptr || _canvas->getBuffer() == nullptr) { return false; }
+
+    int32_t w = _canvas->width();
+    int32_t h = _canvas->height();
+    if (_canvas->getRotation() & 1) { std::swap(w, h); }
+
+    _front.setColorDepth(_canvas->getColorDepth());
+    if (_front.createSprite(w, h) == nullptr) { return false; }
+
+    if (_canvas->hasPalette())
+    {
+      auto palette = _canvas->getPalette();
+      _front.createPalette();
+      for (uint32_t i = 0; i < _canvas->getPaletteCount(); ++i)
+      {
+        _front.setPaletteColor(i, palette[i]);
+      }
+    }
+
+    // 表裏のバッファを同じ内容から開始する。画面との差分は描画先の変更領域が保持している;
+    memcpy(_front.getBuffer(), _canvas->getBuffer(), _canvas->bufferLength());
+    _front.setDirtyTracking(_canvas->getDirtyTracking());
+    _front.clearDirty();
+
+    auto done = xSemaphoreCreateBinary();
+    if (done == nullptr)
+    {
+      _front.deleteSprite();
+      return false;
+    }
+    _done = done;
+
+    TaskHandle_t task = nullptr;
+#if portNUM_PROCESSORS > 1
+    if (((size_t)_cfg.task_pinned_core) < portNUM_PROCESSORS)
+    {
+      xTaskCreatePinnedToCore(task_proc, "lgfx_present", _cfg.task_stack_size, this, _cfg.task_priority, &task, _cfg.task_pinned_core);
+    }
+    else
+#endif
+    {
+      xTaskCreate(task_proc, "lgfx_present", _cfg.task_stack_size, this, _cfg.task_priority, &task);
+    }
+    if (task == nullptr)
+    {
+      vSemaphoreDelete((SemaphoreHandle_t)_done);
+      _done = nullptr;
+      _front.deleteSprite();
+      return false;
+    }
+    _task = task;
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  void LGFX_Presenter::end(void)
+  {
+#if defined (ESP_PLATFORM)
+    if (_task == nullptr) { return; }
+    waitPresent();
+
+    // 転送先が無い状態で起床させるとタスクは終了する;
+    _dst = nullptr;
+    xTaskNotifyGive((TaskHandle_t)_task);
+    xSemaphoreTake((SemaphoreHandle_t)_done, portMAX_DELAY);
+    _task = nullptr;
+
+    vSemaphoreDelete((SemaphoreHandle_t)_done);
+    _done = nullptr;
+    _front.deleteSprite();
+    _front.deletePalette();
+#endif
+  }
+
+  void LGFX_Presenter::present(LovyanGFX* dst, int32_t x, int32_t y, uint32_t tag)
+  {
+    if (dst == nullptr) { return; }
+#if defined (ESP_PLATFORM)
+    if (_task != nullptr)
+    {
+      // 前のフレームの転送が終わるまで表側のバッファは使用中;
+      waitPresent();
+
+      if (_front.getDirtyTracking() != _canvas->getDirtyTracking())
+      {
+        _front.setDirtyTracking(_canvas->getDirtyTracking());
+        _front.clearDirty();
+      }
+
+      // 描画済みのバッファと変更領域を表側へ移し、描画先には1フレーム前のバッファを割り当てる;
+      // 1フレーム前のバッファは今回の変更領域だけ古いので、その部分を複写して画面と同じ内容に揃える;
+      if (_front.swapBuffer(*_canvas))
+      {
+        _canvas->copyDirtyFrom(_front);
+        _canvas->clearDirty();
+
+        _dst = dst;
+        _x = x;
+        _y = y;
+        _tag = tag;
+        _presenting = true;
+        xTaskNotifyGive((TaskHandle_t)_task);
+        return;
+      }
+    }
+#endif
+    _canvas->pushSpriteDirty(dst, x, y);
+    if (_cfg.on_presented) { _cfg.on_presented(tag); }
+  }
+
+  void LGFX_Presenter::waitPresent(void)
+  {
+#if defined (ESP_PLATFORM)
+    if (!_presenting) { return; }
+    xSemaphoreTake((SemaphoreHandle_t)_done, portMAX_DELAY);
+    _presenting = false;
+#endif
+  }
+
+  void LGFX_Presenter::task_proc(void* arg)
+  {
+#if defined (ESP_PLATFORM)
+    auto me = (LGFX_Presenter*)arg;
+    auto done = (SemaphoreHandle_t)me->_done;
+    for (;;)
+    {
+      ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+      auto dst = me->_dst;
+      if (dst == nullptr) { break; }
+
+      // 変更領域ごとにDMAキューで転送し、endWriteで転送完了まで待機する;
+      me->_front.pushSpriteDirty(dst, me->_x, me->_y);
+      if (me->_cfg.on_presented) { me->_cfg.on_presented(me->_tag); }
+      xSemaphoreGive(done);
+    }
+    xSemaphoreGive(done);
+    vTaskDelete(nullptr);
+#else
+    (void)arg;
+#endif
+  }
+
+//----------------------------------------------------------------------------
+ }
+}
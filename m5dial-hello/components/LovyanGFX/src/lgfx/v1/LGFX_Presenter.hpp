@@ -0,0 +1,92 @@
+/*----------------------------------------------------------------------------/
+  Lovyan GFX - Graphics library for embedded devices.
+
+Original Source:
+ https://github.com/lovyan03/LovyanGFX/
+
+Licence:
+ [FreeBSD](https://github.com/lovyan03/LovyanGFX/blob/master/license.txt)
+
+Author:
+ [lovyan03](https://twitter.com/lovyan03)
+
+Contributors:
+ [ciniml](https://github.com/ciniml)
+ [mongonta0716](https://github.com/mongonta0716)
+ [tobozo](https://github.com/tobozo)
+/----------------------------------------------------------------------------*/
+#pragma once
+
+#include "LGFX_Sprite.hpp"
+
+namespace lgfx
+{
+ inline namespace v1
+ {
+//----------------------------------------------------------------------------
+
+  /// スプライトをダブルバッファ化し、転送中に次のフレームを描画できるようにする。;
+  /// present()で描画済みのバッファを裏側の転送タスクへ渡し、描画先のスプライトには次のバッファを割り当てる。;
+  /// 転送はpushSpriteDirtyと同じ経路(DMAキュー)で行われるため、変更領域の記録と併用できる。;
+  /// 転送中は転送先のディスプレイへ直接描画しないこと。;
+  class LGFX_Presenter
+  {
+  public:
+    struct config_t
+    {
+      /// 転送タスクの優先度;
+      int task_priority = 2;
+
+      /// 転送タスクを固定するコア。 (APP_CPU_NUM or PRO_CPU_NUM) 負の値は固定しない;
+      int task_pinned_core = -1;
+
+      /// 転送タスクのスタックサイズ;
+      uint32_t task_stack_size = 4096;
+
+      /// フレームの転送が完了するたびに呼ばれる関数。引数はpresent()に渡したtag;
+      /// 転送タスクから呼ばれる (同期転送の場合はpresent()の中で呼ばれる);
+      void (*on_presented)(uint32_t tag) = nullptr;
+    };
+
+    LGFX_Presenter(LGFX_Sprite* canvas) : _canvas(canvas) {}
+    virtual ~LGFX_Presenter(void) { end(); }
+
+    const config_t& config(void) const { return _cfg; }
+    void config(const config_t& config) { _cfg = config; }
+
+    /// 描画先スプライトと同じ大きさ・色深度の裏バッファを確保し、転送タスクを開始する。;
+    /// 確保に失敗した場合はfalseを返し、present()は通常の同期転送として動作する。;
+    bool begin(void);
+    void end(void);
+
+    /// 描画済みのフレームの転送を開始する。前のフレームの転送が終わっていない場合は完了を待つ。;
+    /// tagは転送完了時にconfig_t::on_presentedへ渡される;
+    void present(LovyanGFX* dst, int32_t x, int32_t y, uint32_t tag = 0);
+    void present(int32_t x, int32_t y, uint32_t tag = 0) { present(_canvas->getParent(), x, y, tag); }
+
+    /// 転送中のフレームの完了を待つ。;
+    void waitPresent(void);
+
+    bool isPresenting(void) const { return _presenting; }
+    bool isDoubleBuffered(void) const { return _task != nullptr; }
+
+  protected:
+    static void task_proc(void* arg);
+
+    config_t _cfg;
+    LGFX_Sprite* _canvas;
+    LGFX_Sprite _front;
+    LovyanGFX* _dst = nullptr;
+    int32_t _x = 0;
+    int32_t _y = 0;
+    uint32_t _tag = 0;
+    void* _task = nullptr;
+    void* _done = nullptr;
+    volatile bool _presenting = false;
+  };
+
+//----------------------------------------------------------------------------
+ }
+}
+
+using LGFX_Presenter = lgfx::LGFX_Presenter;
@@ -46,6 +46,7 @@ namespace lgfx
     _ye = h - 1;
 
     setRotation(_rotation);
+    if (_dirty_tracking) { markDirty(); }
   }
 
   void Panel_Sprite::deleteSprite(void)
@@ -81,6 +82,7 @@ namespace lgfx
     memset(_img, 0, (_bitwidth * _write_bits >> 3) * _panel_height);
 
     setRotation(_rotation);
+    if (_dirty_tracking) { markDirty(); }
 
     return _img;
   }
@@ -133,6 +135,7 @@ namespace lgfx
       if (r & 2)                  { x = _width  - (x + 1); }
       if (r & 1) { std::swap(x, y); }
     }
+    if (_dirty_tracking) { _add_dirty(x, y, x, y); }
     auto bits = _write_bits;
     uint32_t index = x + y * _bitwidth;
     if (bits >= 8)
@@ -170,6 +173,11 @@ namespace lgfx
     }
 
     uint_fast8_t bits = _write_bits;
+    if (_dirty_tracking)
+    {
+      if (bits >= 8) { _add_dirty_fill(x, y, w, h, rawcolor); }
+      else { _add_dirty(x, y, x + w - 1, y + h - 1); }
+    }
     if (bits >= 8)
     {
       if (w > 1)
@@ -334,6 +342,14 @@ namespace lgfx
     auto k = _bitwidth * bits >> 3;
 
     uint_fast8_t r = _rotation;
+    if (_dirty_tracking)
+    { // 書込み範囲はウィンドウ内に収まるため、ウィンドウ全体を変更領域とする;
+      uint_fast16_t dl = xs, dt = ys, dr = xe, db = ye;
+      if ((1u << r) & 0b10010110) { dt = _height - (ye + 1); db = _height - (ys + 1); }
+      if (r & 2)                  { dl = _width  - (xe + 1); dr = _width  - (xs + 1); }
+      if (r & 1) { std::swap(dl, dt);  std::swap(dr, db); }
+      _add_dirty(dl, dt, dr, db);
+    }
     if (!r)
     {
       uint_fast16_t linelength;
@@ -428,6 +444,7 @@ namespace lgfx
   void Panel_Sprite::writeImage(uint_fast16_t x, uint_fast16_t y, uint_fast16_t w, uint_fast16_t h, pixelcopy_t* param, bool)
   {
     uint_fast8_t r = _rotation;
+    if (_dirty_tracking && r == 0) { _add_dirty(x, y, x + w - 1, y + h - 1); }
     if (r == 0 && param->transp == pixelcopy_t::NON_TRANSP && param->no_convert && _img.use_memcpy())
     {
       auto sx = param->src_x;
@@ -468,6 +485,7 @@ namespace lgfx
     if (r)
     {
       _rotate_pixelcopy(x, y, w, h, param, nextx, nexty);
+      if (_dirty_tracking) { _add_dirty(x, y, x + w - 1, y + h - 1); }
     }
     uint32_t sx32 = param->src_x32;
     uint32_t sy32 = param->src_y32;
@@ -493,6 +511,7 @@ namespace lgfx
     {
       _rotate_pixelcopy(x, y, w, h, param, nextx, nexty);
     }
+    if (_dirty_tracking) { _add_dirty(x, y, x + w - 1, y + h - 1); }
     uint32_t sx32 = param->src_x32;
     uint32_t sy32 = param->src_y32;
 
@@ -613,6 +632,7 @@ namespace lgfx
       if (r & 2)                  { src_x = _width  - (src_x + w); dst_x = _width  - (dst_x + w); }
       if (r & 1) { std::swap(src_x, src_y);  std::swap(dst_x, dst_y);  std::swap(w, h); }
     }
+    if (_dirty_tracking) { _add_dirty(dst_x, dst_y, dst_x + w - 1, dst_y + h - 1); }
 
     if (_write_bits < 8) {
       pixelcopy_t param(_img, _write_depth, _write_depth);
@@ -679,6 +699,193 @@ namespace lgfx
     }
   }
 
+  void Panel_Sprite::setDirtyTracking(bool enable)
+  {
+    _dirty_tracking = enable;
+    _dirty_count = 0;
+    if (enable) { markDirty(); }
+  }
+
+  void Panel_Sprite::markDirty(void)
+  {
+    _dirty_count = 0;
+    if (_panel_width && _panel_height)
+    {
+      _add_dirty(0, 0, _panel_width - 1, _panel_height - 1);
+    }
+  }
+
+  void Panel_Sprite::swapBuffer(Panel_Sprite& other)
+  {
+    _img.swap(other._img);
+    std::swap(_dirty_rects, other._dirty_rects);
+    std::swap(_dirty_count, other._dirty_count);
+  }
+
+  void Panel_Sprite::copyDirtyFrom(const Panel_Sprite& src)
+  {
+    auto dst_buf = _img.img8();
+    auto src_buf = src._img.img8();
+    if (dst_buf == nullptr || src_buf == nullptr || dst_buf == src_buf) { return; }
+
+    if (!src._dirty_tracking)
+    {
+      memcpy(dst_buf, src_buf, bufferLength());
+      return;
+    }
+
+    size_t bits = _write_bits;
+    size_t stride = _bitwidth * bits >> 3;
+    for (size_t i = 0; i < src._dirty_count; ++i)
+    {
+      auto& r = src._dirty_rects[i];
+      // 1Byte未満の色深度の場合はByte境界まで広げて複写する;
+      size_t l = r.left * bits >> 3;
+      size_t len = (((r.right + 1) * bits + 7) >> 3) - l;
+      size_t pos = r.top * stride + l;
+      for (int y = r.top; y <= r.bottom; ++y)
+      {
+        memcpy(&dst_buf[pos], &src_buf[pos], len);
+        pos += stride;
+      }
+    }
+  }
+
+  void Panel_Sprite::_add_dirty(int_fast16_t left, int_fast16_t top, int_fast16_t right, int_fast16_t bottom)
+  {
+    range_rect_t rect;
+    rect.left   = left;
+    rect.top    = top;
+    rect.right  = right;
+    rect.bottom = bottom;
+
+    // 重なる矩形・接する矩形は統合する;
+    size_t i = 0;
+    while (i < _dirty_count)
+    {
+      auto& d = _dirty_rects[i];
+      if (d.left <= rect.right + 1 && rect.left <= d.right + 1
+       && d.top <= rect.bottom + 1 && rect.top <= d.bottom + 1)
+      {
+        rect.left   = std::min(rect.left  , d.left  );
+        rect.top    = std::min(rect.top   , d.top   );
+        rect.right  = std::max(rect.right , d.right );
+        rect.bottom = std::max(rect.bottom, d.bottom);
+        _dirty_rects[i] = _dirty_rects[--_dirty_count];
+        i = 0;
+        continue;
+      }
+      ++i;
+    }
+
+    if (_dirty_count < DIRTY_RECT_MAX)
+    {
+      _dirty_rects[_dirty_count++] = rect;
+      return;
+    }
+
+    // 空きが無い場合は、統合による面積の増加が最も小さい矩形と統合する;
+    size_t best = 0;
+    int32_t best_cost = INT32_MAX;
+    for (i = 0; i < _dirty_count; ++i)
+    {
+      auto& d = _dirty_rects[i];
+      int32_t w = std::max(rect.right , d.right ) - std::min(rect.left, d.left) + 1;
+      int32_t h = std::max(rect.bottom, d.bottom) - std::min(rect.top , d.top ) + 1;
+      int32_t cost = w * h - d.width() * d.height();
+      if (best_cost > cost)
+      {
+        best_cost = cost;
+        best = i;
+      }
+    }
+    auto d = _dirty_rects[best];
+    _dirty_rects[best] = _dirty_rects[--_dirty_count];
+    _add_dirty( std::min(rect.left  , d.left  )
+              , std::min(rect.top   , d.top   )
+              , std::max(rect.right , d.right )
+              , std::max(rect.bottom, d.bottom));
+  }
+
+  template <typename T>
+  static bool find_changed_span(const T* src, T value, uint_fast16_t w, uint_fast16_t& first, uint_fast16_t& last)
+  {
+    uint_fast16_t i = 0;
+    while (src[i] == value) { if (++i == w) return false; }
+    first = i;
+    i = w - 1;
+    while (src[i] == value) { --i; }
+    last = i;
+    return true;
+  }
+
+  static bool find_changed_span_bytes(const uint8_t* src, const uint8_t* value, size_t bytes, uint_fast16_t w, uint_fast16_t& first, uint_fast16_t& last)
+  {
+    uint_fast16_t i = 0;
+    while (0 == memcmp(&src[i * bytes], value, bytes)) { if (++i == w) return false; }
+    first = i;
+    i = w - 1;
+    while (0 == memcmp(&src[i * bytes], value, bytes)) { --i; }
+    last = i;
+    return true;
+  }
+
+  /// 塗り潰しによって実際に値が変わるピクセルの範囲のみを変更領域として記録する。;
+  /// 毎フレーム画面全体を塗り潰す用途でも、変化の無い領域は転送対象から除外できる。;
+  void Panel_Sprite::_add_dirty_fill(uint_fast16_t x, uint_fast16_t y, uint_fast16_t w, uint_fast16_t h, uint32_t rawcolor)
+  {
+    size_t bytes = _write_bits >> 3;
+    size_t add = _bitwidth * bytes;
+    auto src = &_img[(x + y * _bitwidth) * bytes];
+
+    // 変化のある行が連続する範囲ごとに矩形として記録する;
+    int_fast16_t run_top = -1;
+    int_fast16_t run_left = 0;
+    int_fast16_t run_right = 0;
+    uint_fast16_t ye = y + h;
+    for (uint_fast16_t yy = y; yy < ye; ++yy, src += add)
+    {
+      uint_fast16_t first, last;
+      bool changed;
+      if (bytes == 2)
+      {
+        changed = find_changed_span((const uint16_t*)src, (uint16_t)rawcolor, w, first, last);
+      }
+      else if (bytes == 1)
+      {
+        changed = find_changed_span(src, (uint8_t)rawcolor, w, first, last);
+      }
+      else
+      {
+        changed = find_changed_span_bytes(src, (const uint8_t*)&rawcolor, bytes, w, first, last);
+      }
+
+      if (changed)
+      {
+        if (run_top < 0)
+        {
+          run_top = yy;
+          run_left = first;
+          run_right = last;
+        }
+        else
+        {
+          run_left  = std::min<int_fast16_t>(run_left , first);
+          run_right = std::max<int_fast16_t>(run_right, last );
+        }
+      }
+      else if (run_top >= 0)
+      {
+        _add_dirty(x + run_left, run_top, x + run_right, yy - 1);
+        run_top = -1;
+      }
+    }
+    if (run_top >= 0)
+    {
+      _add_dirty(x + run_left, run_top, x + run_right, ye - 1);
+    }
+  }
+
 //----------------------------------------------------------------------------
  }
 }
@@ -22,6 +22,7 @@ Contributors:
 #include "LGFXBase.hpp"
 #include "misc/SpriteBuffer.hpp"
 #include "misc/bitmap.hpp"
+#include "misc/range.hpp"
 #include "Panel.hpp"
 
 namespace lgfx
@@ -37,6 +38,7 @@ namespace lgfx
 
 //----------------------------------------------------------------------------
   class LGFX_Sprite;
+  class LGFX_Layer;
 
   struct Panel_Sprite : public IPanel
   {
@@ -89,11 +91,38 @@ namespace lgfx
 
     uint32_t readPixelValue(uint_fast16_t x, uint_fast16_t y);
 
+    /// 変更領域の記録に使用する矩形の最大数。これを超える場合は近い矩形同士を統合する。;
+    static constexpr size_t DIRTY_RECT_MAX = 6;
+
+    /// 変更領域(ダメージリスト)の記録の有効/無効を設定する。有効化時はバッファ全体を変更済みとする。;
+    void setDirtyTracking(bool enable);
+    LGFX_INLINE bool getDirtyTracking(void) const { return _dirty_tracking; }
+
+    /// バッファ全体を変更済みとして記録する。;
+    void markDirty(void);
+    LGFX_INLINE void clearDirty(void) { _dirty_count = 0; }
+    LGFX_INLINE size_t getDirtyCount(void) const { return _dirty_count; }
+    /// 記録された変更領域。座標は回転前のバッファ座標系。;
+    LGFX_INLINE const range_rect_t* getDirtyRects(void) const { return _dirty_rects; }
+
+    /// 同じ大きさ・色深度のスプライトと、バッファおよび変更領域をコピーせずに交換する。;
+    void swapBuffer(Panel_Sprite& other);
+
+    /// srcの変更領域をsrcのバッファから複写する。変更領域の記録が無効の場合はバッファ全体を複写する。;
+    void copyDirtyFrom(const Panel_Sprite& src);
+
   protected:
     void _rotate_pixelcopy(uint_fast16_t& x, uint_fast16_t& y, uint_fast16_t& w, uint_fast16_t& h, pixelcopy_t* param, uint32_t& nextx, uint32_t& nexty);
 
+    void _add_dirty(int_fast16_t left, int_fast16_t top, int_fast16_t right, int_fast16_t bottom);
+    void _add_dirty_fill(uint_fast16_t x, uint_fast16_t y, uint_fast16_t w, uint_fast16_t h, uint32_t rawcolor);
+
     SpriteBuffer _img;
 
+    range_rect_t _dirty_rects[DIRTY_RECT_MAX];
+    uint8_t _dirty_count = 0;
+    bool _dirty_tracking = false;
+
     uint_fast16_t _xpos;
     uint_fast16_t _ypos;
     uint_fast16_t _panel_width;   // rotationしていない状態の幅;
@@ -103,6 +132,8 @@ namespace lgfx
 
   class LGFX_Sprite : public LovyanGFX
   {
+    friend LGFX_Layer;
+
   public:
 
     LGFX_Sprite(LovyanGFX* parent)
@@ -133,6 +164,28 @@ namespace lgfx
       _palette.release();
     }
 
+    /// 描画による変更領域を記録し、pushSpriteDirtyで変更部分のみを転送できるようにする。;
+    LGFX_INLINE void setDirtyTracking(bool enable) { _panel_sprite.setDirtyTracking(enable); }
+    LGFX_INLINE bool getDirtyTracking(void) const { return _panel_sprite.getDirtyTracking(); }
+    LGFX_INLINE void markDirty(void) { _panel_sprite.markDirty(); }
+    LGFX_INLINE void clearDirty(void) { _panel_sprite.clearDirty(); }
+    LGFX_INLINE void copyDirtyFrom(const LGFX_Sprite& src) { _panel_sprite.copyDirtyFrom(src._panel_sprite); }
+
+    /// 同じ大きさ・色深度のスプライトと画素バッファを交換する。(ダブルバッファ用);
+    bool swapBuffer(LGFX_Sprite& other)
+    {
+      if (_panel_sprite._panel_width  != other._panel_sprite._panel_width
+       || _panel_sprite._panel_height != other._panel_sprite._panel_height
+       || getColorDepth() != other.getColorDepth())
+      {
+        return false;
+      }
+      _panel_sprite.swapBuffer(other._panel_sprite);
+      _img = _panel_sprite.getBuffer();
+      other._img = other._panel_sprite.getBuffer();
+      return true;
+    }
+
     void deleteSprite(void)
     {
 //      _bitwidth = 0;
@@ -358,6 +411,10 @@ namespace lgfx
     LGFX_INLINE void pushSprite(                int32_t x, int32_t y) { push_sprite(_parent, x, y); }
     LGFX_INLINE void pushSprite(LovyanGFX* dst, int32_t x, int32_t y) { push_sprite(    dst, x, y); }
 
+    /// 前回の転送以降に変更された領域のみを転送する。変更領域の記録が無効な場合はpushSpriteと同じ。;
+    LGFX_INLINE void pushSpriteDirty(                int32_t x, int32_t y) { push_sprite_dirty(_parent, x, y); }
+    LGFX_INLINE void pushSpriteDirty(LovyanGFX* dst, int32_t x, int32_t y) { push_sprite_dirty(    dst, x, y); }
+
     template<typename T> void pushRotated(                float angle, const T& transp) { push_rotate_zoom(_parent, _parent->getPivotX(), _parent->getPivotY(), angle, 1.0f, 1.0f, _write_conv.convert(transp) & _write_conv.colormask); }
     template<typename T> void pushRotated(LovyanGFX* dst, float angle, const T& transp) { push_rotate_zoom(dst    , dst    ->getPivotX(), dst    ->getPivotY(), angle, 1.0f, 1.0f, _write_conv.convert(transp) & _write_conv.colormask); }
                          void pushRotated(                float angle                 ) { push_rotate_zoom(_parent, _parent->getPivotX(), _parent->getPivotY(), angle, 1.0f, 1.0f); }
@@ -540,6 +597,36 @@ namespace lgfx
       dst->pushImage(x, y, _panel_sprite._panel_width, _panel_sprite._panel_height, &p, _panel_sprite.getSpriteBuffer()->use_dma()); // DMA disable with use SPIRAM
     }
 
+    void push_sprite_dirty(LovyanGFX* dst, int32_t x, int32_t y)
+    {
+      if (!_panel_sprite.getDirtyTracking())
+      {
+        push_sprite(dst, x, y);
+        return;
+      }
+      size_t count = _panel_sprite.getDirtyCount();
+      if (count == 0) return;
+
+      // 転送先のクリップ範囲を変更領域に絞り込んで、既存のpushImage経路で転送する;
+      int32_t cx, cy, cw, ch;
+      dst->getClipRect(&cx, &cy, &cw, &ch);
+      auto rects = _panel_sprite.getDirtyRects();
+      dst->startWrite();
+      for (size_t i = 0; i < count; ++i)
+      {
+        int32_t l = std::max<int32_t>(cx          , x + rects[i].left  );
+        int32_t t = std::max<int32_t>(cy          , y + rects[i].top   );
+        int32_t r = std::min<int32_t>(cx + cw - 1, x + rects[i].right );
+        int32_t b = std::min<int32_t>(cy + ch - 1, y + rects[i].bottom);
+        if (l > r || t > b) continue;
+        dst->setClipRect(l, t, r - l + 1, b - t + 1);
+        push_sprite(dst, x, y);
+      }
+      dst->setClipRect(cx, cy, cw, ch);
+      dst->endWrite();
+      _panel_sprite.clearDirty();
+    }
+
     void push_rotate_zoom(LovyanGFX* dst, float x, float y, float angle, float zoom_x, float zoom_y, uint32_t transp = pixelcopy_t::NON_TRANSP)
     {
       dst->pushImageRotateZoom(x, y, _xpivot, _ypivot, angle, zoom_x, zoom_y, _panel_sprite._panel_width, _panel_sprite._panel_height, _img, transp, getColorDepth(), _palette.img24());
@@ -564,6 +564,11 @@ label_nextbyte: /// 次のデータを取得する;
     }
     else
     {
+      if (_index_stride && (_index || createIndex()))
+      {
+        return searchIndex(encoding);
+      }
+
       uint_fast16_t e;
       const uint8_t *unicode_lut;
 
@@ -585,6 +590,68 @@ label_nextbyte: /// 次のデータを取得する;
     return nullptr;
   }
 
+  void U8g2font::setIndexStride(uint_fast8_t stride) const
+  {
+    if (_index_stride == stride) { return; }
+    if (_index)
+    {
+      heap_free(_index);
+      _index = nullptr;
+      _index_count = 0;
+    }
+    _index_stride = stride;
+  }
+
+  bool U8g2font::createIndex(void) const
+  {
+    // ユニコード部の先頭はLUTで、最初の要素がグリフ列までのオフセットを持つ;
+    auto unicode_lut = &this->_font[23 + this->start_pos_unicode()];
+    auto first = unicode_lut + ((pgm_read_byte(&unicode_lut[0]) << 8) + pgm_read_byte(&unicode_lut[1]));
+
+    size_t glyphs = 0;
+    for (auto font = first; pgm_read_byte(&font[0]) | pgm_read_byte(&font[1]); font += pgm_read_byte(&font[2]))
+    {
+      ++glyphs;
+    }
+    size_t count = (glyphs + _index_stride - 1) / _index_stride;
+    if (count == 0 || count > UINT16_MAX
+     || nullptr == (_index = (uint32_t*)heap_alloc(count * (sizeof(uint32_t) + sizeof(uint16_t)))))
+    {
+      // 作成できない場合は索引を使わず線形探索とする;
+      _index_stride = 0;
+      return false;
+    }
+
+    auto codes = (uint16_t*)&_index[count];
+    size_t i = 0;
+    size_t n = 0;
+    for (auto font = first; n < count; font += pgm_read_byte(&font[2]), ++i)
+    {
+      if (i % _index_stride) { continue; }
+      _index[n] = font - this->_font;
+      codes[n] = (pgm_read_byte(&font[0]) << 8) + pgm_read_byte(&font[1]);
+      ++n;
+    }
+    _index_count = count;
+    return true;
+  }
+
+  const uint8_t* U8g2font::searchIndex(uint16_t encoding) const
+  {
+    // グリフ列は文字コード順のため、encoding以下で最大のコードを持つ索引の位置から探す;
+    auto codes = (const uint16_t*)&_index[_index_count];
+    auto it = std::upper_bound(codes, &codes[_index_count], encoding);
+    if (it == codes) { return nullptr; }
+
+    uint_fast16_t e;
+    for (auto font = &this->_font[_index[it - codes - 1]]; 0 != (e = (pgm_read_byte(&font[0]) << 8) + pgm_read_byte(&font[1])); font += pgm_read_byte(&font[2]))
+    {
+      if ( e == encoding ) { return font + 3; }  /* skip encoding and glyph size */
+      if ( e > encoding ) { break; }
+    }
+    return nullptr;
+  }
+
   void U8g2font::getDefaultMetric(lgfx::FontMetrics *metrics) const
   {
     metrics->height    = max_char_height();
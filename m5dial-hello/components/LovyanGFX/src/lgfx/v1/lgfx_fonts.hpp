@@ -206,9 +206,22 @@ namespace lgfx
     bool updateFontMetric(FontMetrics *metrics, uint16_t uniCode) const override;
     size_t drawChar(LGFXBase* gfx, int32_t x, int32_t y, uint16_t c, const TextStyle* style, FontMetrics* metrics, int32_t& filled_x) const override;
 
+    /// 0x100以上の文字の検索に使う索引の間隔を設定する。0で索引を使用しない(初期値);
+    /// 索引はstride文字ごとの文字コードと位置を持ち、初回の検索時にRAMへ作成される。;
+    /// 全角フォントでは数百文字の線形探索が二分探索と最大stride文字の探索になる。;
+    void setIndexStride(uint_fast8_t stride) const;
+    uint_fast8_t getIndexStride(void) const { return _index_stride; }
+
   private:
     const uint8_t* getGlyph(uint16_t encoding) const;
+    const uint8_t* searchIndex(uint16_t encoding) const;
+    bool createIndex(void) const;
     const uint8_t* _font;
+
+    // 前半にグリフの位置(_fontからのオフセット)、後半に文字コードを_index_count個ずつ持つ;
+    mutable uint32_t* _index = nullptr;
+    mutable uint16_t _index_count = 0;
+    mutable uint8_t _index_stride = 0;
   };
 
 //----------------------------------------------------------------------------
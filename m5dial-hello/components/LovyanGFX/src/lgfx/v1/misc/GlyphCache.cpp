@@ -0,0 +1,314 @@
+/*----------------------------------------------------------------------------/
+  Lovyan GFX - Graphics library for embedded devices.
+
+Original Source:
+ https://github.com/lovyan03/LovyanGFX/
+
+Licence:
+ [FreeBSD](https://github.com/lovyan03/LovyanGFX/blob/master/license.txt)
+
+Author:
+ [lovyan03](https://twitter.com/lovyan03)
+
+Contributors:
+ [ciniml](https://github.com/ciniml)
+ [mongonta0716](https://github.com/mongonta0716)
+ [tobozo](https://github.com/tobozo)
+/----------------------------------------------------------------------------*/
+#include "GlyphCache.hpp"
+
+#include "../LGFXBase.hpp"
+#include "../platforms/common.hpp"
+
+#include <string.h>
+
+namespace lgfx
+{
+ inline namespace v1
+ {
+//----------------------------------------------------------------------------
+
+  namespace
+  {
+    /// 文字の描画を受け取り、前景の矩形として記録するパネル。;
+    /// 矩形の塗り潰し以外の方法で描画された場合はキャッシュできない文字として扱う。;
+    struct Panel_GlyphCapture : public IPanel
+    {
+      // 記録できる範囲(-128～127)を十分に上回る大きさとし、範囲内の描画がクリッピングされないようにする;
+      static constexpr int32_t origin = 256;
+
+      Panel_GlyphCapture(GlyphCache::rect_t* rects, size_t limit)
+      : _rects(rects), _limit(limit)
+      {
+        _start_count = INT32_MAX;
+        _width = origin * 2;
+        _height = origin * 2;
+      }
+
+      void beginTransaction(void) override {}
+      void endTransaction(void) override {}
+      color_depth_t setColorDepth(color_depth_t depth) override { _write_depth = depth; _read_depth = depth; return depth; }
+      void setInvert(bool) override {}
+      void setRotation(uint_fast8_t) override { _rotation = 0; }
+      void setSleep(bool) override {}
+      void setPowerSave(bool) override {}
+      void writeCommand(uint32_t, uint_fast8_t) override {}
+      void writeData(uint32_t, uint_fast8_t) override {}
+      void initDMA(void) override {}
+      void waitDMA(void) override {}
+      bool dmaBusy(void) override { return false; }
+      void waitDisplay(void) override {}
+      bool displayBusy(void) override { return false; }
+      void display(uint_fast16_t, uint_fast16_t, uint_fast16_t, uint_fast16_t) override {}
+      bool isReadable(void) const override { return false; }
+      bool isBusShared(void) const override { return false; }
+      uint32_t readCommand(uint_fast16_t, uint_fast8_t, uint_fast8_t) override { return 0; }
+      uint32_t readData(uint_fast8_t, uint_fast8_t) override { return 0; }
+
+      void setWindow(uint_fast16_t, uint_fast16_t, uint_fast16_t, uint_fast16_t) override {}
+      void writeBlock(uint32_t, uint32_t) override { _failed = true; }
+      void writePixels(pixelcopy_t*, uint32_t, bool) override { _failed = true; }
+      void writeImage(uint_fast16_t, uint_fast16_t, uint_fast16_t, uint_fast16_t, pixelcopy_t*, bool) override { _failed = true; }
+      void writeImageARGB(uint_fast16_t, uint_fast16_t, uint_fast16_t, uint_fast16_t, pixelcopy_t*) override { _failed = true; }
+      void readRect(uint_fast16_t, uint_fast16_t, uint_fast16_t, uint_fast16_t, void*, pixelcopy_t*) override { _failed = true; }
+      void copyRect(uint_fast16_t, uint_fast16_t, uint_fast16_t, uint_fast16_t, uint_fast16_t, uint_fast16_t) override { _failed = true; }
+
+      void drawPixelPreclipped(uint_fast16_t x, uint_fast16_t y, uint32_t rawcolor) override
+      {
+        writeFillRectPreclipped(x, y, 1, 1, rawcolor);
+      }
+
+      void writeFillRectPreclipped(uint_fast16_t x, uint_fast16_t y, uint_fast16_t w, uint_fast16_t h, uint32_t) override
+      {
+        int32_t rx = (int32_t)x - origin;
+        int32_t ry = (int32_t)y - origin;
+        if (rx < INT8_MIN || rx + (int32_t)w > INT8_MAX + 1 || ry < INT8_MIN || ry + (int32_t)h > INT8_MAX + 1)
+        {
+          _failed = true;
+          return;
+        }
+
+        // 行ごと(GLCDは列ごと)に出力される矩形のうち、隣接して同じ幅(高さ)のものは一つにまとめる;
+        for (size_t i = _count; i--;)
+        {
+          auto& r = _rects[i];
+          if (r.x == rx && r.w == w && r.y + r.h == ry && r.h + h <= UINT8_MAX)
+          {
+            r.h += h;
+            return;
+          }
+          if (r.y == ry && r.h == h && r.x + r.w == rx && r.w + w <= UINT8_MAX)
+          {
+            r.w += w;
+            return;
+          }
+        }
+        if (_count >= _limit)
+        {
+          _overflow = true;
+          return;
+        }
+        auto& r = _rects[_count++];
+        r.x = rx;
+        r.y = ry;
+        r.w = w;
+        r.h = h;
+      }
+
+      GlyphCache::rect_t* _rects;
+      size_t _limit;
+      size_t _count = 0;
+      bool _failed = false;
+      bool _overflow = false;
+    };
+
+    class LGFX_GlyphCapture : public LovyanGFX
+    {
+    public:
+      LGFX_GlyphCapture(GlyphCache::rect_t* rects, size_t limit)
+      : _panel_capture(rects, limit)
+      {
+        _panel = &_panel_capture;
+        setColorDepth(color_depth_t::rgb565_2Byte);
+        clearClipRect();
+      }
+      Panel_GlyphCapture _panel_capture;
+    };
+  }
+
+//----------------------------------------------------------------------------
+
+  void GlyphCache::clear(void)
+  {
+    _entry_count = 0;
+    _rect_used = 0;
+  }
+
+  void GlyphCache::release(void)
+  {
+    if (_rects) { heap_free(_rects); }
+    if (_entries) { heap_free(_entries); }
+    _rects = nullptr;
+    _entries = nullptr;
+    clear();
+  }
+
+  bool GlyphCache::drawChar(LGFXBase* gfx, const IFont* font, int32_t x, int32_t y, uint16_t uniCode, const TextStyle* style, const FontMetrics* metrics, size_t* x_advance)
+  {
+    // 背景の塗り潰しや拡大を伴う描画は前後の文字との位置関係に依存するため対象外とする;
+    if (style->fore_rgb888 != style->back_rgb888
+     || style->size_x != 1.0f || style->size_y != 1.0f)
+    {
+      return false;
+    }
+    switch (font->getType())
+    {
+    case IFont::font_type_t::ft_glcd:
+    case IFont::font_type_t::ft_bmp:
+    case IFont::font_type_t::ft_rle:
+    case IFont::font_type_t::ft_gfx:
+    case IFont::font_type_t::ft_u8g2:
+      break;
+    default:
+      return false;
+    }
+
+    if (_rects == nullptr)
+    {
+      if (_rect_capacity > UINT16_MAX) { _rect_capacity = UINT16_MAX; }
+      _rects = (rect_t*)heap_alloc(_rect_capacity * sizeof(rect_t));
+      _entries = (entry_t*)heap_alloc(_max_entries * sizeof(entry_t));
+      if (_rects == nullptr || _entries == nullptr)
+      {
+        release();
+        return false;
+      }
+    }
+
+    uint32_t code = uniCode | (style->cp437 ? 0x10000u : 0);
+    auto entry = _find(font, code, metrics);
+    if (entry)
+    {
+      ++_hit;
+    }
+    else
+    {
+      ++_miss;
+      entry = _capture(font, code, uniCode, style, metrics);
+      if (entry == nullptr) { return false; }
+    }
+    entry->last_used = ++_tick;
+    if (entry->count == uncacheable) { return false; }
+
+    auto rects = &_rects[entry->offset];
+    gfx->setRawColor(gfx->getColorConverter()->convert(style->fore_rgb888));
+    gfx->startWrite();
+    for (size_t i = 0; i < entry->count; ++i)
+    {
+      gfx->writeFillRect(x + rects[i].x, y + rects[i].y, rects[i].w, rects[i].h);
+    }
+    gfx->endWrite();
+    *x_advance = entry->x_advance;
+    return true;
+  }
+
+  GlyphCache::entry_t* GlyphCache::_find(const IFont* font, uint32_t code, const FontMetrics* metrics)
+  {
+    for (size_t i = 0; i < _entry_count; ++i)
+    {
+      auto& e = _entries[i];
+      if (e.code == code && e.font == font && e.height == metrics->height && e.y_offset == metrics->y_offset)
+      {
+        return &e;
+      }
+    }
+    return nullptr;
+  }
+
+  GlyphCache::entry_t* GlyphCache::_capture(const IFont* font, uint32_t code, uint16_t uniCode, const TextStyle* style, const FontMetrics* metrics)
+  {
+    if (_entry_count >= _max_entries) { _evict(nullptr); }
+
+    // 空き領域へ直接記録し、入りきらなければ古い文字を破棄して記録し直す;
+    size_t count = 0;
+    size_t advance = 0;
+    bool cacheable = false;
+    for (;;)
+    {
+      LGFX_GlyphCapture capture(&_rects[_rect_used], _rect_capacity - _rect_used);
+      auto m = *metrics;
+      int32_t filled_x = 0;
+      advance = font->drawChar(&capture, Panel_GlyphCapture::origin, Panel_GlyphCapture::origin, uniCode, style, &m, filled_x);
+      auto& panel = capture._panel_capture;
+      if (panel._failed || advance > INT16_MAX) { break; }
+      if (!panel._overflow)
+      {
+        count = panel._count;
+        cacheable = true;
+        break;
+      }
+
+      // 破棄済みの文字の領域が残っていれば詰め、無ければ最も長く使われていない文字を破棄する;
+      size_t used = _rect_used;
+      _compact();
+      if (_rect_used == used)
+      {
+        if (_entry_count == 0) { break; }
+        _evict(nullptr);
+      }
+    }
+
+    auto& e = _entries[_entry_count++];
+    e.font = font;
+    e.code = code;
+    e.height = metrics->height;
+    e.y_offset = metrics->y_offset;
+    e.x_advance = advance;
+    e.count = cacheable ? count : uncacheable;
+    e.offset = _rect_used;
+    if (cacheable) { _rect_used += count; }
+    return &e;
+  }
+
+  void GlyphCache::_evict(entry_t* entry)
+  {
+    if (entry == nullptr)
+    {
+      // 最も長く使われていない文字を選ぶ;
+      if (_entry_count == 0) { return; }
+      entry = _entries;
+      for (size_t i = 1; i < _entry_count; ++i)
+      {
+        if ((int32_t)(_entries[i].last_used - entry->last_used) < 0) { entry = &_entries[i]; }
+      }
+    }
+    *entry = _entries[--_entry_count];
+  }
+
+  void GlyphCache::_compact(void)
+  {
+    // 矩形の配置順に前へ詰める;
+    size_t pos = 0;
+    for (;;)
+    {
+      entry_t* next = nullptr;
+      for (size_t i = 0; i < _entry_count; ++i)
+      {
+        auto& e = _entries[i];
+        if (e.count == 0 || e.count == uncacheable || e.offset < pos) { continue; }
+        if (next == nullptr || e.offset < next->offset) { next = &e; }
+      }
+      if (next == nullptr) { break; }
+      if (next->offset != pos)
+      {
+        memmove(&_rects[pos], &_rects[next->offset], next->count * sizeof(rect_t));
+        next->offset = pos;
+      }
+      pos += next->count;
+    }
+    _rect_used = pos;
+  }
+
+//----------------------------------------------------------------------------
+ }
+}
@@ -0,0 +1,101 @@
+/*----------------------------------------------------------------------------/
+  Lovyan GFX - Graphics library for embedded devices.
+
+Original Source:
+ https://github.com/lovyan03/LovyanGFX/
+
+Licence:
+ [FreeBSD](https://github.com/lovyan03/LovyanGFX/blob/master/license.txt)
+
+Author:
+ [lovyan03](https://twitter.com/lovyan03)
+
+Contributors:
+ [ciniml](https://github.com/ciniml)
+ [mongonta0716](https://github.com/mongonta0716)
+ [tobozo](https://github.com/tobozo)
+/----------------------------------------------------------------------------*/
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace lgfx
+{
+ inline namespace v1
+ {
+//----------------------------------------------------------------------------
+
+  class LGFXBase;
+  struct IFont;
+  struct TextStyle;
+  struct FontMetrics;
+
+  /// 文字の前景を矩形の集まりとして記録し、同じ文字を再び描画する際にフォントデータの展開を省略するキャッシュ。;
+  /// 背景色を指定しない(透過)描画で、拡大率が1倍の場合に使用される。それ以外は通常の描画となる。;
+  /// 容量を超えた場合は最も長く使われていない文字から破棄する。;
+  /// 複数のLGFXから共有できるが、異なるタスクから同時に使用しないこと。;
+  class GlyphCache
+  {
+  public:
+    /// 1つの文字を構成する前景の矩形。座標は描画位置からの相対値;
+    struct rect_t
+    {
+      int8_t x;
+      int8_t y;
+      uint8_t w;
+      uint8_t h;
+    };
+
+    /// rect_capacity は全文字分の矩形の総数、max_entries は保持する文字数の上限。領域は初回の使用時に確保する;
+    GlyphCache(size_t rect_capacity = 1024, uint_fast16_t max_entries = 128)
+    : _rect_capacity(rect_capacity)
+    , _max_entries(max_entries)
+    {}
+    ~GlyphCache(void) { release(); }
+
+    /// 記録した文字を全て破棄する;
+    void clear(void);
+
+    /// 確保した領域を解放する;
+    void release(void);
+
+    /// キャッシュを使用して文字を描画する。キャッシュの対象外の場合は何もせずfalseを返す;
+    bool drawChar(LGFXBase* gfx, const IFont* font, int32_t x, int32_t y, uint16_t uniCode, const TextStyle* style, const FontMetrics* metrics, size_t* x_advance);
+
+    uint32_t getHitCount(void) const { return _hit; }
+    uint32_t getMissCount(void) const { return _miss; }
+
+  protected:
+    struct entry_t
+    {
+      const IFont* font;
+      uint32_t code;        // 文字コードと描画に影響するスタイルの組;
+      int16_t height;       // 対象外の文字の描画位置に影響するため、フォントの高さとオフセットも区別する;
+      int16_t y_offset;
+      int16_t x_advance;
+      uint16_t count;       // 矩形の数。キャッシュできない文字は uncacheable;
+      uint16_t offset;      // _rects 内の位置;
+      uint32_t last_used;
+    };
+    static constexpr uint16_t uncacheable = UINT16_MAX;
+
+    entry_t* _find(const IFont* font, uint32_t code, const FontMetrics* metrics);
+    entry_t* _capture(const IFont* font, uint32_t code, uint16_t uniCode, const TextStyle* style, const FontMetrics* metrics);
+    void _evict(entry_t* entry);
+    void _compact(void);
+
+    rect_t* _rects = nullptr;
+    entry_t* _entries = nullptr;
+    size_t _rect_capacity;
+    size_t _rect_used = 0;
+    uint_fast16_t _max_entries;
+    uint_fast16_t _entry_count = 0;
+    uint32_t _tick = 0;
+    uint32_t _hit = 0;
+    uint32_t _miss = 0;
+  };
+
+//----------------------------------------------------------------------------
+ }
+}
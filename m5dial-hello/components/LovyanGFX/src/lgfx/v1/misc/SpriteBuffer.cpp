@@ -105,6 +105,13 @@ namespace lgfx
     return *this;
   }
 
+  void SpriteBuffer::swap(SpriteBuffer& other)
+  {
+    std::swap(_buffer, other._buffer);
+    std::swap(_length, other._length);
+    std::swap(_source, other._source);
+  }
+
   void SpriteBuffer::reset(void* buffer)
   {
     this->release();
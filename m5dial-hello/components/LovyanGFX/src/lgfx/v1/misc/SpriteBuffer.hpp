@@ -75,6 +75,9 @@ namespace lgfx
 
     void release(void);
 
+    /// 確保済みの領域をコピーせずに交換する;
+    void swap(SpriteBuffer& other);
+
     bool use_dma(void) const { return _source == AllocationSource::Dma; }
     bool use_memcpy(void) const { return _source != AllocationSource::Psram; }
   };
@@ -0,0 +1,74 @@
+/*----------------------------------------------------------------------------/
+  Lovyan GFX - Graphics library for embedded devices.
+
+Original Source:
+ https://github.com/lovyan03/LovyanGFX/
+
+Licence:
+ [FreeBSD](https://github.com/lovyan03/LovyanGFX/blob/master/license.txt)
+
+Author:
+ [lovyan03](https://twitter.com/lovyan03)
+
+Contributors:
+ [ciniml](https://github.com/ciniml)
+ [mongonta0716](https://github.com/mongonta0716)
+ [tobozo](https://github.com/tobozo)
+/----------------------------------------------------------------------------*/
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace lgfx
+{
+ inline namespace v1
+ {
+//----------------------------------------------------------------------------
+
+  namespace round_span
+  {
+    template <size_t... I> struct index_list {};
+    template <size_t N, size_t... I> struct make_index_list : make_index_list<N - 1, N - 1, I...> {};
+    template <size_t... I> struct make_index_list<0, I...> { typedef index_list<I...> type; };
+
+    static constexpr uint32_t isqrt(uint32_t n, uint32_t lo = 0, uint32_t hi = 65536)
+    {
+      return (hi - lo <= 1) ? lo
+           : ((((lo + hi) >> 1) * ((lo + hi) >> 1) <= n) ? isqrt(n, (lo + hi) >> 1, hi) : isqrt(n, lo, (lo + hi) >> 1));
+    }
+
+    /// 中心からの距離(2倍値)。画素の中心ではなく画素の最も中心に近い辺で測る;
+    static constexpr uint32_t near_dist2(uint32_t size, uint32_t pos)
+    {
+      return (pos * 2 + 1 >= size)
+           ? ((pos * 2 + 1 - size) > 0 ? (pos * 2 + 1 - size) - 1 : 0)
+           : (size - pos * 2 - 1) - 1;
+    }
+
+    /// 直径sizeの円に一部でも掛かる画素のうち、y行目で最も左の画素のx座標;
+    static constexpr uint16_t left(uint32_t size, uint32_t y)
+    {
+      return (near_dist2(size, y) >= size) ? (size >> 1)
+           : ((size < 2 + isqrt(size * size - near_dist2(size, y) * near_dist2(size, y) - 1)) ? 0
+           : (size - 2 - isqrt(size * size - near_dist2(size, y) * near_dist2(size, y) - 1) + 1) >> 1);
+    }
+
+    template <uint16_t Size, typename T> struct table_impl;
+    template <uint16_t Size, size_t... I>
+    struct table_impl<Size, index_list<I...> >
+    {
+      static constexpr uint16_t value[Size] = { left(Size, I)... };
+    };
+    template <uint16_t Size, size_t... I>
+    constexpr uint16_t table_impl<Size, index_list<I...> >::value[Size];
+  }
+
+  /// 直径Sizeの円形パネルで表示される各行の左端x座標のテーブル。コンパイル時に生成される;
+  /// 円は左右対称のため、右端は (Size - 1 - left) となる;
+  template <uint16_t Size>
+  struct round_span_t : public round_span::table_impl<Size, typename round_span::make_index_list<Size>::type> {};
+
+//----------------------------------------------------------------------------
+ }
+}
@@ -24,6 +24,7 @@ Contributors:
 
 #include "Panel_LCD.hpp"
 #include "../Bus.hpp"
+#include "../misc/round_span.hpp"
 
 namespace lgfx
 {
@@ -94,6 +95,13 @@ namespace lgfx
       _nop_closing = false;
     }
 
+    /// 円形の表示部に合わせ、各行の見えない部分を転送しないようにする。Sizeは円の直径(パネルの幅と高さ);
+    template <uint16_t Size = 240>
+    void setRoundMask(bool enable = true)
+    {
+      setVisibleSpan(enable ? round_span_t<Size>::value : nullptr, Size);
+    }
+
   protected:
 
     const uint8_t* getInitCommands(uint8_t listno) const override
@@ -232,6 +240,7 @@ Contributors:
 
 #include "Panel_LCD.hpp"
 #include "../Bus.hpp"
+#include "../misc/round_span.hpp"
 
 namespace lgfx
 {
@@ -302,6 +311,13 @@ namespace lgfx
       _nop_closing = false;
     }
 
+    /// 円形の表示部に合わせ、各行の見えない部分を転送しないようにする。Sizeは円の直径(パネルの幅と高さ);
+    template <uint16_t Size = 240>
+    void setRoundMask(bool enable = true)
+    {
+      setVisibleSpan(enable ? round_span_t<Size>::value : nullptr, Size);
+    }
+
   protected:
 
     const uint8_t* getInitCommands(uint8_t listno) const override
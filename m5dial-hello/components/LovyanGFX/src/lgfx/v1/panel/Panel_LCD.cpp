@@ -284,6 +284,51 @@ namespace lgfx
   }
 
   void Panel_LCD::writeImage(uint_fast16_t x, uint_fast16_t y, uint_fast16_t w, uint_fast16_t h, pixelcopy_t* param, bool use_dma)
+  {
+    auto span = _visible_span;
+    if (span == nullptr)
+    {
+      write_image(x, y, w, h, param, use_dma);
+      return;
+    }
+
+    // 各行を表示範囲で切り詰め、範囲が同じ行が続く間は一つのウィンドウにまとめて転送する;
+    int_fast16_t rows = _visible_span_rows;
+    int_fast16_t xs = x;
+    int_fast16_t xe = x + w - 1;
+    int_fast16_t ye = y + h;
+    auto src_x32 = param->src_x32;
+    auto src_y32 = param->src_y32;
+    int_fast16_t gy = y;
+    int_fast16_t gl = 1;
+    int_fast16_t gr = 0;
+    for (int_fast16_t yy = y; yy <= ye; ++yy)
+    {
+      int_fast16_t l = xs;
+      int_fast16_t r = xe;
+      if (yy < rows)
+      {
+        int_fast16_t sl = span[yy];
+        int_fast16_t sr = rows - 1 - sl;
+        if (l < sl) { l = sl; }
+        if (r > sr) { r = sr; }
+      }
+      if (yy == ye || l > r) { l = 1; r = 0; }
+      if (l == gl && r == gr) { continue; }
+
+      if (gl <= gr)
+      {
+        param->src_x32 = src_x32 + (gl - xs) * param->src_x32_add;
+        param->src_y32 = src_y32 + (gl - xs) * param->src_y32_add + ((gy - y) << pixelcopy_t::FP_SCALE);
+        write_image(gl, gy, gr - gl + 1, yy - gy, param, use_dma);
+      }
+      gy = yy;
+      gl = l;
+      gr = r;
+    }
+  }
+
+  void Panel_LCD::write_image(uint_fast16_t x, uint_fast16_t y, uint_fast16_t w, uint_fast16_t h, pixelcopy_t* param, bool use_dma)
   {
     auto bytes = param->dst_bits >> 3;
     auto src_x = param->src_x;
@@ -55,8 +55,18 @@ namespace lgfx
 
     int32_t getScanLine(void) override;
 
+    /// 各行の表示範囲の左端x座標のテーブルを設定する。右端は左右対称として (rows - 1 - 左端) とする。;
+    /// 設定するとwriteImageは表示範囲外の画素を転送しない。円形パネル向け。nullptrで解除する。;
+    void setVisibleSpan(const uint16_t* left_table, uint16_t rows) { _visible_span = left_table; _visible_span_rows = rows; }
+    const uint16_t* getVisibleSpan(void) const { return _visible_span; }
+
   protected:
 
+    void write_image(uint_fast16_t x, uint_fast16_t y, uint_fast16_t w, uint_fast16_t h, pixelcopy_t* param, bool use_dma);
+
+    const uint16_t* _visible_span = nullptr;
+    uint16_t _visible_span_rows = 0;
+
     uint16_t _colstart = 0;
     uint16_t _rowstart = 0;
     bool _in_transaction = false;
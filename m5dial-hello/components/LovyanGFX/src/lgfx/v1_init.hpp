@@ -24,6 +24,9 @@ Contributors:
 #include "v1/lgfx_filesystem_support.hpp"
 #include "v1/LGFXBase.hpp"
 #include "v1/LGFX_Sprite.hpp"
+#include "v1/LGFX_Presenter.hpp"
+#include "v1/LGFX_DisplayList.hpp"
+#include "v1/LGFX_Layer.hpp"
 #include "v1/LGFX_Button.hpp"
 #include "v1/Light.hpp"
 
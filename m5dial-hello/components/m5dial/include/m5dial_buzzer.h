@@ -0,0 +1,57 @@
+/**
+ * M5Dial ブザー
+ *
+ * 音の要求をロックフリーのキューに積み、esp_timerのコールバックで順にLEDCを切り替えて鳴らす。
+ * 呼び出し側は待たされないため、効果音の再生中も入力処理や描画が止まらない。
+ * 複数のタスクから同時に呼び出してよい (ISRからは不可)。
+ *
+ * ESP-IDF以外 (ESP_PLATFORMが未定義) でビルドした場合はモックで動作する。
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// デューティ (LEDC 10ビット, 1023 = 100%)
+#define BUZZER_DUTY_HALF    512
+#define BUZZER_DUTY_QUARTER 256
+
+// キューに積める要求の数 (2のべき乗)
+#define BUZZER_QUEUE_LENGTH 32
+
+// 音1つ。freq = 0 は休符
+struct buzzer_tone_t {
+    uint16_t freq;         // 周波数 (Hz)
+    uint16_t duration_ms;  // 長さ (ms)
+    uint16_t duty;         // デューティ (0〜1023)
+};
+
+// LEDC (LOW_SPEED, TIMER_0, CHANNEL_0) と再生用タイマーを初期化
+void buzzer_init(int gpio_num);
+
+// 音を1つ再生キューに追加する。キューが一杯の場合はfalse
+bool buzzer_tone(uint32_t freq, uint32_t duration_ms, uint32_t duty = BUZZER_DUTY_HALF);
+
+// 従来の短いビープ音 (50%デューティ)
+static inline bool buzzer_beep(uint32_t freq, uint32_t duration_ms) {
+    return buzzer_tone(freq, duration_ms, BUZZER_DUTY_HALF);
+}
+
+// 音の列を再生キューに追加する。列はキュー内で1要素として扱われ、他の要求と混ざらない
+// tonesは再生が終わるまで参照されるため、静的な配列を渡すこと
+bool buzzer_play(const buzzer_tone_t* tones, size_t count);
+
+// 再生中の音と、それまでにキューに積まれた内容を破棄して無音にする
+// 戻った後に積んだ音は破棄されない
+void buzzer_stop();
+
+// 再生中またはキューに音が残っている場合true
+bool buzzer_is_busy();
+
+#ifndef ESP_PLATFORM
+// モック: 時刻を us だけ進め、その間に終わる音を次へ切り替える
+void buzzer_mock_advance(uint32_t us);
+
+// モック: 鳴っている周波数 (無音は0)
+uint32_t buzzer_mock_freq();
+#endif
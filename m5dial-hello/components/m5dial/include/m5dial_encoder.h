@@ -0,0 +1,60 @@
+/**
+ * M5Dial ロータリーエンコーダー
+ *
+ * パルスカウンタ (PCNT) の1ユニットで直交デコード (4逓倍) を行う。A相・B相の各エッジは
+ * ハードウェアだけで数えるため、回転中もエッジごとのCPU処理は発生しない。
+ * 短いノイズはPCNTのグリッチフィルタで除く。
+ *
+ * 回した量は上下限を広くしたPCNTのユニットで数え (上下限で0に戻る分はドライバが積算)、
+ * これを正とする。もう1つのユニットは同じ入力を ±1デテント (±ENCODER_COUNTS_PER_DETENT) で
+ * 0に戻るように数え、上下限に達するたび (= デテントの境目ごと) に割り込む。割り込みは
+ * 回した量を読んでデテント数を進める。割り込みは1クリックに1回だけで、デテントの間で
+ * 行き来してもデテント数は増減しない。割り込みが遅れて複数のデテントの事象が1回に
+ * まとまっても、回した量から求めるのでデテントは失われない。
+ * 割り込みはIRAMに置き、フラッシュへの書き込み (OTA) の間も遅れないようにする
+ * (アプリの sdkconfig.defaults で CONFIG_PCNT_ISR_IRAM_SAFE と CONFIG_PCNT_CTRL_FUNC_IN_IRAM を有効にする)。
+ *
+ * ESP-IDF以外 (ESP_PLATFORMが未定義) でビルドした場合はPCNTの代わりにモックで動作し、
+ * encoder_mock_turn() で回転を与えられる。
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// 1デテント (1クリック) あたりのカウント (A相・B相の両エッジ)
+#define ENCODER_COUNTS_PER_DETENT 4
+
+// グリッチフィルタ: これより短いパルスを無視する (最大 約12us)
+#define ENCODER_GLITCH_NS 1000
+
+// デテントが変わるたびに割り込みから呼ばれる。step は +1 (時計回り) または -1
+// 割り込みが遅れた場合は1回の割り込みから続けて複数回呼ばれる
+// IRAMに置き (キャッシュ無効の間も呼ばれる)、キューへの投入やタスクの通知程度の処理にすること
+// 優先度の高いタスクを起こした場合はtrueを返す
+typedef bool (*encoder_callback_t)(int step, void* arg);
+
+// A相・B相のGPIOでPCNTを初期化して計数を開始する (プルアップ有効)
+bool encoder_init(int gpio_a, int gpio_b);
+
+// 起動 (または encoder_reset()) からのデテント数。時計回りが正
+int32_t encoder_detents();
+
+// デテント数を0に戻す。デテントの途中まで回した分も捨てる (ISRからは不可)
+void encoder_reset();
+
+// デテントの変化の通知先を設定する (nullptrで解除)
+// 回転中に差し替えると、その直後の1回だけ古い関数が新しい arg で呼ばれることがある
+void encoder_set_callback(encoder_callback_t callback, void* arg);
+
+#ifndef ESP_PLATFORM
+// モック: counts だけ回す (4で1デテント、負で反時計回り)。PCNTと同じく1カウントずつ進める
+void encoder_mock_turn(int counts);
+
+// モック: デテント未満の端数 (±1デテントで0に戻るユニットのカウンタ値に相当)
+int encoder_mock_count();
+
+// モック: trueの間は割り込みを止める (キャッシュ無効の間のように)。PCNTと同じく、その間に起きた
+// 上下限の事象は上限・下限ごとに1つにまとまって保留され、falseにした時に処理される
+void encoder_mock_hold_isr(bool hold);
+#endif
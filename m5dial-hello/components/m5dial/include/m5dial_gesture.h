@@ -0,0 +1,59 @@
+/**
+ * M5Dial タッチのジェスチャー認識
+ *
+ * タッチパネルの読み取り (時刻・触れているか・位置) を順に与えると、タップ・スワイプ・
+ * 外周に沿ったドラッグを入力イベントとして返す。ハードウェアにもタスクにも依存しないため、
+ * Linux上で記録したタッチの列を再生して確かめられる (tools/touch_gesture_replay.cpp)。
+ *
+ * - タップ: 触れてから tap_max_us 以内に、tap_max_move 以上動かさずに離した
+ * - スワイプ: 触れてから swipe_max_us 以内に swipe_min_move 以上動かして離した。
+ *   向きは大きく動いた軸で決める
+ * - 外周のドラッグ: 中心から ring_radius 以上離れた所で触れ、円周に沿って動かした。
+ *   ring_step_deg 回るたびに1件 (時計回り +1)。1件でも出した後は、離してもタップや
+ *   スワイプにしない
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "m5dial_input.h"
+
+// 1回の読み取りで返す事象の最大数
+#define GESTURE_MAX_EVENTS 4
+
+struct gesture_config_t {
+    int16_t center_x;       // 外周のドラッグの中心 (画面の座標)
+    int16_t center_y;
+    uint16_t ring_radius;   // これより外側で触れた場合は外周のドラッグとして扱う
+    uint16_t ring_step_deg; // 外周のドラッグ1件あたりの角度
+    uint16_t tap_max_move;  // タップとみなす最大の移動 (px)
+    uint16_t swipe_min_move;
+    uint32_t tap_max_us;
+    uint32_t swipe_max_us;
+};
+
+// M5Dial (240x240の円形画面、回転0) の既定値
+#define GESTURE_CONFIG_M5DIAL gesture_config_t{ 120, 120, 80, 15, 12, 40, 300000, 500000 }
+
+// 認識の途中の状態 (gesture_reset() で初期化する)
+struct gesture_state_t {
+    bool down;
+    bool ring;       // 外周で触れた
+    bool moved;      // tap_max_move より大きく動いた
+    bool dragged;    // 外周のドラッグを1件以上出した
+    bool has_angle;  // angle が有効 (中心に近い間は角度を測らない)
+    int64_t down_us;
+    int16_t start_x;
+    int16_t start_y;
+    int16_t x;
+    int16_t y;
+    int32_t angle;   // 直前の角度 (0.1度、右が0で時計回り)
+    int32_t turn;    // まだ事象にしていない回転 (0.1度)
+};
+
+void gesture_reset(gesture_state_t* state);
+
+// 読み取りを1件与え、認識した事象を out (GESTURE_MAX_EVENTS件分) に書いて件数を返す
+// touching が false の場合 x, y は使わない (離した位置は直前の読み取りの位置とする)
+int gesture_feed(gesture_state_t* state, const gesture_config_t& config,
+                 int64_t time_us, bool touching, int16_t x, int16_t y, input_event_t* out);
@@ -0,0 +1,115 @@
+/**
+ * M5Dial 入力イベントキュー
+ *
+ * エンコーダーのデテントとボタンの押下・解放を、割り込みの時点のタイムスタンプ (us) 付きで
+ * 単一生産者・単一消費者のリングに積む。アプリは input_read() で待つか、まとめて取り出して
+ * 1件ずつ処理するため、ポーリングの間に起きた回転や短い押下も失われず、まとまりもしない。
+ *
+ * 生産者はエンコーダー (PCNT)、ボタンとタッチパネルのINT (GPIO) の割り込みで、いずれも
+ * input_init() を呼んだタスクのコアに割り当てる。消費者は input_init() を呼んだタスクで、
+ * そのタスクだけが input_read() を呼ぶこと。長押しは消費側で押下から long_press_ms 後の時刻で生成する。
+ *
+ * デテントには割り込みの時刻から求めた回転速度を付ける (同じ向きの直近 INPUT_VELOCITY_WINDOW
+ * デテントの平均)。処理側のループが遅れても速度は変わらない。input_accel_step() で
+ * 速度に応じた加速曲線をかけ、速く回すと大きく、ゆっくり回すと1ずつ変えられる。
+ *
+ * タッチパネルは input_touch_init() で加える。INT (触れている間Low) の変化を割り込みで積み、
+ * 消費側は触れている間だけ INPUT_TOUCH_POLL_US ごとにI2Cで位置を読んでジェスチャーを認識する
+ * (m5dial_gesture.h)。離したことはINTの変化で分かるので、触れていない間はI2Cを使わない。
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// キューの長さ (2のべき乗)。あふれた事象は捨てて input_overflows() で数える
+#define INPUT_QUEUE_LENGTH 64
+
+// ボタンのチャタリング除去: 受け付けた変化からこの時間内の変化を無視する
+// (この時間が終わった時点でボタンを読み直し、状態が違えばその変化を返す)
+#define INPUT_DEBOUNCE_US 5000
+
+// 回転速度を求めるデテントの数と、速度の計測をやり直す間隔
+#define INPUT_VELOCITY_WINDOW 4
+#define INPUT_VELOCITY_GAP_US 250000
+
+// 触れている間にタッチパネルの位置を読む間隔
+#define INPUT_TOUCH_POLL_US 16000
+
+#define INPUT_WAIT_FOREVER UINT32_MAX
+
+enum input_event_type_t {
+    INPUT_DETENT = 0,   // value: +1 (時計回り) または -1
+    INPUT_PRESS,        // ボタンを押した
+    INPUT_RELEASE,      // ボタンを離した。value: 長押しにならずに離した場合1
+    INPUT_LONG_PRESS,   // 押したまま long_press_ms 経った (時刻は押下 + long_press_ms)
+    INPUT_TAP,          // タッチ: タップ (時刻は離した時)。x, y: 触れた位置
+    INPUT_SWIPE,        // タッチ: スワイプ (時刻は離した時)。value: input_swipe_t。x, y: 触れ始めた位置
+    INPUT_RING,         // タッチ: 外周に沿ったドラッグ。value: +1 (時計回り) または -1。x, y: 位置
+};
+
+enum input_swipe_t {
+    INPUT_SWIPE_RIGHT = 0,
+    INPUT_SWIPE_DOWN,
+    INPUT_SWIPE_LEFT,
+    INPUT_SWIPE_UP,
+};
+
+struct input_event_t {
+    int64_t time_us;  // 割り込みの時刻 (esp_timer_get_time())
+    uint8_t type;     // input_event_type_t
+    int8_t value;
+    uint16_t speed;   // INPUT_DETENT: 回転速度 (デテント/秒)。回し始めは0
+    int16_t x;        // タッチの事象: 画面の座標
+    int16_t y;
+};
+
+// 加速曲線: 速度が min_speed 以下なら1、max_speed 以上なら max_step、その間は
+// (速度の割合)^shape で1から max_step まで増える (shape 1: 直線, 2: 二次曲線)
+struct input_accel_t {
+    uint16_t min_speed;  // デテント/秒
+    uint16_t max_speed;  // デテント/秒
+    uint8_t max_step;
+    uint8_t shape;
+};
+
+// 加速しない (1デテント = 1ステップ)
+#define INPUT_ACCEL_NONE input_accel_t{ 0, 0, 1, 1 }
+
+// ボタンの割り込みとエンコーダーの通知先を設定し、呼び出したタスクを消費者にする
+// encoder_init() の後に呼ぶこと
+bool input_init(int button_gpio, uint32_t long_press_ms);
+
+// タッチパネルの位置を読む (消費者のタスクから呼ばれる)。触れていれば x, y に書いてtrueを返す
+typedef bool (*input_touch_read_t)(int16_t* x, int16_t* y, void* arg);
+
+struct gesture_config_t;
+
+// タッチパネルのINTの割り込みを設定し、ジェスチャーを入力イベントにする
+// input_init() と、タッチパネルの初期化 (LovyanGFXでは display.init()) の後に呼ぶこと
+bool input_touch_init(int int_gpio, input_touch_read_t read, void* arg, const gesture_config_t& config);
+
+// 事象を最大 max 件、古い順に out へ取り出して件数を返す
+// 1件も無ければ timeout_ms まで待つ (0なら待たない)。待つのは消費者のタスクのみ
+size_t input_read(input_event_t* out, size_t max, uint32_t timeout_ms);
+
+// デテントの事象 ev に加速曲線をかけたステップ数 (符号付き) を返す
+int input_accel_step(const input_event_t& ev, const input_accel_t& accel);
+
+// 取り出した事象の上で、長押しになってからまだ離していない場合true
+bool input_button_held();
+
+// キューがあふれて捨てた事象の数
+uint32_t input_overflows();
+
+#ifndef ESP_PLATFORM
+// モック: 現在時刻を設定する (以降の事象のタイムスタンプと長押しの判定に使う)
+void input_mock_set_time(int64_t time_us);
+
+// モック: ボタンの状態を変える (割り込みと同じくチャタリング除去を通る。読み直しはこの状態を読む)
+void input_mock_button(bool pressed);
+
+// モック: タッチパネルのINTを変える (位置は input_touch_init() の read で読む)
+void input_mock_touch(bool touching);
+#endif
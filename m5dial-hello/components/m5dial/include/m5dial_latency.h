@@ -0,0 +1,45 @@
+/**
+ * M5Dial 入力から表示までの遅延の集計
+ *
+ * 入力の割り込みの時刻から、その入力を反映したフレームの転送完了までの時間をヒストグラムに
+ * 記録し、p50/p95/p99 を求める。バケットは2のべき乗ごとに8分割した対数目盛 (誤差12.5%以内) で、
+ * 16us未満は1us単位。記録と読み出しは別のタスクから行ってよい (ISRからは不可)。
+ *
+ * 計測はアプリのビルドフラグで有効にする。使わない場合は関数が参照されずリンクされない。
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+#define LATENCY_BUCKETS (16 + 21 * 8)  // 16us未満 + 16us〜約33秒
+
+struct latency_hist_t {
+    std::atomic<uint32_t> buckets[LATENCY_BUCKETS];
+    std::atomic<uint32_t> count;
+    std::atomic<uint32_t> max_us;
+};
+
+// 遅延を1件記録する
+void latency_record(latency_hist_t* hist, uint32_t latency_us);
+
+// 記録した遅延の permille/1000 の位置の値 (バケットの上限, us)。記録が無ければ0
+uint32_t latency_percentile(const latency_hist_t* hist, uint32_t permille);
+
+// 記録を消す
+void latency_reset(latency_hist_t* hist);
+
+// "name: N件 p50 ... p95 ... p99 ... 最大 ... us" の1行を書き、書いた長さを返す
+int latency_format(const latency_hist_t* hist, const char* name, char* buf, size_t size);
+
+// 割り込みの時刻 (esp_timer_get_time()) を受け渡し用の32ビットの印にする (0は「入力なし」)
+static inline uint32_t latency_tag(int64_t time_us) {
+    uint32_t tag = (uint32_t)time_us;
+    return tag ? tag : 1;
+}
+
+// 印を付けた時刻から now_us までの遅延 (32ビットで折り返しても正しい)
+static inline uint32_t latency_since(uint32_t tag, int64_t now_us) {
+    return (uint32_t)now_us - tag;
+}
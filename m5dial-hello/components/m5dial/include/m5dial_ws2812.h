@@ -0,0 +1,61 @@
+/**
+ * M5Dial WS2812 LEDストリップ出力
+ *
+ * 画素バッファを2面持ち、一方をRMT (DMA) で送信している間にもう一方へ次のフレームを書き込む。
+ * ws2812_submit() は送信を開始してすぐに戻り、前回と同じ内容のフレームは送信しない。
+ * 画素の書き込みと送信は同じタスクから行うこと。
+ *
+ * 複数のストリップ (それぞれ別のGPIOとRMTチャネル) をまとめて1本の論理ストリップとして扱える。
+ * 論理画素の番号は対応表で各ストリップの画素に変換され、送信は全ストリップで同時に行うため、
+ * 1フレームの送信時間は合計ではなく最も長いストリップの時間になる。
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// 同時に使えるストリップの最大数 (ESP32-S3のRMT送信チャネル数)
+#define WS2812_MAX_STRIPS 4
+
+struct ws2812_strip_config_t {
+    int gpio_num;     // データ出力のGPIO
+    uint16_t length;  // LED数
+};
+
+// 複数のストリップを初期化する
+// 論理画素は最初はストリップの順に連結した並び (0番のストリップの先頭から) に対応する
+// 初期化済みの場合は解放してから初期化し直す
+// DMAは長いストリップから順に割り当て、使えない場合は割り込みによる送信で動作する
+bool ws2812_init_strips(const ws2812_strip_config_t* strips, size_t count);
+
+// 1本のストリップで初期化する (論理画素 = ストリップの画素)
+bool ws2812_init(int gpio_num, uint16_t max_leds);
+
+// 全ストリップの送信を止めてチャネルとバッファを解放する (LED数を変えて初期化し直す場合など)
+void ws2812_deinit();
+
+// 論理画素の数 (全ストリップのLED数の合計)
+uint16_t ws2812_logical_count();
+
+// 論理画素 logical_start から count 個を、strip番のストリップの strip_start 番目以降に対応付ける
+// reverse = true の場合はストリップ上で逆順に並べる (折り返し配線用)
+// 対応を変えると書き込み側のバッファは消灯状態になるので、次のフレームを全て描き直すこと
+bool ws2812_map(uint16_t logical_start, uint16_t count, int strip, uint16_t strip_start, bool reverse);
+
+// 論理画素 logical_start から count 個をどのLEDにも出力しないようにする
+void ws2812_unmap(uint16_t logical_start, uint16_t count);
+
+// 書き込み側のバッファの論理画素を設定 (送信は ws2812_submit() まで行われない)
+void ws2812_set_pixel(uint16_t index, uint8_t r, uint8_t g, uint8_t b);
+
+// 書き込み側のバッファを全て消灯にする
+void ws2812_clear();
+
+// 書き込み側のバッファの送信を開始する。前回の送信が終わっていなければ完了を待つ
+// 前回送信した内容と同じストリップは送信せず、全て同じ場合はfalseを返す
+// 送信後も書き込み側のバッファには送信した内容が残るため、変わった画素だけを書き換えればよい
+bool ws2812_submit();
+
+// 送信中のフレームの完了を待つ
+void ws2812_wait();
@@ -0,0 +1,316 @@
+/**
+ * M5Dial ブザー
+ *
+ * キューは要素ごとに順番号を持つ有界MPMCリング (Vyukov方式)。
+ * 取り出すのはesp_timerのコールバックのみで、各音の長さだけタイマーを再設定して次の要素へ進む。
+ *
+ * buzzer_stop() は呼んだ時点のキューの書き込み位置を区切りとして記録し、コールバックは
+ * 区切りより前に積まれた要素だけを捨てる。停止の直後に積んだ音は停止の処理が後から
+ * 別のタスクで動いても消えない。
+ *
+ * ESP-IDF以外 (ESP_PLATFORMが未定義) でビルドした場合はLEDCとesp_timerの代わりにモックで動作し、
+ * buzzer_mock_advance() で時刻を進める。
+ */
+#include "m5dial_buzzer.h"
+
+#include <atomic>
+
+#ifdef ESP_PLATFORM
+#include "driver/ledc.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+
+static const char *TAG = "buzzer";
+#endif
+
+namespace {
+
+// キューの要素。tonesがnullptrの場合は単音tone、それ以外は音の列
+struct request_t {
+    const buzzer_tone_t* tones;
+    uint16_t count;
+    buzzer_tone_t tone;
+};
+
+struct slot_t {
+    std::atomic<uint32_t> seq;
+    request_t req;
+};
+
+slot_t queue[BUZZER_QUEUE_LENGTH];
+std::atomic<uint32_t> enqueue_pos(0);
+std::atomic<uint32_t> dequeue_pos(0);
+
+std::atomic<bool> running(false);        // タイマーが動作中 (再生中) の間true
+std::atomic<bool> stop_request(false);
+std::atomic<uint32_t> stop_pos(0);       // 最後の buzzer_stop() の時点の enqueue_pos。これより前を捨てる
+
+// 再生中の要素とそのキュー内の位置、列内の位置 (タイマーのコールバックからのみ使用)
+request_t current = {};
+uint32_t current_pos = 0;
+uint16_t current_index = 0;
+bool has_current = false;
+
+#ifdef ESP_PLATFORM
+
+esp_timer_handle_t timer = nullptr;
+
+bool timer_ready() {
+    return timer != nullptr;
+}
+
+void timer_start(uint64_t us) {
+    esp_timer_start_once(timer, us);
+}
+
+void timer_stop() {
+    esp_timer_stop(timer);
+}
+
+void output(uint32_t freq, uint32_t duty) {
+    if (freq == 0 || duty == 0) {
+        ledc_set_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0, 0);
+    } else {
+        ledc_set_freq(LEDC_LOW_SPEED_MODE, LEDC_TIMER_0, freq);
+        ledc_set_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0, duty);
+    }
+    ledc_update_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0);
+}
+
+#else
+
+bool mock_ready = false;
+int64_t mock_now_us = 0;
+int64_t mock_deadline_us = -1;  // タイマーの満了時刻 (-1: 停止中)
+uint32_t mock_freq = 0;
+
+bool timer_ready() {
+    return mock_ready;
+}
+
+void timer_start(uint64_t us) {
+    mock_deadline_us = mock_now_us + (int64_t)us;
+}
+
+void timer_stop() {
+    mock_deadline_us = -1;
+}
+
+void output(uint32_t freq, uint32_t duty) {
+    mock_freq = duty ? freq : 0;
+}
+
+#endif
+
+bool queue_push(const request_t& req) {
+    uint32_t pos = enqueue_pos.load(std::memory_order_relaxed);
+    for (;;) {
+        slot_t& slot = queue[pos & (BUZZER_QUEUE_LENGTH - 1)];
+        uint32_t seq = slot.seq.load(std::memory_order_acquire);
+        int32_t diff = (int32_t)(seq - pos);
+        if (diff == 0) {
+            if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                slot.req = req;
+                slot.seq.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (diff < 0) {
+            return false;  // 一杯
+        } else {
+            pos = enqueue_pos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+// 先頭の要素を取り出し、その位置を *req_pos に書く
+bool queue_pop(request_t* req, uint32_t* req_pos) {
+    uint32_t pos = dequeue_pos.load(std::memory_order_relaxed);
+    for (;;) {
+        slot_t& slot = queue[pos & (BUZZER_QUEUE_LENGTH - 1)];
+        uint32_t seq = slot.seq.load(std::memory_order_acquire);
+        int32_t diff = (int32_t)(seq - (pos + 1));
+        if (diff == 0) {
+            if (dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                *req = slot.req;
+                *req_pos = pos;
+                slot.seq.store(pos + BUZZER_QUEUE_LENGTH, std::memory_order_release);
+                return true;
+            }
+        } else if (diff < 0) {
+            return false;  // 空
+        } else {
+            pos = dequeue_pos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool queue_empty() {
+    return enqueue_pos.load(std::memory_order_acquire) == dequeue_pos.load(std::memory_order_acquire);
+}
+
+// pos が最後の buzzer_stop() より前に積まれた位置ならtrue
+bool before_stop(uint32_t pos) {
+    return (int32_t)(pos - stop_pos.load(std::memory_order_acquire)) < 0;
+}
+
+// 止まっているタイマーを起動する。起動できるのはrunningをfalseからtrueにした1者のみ
+void kick() {
+    if (!running.exchange(true)) {
+        timer_start(1);
+    }
+}
+
+// 前の音が終わった時点で呼ばれ、次の音を鳴らしてその長さだけタイマーを設定する
+void timer_callback(void*) {
+    if (stop_request.exchange(false)) {
+        // 停止より前に積まれた要素だけを捨てる (停止の後に積まれた要素は残す)
+        if (has_current && before_stop(current_pos)) {
+            has_current = false;
+        }
+        while (!has_current && before_stop(dequeue_pos.load(std::memory_order_relaxed)) && queue_pop(&current, &current_pos)) {
+            current_index = 0;
+            has_current = current.count > 0 && !before_stop(current_pos);
+        }
+    }
+
+    for (;;) {
+        if (has_current) {
+            const buzzer_tone_t& t = current.tones ? current.tones[current_index] : current.tone;
+            if (++current_index >= current.count) {
+                has_current = false;
+            }
+            if (t.duration_ms == 0) {
+                continue;
+            }
+            output(t.freq, t.duty);
+            timer_start((uint64_t)t.duration_ms * 1000);
+            return;
+        }
+        if (!queue_pop(&current, &current_pos)) {
+            break;
+        }
+        current_index = 0;
+        has_current = current.count > 0;
+    }
+
+    // 再生するものが無いので停止する
+    // 停止と同時に積まれた要求を取りこぼさないよう、停止後にキューを確認し直す
+    output(0, 0);
+    running.store(false);
+    if (!queue_empty() || stop_request.load()) {
+        kick();
+    }
+}
+
+}  // namespace
+
+void buzzer_init(int gpio_num) {
+    for (uint32_t i = 0; i < BUZZER_QUEUE_LENGTH; i++) {
+        queue[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+#ifdef ESP_PLATFORM
+    ledc_timer_config_t timer_conf = {
+        .speed_mode = LEDC_LOW_SPEED_MODE,
+        .duty_resolution = LEDC_TIMER_10_BIT,
+        .timer_num = LEDC_TIMER_0,
+        .freq_hz = 4000,
+        .clk_cfg = LEDC_AUTO_CLK
+    };
+    ledc_timer_config(&timer_conf);
+
+    ledc_channel_config_t channel_conf = {
+        .gpio_num = gpio_num,
+        .speed_mode = LEDC_LOW_SPEED_MODE,
+        .channel = LEDC_CHANNEL_0,
+        .intr_type = LEDC_INTR_DISABLE,
+        .timer_sel = LEDC_TIMER_0,
+        .duty = 0,
+        .hpoint = 0,
+        .flags = {0}
+    };
+    ledc_channel_config(&channel_conf);
+
+    esp_timer_create_args_t timer_args = {
+        .callback = timer_callback,
+        .arg = nullptr,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "buzzer",
+        .skip_unhandled_events = false
+    };
+    if (esp_timer_create(&timer_args, &timer) != ESP_OK) {
+        ESP_LOGE(TAG, "タイマー作成失敗");
+    }
+#else
+    (void)gpio_num;
+    mock_ready = true;
+#endif
+}
+
+bool buzzer_tone(uint32_t freq, uint32_t duration_ms, uint32_t duty) {
+    request_t req = {};
+    req.count = 1;
+    req.tone.freq = (uint16_t)freq;
+    req.tone.duration_ms = (uint16_t)(duration_ms > UINT16_MAX ? UINT16_MAX : duration_ms);
+    req.tone.duty = (uint16_t)duty;
+    if (!timer_ready() || !queue_push(req)) {
+        return false;
+    }
+    kick();
+    return true;
+}
+
+bool buzzer_play(const buzzer_tone_t* tones, size_t count) {
+    if (count == 0) {
+        return true;
+    }
+    request_t req = {};
+    req.tones = tones;
+    req.count = (uint16_t)count;
+    if (!timer_ready() || !queue_push(req)) {
+        return false;
+    }
+    kick();
+    return true;
+}
+
+void buzzer_stop() {
+    if (!timer_ready()) {
+        return;
+    }
+    // 区切りは後退させない (同時に呼ばれた場合は後の位置を使う)
+    uint32_t pos = enqueue_pos.load(std::memory_order_acquire);
+    uint32_t prev = stop_pos.load(std::memory_order_relaxed);
+    while ((int32_t)(pos - prev) > 0 && !stop_pos.compare_exchange_weak(prev, pos, std::memory_order_release)) {
+    }
+    stop_request.store(true);
+    // 再生中なら現在の音を打ち切り、すぐにコールバックで破棄させる
+    if (running.load()) {
+        timer_stop();
+        timer_start(1);
+    } else {
+        kick();
+    }
+}
+
+bool buzzer_is_busy() {
+    return running.load() || !queue_empty();
+}
+
+#ifndef ESP_PLATFORM
+
+void buzzer_mock_advance(uint32_t us) {
+    int64_t end = mock_now_us + us;
+    while (mock_deadline_us >= 0 && mock_deadline_us <= end) {
+        mock_now_us = mock_deadline_us;
+        mock_deadline_us = -1;
+        timer_callback(nullptr);
+    }
+    mock_now_us = end;
+}
+
+uint32_t buzzer_mock_freq() {
+    return mock_freq;
+}
+
+#endif
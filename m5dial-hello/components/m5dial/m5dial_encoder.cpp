@@ -0,0 +1,271 @@
+/**
+ * M5Dial ロータリーエンコーダー
+ *
+ * PCNTの2チャネルで4逓倍の直交デコードを行う。
+ *   チャネルA: A相のエッジで数え、B相のレベルで向きを反転
+ *   チャネルB: B相のエッジで数え、A相のレベルで向きを反転
+ * 同じA相・B相を2つのユニットで数える。
+ *   total_unit:  回した量。上下限を広くし、上下限で0に戻る分はドライバが積算する (accum_count)
+ *   detent_unit: 上下限 ±1デテントで0に戻り、そのウォッチポイントでデテントの境目ごとに割り込む
+ * 割り込みは total_unit のカウントを読み、最後にデテントを数えた位置から1デテント離れるたびに
+ * detent_count を進める。割り込みが遅れて detent_unit の事象が1つにまとまっても、回した量は
+ * total_unit が数えているのでデテントは失われない (遅れた分はまとめて通知する)。
+ * PCNTの代わりのモックも同じ2つのカウンタと保留される事象を再現し、同じ経路でデテントを数える。
+ */
+#include "m5dial_encoder.h"
+
+#include <atomic>
+
+#ifdef ESP_PLATFORM
+#include "driver/pulse_cnt.h"
+#include "driver/gpio.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+
+static const char *TAG = "encoder";
+#else
+#define IRAM_ATTR
+#endif
+
+namespace {
+
+// total_unit の上下限 (int16の範囲に収まるデテントの倍数)
+constexpr int TOTAL_LIMIT = (INT16_MAX / ENCODER_COUNTS_PER_DETENT) * ENCODER_COUNTS_PER_DETENT;
+
+std::atomic<int32_t> detent_count(0);  // 起動からのデテント数 (割り込みからのみ書き込む)
+int32_t detent_base = 0;               // encoder_reset() 時点のデテント数
+int detent_pos = 0;                    // 最後にデテントを数えた時の回した量 (割り込みからのみ書き込む)
+std::atomic<encoder_callback_t> callback(nullptr);
+void* callback_arg = nullptr;
+
+bool IRAM_ATTR detent_step(int step) {
+    detent_count.fetch_add(step, std::memory_order_relaxed);
+    encoder_callback_t cb = callback.load(std::memory_order_acquire);
+    return cb ? cb(step, callback_arg) : false;
+}
+
+// 回した量 total が最後にデテントを数えた位置から1デテント以上離れた分だけデテントを進める
+// 戻る向きも1デテント離れるまで数えないため、境目での行き来は1回しか数えない
+bool IRAM_ATTR total_reached(int total) {
+    bool woken = false;
+    while (total - detent_pos >= ENCODER_COUNTS_PER_DETENT) {
+        detent_pos += ENCODER_COUNTS_PER_DETENT;
+        woken |= detent_step(1);
+    }
+    while (detent_pos - total >= ENCODER_COUNTS_PER_DETENT) {
+        detent_pos -= ENCODER_COUNTS_PER_DETENT;
+        woken |= detent_step(-1);
+    }
+    return woken;
+}
+
+#ifdef ESP_PLATFORM
+
+pcnt_unit_handle_t total_unit = nullptr;
+pcnt_unit_handle_t detent_unit = nullptr;
+
+// detent_unit が上限または下限に達した: デテントの境目を越えた (遅れた場合は複数のこともある)
+bool IRAM_ATTR on_reach(pcnt_unit_handle_t, const pcnt_watch_event_data_t*, void*) {
+    int total = 0;
+    pcnt_unit_get_count(total_unit, &total);  // IRAMに置く (CONFIG_PCNT_CTRL_FUNC_IN_IRAM)
+    return total_reached(total);
+}
+
+esp_err_t add_channel(pcnt_unit_handle_t unit, int edge_gpio, int level_gpio, pcnt_channel_edge_action_t on_rise, pcnt_channel_edge_action_t on_fall) {
+    pcnt_chan_config_t config = {};
+    config.edge_gpio_num = edge_gpio;
+    config.level_gpio_num = level_gpio;
+    pcnt_channel_handle_t chan;
+    esp_err_t err = pcnt_new_channel(unit, &config, &chan);
+    if (err != ESP_OK) {
+        return err;
+    }
+    err = pcnt_channel_set_edge_action(chan, on_rise, on_fall);
+    if (err != ESP_OK) {
+        return err;
+    }
+    // 相手の相がLowの間は向きを反転する
+    return pcnt_channel_set_level_action(chan, PCNT_CHANNEL_LEVEL_ACTION_KEEP, PCNT_CHANNEL_LEVEL_ACTION_INVERSE);
+}
+
+// A相・B相を数えるユニットを作り、上下限をウォッチポイントにする (積算にも必要)
+esp_err_t unit_create(int gpio_a, int gpio_b, int limit, bool accum, pcnt_unit_handle_t* out) {
+    pcnt_unit_config_t unit_config = {};
+    unit_config.low_limit = -limit;
+    unit_config.high_limit = limit;
+    unit_config.flags.accum_count = accum;
+    esp_err_t err = pcnt_new_unit(&unit_config, out);
+    if (err != ESP_OK) {
+        return err;
+    }
+    pcnt_unit_handle_t unit = *out;
+
+    pcnt_glitch_filter_config_t filter_config = {};
+    filter_config.max_glitch_ns = ENCODER_GLITCH_NS;
+    err = pcnt_unit_set_glitch_filter(unit, &filter_config);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    // 時計回り (A,B) = 00 -> 01 -> 11 -> 10 -> 00 で増える向き
+    err = add_channel(unit, gpio_a, gpio_b, PCNT_CHANNEL_EDGE_ACTION_INCREASE, PCNT_CHANNEL_EDGE_ACTION_DECREASE);
+    if (err != ESP_OK) {
+        return err;
+    }
+    err = add_channel(unit, gpio_b, gpio_a, PCNT_CHANNEL_EDGE_ACTION_DECREASE, PCNT_CHANNEL_EDGE_ACTION_INCREASE);
+    if (err != ESP_OK) {
+        return err;
+    }
+    const int limits[] = { limit, -limit };
+    for (int point : limits) {
+        err = pcnt_unit_add_watch_point(unit, point);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t unit_enable(pcnt_unit_handle_t unit) {
+    esp_err_t err = pcnt_unit_enable(unit);
+    if (err != ESP_OK) {
+        return err;
+    }
+    return pcnt_unit_clear_count(unit);
+}
+
+esp_err_t unit_start(int gpio_a, int gpio_b) {
+    esp_err_t err = unit_create(gpio_a, gpio_b, TOTAL_LIMIT, true, &total_unit);
+    if (err != ESP_OK) {
+        return err;
+    }
+    err = unit_create(gpio_a, gpio_b, ENCODER_COUNTS_PER_DETENT, false, &detent_unit);
+    if (err != ESP_OK) {
+        return err;
+    }
+    gpio_pullup_en((gpio_num_t)gpio_a);
+    gpio_pullup_en((gpio_num_t)gpio_b);
+
+    pcnt_event_callbacks_t cbs = {};
+    cbs.on_reach = on_reach;
+    err = pcnt_unit_register_event_callbacks(detent_unit, &cbs, nullptr);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    const pcnt_unit_handle_t units[] = { total_unit, detent_unit };
+    for (pcnt_unit_handle_t unit : units) {
+        err = unit_enable(unit);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+    // 回した量を先に数え始める (デテントの割り込みが読む時には動いている)
+    err = pcnt_unit_start(total_unit);
+    if (err != ESP_OK) {
+        return err;
+    }
+    return pcnt_unit_start(detent_unit);
+}
+
+#else
+
+// モックのPCNT
+int mock_count = 0;        // detent_unit のカウンタ値
+int mock_total = 0;        // total_unit のカウンタ値 (積算を含む)
+bool mock_hold = false;    // 割り込みを止めている
+uint8_t mock_pending = 0;  // 保留中の detent_unit の事象 (bit0: 上限, bit1: 下限)。同じ事象は1つにまとまる
+
+void mock_isr() {
+    for (int i = 0; i < 2; i++) {
+        if (mock_pending & (1 << i)) {
+            mock_pending &= ~(1 << i);
+            total_reached(mock_total);
+        }
+    }
+}
+
+#endif
+
+}  // namespace
+
+bool encoder_init(int gpio_a, int gpio_b) {
+    detent_count.store(0, std::memory_order_relaxed);
+    detent_base = 0;
+#ifdef ESP_PLATFORM
+    if (detent_unit != nullptr) {
+        ESP_LOGW(TAG, "初期化済み");
+        return true;
+    }
+    esp_err_t err = unit_start(gpio_a, gpio_b);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "PCNT初期化失敗: %s", esp_err_to_name(err));
+        return false;
+    }
+    ESP_LOGI(TAG, "PCNT: A=GPIO%d B=GPIO%d, グリッチフィルタ %dns", gpio_a, gpio_b, ENCODER_GLITCH_NS);
+#else
+    (void)gpio_a;
+    (void)gpio_b;
+    mock_count = 0;
+    mock_total = 0;
+    mock_pending = 0;
+#endif
+    detent_pos = 0;
+    return true;
+}
+
+int32_t encoder_detents() {
+    return detent_count.load(std::memory_order_relaxed) - detent_base;
+}
+
+void encoder_reset() {
+    // カウンタを先に0にする: その前に数えたデテントは detent_base に含まれて打ち消される
+#ifdef ESP_PLATFORM
+    if (detent_unit != nullptr) {
+        pcnt_unit_clear_count(detent_unit);
+        pcnt_unit_clear_count(total_unit);  // 積算も0に戻る
+    }
+#else
+    mock_count = 0;
+    mock_total = 0;
+    mock_pending = 0;
+#endif
+    detent_pos = 0;
+    detent_base = detent_count.load(std::memory_order_relaxed);
+}
+
+void encoder_set_callback(encoder_callback_t cb, void* arg) {
+    callback.store(nullptr, std::memory_order_relaxed);
+    callback_arg = arg;
+    callback.store(cb, std::memory_order_release);  // 割り込みには引数を書いた後で見える
+}
+
+#ifndef ESP_PLATFORM
+
+void encoder_mock_turn(int counts) {
+    int step = counts > 0 ? 1 : -1;
+    for (int i = 0; i != counts; i += step) {
+        mock_count += step;
+        mock_total += step;
+        if (mock_count == ENCODER_COUNTS_PER_DETENT || mock_count == -ENCODER_COUNTS_PER_DETENT) {
+            mock_count = 0;  // PCNTは上下限で0に戻る
+            mock_pending |= step > 0 ? 1 : 2;
+        }
+        if (!mock_hold) {
+            mock_isr();
+        }
+    }
+}
+
+void encoder_mock_hold_isr(bool hold) {
+    mock_hold = hold;
+    if (!hold) {
+        mock_isr();
+    }
+}
+
+int encoder_mock_count() {
+    return mock_count;
+}
+
+#endif
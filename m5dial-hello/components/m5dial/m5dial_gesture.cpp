@@ -0,0 +1,108 @@
+/**
+ * M5Dial タッチのジェスチャー認識
+ *
+ * 角度は中心からの向きを atan2 で求め、前回との差を ±180度に折り返して足していく。
+ * 中心の近くは少しの移動で角度が大きく変わるため、ring_radius の半分より内側にいる間は
+ * 測らず、外に戻った所から測り直す。
+ */
+#include "m5dial_gesture.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+namespace {
+
+// 中心からの向き (0.1度、右が0で時計回り。画面のyは下向き)
+int32_t angle_of(int dx, int dy) {
+    return (int32_t)lroundf(atan2f((float)dy, (float)dx) * (1800.0f / (float)M_PI));
+}
+
+int32_t distance_sq(int dx, int dy) {
+    return (int32_t)dx * dx + (int32_t)dy * dy;
+}
+
+}  // namespace
+
+void gesture_reset(gesture_state_t* state) {
+    *state = {};
+}
+
+int gesture_feed(gesture_state_t* state, const gesture_config_t& config,
+                 int64_t time_us, bool touching, int16_t x, int16_t y, input_event_t* out) {
+    int n = 0;
+    if (touching) {
+        int cx = x - config.center_x;
+        int cy = y - config.center_y;
+        if (!state->down) {
+            gesture_reset(state);
+            state->down = true;
+            state->down_us = time_us;
+            state->start_x = state->x = x;
+            state->start_y = state->y = y;
+            state->ring = distance_sq(cx, cy) >= (int32_t)config.ring_radius * config.ring_radius;
+            state->has_angle = state->ring;
+            state->angle = angle_of(cx, cy);
+            return 0;
+        }
+        state->x = x;
+        state->y = y;
+        if (distance_sq(x - state->start_x, y - state->start_y) > (int32_t)config.tap_max_move * config.tap_max_move) {
+            state->moved = true;
+        }
+        if (!state->ring) {
+            return 0;
+        }
+
+        int32_t inner = config.ring_radius / 2;
+        if (distance_sq(cx, cy) < inner * inner) {
+            state->has_angle = false;
+            return 0;
+        }
+        int32_t angle = angle_of(cx, cy);
+        if (state->has_angle) {
+            int32_t d = angle - state->angle;
+            if (d >= 1800) {
+                d -= 3600;
+            } else if (d < -1800) {
+                d += 3600;
+            }
+            state->turn += d;
+        }
+        state->angle = angle;
+        state->has_angle = true;
+
+        int32_t step = (int32_t)config.ring_step_deg * 10;
+        while (n < GESTURE_MAX_EVENTS && step > 0 && abs(state->turn) >= step) {
+            int8_t dir = state->turn > 0 ? 1 : -1;
+            state->turn -= dir * step;
+            state->dragged = true;
+            out[n++] = { time_us, INPUT_RING, dir, 0, x, y };
+        }
+        return n;
+    }
+
+    if (!state->down) {
+        return 0;
+    }
+    state->down = false;
+    if (state->dragged) {
+        return 0;
+    }
+    int64_t duration = time_us - state->down_us;
+    int dx = state->x - state->start_x;
+    int dy = state->y - state->start_y;
+    if (!state->moved) {
+        if (duration <= config.tap_max_us) {
+            out[n++] = { time_us, INPUT_TAP, 0, 0, state->start_x, state->start_y };
+        }
+    } else if (duration <= config.swipe_max_us && (abs(dx) >= config.swipe_min_move || abs(dy) >= config.swipe_min_move)) {
+        int8_t dir;
+        if (abs(dx) >= abs(dy)) {
+            dir = dx > 0 ? INPUT_SWIPE_RIGHT : INPUT_SWIPE_LEFT;
+        } else {
+            dir = dy > 0 ? INPUT_SWIPE_DOWN : INPUT_SWIPE_UP;
+        }
+        out[n++] = { time_us, INPUT_SWIPE, dir, 0, state->start_x, state->start_y };
+    }
+    return n;
+}
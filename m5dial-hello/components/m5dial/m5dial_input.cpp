@@ -0,0 +1,461 @@
+/**
+ * M5Dial 入力イベントキュー
+ *
+ * リングは head (生産者のみ書く) と tail (消費者のみ書く) の2つの添字で管理し、ロックを使わない。
+ * 生産者の割り込みは同じコアにあるが優先度が違うと入れ子になり得るため、1件書き込む間だけ
+ * そのコアの割り込みを止める (他のコアや消費者は止めない)。
+ * 消費者はキューが空の間タスク通知で待ち、生産者が積むたびに起こされる。
+ * 回転速度は消費側で、取り出したデテントの (割り込みの) 時刻から求める。
+ * タッチパネルのINTの変化は内部の事象としてリングに積み、消費側で取り出した時にI2Cで位置を
+ * 読む (離した時は読まない)。触れている間の読み取りは長押しと同じく消費側の時刻で行い、
+ * 認識したジェスチャーは次に取り出す事象より先に返す。
+ * ボタンは受け付けた変化から INPUT_DEBOUNCE_US の間の変化を捨てるため、その間に離した・押し直した
+ * ままになると変化を取りこぼす。消費側は取り出したボタンの事象ごとに除去の時間が終わった時点で
+ * ボタンを読み直し、状態が違えばその変化を返す。
+ */
+#include "m5dial_input.h"
+
+#include <algorithm>
+#include <atomic>
+#include "m5dial_encoder.h"
+#include "m5dial_gesture.h"
+
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "driver/gpio.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+
+static const char *TAG = "input";
+#else
+#define IRAM_ATTR
+#endif
+
+static_assert((INPUT_QUEUE_LENGTH & (INPUT_QUEUE_LENGTH - 1)) == 0, "INPUT_QUEUE_LENGTH must be a power of two");
+
+namespace {
+
+// 内部の事象: タッチパネルのINTの変化 (value: 1 = 触れた)。input_read() では返さない
+constexpr uint8_t TOUCH_EDGE = 0xff;
+
+input_event_t ring[INPUT_QUEUE_LENGTH];
+std::atomic<uint32_t> head(0);  // 次に書き込む位置
+std::atomic<uint32_t> tail(0);  // 次に読み出す位置
+std::atomic<uint32_t> overflow_count(0);
+
+// ボタン (割り込み側。消費側の読み直しも button_mux を取って書き換える)
+int button_pin = -1;
+bool button_down = false;
+int64_t button_edge_us = 0;
+
+// タッチパネル (割り込み側)
+int touch_pin = -1;
+
+// 長押しの判定 (消費側)
+int64_t long_press_us = 0;
+bool long_pending = false;
+int64_t long_deadline_us = 0;
+bool long_fired = false;
+bool held = false;
+
+// ボタンの読み直し (消費側)
+bool button_check_pending = false;
+int64_t button_check_us = 0;
+
+// 回転速度 (消費側)。同じ向きの直近のデテントの時刻
+int64_t detent_times[INPUT_VELOCITY_WINDOW];
+uint8_t detent_times_count = 0;
+int8_t detent_dir = 0;
+
+// タッチパネル (消費側)
+input_touch_read_t touch_read = nullptr;
+void* touch_arg = nullptr;
+gesture_config_t touch_config;
+gesture_state_t touch_state;
+bool touch_active = false;  // 触れている (位置を読み続ける)
+int64_t touch_poll_us = 0;  // 次に位置を読む時刻
+input_event_t touch_events[GESTURE_MAX_EVENTS];  // 認識したがまだ返していない事象
+int touch_event_count = 0;
+int touch_event_next = 0;
+
+#ifdef ESP_PLATFORM
+
+TaskHandle_t consumer = nullptr;
+portMUX_TYPE button_mux = portMUX_INITIALIZER_UNLOCKED;
+
+inline int64_t IRAM_ATTR now_us() {
+    return esp_timer_get_time();
+}
+
+inline bool IRAM_ATTR button_level() {
+    return gpio_get_level((gpio_num_t)button_pin) == 0;
+}
+
+#else
+
+int64_t mock_time_us = 0;
+bool mock_button_pressed = false;
+
+inline int64_t now_us() {
+    return mock_time_us;
+}
+
+inline bool button_level() {
+    return mock_button_pressed;
+}
+
+#endif
+
+// 1件書き込む (割り込みを止めている間に呼ぶ)。書き込めた場合true
+bool IRAM_ATTR store(int64_t t, uint8_t type, int8_t value) {
+    uint32_t h = head.load(std::memory_order_relaxed);
+    if (h - tail.load(std::memory_order_acquire) >= INPUT_QUEUE_LENGTH) {
+        overflow_count.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    ring[h & (INPUT_QUEUE_LENGTH - 1)] = { t, type, value, 0, 0, 0 };
+    head.store(h + 1, std::memory_order_release);
+    return true;
+}
+
+// 割り込みから積んだ後に消費者を起こす。タスクを切り替える必要がある場合true
+bool IRAM_ATTR wake_consumer() {
+#ifdef ESP_PLATFORM
+    BaseType_t woken = pdFALSE;
+    if (consumer != nullptr) {
+        vTaskNotifyGiveFromISR(consumer, &woken);
+    }
+    return woken == pdTRUE;
+#else
+    return false;
+#endif
+}
+
+// 割り込みから1件積む。消費者を起こす必要がある場合true
+bool IRAM_ATTR push(uint8_t type, int8_t value) {
+    int64_t t = now_us();
+#ifdef ESP_PLATFORM
+    UBaseType_t mask = portSET_INTERRUPT_MASK_FROM_ISR();
+#endif
+    bool stored = store(t, type, value);
+#ifdef ESP_PLATFORM
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+#endif
+    return stored && wake_consumer();
+}
+
+bool IRAM_ATTR on_detent(int step, void*) {
+    return push(INPUT_DETENT, (int8_t)step);
+}
+
+// 状態の確認と書き込みを button_mux の中で行い、消費側の読み直しと順序が入れ替わらないようにする
+bool IRAM_ATTR on_button(bool pressed) {
+    bool stored = false;
+#ifdef ESP_PLATFORM
+    portENTER_CRITICAL_ISR(&button_mux);
+#endif
+    int64_t t = now_us();
+    if (pressed != button_down && t - button_edge_us >= INPUT_DEBOUNCE_US) {
+        button_down = pressed;
+        button_edge_us = t;
+        stored = store(t, pressed ? INPUT_PRESS : INPUT_RELEASE, 0);
+    }
+#ifdef ESP_PLATFORM
+    portEXIT_CRITICAL_ISR(&button_mux);
+#endif
+    return stored && wake_consumer();
+}
+
+// チャタリング除去の時間が終わった時にボタンを読み直す (消費側)
+// 除去の時間内に捨てた変化で状態が違っていれば、受け付けた変化として状態を書き換えて *ev に置く
+// 割り込みがその後に受け付けた変化がまだキューにあれば何もしない (その事象の後でまた読み直す)
+bool button_recheck(input_event_t* ev) {
+    bool pressed = button_level();
+    bool changed = false;
+#ifdef ESP_PLATFORM
+    portENTER_CRITICAL(&button_mux);
+#endif
+    int64_t t = now_us();
+    if (pressed != button_down && t - button_edge_us >= INPUT_DEBOUNCE_US) {
+        button_down = pressed;
+        button_edge_us = t;
+        changed = true;
+    }
+#ifdef ESP_PLATFORM
+    portEXIT_CRITICAL(&button_mux);
+#endif
+    if (changed) {
+        *ev = { t, (uint8_t)(pressed ? INPUT_PRESS : INPUT_RELEASE), 0, 0, 0, 0 };
+    }
+    return changed;
+}
+
+bool IRAM_ATTR on_touch(bool touching) {
+    return push(TOUCH_EDGE, touching ? 1 : 0);
+}
+
+#ifdef ESP_PLATFORM
+
+void IRAM_ATTR button_isr(void*) {
+    if (on_button(button_level())) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+void IRAM_ATTR touch_isr(void*) {
+    if (on_touch(gpio_get_level((gpio_num_t)touch_pin) == 0)) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+#endif
+
+const input_event_t* peek() {
+    uint32_t t = tail.load(std::memory_order_relaxed);
+    if (t == head.load(std::memory_order_acquire)) {
+        return nullptr;
+    }
+    return &ring[t & (INPUT_QUEUE_LENGTH - 1)];
+}
+
+void pop() {
+    tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+// デテントの時刻を記録し、窓の最初から最後までの平均の速度 (デテント/秒) を返す
+uint16_t detent_speed(const input_event_t& ev) {
+    int64_t last = detent_times_count ? detent_times[(detent_times_count - 1) % INPUT_VELOCITY_WINDOW] : 0;
+    if (ev.value != detent_dir || ev.time_us - last > INPUT_VELOCITY_GAP_US) {
+        detent_times_count = 0;  // 逆回転、または止まってから回し始めた
+        detent_dir = ev.value;
+    }
+    if (detent_times_count >= 2 * INPUT_VELOCITY_WINDOW) {
+        detent_times_count -= INPUT_VELOCITY_WINDOW;  // 添字の位置を保ったまま数を抑える
+    }
+    detent_times[detent_times_count % INPUT_VELOCITY_WINDOW] = ev.time_us;
+    detent_times_count++;
+
+    int n = std::min<int>(detent_times_count, INPUT_VELOCITY_WINDOW);
+    if (n < 2) {
+        return 0;
+    }
+    int64_t first = detent_times[(detent_times_count - n) % INPUT_VELOCITY_WINDOW];
+    int64_t span = std::max<int64_t>(ev.time_us - first, 1);
+    return (uint16_t)std::min<int64_t>((int64_t)(n - 1) * 1000000 / span, UINT16_MAX);
+}
+
+// タッチパネルの状態を1件ジェスチャー認識に与え、認識した事象を touch_events に置く
+// 触れた時と触れている間は位置をI2Cで読む。離した時 (released) は読まない
+void touch_sample(int64_t time_us, bool released) {
+    int16_t x = 0;
+    int16_t y = 0;
+    bool touching = !released && touch_read(&x, &y, touch_arg);
+#ifdef ESP_PLATFORM
+    // tools/touch_gesture_replay.cpp で再生できる形式
+    ESP_LOGD(TAG, "touch: %lld %d %d %d", (long long)time_us, touching ? 1 : 0, x, y);
+#endif
+    touch_event_count = gesture_feed(&touch_state, touch_config, time_us, touching, x, y, touch_events);
+    touch_event_next = 0;
+    touch_active = touching;
+    touch_poll_us = now_us() + INPUT_TOUCH_POLL_US;
+}
+
+// キューの事象と長押し、タッチとボタンの読み直しを時刻の順に取り出す
+size_t drain(input_event_t* out, size_t max) {
+    size_t n = 0;
+    while (n < max) {
+        if (touch_event_next < touch_event_count) {
+            out[n++] = touch_events[touch_event_next++];
+            continue;
+        }
+        const input_event_t* e = peek();
+        if (long_pending && (e == nullptr || e->time_us >= long_deadline_us) && now_us() >= long_deadline_us) {
+            out[n++] = { long_deadline_us, INPUT_LONG_PRESS, 0, 0, 0, 0 };
+            long_pending = false;
+            long_fired = true;
+            held = true;
+            continue;
+        }
+        if (touch_active && (e == nullptr || e->time_us >= touch_poll_us) && now_us() >= touch_poll_us) {
+            touch_sample(now_us(), false);
+            continue;
+        }
+        input_event_t ev;
+        if (button_check_pending && (e == nullptr || e->time_us >= button_check_us) && now_us() >= button_check_us) {
+            button_check_pending = false;
+            if (!button_recheck(&ev)) {
+                continue;
+            }
+        } else {
+            if (e == nullptr) {
+                break;
+            }
+            ev = *e;
+            pop();
+        }
+        if (ev.type == TOUCH_EDGE) {
+            // 触れた: 位置を読む。離した: 読まずに離したことだけ与える
+            // (読み取りで先に離したと分かっていれば何もしない)
+            if (touch_read != nullptr && (ev.value || touch_active)) {
+                touch_sample(ev.time_us, !ev.value);
+            }
+            continue;
+        }
+        if (ev.type == INPUT_PRESS || ev.type == INPUT_RELEASE) {
+            button_check_pending = true;
+            button_check_us = ev.time_us + INPUT_DEBOUNCE_US;
+        }
+        if (ev.type == INPUT_DETENT) {
+            ev.speed = detent_speed(ev);
+        } else if (ev.type == INPUT_PRESS) {
+            long_pending = true;
+            long_deadline_us = ev.time_us + long_press_us;
+            long_fired = false;
+        } else if (ev.type == INPUT_RELEASE) {
+            ev.value = long_fired ? 0 : 1;
+            long_pending = false;
+            long_fired = false;
+            held = false;
+        }
+        out[n++] = ev;
+    }
+    return n;
+}
+
+}  // namespace
+
+bool input_init(int button_gpio, uint32_t long_press_ms) {
+    long_press_us = (int64_t)long_press_ms * 1000;
+    button_pin = button_gpio;
+#ifdef ESP_PLATFORM
+    consumer = xTaskGetCurrentTaskHandle();
+
+    gpio_config_t io_conf = {};
+    io_conf.intr_type = GPIO_INTR_ANYEDGE;
+    io_conf.mode = GPIO_MODE_INPUT;
+    io_conf.pin_bit_mask = (1ULL << button_gpio);
+    io_conf.pull_up_en = GPIO_PULLUP_ENABLE;
+    gpio_config(&io_conf);
+    button_down = gpio_get_level((gpio_num_t)button_gpio) == 0;
+
+    esp_err_t err = gpio_install_isr_service(0);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {  // INVALID_STATE: インストール済み
+        ESP_LOGE(TAG, "GPIO ISRサービス初期化失敗: %s", esp_err_to_name(err));
+        return false;
+    }
+    err = gpio_isr_handler_add((gpio_num_t)button_gpio, button_isr, nullptr);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "ボタン割り込み登録失敗: %s", esp_err_to_name(err));
+        return false;
+    }
+#endif
+    encoder_set_callback(on_detent, nullptr);
+    return true;
+}
+
+bool input_touch_init(int int_gpio, input_touch_read_t read, void* arg, const gesture_config_t& config) {
+    touch_read = read;
+    touch_arg = arg;
+    touch_config = config;
+    gesture_reset(&touch_state);
+    touch_pin = int_gpio;
+#ifdef ESP_PLATFORM
+    // タッチパネルの初期化でINTは割り込みなしの入力に設定されるため、ここで割り込みを付け直す
+    gpio_config_t io_conf = {};
+    io_conf.intr_type = GPIO_INTR_ANYEDGE;
+    io_conf.mode = GPIO_MODE_INPUT;
+    io_conf.pin_bit_mask = (1ULL << int_gpio);
+    io_conf.pull_up_en = GPIO_PULLUP_ENABLE;
+    gpio_config(&io_conf);
+
+    esp_err_t err = gpio_isr_handler_add((gpio_num_t)int_gpio, touch_isr, nullptr);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "タッチ割り込み登録失敗: %s", esp_err_to_name(err));
+        return false;
+    }
+    // 初期化の時点で触れていれば、次の input_read() から位置を読み始める
+    touch_active = gpio_get_level((gpio_num_t)int_gpio) == 0;
+    touch_poll_us = now_us();
+#endif
+    return true;
+}
+
+size_t input_read(input_event_t* out, size_t max, uint32_t timeout_ms) {
+    size_t n = drain(out, max);
+#ifdef ESP_PLATFORM
+    if (n > 0 || timeout_ms == 0) {
+        return n;
+    }
+    int64_t end_us = timeout_ms == INPUT_WAIT_FOREVER ? INT64_MAX : now_us() + (int64_t)timeout_ms * 1000;
+    for (;;) {
+        int64_t now = now_us();
+        int64_t until = long_pending ? std::min(end_us, long_deadline_us) : end_us;
+        if (touch_active) {
+            until = std::min(until, touch_poll_us);
+        }
+        if (button_check_pending) {
+            until = std::min(until, button_check_us);
+        }
+        if (until > now) {
+            TickType_t ticks = portMAX_DELAY;
+            if (until != INT64_MAX) {
+                ticks = pdMS_TO_TICKS((until - now + 999) / 1000);
+                ticks = ticks ? ticks : 1;
+            }
+            ulTaskNotifyTake(pdTRUE, ticks);
+        }
+        n = drain(out, max);
+        if (n > 0 || now_us() >= end_us) {
+            return n;
+        }
+    }
+#else
+    (void)timeout_ms;  // モックは待たない (時刻は input_mock_set_time() で進める)
+    return n;
+#endif
+}
+
+int input_accel_step(const input_event_t& ev, const input_accel_t& accel) {
+    if (ev.type != INPUT_DETENT) {
+        return 0;
+    }
+    int step = 1;
+    if (accel.max_step > 1 && ev.speed > accel.min_speed) {
+        // 速度の割合 (8ビット固定小数点) を shape 乗する
+        int range = std::max(accel.max_speed - accel.min_speed, 1);
+        int f = std::min((ev.speed - accel.min_speed) * 256 / range, 256);
+        int curve = 256;
+        for (int i = 0; i < accel.shape; i++) {
+            curve = curve * f >> 8;
+        }
+        step = 1 + (((accel.max_step - 1) * curve + 128) >> 8);
+    }
+    return ev.value * step;
+}
+
+bool input_button_held() {
+    return held;
+}
+
+uint32_t input_overflows() {
+    return overflow_count.load(std::memory_order_relaxed);
+}
+
+#ifndef ESP_PLATFORM
+
+void input_mock_set_time(int64_t time_us) {
+    mock_time_us = time_us;
+}
+
+void input_mock_button(bool pressed) {
+    mock_button_pressed = pressed;
+    on_button(pressed);
+}
+
+void input_mock_touch(bool touching) {
+    on_touch(touching);
+}
+
+#endif
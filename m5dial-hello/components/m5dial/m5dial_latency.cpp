@@ -0,0 +1,81 @@
+/**
+ * M5Dial 入力から表示までの遅延の集計
+ *
+ * バケットの番号: 16us未満はその値。それ以上は最上位ビットの位置 e (4〜) と、その下の3ビット s で
+ * 16 + (e - 4) * 8 + s。各バケットは [ (8 + s) << (e - 3), (9 + s) << (e - 3) ) の範囲を表す。
+ */
+#include "m5dial_latency.h"
+
+#include <stdio.h>
+
+namespace {
+
+int bucket_of(uint32_t us) {
+    if (us < 16) {
+        return (int)us;
+    }
+    int e = 31 - __builtin_clz(us);
+    int s = (us >> (e - 3)) & 7;
+    int b = 16 + (e - 4) * 8 + s;
+    return b < LATENCY_BUCKETS ? b : LATENCY_BUCKETS - 1;
+}
+
+// バケットの上限 (この値未満がバケットに入る)
+uint32_t bucket_limit(int b) {
+    if (b < 16) {
+        return (uint32_t)b + 1;
+    }
+    int e = (b - 16) / 8 + 4;
+    int s = (b - 16) % 8;
+    return (uint32_t)(9 + s) << (e - 3);
+}
+
+}  // namespace
+
+void latency_record(latency_hist_t* hist, uint32_t latency_us) {
+    hist->buckets[bucket_of(latency_us)].fetch_add(1, std::memory_order_relaxed);
+    hist->count.fetch_add(1, std::memory_order_relaxed);
+    uint32_t max = hist->max_us.load(std::memory_order_relaxed);
+    while (latency_us > max && !hist->max_us.compare_exchange_weak(max, latency_us, std::memory_order_relaxed)) {
+    }
+}
+
+uint32_t latency_percentile(const latency_hist_t* hist, uint32_t permille) {
+    // 記録中でも読めるように、件数はバケットの合計から求める
+    uint32_t counts[LATENCY_BUCKETS];
+    uint64_t total = 0;
+    for (int b = 0; b < LATENCY_BUCKETS; b++) {
+        counts[b] = hist->buckets[b].load(std::memory_order_relaxed);
+        total += counts[b];
+    }
+    if (total == 0) {
+        return 0;
+    }
+    uint64_t rank = (total * permille + 999) / 1000;  // 1件目から数えた順位
+    rank = rank ? rank : 1;
+    uint64_t seen = 0;
+    for (int b = 0; b < LATENCY_BUCKETS; b++) {
+        seen += counts[b];
+        if (seen >= rank) {
+            uint32_t limit = bucket_limit(b);
+            uint32_t max = hist->max_us.load(std::memory_order_relaxed);
+            return limit - 1 < max ? limit - 1 : max;
+        }
+    }
+    return hist->max_us.load(std::memory_order_relaxed);
+}
+
+void latency_reset(latency_hist_t* hist) {
+    for (auto& bucket : hist->buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    hist->count.store(0, std::memory_order_relaxed);
+    hist->max_us.store(0, std::memory_order_relaxed);
+}
+
+int latency_format(const latency_hist_t* hist, const char* name, char* buf, size_t size) {
+    return snprintf(buf, size, "%s: %lu件 p50 %lu / p95 %lu / p99 %lu / 最大 %lu us",
+                    name, (unsigned long)hist->count.load(std::memory_order_relaxed),
+                    (unsigned long)latency_percentile(hist, 500), (unsigned long)latency_percentile(hist, 950),
+                    (unsigned long)latency_percentile(hist, 990), (unsigned long)hist->max_us.load(std::memory_order_relaxed));
+}
@@ -0,0 +1,371 @@
+/**
+ * M5Dial WS2812 LEDストリップ出力
+ *
+ * RMTのバイトエンコーダでGRBの各ビットをパルスに変換し、最後にリセット (Low) 期間を付け加える。
+ * 送信中のバッファ (front) はエンコーダが割り込みから読むため、送信完了まで書き換えない。
+ *
+ * 全ストリップの画素は1つのバッファに並べて置き、2面まとめて入れ替える。
+ * 論理画素の対応表はバッファ内の位置 (バイト単位) を持つため、書き込みは表を1回引くだけで済む。
+ *
+ * RMTのシンボル (1ビット = 4バイト) はフレーム全体分を作らず、エンコーダが送信の進み具合に合わせて
+ * GRBのバッファからRMTメモリ (またはDMAバッファ) の空いた分だけ変換する。
+ * このため使うメモリは1LEDあたり 画素2面 × 3バイト + 対応表 2バイト = 8バイトで、LED数に比例するのはこれだけ。
+ */
+#include "m5dial_ws2812.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include "driver/rmt_tx.h"
+#include "soc/soc_caps.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+
+static const char *TAG = "ws2812";
+
+// RMTの分解能 (1ティック = 0.1us)
+#define WS2812_RESOLUTION_HZ  (10 * 1000 * 1000)
+#define WS2812_T0H_TICKS      3   // 0.3us
+#define WS2812_T0L_TICKS      9   // 0.9us
+#define WS2812_T1H_TICKS      9   // 0.9us
+#define WS2812_T1L_TICKS      3   // 0.3us
+#define WS2812_RESET_TICKS    1500  // 150us x 2 = 300us (新しいWS2812Bは280us以上必要)
+
+namespace {
+
+struct ws2812_encoder_t {
+    rmt_encoder_t base;
+    rmt_encoder_t* bytes_encoder;
+    rmt_encoder_t* copy_encoder;
+    int state;
+    rmt_symbol_word_t reset_code;
+};
+
+#define UNMAPPED 0xFFFF
+
+struct strip_t {
+    rmt_channel_handle_t channel;
+    ws2812_encoder_t* encoder;  // エンコーダは送信の途中状態を持つためストリップごとに作る
+    size_t offset;              // バッファ内の先頭位置 (バイト)
+    size_t size;                // バイト数
+    uint16_t length;
+    bool transmitting;
+    bool sent_once;
+};
+
+strip_t strips[WS2812_MAX_STRIPS] = {};
+size_t strip_count = 0;
+uint8_t* buffers[2] = {nullptr, nullptr};
+uint8_t* front = nullptr;  // 送信中 (または最後に送信した) フレーム
+uint8_t* back = nullptr;   // 書き込み中のフレーム
+size_t buffer_size = 0;
+uint16_t* pixel_map = nullptr;  // 論理画素 → バッファ内の位置 (UNMAPPEDは出力しない)
+uint16_t logical_count = 0;
+
+rmt_encode_state_t add_state(rmt_encode_state_t state, rmt_encode_state_t flag) {
+    return (rmt_encode_state_t)(state | flag);
+}
+
+size_t encode(rmt_encoder_t* base, rmt_channel_handle_t chan, const void* data, size_t size, rmt_encode_state_t* ret_state) {
+    ws2812_encoder_t* enc = (ws2812_encoder_t*)base;  // baseは先頭のメンバ
+    rmt_encode_state_t session_state = RMT_ENCODING_RESET;
+    rmt_encode_state_t state = RMT_ENCODING_RESET;
+    size_t encoded = 0;
+
+    switch (enc->state) {
+        case 0:  // 画素データ
+            encoded += enc->bytes_encoder->encode(enc->bytes_encoder, chan, data, size, &session_state);
+            if (session_state & RMT_ENCODING_COMPLETE) {
+                enc->state = 1;
+            }
+            if (session_state & RMT_ENCODING_MEM_FULL) {
+                state = add_state(state, RMT_ENCODING_MEM_FULL);
+                break;  // 空きができたら続きから
+            }
+            // fall through
+        case 1:  // リセット期間
+            encoded += enc->copy_encoder->encode(enc->copy_encoder, chan, &enc->reset_code, sizeof(enc->reset_code), &session_state);
+            if (session_state & RMT_ENCODING_COMPLETE) {
+                enc->state = RMT_ENCODING_RESET;
+                state = add_state(state, RMT_ENCODING_COMPLETE);
+            }
+            if (session_state & RMT_ENCODING_MEM_FULL) {
+                state = add_state(state, RMT_ENCODING_MEM_FULL);
+            }
+            break;
+    }
+    *ret_state = state;
+    return encoded;
+}
+
+esp_err_t encoder_reset(rmt_encoder_t* base) {
+    ws2812_encoder_t* enc = (ws2812_encoder_t*)base;  // baseは先頭のメンバ
+    rmt_encoder_reset(enc->bytes_encoder);
+    rmt_encoder_reset(enc->copy_encoder);
+    enc->state = RMT_ENCODING_RESET;
+    return ESP_OK;
+}
+
+esp_err_t encoder_del(rmt_encoder_t* base) {
+    ws2812_encoder_t* enc = (ws2812_encoder_t*)base;  // baseは先頭のメンバ
+    if (enc->bytes_encoder) rmt_del_encoder(enc->bytes_encoder);
+    if (enc->copy_encoder) rmt_del_encoder(enc->copy_encoder);
+    free(enc);
+    return ESP_OK;
+}
+
+esp_err_t encoder_new(ws2812_encoder_t** ret) {
+    ws2812_encoder_t* enc = (ws2812_encoder_t*)calloc(1, sizeof(ws2812_encoder_t));
+    if (enc == nullptr) {
+        return ESP_ERR_NO_MEM;
+    }
+    enc->base.encode = encode;
+    enc->base.reset = encoder_reset;
+    enc->base.del = encoder_del;
+
+    rmt_bytes_encoder_config_t bytes_config = {};
+    bytes_config.bit0.level0 = 1;
+    bytes_config.bit0.duration0 = WS2812_T0H_TICKS;
+    bytes_config.bit0.level1 = 0;
+    bytes_config.bit0.duration1 = WS2812_T0L_TICKS;
+    bytes_config.bit1.level0 = 1;
+    bytes_config.bit1.duration0 = WS2812_T1H_TICKS;
+    bytes_config.bit1.level1 = 0;
+    bytes_config.bit1.duration1 = WS2812_T1L_TICKS;
+    bytes_config.flags.msb_first = 1;
+    esp_err_t err = rmt_new_bytes_encoder(&bytes_config, &enc->bytes_encoder);
+    if (err == ESP_OK) {
+        rmt_copy_encoder_config_t copy_config = {};
+        err = rmt_new_copy_encoder(&copy_config, &enc->copy_encoder);
+    }
+    if (err != ESP_OK) {
+        encoder_del(&enc->base);
+        return err;
+    }
+
+    enc->reset_code.level0 = 0;
+    enc->reset_code.duration0 = WS2812_RESET_TICKS;
+    enc->reset_code.level1 = 0;
+    enc->reset_code.duration1 = WS2812_RESET_TICKS;
+    *ret = enc;
+    return ESP_OK;
+}
+
+esp_err_t channel_new(int gpio_num, bool with_dma, rmt_channel_handle_t* ret) {
+    rmt_tx_channel_config_t config = {};
+    config.gpio_num = (gpio_num_t)gpio_num;
+    config.clk_src = RMT_CLK_SRC_DEFAULT;
+    config.resolution_hz = WS2812_RESOLUTION_HZ;
+    // DMA使用時は1回の補充で送れる量が増え、割り込みの回数が大きく減る
+    // DMA無しの場合はRMTのメモリを1ブロックだけ使い、4本全てにチャネルを割り当てられるようにする
+    config.mem_block_symbols = with_dma ? 1024 : SOC_RMT_MEM_WORDS_PER_CHANNEL;
+    config.trans_queue_depth = 2;
+    config.flags.with_dma = with_dma;
+    return rmt_new_tx_channel(&config, ret);
+}
+
+esp_err_t strip_new(strip_t* strip, int gpio_num) {
+    esp_err_t err = channel_new(gpio_num, true, &strip->channel);
+    if (err != ESP_OK) {
+        ESP_LOGI(TAG, "GPIO%d: DMA無しで動作します", gpio_num);
+        err = channel_new(gpio_num, false, &strip->channel);
+    }
+    if (err == ESP_OK) {
+        err = encoder_new(&strip->encoder);
+    }
+    if (err == ESP_OK) {
+        err = rmt_enable(strip->channel);
+    }
+    return err;
+}
+
+}  // namespace
+
+bool ws2812_init_strips(const ws2812_strip_config_t* configs, size_t count) {
+    ws2812_deinit();
+    if (count == 0 || count > WS2812_MAX_STRIPS) {
+        ESP_LOGE(TAG, "ストリップ数が不正: %d", (int)count);
+        return false;
+    }
+
+    size_t total = 0;
+    for (size_t i = 0; i < count; i++) {
+        strips[i].offset = total * 3;
+        strips[i].size = (size_t)configs[i].length * 3;
+        strips[i].length = configs[i].length;
+        total += configs[i].length;
+    }
+    if (total > UNMAPPED / 3) {
+        ESP_LOGE(TAG, "LED数が多すぎます: %d", (int)total);
+        return false;
+    }
+    strip_count = count;
+    logical_count = (uint16_t)total;
+    buffer_size = total * 3;
+
+    for (int i = 0; i < 2; i++) {
+        buffers[i] = (uint8_t*)heap_caps_calloc(1, buffer_size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        if (buffers[i] == nullptr) {
+            ESP_LOGE(TAG, "バッファ確保失敗");
+            ws2812_deinit();
+            return false;
+        }
+    }
+    front = buffers[0];
+    back = buffers[1];
+
+    pixel_map = (uint16_t*)heap_caps_malloc(total * sizeof(uint16_t), MALLOC_CAP_INTERNAL);
+    if (pixel_map == nullptr) {
+        ESP_LOGE(TAG, "対応表確保失敗");
+        ws2812_deinit();
+        return false;
+    }
+    for (size_t i = 0; i < total; i++) {
+        pixel_map[i] = (uint16_t)(i * 3);
+    }
+
+    // DMAを使えるチャネルは限られる (ESP32-S3は1つ) ので、送信時間の長いストリップから確保する
+    int order[WS2812_MAX_STRIPS];
+    for (size_t i = 0; i < count; i++) {
+        order[i] = (int)i;
+    }
+    std::stable_sort(order, order + count, [&](int a, int b) { return configs[a].length > configs[b].length; });
+    for (size_t i = 0; i < count; i++) {
+        int n = order[i];
+        esp_err_t err = strip_new(&strips[n], configs[n].gpio_num);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "GPIO%d: 初期化失敗: %s", configs[n].gpio_num, esp_err_to_name(err));
+            ws2812_deinit();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ws2812_init(int gpio_num, uint16_t max_leds) {
+    ws2812_strip_config_t config = { gpio_num, max_leds };
+    return ws2812_init_strips(&config, 1);
+}
+
+void ws2812_deinit() {
+    ws2812_wait();
+    for (size_t i = 0; i < WS2812_MAX_STRIPS; i++) {
+        strip_t& s = strips[i];
+        if (s.channel) {
+            rmt_disable(s.channel);  // 有効化前に失敗したチャネルではエラーになるが無視してよい
+            rmt_del_channel(s.channel);
+        }
+        if (s.encoder) {
+            encoder_del(&s.encoder->base);
+        }
+        s = {};
+    }
+    for (int i = 0; i < 2; i++) {
+        heap_caps_free(buffers[i]);
+        buffers[i] = nullptr;
+    }
+    heap_caps_free(pixel_map);
+    pixel_map = nullptr;
+    front = back = nullptr;
+    buffer_size = 0;
+    strip_count = 0;
+    logical_count = 0;
+}
+
+uint16_t ws2812_logical_count() {
+    return logical_count;
+}
+
+bool ws2812_map(uint16_t logical_start, uint16_t count, int strip, uint16_t strip_start, bool reverse) {
+    if (strip < 0 || strip >= (int)strip_count
+     || logical_start + count > logical_count
+     || strip_start + count > strips[strip].length) {
+        return false;
+    }
+    const strip_t& s = strips[strip];
+    for (uint16_t i = 0; i < count; i++) {
+        uint16_t pos = reverse ? (strip_start + count - 1 - i) : (strip_start + i);
+        pixel_map[logical_start + i] = (uint16_t)(s.offset + pos * 3);
+    }
+    ws2812_clear();
+    return true;
+}
+
+void ws2812_unmap(uint16_t logical_start, uint16_t count) {
+    for (uint32_t i = logical_start; i < (uint32_t)logical_start + count && i < logical_count; i++) {
+        pixel_map[i] = UNMAPPED;
+    }
+    ws2812_clear();
+}
+
+void ws2812_set_pixel(uint16_t index, uint8_t r, uint8_t g, uint8_t b) {
+    if (index >= logical_count) {
+        return;
+    }
+    uint16_t pos = pixel_map[index];
+    if (pos == UNMAPPED) {
+        return;
+    }
+    uint8_t* p = &back[pos];
+    p[0] = g;
+    p[1] = r;
+    p[2] = b;
+}
+
+void ws2812_clear() {
+    if (back) {
+        memset(back, 0, buffer_size);
+    }
+}
+
+bool ws2812_submit() {
+    if (strip_count == 0 || back == nullptr) {
+        return false;
+    }
+
+    // 内容が変わったストリップだけを送る
+    bool changed[WS2812_MAX_STRIPS];
+    bool any = false;
+    for (size_t i = 0; i < strip_count; i++) {
+        const strip_t& s = strips[i];
+        changed[i] = !s.sent_once || memcmp(front + s.offset, back + s.offset, s.size) != 0;
+        any |= changed[i];
+    }
+    if (!any) {
+        return false;
+    }
+    ws2812_wait();
+
+    // 書き込み側を送信側にし、新しい書き込み側には送信する内容を複写しておく
+    uint8_t* tmp = front;
+    front = back;
+    back = tmp;
+    memcpy(back, front, buffer_size);
+
+    // 各ストリップは別のチャネルなので、開始した送信は並行して進む
+    rmt_transmit_config_t tx_config = {};
+    tx_config.loop_count = 0;
+    bool sent = false;
+    for (size_t i = 0; i < strip_count; i++) {
+        strip_t& s = strips[i];
+        if (!changed[i] || s.size == 0) {
+            continue;
+        }
+        if (rmt_transmit(s.channel, &s.encoder->base, front + s.offset, s.size, &tx_config) != ESP_OK) {
+            continue;
+        }
+        s.transmitting = true;
+        s.sent_once = true;
+        sent = true;
+    }
+    return sent;
+}
+
+void ws2812_wait() {
+    for (size_t i = 0; i < strip_count; i++) {
+        if (strips[i].transmitting) {
+            rmt_tx_wait_all_done(strips[i].channel, -1);
+            strips[i].transmitting = false;
+        }
+    }
+}
@@ -5,6 +5,7 @@
  * - LCDに「Hello World」を表示
  * - エンコーダー回転でカウンター変更
  * - エンコーダーボタン押下でカウンターリセット
+ * - 画面の外周をなぞってカウンター変更、タップでカウンターリセット
  */
 
 #include <stdio.h>
@@ -13,7 +14,6 @@
 #include "freertos/task.h"
 #include "freertos/event_groups.h"
 #include "driver/gpio.h"
-#include "driver/ledc.h"
 #include "esp_log.h"
 #include "esp_wifi.h"
 #include "esp_event.h"
@@ -27,6 +27,10 @@
 #include <LovyanGFX.hpp>
 
 #include "wifi_credentials.h"
+#include "m5dial_buzzer.h"
+#include "m5dial_encoder.h"
+#include "m5dial_input.h"
+#include "m5dial_gesture.h"
 
 #ifndef MIN
 #define MIN(a, b) ((a) < (b) ? (a) : (b))
@@ -47,6 +51,16 @@ static const char *TAG = "M5Dial-Hello";
 #define ENCODER_B_PIN 40
 #define ENCODER_BTN_PIN 42
 
+// タッチパネル (FT3267, I2C)
+#define TOUCH_SDA_PIN 11
+#define TOUCH_SCL_PIN 12
+#define TOUCH_INT_PIN 14
+#define TOUCH_I2C_PORT 1
+
+// 入力
+#define LONG_PRESS_MS 500
+#define INPUT_BATCH 16  // 1回に取り出す入力イベントの数
+
 // ブザーピン定義
 #define BUZZER_PIN 3
 
@@ -55,6 +69,7 @@ class LGFX_M5Dial : public lgfx::LGFX_Device {
     lgfx::Panel_GC9A01 _panel_instance;
     lgfx::Bus_SPI _bus_instance;
     lgfx::Light_PWM _light_instance;
+    lgfx::Touch_FT5x06 _touch_instance;
 
 public:
     LGFX_M5Dial(void) {
@@ -97,6 +112,7 @@ public:
             cfg.bus_shared = true;
 
             _panel_instance.config(cfg);
+            _panel_instance.setRoundMask<240>();  // 円形表示部の外側は転送しない
         }
 
         // バックライト設定
@@ -111,15 +127,35 @@ public:
             _panel_instance.setLight(&_light_instance);
         }
 
+        // タッチパネル設定 (INTは触れている間Low。離している間はI2Cを読まない)
+        {
+            auto cfg = _touch_instance.config();
+            cfg.x_min = 0;
+            cfg.x_max = 239;
+            cfg.y_min = 0;
+            cfg.y_max = 239;
+            cfg.pin_int = TOUCH_INT_PIN;
+            cfg.bus_shared = false;
+            cfg.offset_rotation = 0;
+            cfg.i2c_port = TOUCH_I2C_PORT;
+            cfg.i2c_addr = 0x38;
+            cfg.pin_sda = TOUCH_SDA_PIN;
+            cfg.pin_scl = TOUCH_SCL_PIN;
+            cfg.freq = 400000;
+
+            _touch_instance.config(cfg);
+            _panel_instance.setTouch(&_touch_instance);
+        }
+
         setPanel(&_panel_instance);
     }
 };
 
 // グローバルインスタンス
 LGFX_M5Dial display;
-LGFX_Sprite canvas(&display);  // オフスクリーンバッファ
+LGFX_DisplayList canvas(&display);  // 描画命令を記録するキャンバス
+lgfx::GlyphCache glyph_cache;       // 描画済みの文字を矩形として保持し、フォントの展開を省略
 int32_t counter = 0;
-int32_t last_encoder_value = 0;
 
 // WiFi状態
 static EventGroupHandle_t wifi_event_group;
@@ -128,117 +164,6 @@ static char ip_address[16] = "Connecting...";
 static bool ota_in_progress = false;
 static int ota_progress = 0;
 
-// エンコーダー割り込み変数
-volatile int32_t encoder_count = 0;
-volatile int32_t encoder_raw = 0;
-static int8_t last_state = 0;
-
-// 直交エンコーダー状態テーブル: [前回状態][現在状態] -> 方向 (-1, 0, +1)
-// 状態: 00=0, 01=1, 11=2, 10=3 (グレイコード順)
-static const int8_t quad_table[4][4] = {
-    // 行先:  0   1   2   3   元:
-    {  0, +1,  0, -1 },  // 0
-    { -1,  0, +1,  0 },  // 1
-    {  0, -1,  0, +1 },  // 2
-    { +1,  0, -1,  0 },  // 3
-};
-
-// エンコーダーISR - 直交デコード
-static void IRAM_ATTR encoder_isr(void* arg) {
-    int a = gpio_get_level((gpio_num_t)ENCODER_A_PIN);
-    int b = gpio_get_level((gpio_num_t)ENCODER_B_PIN);
-
-    // グレイコード状態に変換 (0,1,3,2 -> 0,1,2,3)
-    int8_t state = (a << 1) | (a ^ b);
-
-    // 状態遷移から方向を取得
-    int8_t dir = quad_table[last_state][state];
-    encoder_raw += dir;
-    last_state = state;
-
-    // 生カウントをデテントカウントに変換 (1デテント = 4パルス)
-    encoder_count = encoder_raw / 4;
-}
-
-// ブザーリクエストフラグ (ISRで設定、メインループで処理)
-volatile bool buzzer_click_request = false;
-volatile bool buzzer_reset_request = false;
-
-// ボタンISR
-static void IRAM_ATTR button_isr(void* arg) {
-    counter = 0;
-    encoder_count = 0;
-    encoder_raw = 0;
-    buzzer_reset_request = true;
-}
-
-// ブザー初期化
-void buzzer_init() {
-    ledc_timer_config_t timer_conf = {
-        .speed_mode = LEDC_LOW_SPEED_MODE,
-        .duty_resolution = LEDC_TIMER_10_BIT,
-        .timer_num = LEDC_TIMER_0,
-        .freq_hz = 4000,
-        .clk_cfg = LEDC_AUTO_CLK
-    };
-    ledc_timer_config(&timer_conf);
-
-    ledc_channel_config_t channel_conf = {
-        .gpio_num = BUZZER_PIN,
-        .speed_mode = LEDC_LOW_SPEED_MODE,
-        .channel = LEDC_CHANNEL_0,
-        .intr_type = LEDC_INTR_DISABLE,
-        .timer_sel = LEDC_TIMER_0,
-        .duty = 0,
-        .hpoint = 0
-    };
-    ledc_channel_config(&channel_conf);
-
-    ESP_LOGI(TAG, "ブザー初期化完了");
-}
-
-// 短いビープ音を鳴らす
-void buzzer_beep(uint32_t freq, uint32_t duration_ms) {
-    ledc_set_freq(LEDC_LOW_SPEED_MODE, LEDC_TIMER_0, freq);
-    ledc_set_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0, 512);  // 50%デューティ
-    ledc_update_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0);
-
-    vTaskDelay(pdMS_TO_TICKS(duration_ms));
-
-    ledc_set_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0, 0);
-    ledc_update_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0);
-}
-
-// エンコーダー初期化
-void encoder_init() {
-    // エンコーダーピンを入力・プルアップ・両エッジ検出で設定
-    gpio_config_t io_conf = {};
-    io_conf.intr_type = GPIO_INTR_ANYEDGE;
-    io_conf.mode = GPIO_MODE_INPUT;
-    io_conf.pin_bit_mask = (1ULL << ENCODER_A_PIN) | (1ULL << ENCODER_B_PIN);
-    io_conf.pull_up_en = GPIO_PULLUP_ENABLE;
-    gpio_config(&io_conf);
-
-    // ボタンピンを設定
-    io_conf.intr_type = GPIO_INTR_NEGEDGE;
-    io_conf.pin_bit_mask = (1ULL << ENCODER_BTN_PIN);
-    io_conf.pull_up_en = GPIO_PULLUP_ENABLE;
-    gpio_config(&io_conf);
-
-    // 初期状態を取得
-    int a = gpio_get_level((gpio_num_t)ENCODER_A_PIN);
-    int b = gpio_get_level((gpio_num_t)ENCODER_B_PIN);
-    last_state = (a << 1) | (a ^ b);
-
-    // GPIO ISRサービスをインストール
-    gpio_install_isr_service(0);
-    gpio_isr_handler_add((gpio_num_t)ENCODER_A_PIN, encoder_isr, NULL);
-    gpio_isr_handler_add((gpio_num_t)ENCODER_B_PIN, encoder_isr, NULL);
-    gpio_isr_handler_add((gpio_num_t)ENCODER_BTN_PIN, button_isr, NULL);
-
-    ESP_LOGI(TAG, "エンコーダー初期化完了");
-}
-
 // ディスプレイ更新 (スプライトでちらつき防止)
 void update_display() {
     canvas.fillScreen(TFT_BLACK);
@@ -286,8 +211,19 @@ void update_display() {
         canvas.drawString("Rotate: Change | Press: Reset", 120, 220);
     }
 
-    // 一括でディスプレイに転送
-    canvas.pushSprite(0, 0);
+    // 記録した描画を24行ずつのバンドに展開しながらディスプレイに転送
+    canvas.pushList(0, 0);
+}
+
+// タッチパネルの位置を読む (入力イベントキューから、触れている間だけ呼ばれる)
+static bool read_touch(int16_t* x, int16_t* y, void*) {
+    lgfx::touch_point_t tp;
+    if (display.getTouch(&tp, 1) == 0) {
+        return false;
+    }
+    *x = tp.x;
+    *y = tp.y;
+    return true;
 }
 
 // ===== WiFi関数 =====
@@ -475,16 +411,25 @@ extern "C" void app_main(void) {
     display.setBrightness(128);
     display.setRotation(0);
 
-    // スプライトバッファ作成 (240x240, 16ビットカラー)
-    canvas.createSprite(240, 240);
+    // 描画記録領域と転送用バンド作成 (240x240, 16ビットカラー, 24行x2本)
+    canvas.setColorDepth(16);
+    canvas.createList(240, 240, 24);
+    canvas.setGlyphCache(&glyph_cache);
 
     ESP_LOGI(TAG, "ディスプレイ初期化完了");
 
     // ブザー初期化
-    buzzer_init();
+    buzzer_init(BUZZER_PIN);
+    ESP_LOGI(TAG, "ブザー初期化完了");
 
-    // エンコーダー初期化
-    encoder_init();
+    // エンコーダー初期化 (回転はPCNTで数え、回転とボタンは入力イベントキューで受け取る)
+    encoder_init(ENCODER_A_PIN, ENCODER_B_PIN);
+    input_init(ENCODER_BTN_PIN, LONG_PRESS_MS);
+    ESP_LOGI(TAG, "エンコーダー初期化完了");
+
+    // タッチパネル (タップと外周のドラッグを同じ入力イベントキューで受け取る)
+    input_touch_init(TOUCH_INT_PIN, read_touch, nullptr, GESTURE_CONFIG_M5DIAL);
+    ESP_LOGI(TAG, "タッチパネル初期化完了");
 
     // 初期表示
     update_display();
@@ -513,23 +458,29 @@ extern "C" void app_main(void) {
 
     // メインループ
     while (1) {
-        // ブザーリクエスト確認
-        if (buzzer_reset_request) {
-            buzzer_reset_request = false;
-            buzzer_beep(1000, 100);  // リセット用の低音
-            update_display();
+        // 入力を待ち、届いた順に1件ずつ処理する
+        input_event_t events[INPUT_BATCH];
+        size_t n = input_read(events, INPUT_BATCH, INPUT_WAIT_FOREVER);
+        bool changed = false;
+        bool reset = false;
+        for (size_t i = 0; i < n; i++) {
+            if (events[i].type == INPUT_DETENT || events[i].type == INPUT_RING) {
+                counter += events[i].value;
+                changed = true;
+            } else if (events[i].type == INPUT_PRESS || events[i].type == INPUT_TAP) {
+                counter = 0;
+                reset = true;
+            }
         }
 
-        // エンコーダー値変化確認
-        int32_t current_encoder = encoder_count;
-        if (current_encoder != last_encoder_value) {
-            counter = current_encoder;
-            last_encoder_value = current_encoder;
-            update_display();
+        if (reset) {
+            buzzer_beep(1000, 100);  // リセット用の低音
+        } else if (changed) {
             buzzer_beep(4000, 10);  // 短いクリック音
+        }
+        if (reset || changed) {
+            update_display();
             ESP_LOGI(TAG, "カウンター: %ld", counter);
         }
-
-        vTaskDelay(pdMS_TO_TICKS(20));
     }
 }
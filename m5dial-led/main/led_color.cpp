@@ -0,0 +1,101 @@
+/**
+ * LEDとUIの色変換
+ *
+ * 各チャンネルは 純色の値c (0-255) から
+ *   out = p + (v - p) * c / 255   (p = v * (255 - s) / 255 は彩度で持ち上がる最低値)
+ * で求める。c = 255 のチャンネルは v、c = 0 のチャンネルは p になる。
+ */
+#include "led_color.h"
+
+#include <math.h>
+#include <array>
+
+namespace {
+
+// 色相hの純色。6つの区間ごとに1チャンネルが上昇または下降する
+constexpr Rgb pure_hue(int h) {
+    int region = h / 60;
+    uint8_t rise = (uint8_t)((h - region * 60) * 255 / 60);
+    uint8_t fall = 255 - rise;
+    switch (region) {
+        case 0:  return { 255, rise, 0 };
+        case 1:  return { fall, 255, 0 };
+        case 2:  return { 0, 255, rise };
+        case 3:  return { 0, fall, 255 };
+        case 4:  return { rise, 0, 255 };
+        default: return { 255, 0, fall };
+    }
+}
+
+constexpr std::array<Rgb, 360> make_hue_table() {
+    std::array<Rgb, 360> table = {};
+    for (int h = 0; h < 360; h++) {
+        table[h] = pure_hue(h);
+    }
+    return table;
+}
+
+constexpr std::array<Rgb, 360> hue_table = make_hue_table();
+
+ColorCorrection correction;
+bool correction_enabled = false;
+
+inline Rgb convert(const Hsv& in) {
+    uint16_t h = in.h;
+    if (h >= 360) {
+        h -= 360;  // 360〜719は1周戻す (それ以上は呼び出し側で0〜359にすること)
+    }
+    const Rgb& c = hue_table[h];
+    uint8_t p = mul255(in.v, 255 - in.s);
+    uint8_t range = in.v - p;
+    return { (uint8_t)(p + mul255(range, c.r)), (uint8_t)(p + mul255(range, c.g)), (uint8_t)(p + mul255(range, c.b)) };
+}
+
+}  // namespace
+
+void hsv_to_rgb_n(const Hsv* in, Rgb* out, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = convert(in[i]);
+    }
+}
+
+void hsv_to_rgb565_n(const Hsv* in, uint16_t* out, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = rgb565(convert(in[i]));
+    }
+}
+
+Rgb hsv_to_rgb(uint16_t h, uint8_t s, uint8_t v) {
+    return convert({ h, s, v });
+}
+
+void blend_lerp_n(const Rgb* a, const Rgb* b, Rgb* out, size_t n, uint16_t weight) {
+    // a + (b - a) * weight / 256 (差が負でも算術シフトで a と b の間に収まる)
+    int w = weight;
+    for (size_t i = 0; i < n; i++) {
+        out[i].r = (uint8_t)(a[i].r + (((b[i].r - a[i].r) * w) >> 8));
+        out[i].g = (uint8_t)(a[i].g + (((b[i].g - a[i].g) * w) >> 8));
+        out[i].b = (uint8_t)(a[i].b + (((b[i].b - a[i].b) * w) >> 8));
+    }
+}
+
+void led_color_set_correction(float gamma, uint8_t white_r, uint8_t white_g, uint8_t white_b) {
+    if (gamma <= 0.0f && white_r == 255 && white_g == 255 && white_b == 255) {
+        correction_enabled = false;
+        return;
+    }
+    for (int i = 0; i < 256; i++) {
+        float x = i / 255.0f;
+        if (gamma > 0.0f) {
+            x = powf(x, gamma);
+        }
+        correction.r[i] = (uint8_t)(x * white_r + 0.5f);
+        correction.g[i] = (uint8_t)(x * white_g + 0.5f);
+        correction.b[i] = (uint8_t)(x * white_b + 0.5f);
+    }
+    correction_enabled = true;
+}
+
+const ColorCorrection* led_color_correction() {
+    return correction_enabled ? &correction : nullptr;
+}
@@ -0,0 +1,89 @@
+/**
+ * LEDとUIの色変換
+ *
+ * HSV→RGBは色相ごとの純色 (彩度・明度が最大の色) を表から引き、彩度と明度を掛け合わせて求める。
+ * 変換のループ内は整数の乗算とシフトだけで、除算と浮動小数点は使わない。
+ * LEDへの出力にはガンマ補正とホワイトバランスを1つにまとめた表を任意で掛けられる。
+ * エフェクトの切り替えの重ね合わせ (線形補間と加算・最大・乗算) も同じく整数演算で行う。
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+struct Rgb {
+    uint8_t r, g, b;
+};
+
+struct Hsv {
+    uint16_t h;  // 0-359
+    uint8_t s;
+    uint8_t v;
+};
+
+// x * y / 255 (四捨五入)
+static inline uint8_t mul255(uint8_t x, uint8_t y) {
+    uint32_t t = x * y + 128;
+    return (uint8_t)((t + (t >> 8)) >> 8);
+}
+
+// 0-255 の倍率を 8.8固定小数点 (256 = 1.0) にする
+static inline uint16_t q8_from_255(uint8_t x) {
+    return x + (x >> 7);
+}
+
+// 8.8固定小数点の倍率を掛ける (scale は 0〜256)
+static inline Rgb scale_q8(const Rgb& c, uint16_t scale) {
+    return { (uint8_t)((c.r * scale) >> 8), (uint8_t)((c.g * scale) >> 8), (uint8_t)((c.b * scale) >> 8) };
+}
+
+static inline uint16_t rgb565(const Rgb& c) {
+    return ((c.r & 0xF8) << 8) | ((c.g & 0xFC) << 3) | (c.b >> 3);
+}
+
+// 2色を重ねる方法
+enum BlendMode {
+    BLEND_ADD = 0,   // 加算 (255で飽和)
+    BLEND_MAX,       // チャンネルごとに明るい方
+    BLEND_MULTIPLY,  // 乗算 (白で変化なし)
+};
+
+static inline uint8_t blend_channel(uint8_t dst, uint8_t src, BlendMode mode) {
+    switch (mode) {
+        case BLEND_ADD:      return (uint8_t)(dst + src > 255 ? 255 : dst + src);
+        case BLEND_MAX:      return dst > src ? dst : src;
+        case BLEND_MULTIPLY: return mul255(dst, src);
+    }
+    return dst;
+}
+
+// dst に src を mode で重ねる
+static inline Rgb blend(const Rgb& dst, const Rgb& src, BlendMode mode) {
+    return { blend_channel(dst.r, src.r, mode), blend_channel(dst.g, src.g, mode), blend_channel(dst.b, src.b, mode) };
+}
+
+// a から b へ weight (8.8固定小数点, 0でa, 256でb) だけ近づけた色の配列を out に書く
+void blend_lerp_n(const Rgb* a, const Rgb* b, Rgb* out, size_t n, uint16_t weight);
+
+// HSVの配列をまとめてRGBに変換する
+void hsv_to_rgb_n(const Hsv* in, Rgb* out, size_t n);
+
+// HSVの配列をまとめてRGB565に変換する (画面表示用)
+void hsv_to_rgb565_n(const Hsv* in, uint16_t* out, size_t n);
+
+// 1色だけ変換する
+Rgb hsv_to_rgb(uint16_t h, uint8_t s, uint8_t v);
+
+// LED出力用の補正表 (チャンネルごとに 入力値 → 出力値)
+struct ColorCorrection {
+    uint8_t r[256];
+    uint8_t g[256];
+    uint8_t b[256];
+};
+
+// ガンマ値と白色点 (各チャンネルの最大出力) から補正表を作る
+// gamma が 0 以下で白色点が全て255の場合は補正なし。LEDタスクの開始前に呼ぶこと
+void led_color_set_correction(float gamma, uint8_t white_r, uint8_t white_g, uint8_t white_b);
+
+// 現在の補正表。補正なしの場合はnullptr
+const ColorCorrection* led_color_correction();
@@ -0,0 +1,214 @@
+/**
+ * LEDエフェクトの合成
+ *
+ * エフェクトは2つの層のどちらかで描かれ、各層は自分のフレームとLEDごとの状態の領域を持つ。
+ * エフェクトを切り替えると新しいエフェクトをもう一方の層で始め、fade_ms の間に
+ * 前のエフェクトから線形補間 (8.8固定小数点) で移り変わる。フェード中も前のエフェクトは動き続ける。
+ * 色相・彩度・明度の変更も同じ時間をかけて移る。
+ *
+ * 2つのエフェクトを描く分だけフェード中のフレームは重くなる。フェード中の処理時間が
+ * fade_budget_us を超えたフレームではフェードを打ち切り、新しいエフェクトだけにする。
+ *
+ * コントロールモードで位置を自分で表示しないエフェクト (handles_control = false) には、
+ * 位置の目印を highlight_mode で重ねる。
+ */
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "led_effects.h"
+
+template <typename Effects>
+class LedCompositor {
+public:
+    // max_leds 分のフレームと状態を確保する。fade_ms が0なら切り替えは即座に行う
+    bool init(uint16_t max_leds, uint32_t fade_ms, uint32_t fade_budget_us, BlendMode highlight_mode) {
+        for (Layer& layer : layers) {
+            layer.pixels = alloc_frame(max_leds);
+            layer.state = (uint8_t*)heap_caps_calloc(max_leds, EFFECT_STATE_BYTES_PER_LED, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+            if (layer.pixels == nullptr || layer.state == nullptr) {
+                return false;
+            }
+        }
+        output = alloc_frame(max_leds);
+        if (output == nullptr) {
+            return false;
+        }
+        leds = max_leds;
+        fade_us = fade_ms * 1000;
+        budget_us = fade_budget_us;
+        highlight = highlight_mode;
+        return true;
+    }
+
+    // 設定 target のエフェクトで count 個のLEDを描き、合成したフレームを返す
+    // 返したフレームは次に呼ぶまで有効
+    const Rgb* render(uint16_t count, const EffectTime& t, const LedSettings& target) {
+        LedSettings s = glide(target, t.dt_us);
+        size_t index = target.effect < Effects::count ? target.effect : 0;
+        switch_to(index);
+
+        Layer& in = layers[incoming];
+        Layer& out = layers[incoming ^ 1];
+        const Rgb* result = in.pixels;
+        if (out.effect != NONE) {
+            int64_t start = esp_timer_get_time();
+            fade_elapsed_us = std::min<uint32_t>(fade_elapsed_us + t.dt_us, fade_us);
+            uint16_t weight = fade_weight();
+            effects.render(out.effect, { out.pixels, count }, t, s);
+            effects.render(in.effect, { in.pixels, count }, t, s);
+            blend_lerp_n(out.pixels, in.pixels, output, count, weight);
+            result = output;
+
+            uint32_t work_us = (uint32_t)(esp_timer_get_time() - start);
+            if (weight < 256 && work_us > budget_us) {
+                cut_count++;  // 2つ分の描画が間に合わない: 残りのフェードを省く
+                end_fade();
+            } else if (weight >= 256) {
+                end_fade();
+            }
+        } else {
+            effects.render(in.effect, { in.pixels, count }, t, s);
+        }
+
+        // 目印は層のフレームに書き込まない (描画を省略するエフェクトのフレームに残らないように)
+        if (s.control_active && !Effects::handles_control(index) && count > 0) {
+            if (result != output) {
+                memcpy(output, result, count * sizeof(Rgb));
+                result = output;
+            }
+            draw_highlight(count, s);
+        }
+        return result;
+    }
+
+    bool fading() const { return layers[incoming ^ 1].effect != NONE; }
+    uint32_t fades_cut() const { return cut_count; }  // 処理時間の上限で打ち切ったフェードの数
+
+private:
+    static constexpr size_t NONE = SIZE_MAX;
+
+    struct Layer {
+        Rgb* pixels = nullptr;
+        uint8_t* state = nullptr;
+        size_t effect = NONE;
+    };
+
+    static Rgb* alloc_frame(uint16_t n) {
+        return (Rgb*)heap_caps_calloc(n, sizeof(Rgb), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    }
+
+    // 新しいエフェクトの割合 (8.8固定小数点)
+    uint16_t fade_weight() const {
+        return fade_us ? (uint16_t)((uint64_t)fade_elapsed_us * 256 / fade_us) : 256;
+    }
+
+    void start(Layer& layer, size_t index) {
+        effects.enter(index, layer.state, leds);
+        layer.effect = index;
+    }
+
+    void stop(Layer& layer) {
+        if (layer.effect != NONE) {
+            effects.leave(layer.effect);
+            layer.effect = NONE;
+        }
+    }
+
+    void end_fade() {
+        stop(layers[incoming ^ 1]);
+        fade_elapsed_us = 0;
+    }
+
+    void switch_to(size_t index) {
+        Layer& in = layers[incoming];
+        if (index == in.effect) {
+            return;
+        }
+        if (in.effect == NONE || fade_us == 0) {
+            stop(in);
+            start(in, index);
+            return;
+        }
+
+        Layer& out = layers[incoming ^ 1];
+        if (out.effect == index) {
+            // フェード中に元のエフェクトに戻した: 同じ位置から逆向きにフェードする
+            incoming ^= 1;
+            fade_elapsed_us = fade_us - fade_elapsed_us;
+            return;
+        }
+        if (out.effect != NONE) {
+            // フェード中にさらに切り替えた: 表示の割合が大きい方を前のエフェクトとして残す
+            if (fade_weight() >= 128) {
+                stop(out);
+            } else {
+                stop(in);
+                incoming ^= 1;
+            }
+        }
+        incoming ^= 1;
+        start(layers[incoming], index);
+        fade_elapsed_us = 0;
+    }
+
+    // 色相・彩度・明度を、変わった時点で表示していた値から目標へ fade_us かけて移す
+    LedSettings glide(const LedSettings& target, uint32_t dt_us) {
+        if (fade_us == 0 || !glide_started) {
+            glide_from = glide_to = shown = target;
+            glide_started = true;
+            return target;
+        }
+        if (target.hue != glide_to.hue || target.saturation != glide_to.saturation || target.brightness != glide_to.brightness) {
+            glide_from = shown;
+            glide_to = target;
+            glide_elapsed_us = 0;
+        }
+        glide_elapsed_us = std::min<uint32_t>(glide_elapsed_us + dt_us, fade_us);
+        int w = (int)((uint64_t)glide_elapsed_us * 256 / fade_us);
+
+        shown = target;
+        int dh = glide_to.hue - glide_from.hue;  // 近い方向へ回す
+        if (dh > 180) dh -= 360;
+        if (dh < -180) dh += 360;
+        int h = glide_from.hue + ((dh * w) >> 8);
+        shown.hue = (uint16_t)(h < 0 ? h + 360 : (h >= 360 ? h - 360 : h));
+        shown.saturation = (uint8_t)(glide_from.saturation + (((glide_to.saturation - glide_from.saturation) * w) >> 8));
+        shown.brightness = (uint8_t)(glide_from.brightness + (((glide_to.brightness - glide_from.brightness) * w) >> 8));
+        return shown;
+    }
+
+    // コントロールモードの位置に目印 (中心と両隣は半分の明るさ) を重ねる
+    void draw_highlight(uint16_t count, const LedSettings& s) {
+        Rgb c = hsv_to_rgb(s.hue, s.saturation, s.brightness);
+        int pos = s.control_position % count;
+        output[pos] = blend(output[pos], c, highlight);
+        if (count >= 3) {
+            Rgb half = scale_q8(c, 128);
+            int prev = pos == 0 ? count - 1 : pos - 1;
+            int next = pos == count - 1 ? 0 : pos + 1;
+            output[prev] = blend(output[prev], half, highlight);
+            output[next] = blend(output[next], half, highlight);
+        }
+    }
+
+    Effects effects;
+    Layer layers[2];
+    int incoming = 0;  // 表示が増えていく側 (フェード中でなければ表示中の層)
+    Rgb* output = nullptr;
+    uint16_t leds = 0;
+    uint32_t fade_us = 0;
+    uint32_t fade_elapsed_us = 0;
+    uint32_t budget_us = 0;
+    uint32_t cut_count = 0;
+    BlendMode highlight = BLEND_ADD;
+
+    bool glide_started = false;
+    LedSettings glide_from = {};
+    LedSettings glide_to = {};
+    LedSettings shown = {};
+    uint32_t glide_elapsed_us = 0;
+};
@@ -0,0 +1,432 @@
+/**
+ * LEDエフェクトの実装
+ *
+ * 各エフェクトは点灯中のLED (frame.count個) だけを描く。消灯側のLEDは出力側で消す。
+ * 動きは EffectTime の経過時間から決めるため、LEDタスクのフレームレートによらず同じ速さになる。
+ */
+#include "led_effects.h"
+
+#include <string.h>
+#include "led_random.h"
+#include "m5dial_buzzer.h"
+
+#ifndef MIN
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+#endif
+
+// 1ティックあたり1/nの確率で起きる事象が、ticksティックの間に起きる確率を led_rng.chance() の比較値にする
+static uint32_t chance_threshold(float ticks, int n) {
+    float p = ticks / n;
+    if (p >= 1.0f) {
+        return UINT32_MAX;
+    }
+    return (uint32_t)(p * 4294967295.0f);
+}
+
+// make(i) が返すHSVで点灯中の全LEDを描く
+// HSVは HSV_CHUNK 個ずつ作って変換するため、作業領域はLED数によらず一定
+#define HSV_CHUNK 32
+template <typename Make>
+static void render_hsv(const LedFrame& frame, Make make) {
+    Hsv hsv[HSV_CHUNK];
+    for (int base = 0; base < frame.count; base += HSV_CHUNK) {
+        int n = MIN(HSV_CHUNK, frame.count - base);
+        for (int i = 0; i < n; i++) {
+            hsv[i] = make(base + i);
+        }
+        hsv_to_rgb_n(hsv, &frame.pixels[base], n);
+    }
+}
+
+// 背景 (選ばれていないLED) の暗い色
+static inline Rgb dim(const Rgb& c) {
+    return { (uint8_t)(c.r / 15), (uint8_t)(c.g / 15), (uint8_t)(c.b / 15) };
+}
+
+// ===== 単色 =====
+
+void SolidEffect::render(const LedFrame& frame, const EffectTime& t, const LedSettings& s) {
+    Rgb c = hsv_to_rgb(s.hue, s.saturation, s.brightness);
+    if (!s.control_active) {
+        frame.fill(c);
+        return;
+    }
+    // コントロールモード: control_positionの位置だけ点灯
+    frame.fill(dim(c));
+    if (s.control_position < frame.count) {
+        frame[s.control_position] = c;
+    }
+}
+
+// ===== 追いかけ =====
+
+void ChaseEffect::render(const LedFrame& frame, const EffectTime& t, const LedSettings& s) {
+    Rgb c = hsv_to_rgb(s.hue, s.saturation, s.brightness);
+    int num_chasers = 3;  // 追いかける光の数
+    int spacing = frame.count / num_chasers;
+    int base_pos = s.control_active ? s.control_position : ((t.counter / 2) % frame.count);
+
+    frame.fill(dim(c));
+    for (int i = 0; i < num_chasers; i++) {
+        frame[(base_pos + i * spacing) % frame.count] = c;
+    }
+}
+
+// ===== 往復 =====
+
+void BounceEffect::render(const LedFrame& frame, const EffectTime& t, const LedSettings& s) {
+    Rgb c = hsv_to_rgb(s.hue, s.saturation, s.brightness);
+    int bounce_pos;
+    if (s.control_active) {
+        bounce_pos = s.control_position;
+    } else if (frame.count > 1) {
+        int cycle = (frame.count - 1) * 2;
+        int pos_in_cycle = (t.counter / 2) % cycle;
+        bounce_pos = (pos_in_cycle < frame.count) ? pos_in_cycle : (cycle - pos_in_cycle);
+    } else {
+        bounce_pos = 0;
+    }
+
+    frame.fill(dim(c));
+    if (bounce_pos < frame.count) {
+        frame[bounce_pos] = c;
+    }
+}
+
+// ===== コメット =====
+
+void CometEffect::render(const LedFrame& frame, const EffectTime& t, const LedSettings& s) {
+    const int tail_length = 5;
+    Rgb c = hsv_to_rgb(s.hue, s.saturation, s.brightness);
+    int comet_head = s.control_active ? s.control_position : ((t.counter / 2) % frame.count);
+
+    // 頭部からの距離ごとの色 (尾は距離に比例して減衰)
+    Rgb colors[tail_length + 1];
+    colors[0] = c;
+    for (int d = 1; d <= tail_length; d++) {
+        colors[d] = scale_q8(c, 256 - d * 256 / (tail_length + 1));
+    }
+
+    for (int i = 0; i < frame.count; i++) {
+        int distance = comet_head - i;
+        if (distance < 0) {
+            distance += frame.count;
+        }
+        frame[i] = (distance <= tail_length) ? colors[distance] : Rgb{ 0, 0, 0 };
+    }
+}
+
+// ===== レインボー =====
+
+void RainbowEffect::render(const LedFrame& frame, const EffectTime& t, const LedSettings& s) {
+    int offset = s.control_active ? (s.control_position * 360 / frame.count) : (t.counter * 2 % 360);
+
+    // i * 360 / count を商と余りに分けて加算で求める (ループ内で除算しない)
+    int step = 360 / frame.count;
+    int step_rem = 360 % frame.count;
+    int hue = offset;
+    int rem = 0;
+    render_hsv(frame, [&](int) {
+        Hsv c = { (uint16_t)(hue >= 360 ? hue - 360 : hue), s.saturation, s.brightness };
+        hue += step;
+        rem += step_rem;
+        if (rem >= frame.count) {
+            rem -= frame.count;
+            hue++;
+        }
+        return c;
+    });
+}
+
+// ===== ランダム点滅 =====
+
+void RandomBlinkEffect::enter() {
+    last_tick = UINT32_MAX;
+}
+
+void RandomBlinkEffect::render(const LedFrame& frame, const EffectTime& t, const LedSettings& s) {
+    // 点滅の抽選は1ティックに1回 (フレームレートが上がっても点滅の速さは変わらない)
+    // 抽選しないフレームはフレームに前回の内容が残っているのでそのまま送る
+    if (t.tick == last_tick && frame.count == last_count) {
+        return;
+    }
+    last_tick = t.tick;
+    last_count = frame.count;
+
+    // 速度が高いほど点滅が頻繁
+    int blink_threshold = 20 - s.speed;  // 速度1=19, 速度9=11
+    render_hsv(frame, [&](int) {
+        if (led_rng.below(blink_threshold) == 0) {
+            // ランダムな色と位置
+            return Hsv{ (uint16_t)led_rng.below(360), s.saturation, s.brightness };
+        }
+        return Hsv{ 0, 0, 0 };
+    });
+}
+
+// ===== 蛍 =====
+
+// 蛍1匹の状態 (uint16_t)
+// 上位2ビットが向き、下位14ビットが輝度 (1/64単位, 0〜250)
+#define FIREFLY_FADE_IN   0x4000
+#define FIREFLY_FADE_OUT  0x8000
+#define FIREFLY_LEVEL     0x3FFF
+#define FIREFLY_LEVEL_MAX (250 << 6)
+
+// 状態の領域の先頭2バイト×LED数を蛍に使う
+void FireflyEffect::enter() {
+    memset(state, 0, (size_t)state_leds * EFFECT_STATE_BYTES_PER_LED);
+}
+
+void FireflyEffect::frame_params(const EffectTime& t, const LedSettings& s, uint32_t* fade_step, uint32_t* start_chance) {
+    // 速度が高いほどフェードが速く、開始が頻繁
+    *fade_step = (uint32_t)(s.speed * t.ticks * 64);  // 1ティックあたり 速度1=1, 速度9=9
+    int start_threshold = 110 - s.speed * 10;  // 1ティックあたり 速度1=1/100, 速度9=1/20
+    *start_chance = chance_threshold(t.ticks, start_threshold);
+}
+
+uint8_t FireflyEffect::step(int i, uint32_t fade_step, uint32_t start_chance, bool* started) {
+    uint16_t* fireflies = (uint16_t*)state;
+    uint16_t bits = fireflies[i];
+    uint32_t level = bits & FIREFLY_LEVEL;
+    *started = false;
+
+    // ランダムに光り始める
+    if (bits == 0) {
+        if (led_rng.chance(start_chance)) {
+            bits = FIREFLY_FADE_IN;  // フェードイン開始
+            *started = true;
+        }
+    }
+
+    // 輝度更新
+    if (bits & FIREFLY_FADE_IN) {
+        level = MIN((uint32_t)FIREFLY_LEVEL_MAX, level + fade_step);
+        // 最大になったらフェードアウト開始
+        bits = (uint16_t)((level >= FIREFLY_LEVEL_MAX ? FIREFLY_FADE_OUT : FIREFLY_FADE_IN) | level);
+    } else if (bits & FIREFLY_FADE_OUT) {
+        // 消えきったら完了
+        bits = (level > fade_step) ? (uint16_t)(FIREFLY_FADE_OUT | (level - fade_step)) : 0;
+    }
+    fireflies[i] = bits;
+    return (uint8_t)((bits & FIREFLY_LEVEL) >> 6);
+}
+
+void FireflyEffect::render(const LedFrame& frame, const EffectTime& t, const LedSettings& s) {
+    uint32_t fade_step, start_chance;
+    frame_params(t, s, &fade_step, &start_chance);
+    Rgb c = hsv_to_rgb(s.hue, s.saturation, s.brightness);
+    for (int i = 0; i < frame.count; i++) {
+        bool started;
+        uint8_t level = step(i, fade_step, start_chance, &started);
+        frame[i] = scale_q8(c, q8_from_255(level));
+    }
+}
+
+// ===== ランダム蛍 =====
+
+void RandomFireflyEffect::render(const LedFrame& frame, const EffectTime& t, const LedSettings& s) {
+    uint32_t fade_step, start_chance;
+    frame_params(t, s, &fade_step, &start_chance);
+
+    // 色相は蛍の状態の後ろに1バイト (360度を256段階) で持つ
+    uint8_t* hues = state + (size_t)state_leds * 2;
+    render_hsv(frame, [&](int i) {
+        bool started;
+        uint8_t level = step(i, fade_step, start_chance, &started);
+        if (started) {
+            hues[i] = (uint8_t)(led_rng.next() >> 24);  // 光り始めるごとにランダムな色
+        }
+        // 各蛍に個別のランダム色相を使用
+        return Hsv{ (uint16_t)((hues[i] * 360) >> 8), s.saturation, mul255(s.brightness, level) };
+    });
+}
+
+// ===== 心拍 =====
+
+void HeartbeatEffect::render(const LedFrame& frame, const EffectTime& t, const LedSettings& s) {
+    // 心拍パターン: 素早い二重パルス、その後休止
+    int cycle = 100;
+    int pos = t.counter % cycle;
+    int brightness_scale;  // 0〜10
+
+    if (pos < 10) {
+        // 第1拍 上昇
+        brightness_scale = pos;
+    } else if (pos < 20) {
+        // 第1拍 下降
+        brightness_scale = 20 - pos;
+    } else if (pos < 30) {
+        // 第2拍 上昇
+        brightness_scale = pos - 20;
+    } else if (pos < 40) {
+        // 第2拍 下降
+        brightness_scale = 40 - pos;
+    } else {
+        // 休止
+        brightness_scale = 0;
+    }
+
+    frame.fill(hsv_to_rgb(s.hue, s.saturation, (uint8_t)(s.brightness * brightness_scale / 10)));
+}
+
+// ===== クリスマスソング =====
+
+// Xmas Songメロディデータ (ジングルベル)
+// 注: 周波数はHz、0 = 休符
+struct MelodyNote {
+    uint16_t freq;    // 周波数 (Hz)
+    uint8_t duration; // 長さ (1単位 = 基本テンポ)
+    uint16_t hue;     // この音の色相
+};
+
+// 音階の周波数
+#define NOTE_C4  262
+#define NOTE_D4  294
+#define NOTE_E4  330
+#define NOTE_F4  349
+#define NOTE_G4  392
+#define NOTE_A4  440
+#define NOTE_B4  494
+#define NOTE_C5  523
+#define NOTE_REST 0
+
+// ジングルベルのメロディと色 (正確な楽譜)
+// ハ長調 - 色: C=赤, D=オレンジ, E=黄, F=緑, G=シアン
+// 注: VerseとChorusは同じメロディパターン
+static const MelodyNote xmas_melody[] = {
+    // === 1番 ===
+    // 「走れそりよ」 (E E E-)
+    {NOTE_E4, 1, 60},  {NOTE_E4, 1, 60},  {NOTE_E4, 2, 60},
+    // 「風のように」 (E E E-)
+    {NOTE_E4, 1, 60},  {NOTE_E4, 1, 60},  {NOTE_E4, 2, 60},
+    // 「雪の中を」 (E G C D)
+    {NOTE_E4, 1, 60},  {NOTE_G4, 1, 180}, {NOTE_C4, 1, 0},   {NOTE_D4, 1, 30},
+    // 「軽く」 (E-)
+    {NOTE_E4, 2, 60},  {NOTE_REST, 1, 0},
+    // 「鈴が鳴る」 (F F F F)
+    {NOTE_F4, 1, 120}, {NOTE_F4, 1, 120}, {NOTE_F4, 1, 120}, {NOTE_F4, 1, 120},
+    // 「リンリンリン」 (F E E E)
+    {NOTE_F4, 1, 120}, {NOTE_E4, 1, 60},  {NOTE_E4, 1, 60},  {NOTE_E4, 1, 60},
+    // 「鈴が鳴る」 (E D D E)
+    {NOTE_E4, 1, 60},  {NOTE_D4, 1, 30},  {NOTE_D4, 1, 30},  {NOTE_E4, 1, 60},
+    // 「楽しいな」 (D- G-)
+    {NOTE_D4, 2, 30},  {NOTE_G4, 2, 180},
+    {NOTE_REST, 2, 0},
+    // === サビ ===
+    // 「ジングルベル」 (E E E-, E E E-)
+    {NOTE_E4, 1, 60},  {NOTE_E4, 1, 60},  {NOTE_E4, 2, 60},
+    {NOTE_E4, 1, 60},  {NOTE_E4, 1, 60},  {NOTE_E4, 2, 60},
+    // 「ジングルベル」 (E G C D E-)
+    {NOTE_E4, 1, 60},  {NOTE_G4, 1, 180}, {NOTE_C4, 1, 0},   {NOTE_D4, 1, 30}, {NOTE_E4, 2, 60},
+    {NOTE_REST, 1, 0},
+    // 「鈴が鳴る」 (F F F F F E E E)
+    {NOTE_F4, 1, 120}, {NOTE_F4, 1, 120}, {NOTE_F4, 1, 120}, {NOTE_F4, 1, 120},
+    {NOTE_F4, 1, 120}, {NOTE_E4, 1, 60},  {NOTE_E4, 1, 60},  {NOTE_E4, 1, 60},
+    // 「楽しいそり遊び」 (G G F D C-)
+    {NOTE_G4, 1, 180}, {NOTE_G4, 1, 180}, {NOTE_F4, 1, 120}, {NOTE_D4, 1, 30}, {NOTE_C4, 2, 0},
+    {NOTE_REST, 4, 0},
+};
+#define XMAS_MELODY_LENGTH (sizeof(xmas_melody) / sizeof(xmas_melody[0]))
+
+// 各LEDの色相は状態の領域に1バイト (色相/2) で持ち、XMAS_HUE_OFF は消灯
+#define XMAS_HUE_OFF 0xFF
+
+// 切り替えたら曲の先頭から
+void XmasSongEffect::enter() {
+    memset(state, XMAS_HUE_OFF, state_leds);  // 全て消灯
+    melody_index = 0;
+    current_led_pos = 0;
+    note_elapsed_us = 0;
+    note_duration_us = 0;
+    last_control_pos = -1;
+}
+
+// Xmas Songエフェクト以外に切り替えたらブザーを停止
+void XmasSongEffect::leave() {
+    buzzer_stop();
+}
+
+// 音を鳴らしてLEDを点灯する
+// 音の長さ (スタッカート) はブザー側で計時するので、ここでは鳴らし始めるだけ
+void XmasSongEffect::play_note(int note_idx, int led_pos, int duration_ms) {
+    const MelodyNote* note = &xmas_melody[note_idx];
+
+    // LED配列に色を保存 (以前の色を維持)
+    if (note->freq > 0) {
+        state[led_pos] = (uint8_t)(note->hue / 2);
+    }
+
+    // 前の音を打ち切ってから鳴らす
+    buzzer_stop();
+    if (note->freq > 0 && duration_ms > 0) {
+        buzzer_tone(note->freq, duration_ms, BUZZER_DUTY_QUARTER);
+    }
+}
+
+void XmasSongEffect::render(const LedFrame& frame, const EffectTime& t, const LedSettings& s) {
+    int led_count = frame.count;
+
+    // テンポ制御: 速度が高いほどテンポが速い
+    int base_duration = 15 - s.speed;  // 速度1=14, 速度9=6 ティック/単位
+
+    if (s.control_active) {
+        // コントロールモード: ユーザーが手動でメロディを進める
+        if (s.control_position != last_control_pos) {
+            // ダイヤルが動いた - 次の音を再生
+            int diff = s.control_position - last_control_pos;
+            if (diff > led_count / 2) diff -= led_count;
+            if (diff < -led_count / 2) diff += led_count;
+
+            if (diff > 0) {
+                // 前進 - 音を再生
+                for (int j = 0; j < diff; j++) {
+                    melody_index = (melody_index + 1) % XMAS_MELODY_LENGTH;
+                    current_led_pos = (current_led_pos + 1) % led_count;
+                    play_note(melody_index, current_led_pos, 8 * EFFECT_TICK_MS);  // スタッカート
+                }
+            } else if (diff < 0) {
+                // 後退 - LEDをクリア
+                for (int j = 0; j < -diff; j++) {
+                    state[current_led_pos] = XMAS_HUE_OFF;
+                    current_led_pos = (current_led_pos - 1 + led_count) % led_count;
+                    melody_index = (melody_index - 1 + XMAS_MELODY_LENGTH) % XMAS_MELODY_LENGTH;
+                }
+                buzzer_stop();
+            }
+            last_control_pos = s.control_position;
+        }
+    } else {
+        // 自動モード: メロディを自動再生
+        last_control_pos = s.control_position;  // コントロールモード移行時の同期用
+
+        // 次の音を再生する必要があるか確認
+        if (note_elapsed_us >= note_duration_us) {
+            // 超過した分は次の音に繰り越し、フレーム周期の端数でテンポがずれないようにする
+            note_elapsed_us = MIN(note_elapsed_us - note_duration_us, (uint32_t)(EFFECT_TICK_MS * 1000));
+
+            melody_index = (melody_index + 1) % XMAS_MELODY_LENGTH;
+            current_led_pos = (current_led_pos + 1) % led_count;
+
+            // 全LEDを巡ったらリセット
+            if (current_led_pos == 0) {
+                memset(state, XMAS_HUE_OFF, state_leds);
+            }
+
+            note_duration_us = xmas_melody[melody_index].duration * base_duration * EFFECT_TICK_MS * 1000;
+            // スタッカート効果: 次の音の2ティック前に止める
+            play_note(melody_index, current_led_pos, note_duration_us / 1000 - 2 * EFFECT_TICK_MS);
+        }
+
+        note_elapsed_us += t.dt_us;
+    }
+
+    // 保存された色で全ての点灯LEDを表示
+    const uint8_t* hues = state;
+    render_hsv(frame, [&](int i) {
+        if (hues[i] != XMAS_HUE_OFF) {
+            return Hsv{ (uint16_t)(hues[i] * 2), s.saturation, s.brightness };
+        }
+        return Hsv{ 0, 0, 0 };
+    });
+}
@@ -0,0 +1,218 @@
+/**
+ * LEDエフェクト
+ *
+ * 各エフェクトは自分の状態をメンバに持つクラスで、render() で点灯中のLEDの範囲だけを描く。
+ * LedEffects<...> に並べた順がエフェクト番号になり、番号から各エフェクトの render() への
+ * 振り分けはコンパイル時に作る関数表で行う (switchや仮想関数を使わない)。
+ *
+ * LEDごとの状態 (蛍の輝度など) はエフェクトを描く層 (LedCompositor) の領域を借りて state に置き、
+ * エフェクトを始めるたびに enter() で初期化する。1LEDあたり EFFECT_STATE_BYTES_PER_LED バイト。
+ * 切り替えのフェード中は前後のエフェクトがそれぞれ別の層で同時に描かれる。
+ *
+ * エフェクトの追加:
+ * 1. EffectBase を継承したクラスを作り render() を実装する
+ *    (切り替え時の初期化や後始末が必要なら enter() / leave() も定義する)
+ *    コントロールモードの位置を自分で表示するなら handles_control を true にする
+ * 2. main.cpp の LedEffects<...> の並びと effect_names[] に追加する
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <array>
+#include <tuple>
+#include <utility>
+#include "led_color.h"
+
+#define LED_MAX_PIXELS 2048        // 論理ストリップのLED数の上限
+#define EFFECT_STATE_BYTES_PER_LED 3  // エフェクトがLEDごとに持てる状態の大きさ
+#define EFFECT_TICK_MS 20          // エフェクトの速さの基準となる1ティック
+
+// エフェクトに渡す設定 (UIのLED状態のスナップショット)
+struct LedSettings {
+    uint16_t hue;
+    uint8_t saturation;
+    uint8_t brightness;
+    uint16_t count;
+    uint8_t effect;
+    uint8_t speed;
+    bool on;
+    bool control_active;
+    int16_t control_position;
+};
+
+// 点灯中のLEDの画素 (pixels[0]〜pixels[count-1])
+struct LedFrame {
+    Rgb* pixels;
+    uint16_t count;
+
+    Rgb& operator[](int i) const { return pixels[i]; }
+
+    void fill(const Rgb& c) const {
+        for (int i = 0; i < count; i++) pixels[i] = c;
+    }
+};
+
+// フレームの時刻
+struct EffectTime {
+    uint32_t dt_us;    // 前のフレームからの経過時間
+    float ticks;       // dt_us をティック単位にしたもの
+    uint32_t tick;     // 起動からのティック数
+    uint32_t counter;  // 速度×ティック数 (速度1で1ティックに1進む)
+};
+
+// ===== エフェクト =====
+
+// enter() / leave() は必要なエフェクトだけが同名の関数で隠す
+// leave() はフェードアウトが終わって層から外すときに呼ばれる
+struct EffectBase {
+    void enter() {}
+    void leave() {}
+
+    // コントロールモードの位置を自分で表示するか (falseなら合成時に位置を重ねて表示する)
+    static constexpr bool handles_control = false;
+
+    uint8_t* state = nullptr;  // LEDごとの状態 (enter() の前に設定される)
+    uint16_t state_leds = 0;   // state のLED数
+};
+
+// 単色
+struct SolidEffect : EffectBase {
+    static constexpr bool handles_control = true;
+    void render(const LedFrame& frame, const EffectTime& t, const LedSettings& s);
+};
+
+// 追いかけ (複数の光が流れる)
+struct ChaseEffect : EffectBase {
+    static constexpr bool handles_control = true;
+    void render(const LedFrame& frame, const EffectTime& t, const LedSettings& s);
+};
+
+// 往復 (光が左右に跳ね返る)
+struct BounceEffect : EffectBase {
+    static constexpr bool handles_control = true;
+    void render(const LedFrame& frame, const EffectTime& t, const LedSettings& s);
+};
+
+// コメット (明るい頭部と減衰する尾)
+struct CometEffect : EffectBase {
+    static constexpr bool handles_control = true;
+    void render(const LedFrame& frame, const EffectTime& t, const LedSettings& s);
+};
+
+// レインボー (虹色が流れる)
+struct RainbowEffect : EffectBase {
+    static constexpr bool handles_control = true;
+    void render(const LedFrame& frame, const EffectTime& t, const LedSettings& s);
+};
+
+// ランダム点滅
+struct RandomBlinkEffect : EffectBase {
+    void enter();
+    void render(const LedFrame& frame, const EffectTime& t, const LedSettings& s);
+
+private:
+    uint32_t last_tick = UINT32_MAX;  // 最後に抽選したティック
+    uint16_t last_count = 0;
+};
+
+// 蛍 (ランダム位置でゆっくりフェードイン/アウト)
+struct FireflyEffect : EffectBase {
+    void enter();
+    void render(const LedFrame& frame, const EffectTime& t, const LedSettings& s);
+
+protected:
+    // i番目の蛍の輝度をfade_step (1/64単位) だけ進め、輝度 (0〜250) を返す
+    // 消灯中の蛍は start_chance / 2^32 の確率で光り始め、その場合 *started がtrueになる
+    uint8_t step(int i, uint32_t fade_step, uint32_t start_chance, bool* started);
+
+    // 速度と経過時間から、このフレームのフェード量と光り始める確率を求める
+    static void frame_params(const EffectTime& t, const LedSettings& s, uint32_t* fade_step, uint32_t* start_chance);
+};
+
+// ランダム蛍 (ランダムな色の蛍)
+struct RandomFireflyEffect : FireflyEffect {
+    void render(const LedFrame& frame, const EffectTime& t, const LedSettings& s);
+};
+
+// 心拍
+struct HeartbeatEffect : EffectBase {
+    void render(const LedFrame& frame, const EffectTime& t, const LedSettings& s);
+};
+
+// クリスマスソング (メロディに合わせてLEDを順に点灯)
+struct XmasSongEffect : EffectBase {
+    static constexpr bool handles_control = true;
+
+    void enter();
+    void leave();
+    void render(const LedFrame& frame, const EffectTime& t, const LedSettings& s);
+
+private:
+    void play_note(int note_idx, int led_pos, int duration_ms);
+
+    int melody_index = 0;
+    int current_led_pos = 0;
+    uint32_t note_elapsed_us = 0;   // 現在の音が始まってからの時間
+    uint32_t note_duration_us = 0;  // 現在の音の長さ
+    int last_control_pos = -1;
+};
+
+// ===== エフェクトの振り分け =====
+
+// エフェクト番号から各エフェクトを呼ぶ。どのエフェクトを描くかの管理は LedCompositor が行う
+template <typename... Effects>
+class LedEffects {
+public:
+    static constexpr size_t count = sizeof...(Effects);
+
+    // index番のエフェクトを始める。state は leds 個分のLEDごとの状態の領域
+    void enter(size_t index, uint8_t* state, uint16_t leds) { enter_table[index](effects, state, leds); }
+    void leave(size_t index) { leave_table[index](effects); }
+
+    void render(size_t index, const LedFrame& frame, const EffectTime& t, const LedSettings& s) {
+        render_table[index](effects, frame, t, s);
+    }
+
+    static bool handles_control(size_t index) { return control_table[index]; }
+
+private:
+    using Tuple = std::tuple<Effects...>;
+    using RenderFn = void (*)(Tuple&, const LedFrame&, const EffectTime&, const LedSettings&);
+    using EnterFn = void (*)(Tuple&, uint8_t*, uint16_t);
+    using LeaveFn = void (*)(Tuple&);
+
+    template <size_t I>
+    static void render_one(Tuple& e, const LedFrame& frame, const EffectTime& t, const LedSettings& s) {
+        std::get<I>(e).render(frame, t, s);
+    }
+    template <size_t I>
+    static void enter_one(Tuple& e, uint8_t* state, uint16_t leds) {
+        auto& effect = std::get<I>(e);
+        effect.state = state;
+        effect.state_leds = leds;
+        effect.enter();
+    }
+    template <size_t I>
+    static void leave_one(Tuple& e) { std::get<I>(e).leave(); }
+
+    template <size_t... I>
+    static constexpr std::array<RenderFn, count> make_render_table(std::index_sequence<I...>) {
+        return {{ &render_one<I>... }};
+    }
+    template <size_t... I>
+    static constexpr std::array<EnterFn, count> make_enter_table(std::index_sequence<I...>) {
+        return {{ &enter_one<I>... }};
+    }
+    template <size_t... I>
+    static constexpr std::array<LeaveFn, count> make_leave_table(std::index_sequence<I...>) {
+        return {{ &leave_one<I>... }};
+    }
+
+    static constexpr std::array<RenderFn, count> render_table = make_render_table(std::index_sequence_for<Effects...>{});
+    static constexpr std::array<EnterFn, count> enter_table = make_enter_table(std::index_sequence_for<Effects...>{});
+    static constexpr std::array<LeaveFn, count> leave_table = make_leave_table(std::index_sequence_for<Effects...>{});
+    static constexpr std::array<bool, count> control_table = {{ Effects::handles_control... }};
+
+    Tuple effects;
+};
@@ -0,0 +1,431 @@
+#include "led_net.h"
+
+#include <string.h>
+#include <atomic>
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "lwip/igmp.h"
+#include "lwip/pbuf.h"
+#include "lwip/tcpip.h"
+#include "lwip/udp.h"
+#include "led_effects.h"
+
+static const char *TAG = "led_net";
+
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+
+static_assert(sizeof(Rgb) == 3, "フレームはRGBの順に詰めたバイト列として書き込む");
+
+// ===== DDP (Distributed Display Protocol) =====
+#define DDP_HEADER_LEN      10
+#define DDP_FLAGS_VER_MASK  0xC0
+#define DDP_FLAGS_VER1      0x40
+#define DDP_FLAGS_TIMECODE  0x10  // ヘッダの後ろに4バイトのタイムコードが付く
+#define DDP_FLAGS_STORAGE   0x08
+#define DDP_FLAGS_REPLY     0x04
+#define DDP_FLAGS_QUERY     0x02
+#define DDP_FLAGS_PUSH      0x01  // このパケットでフレームが完成
+#define DDP_ID_DISPLAY      1
+#define DDP_ID_ALL          255
+
+// ===== E1.31 (sACN) =====
+#define E131_ACN_ID             4    // "ASC-E1.17"
+#define E131_ROOT_VECTOR        18
+#define E131_FRAMING_VECTOR     40
+#define E131_SYNC_ADDRESS       109  // 0なら同期なし
+#define E131_SEQUENCE           111
+#define E131_OPTIONS            112
+#define E131_UNIVERSE           113
+#define E131_DMP_VECTOR         117
+#define E131_ADDRESS_TYPE       118
+#define E131_PROPERTY_COUNT     123  // スタートコード + チャンネル数
+#define E131_START_CODE         125
+#define E131_DATA               126
+#define E131_SYNC_UNIVERSE      45   // 同期パケットの同期アドレス
+#define E131_SYNC_LEN           49
+
+#define E131_VECTOR_ROOT_DATA       0x00000004
+#define E131_VECTOR_ROOT_EXTENDED   0x00000008
+#define E131_VECTOR_DATA_PACKET     0x00000002
+#define E131_VECTOR_EXTENDED_SYNC   0x00000001
+#define E131_OPTION_PREVIEW         0x80
+#define E131_OPTION_TERMINATED      0x40
+#define E131_MAX_CHANNELS           512
+#define E131_MAX_UNIVERSES ((LED_MAX_PIXELS + LED_NET_E131_PIXELS_PER_UNIVERSE - 1) / LED_NET_E131_PIXELS_PER_UNIVERSE)
+
+static const uint8_t e131_acn_id[12] = { 'A', 'S', 'C', '-', 'E', '1', '.', '1', '7', 0, 0, 0 };
+
+// ===== フレームの受け渡し (3面) =====
+// ready は完成した面の番号で、FRAME_NEW はLEDタスクがまだ受け取っていないことを表す
+#define FRAME_INDEX 0x03
+#define FRAME_NEW   0x80
+
+static Rgb* frames[3] = {};
+static uint16_t frame_pixels = 0;
+static uint8_t write_index = 0;  // TCP/IPタスクのみ
+static uint8_t read_index = 2;   // LEDタスクのみ
+static std::atomic<uint8_t> ready(1);
+static std::atomic<uint32_t> last_frame_ms(0);
+static std::atomic<bool> stream_active(false);
+static std::atomic<bool> net_started(false);
+static void (*frame_callback)() = nullptr;
+
+// ===== 受信の状態 (TCP/IPタスクのみ) =====
+static uint16_t e131_start_universe = 1;
+static uint16_t e131_universe_count = 0;
+static uint8_t e131_last_seq[E131_MAX_UNIVERSES];
+static bool e131_seq_valid[E131_MAX_UNIVERSES];
+static int e131_last_index = -1;    // このストリームで届いた最も後ろのユニバース
+static uint16_t e131_sync_address = 0;  // 同期待ちのアドレス (0なら待っていない)
+static uint16_t e131_sync_joined = 0;   // 参加を試みた同期用マルチキャスト
+static bool e131_sync_member = false;   // e131_sync_joined に参加できている
+static bool e131_member[E131_MAX_UNIVERSES];  // ユニバースのマルチキャストに参加できている
+static bool e131_pending = false;   // 同期待ちのデータがある
+static uint8_t ddp_last_seq = 0;    // 0は未受信
+static uint32_t last_packet_ms = 0;
+
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static LedNetStats stats = {};
+
+static uint32_t now_ms() {
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+static uint16_t be16(const uint8_t* p) {
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static uint32_t be32(const uint8_t* p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static void add_stat(uint32_t* counter, uint32_t n) {
+    portENTER_CRITICAL(&stats_lock);
+    *counter += n;
+    portEXIT_CRITICAL(&stats_lock);
+}
+
+// 先頭len バイトのヘッダを返す。通常はpbufの中をそのまま指し、
+// 先頭のpbufに収まっていない場合だけ copy に集める。短すぎる場合はnullptr
+static const uint8_t* packet_header(const pbuf* p, uint8_t* copy, uint16_t len) {
+    if (p->len >= len) {
+        return (const uint8_t*)p->payload;
+    }
+    if (p->tot_len < len || pbuf_copy_partial(p, copy, len, 0) != len) {
+        return nullptr;
+    }
+    return copy;
+}
+
+// パケットの pbuf_offset から len バイトを、受信中のフレームの byte_offset バイト目以降へ書き込む
+static void write_channels(const pbuf* p, uint16_t pbuf_offset, uint32_t byte_offset, uint32_t len) {
+    uint32_t frame_bytes = (uint32_t)frame_pixels * 3;
+    if (byte_offset >= frame_bytes) {
+        return;
+    }
+    len = MIN(len, frame_bytes - byte_offset);
+    pbuf_copy_partial(p, (uint8_t*)frames[write_index] + byte_offset, (uint16_t)len, pbuf_offset);
+}
+
+// 受信中のフレームを完成した面にしてLEDタスクに知らせる
+static void push_frame() {
+    uint8_t done = write_index;
+    write_index = ready.exchange(done | FRAME_NEW, std::memory_order_acq_rel) & FRAME_INDEX;
+    // DDPは変わった範囲だけを送ってくるため、新しく書き込む面に最新の内容を引き継ぐ
+    memcpy(frames[write_index], frames[done], (size_t)frame_pixels * sizeof(Rgb));
+
+    last_frame_ms.store(now_ms(), std::memory_order_release);
+    stream_active.store(true, std::memory_order_release);
+    add_stat(&stats.frames, 1);
+    if (frame_callback) {
+        frame_callback();
+    }
+}
+
+// 受信が途絶えていたら連番の記録を捨てる (送信元の再起動で連番が戻っても捨てないように)
+static void check_stream_restart() {
+    uint32_t now = now_ms();
+    if (now - last_packet_ms > LED_NET_TIMEOUT_MS) {
+        memset(e131_seq_valid, 0, sizeof(e131_seq_valid));
+        e131_last_index = -1;
+        e131_pending = false;
+        ddp_last_seq = 0;
+    }
+    last_packet_ms = now;
+}
+
+// ===== DDP =====
+
+// DDPの連番は1〜15で巡回する (0は連番なし)
+static bool ddp_sequence_ok(uint8_t seq) {
+    if (seq == 0) {
+        return true;
+    }
+    if (ddp_last_seq != 0) {
+        int diff = (seq - ddp_last_seq + 15) % 15;
+        if (diff == 0 || diff > 7) {
+            add_stat(&stats.out_of_order, 1);
+            return false;
+        }
+        if (diff > 1) {
+            add_stat(&stats.dropped, diff - 1);
+        }
+    }
+    ddp_last_seq = seq;
+    return true;
+}
+
+static void ddp_packet(const pbuf* p) {
+    uint8_t copy[DDP_HEADER_LEN];
+    const uint8_t* h = packet_header(p, copy, DDP_HEADER_LEN);
+    if (h == nullptr
+     || (h[0] & DDP_FLAGS_VER_MASK) != DDP_FLAGS_VER1
+     || (h[0] & (DDP_FLAGS_STORAGE | DDP_FLAGS_REPLY | DDP_FLAGS_QUERY))
+     || (h[3] != DDP_ID_DISPLAY && h[3] != DDP_ID_ALL)) {
+        add_stat(&stats.invalid, 1);
+        return;
+    }
+    // データ型は未指定かRGB 8ビットだけを受け付ける (TTT=0/1, SSS=0/3)
+    uint8_t type = (h[2] >> 3) & 0x07;
+    uint8_t size = h[2] & 0x07;
+    if (type > 1 || (size != 0 && size != 3)) {
+        add_stat(&stats.invalid, 1);
+        return;
+    }
+
+    uint16_t data_at = DDP_HEADER_LEN + ((h[0] & DDP_FLAGS_TIMECODE) ? 4 : 0);
+    uint32_t offset = be32(&h[4]);
+    uint16_t len = be16(&h[8]);
+    if (data_at + len > p->tot_len) {
+        add_stat(&stats.invalid, 1);
+        return;
+    }
+    if (!ddp_sequence_ok(h[1] & 0x0F)) {
+        return;
+    }
+
+    write_channels(p, data_at, offset, len);
+    add_stat(&stats.packets, 1);
+    if (h[0] & DDP_FLAGS_PUSH) {
+        push_frame();
+    }
+}
+
+static void ddp_recv(void* arg, udp_pcb* pcb, pbuf* p, const ip_addr_t* addr, u16_t port) {
+    check_stream_restart();
+    ddp_packet(p);
+    pbuf_free(p);
+}
+
+// ===== E1.31 =====
+
+// ユニバースのマルチキャストに参加する。失敗はログに出してfalseを返す
+static bool e131_join(uint16_t universe) {
+    ip4_addr_t group;
+    IP4_ADDR(&group, 239, 255, universe >> 8, universe & 0xFF);
+    err_t err = igmp_joingroup(IP4_ADDR_ANY4, &group);
+    if (err != ERR_OK) {
+        ESP_LOGW(TAG, "マルチキャスト参加失敗: ユニバース %d (err %d)", universe, err);
+        return false;
+    }
+    return true;
+}
+
+static void e131_leave(uint16_t universe) {
+    ip4_addr_t group;
+    IP4_ADDR(&group, 239, 255, universe >> 8, universe & 0xFF);
+    igmp_leavegroup(IP4_ADDR_ANY4, &group);
+}
+
+// ユニバースと同期アドレスのマルチキャストに参加し直す。参加済みのものは一度抜けてから参加し、
+// 新しいアドレスでメンバーシップレポートを送らせる
+static void e131_join_all(void* arg) {
+    for (int i = 0; i < e131_universe_count; i++) {
+        if (e131_member[i]) {
+            e131_leave(e131_start_universe + i);
+        }
+        e131_member[i] = e131_join(e131_start_universe + i);
+    }
+    if (e131_sync_joined != 0) {
+        if (e131_sync_member) {
+            e131_leave(e131_sync_joined);
+        }
+        e131_sync_member = e131_join(e131_sync_joined);
+    }
+}
+
+// 同じユニバースの連番が20以内で戻ったものは遅れて届いたパケットとして捨てる (E1.31 6.7.2)
+static bool e131_sequence_ok(int index, uint8_t seq) {
+    if (e131_seq_valid[index]) {
+        int8_t diff = (int8_t)(seq - e131_last_seq[index]);
+        if (diff <= 0 && diff > -20) {
+            add_stat(&stats.out_of_order, 1);
+            return false;
+        }
+        if (diff > 1) {
+            add_stat(&stats.dropped, diff - 1);
+        }
+    }
+    e131_last_seq[index] = seq;
+    e131_seq_valid[index] = true;
+    return true;
+}
+
+static void e131_sync_packet(const pbuf* p, const uint8_t* h) {
+    if (p->tot_len < E131_SYNC_LEN || be32(&h[E131_FRAMING_VECTOR]) != E131_VECTOR_EXTENDED_SYNC) {
+        add_stat(&stats.invalid, 1);
+        return;
+    }
+    if (e131_pending && be16(&h[E131_SYNC_UNIVERSE]) == e131_sync_address) {
+        e131_pending = false;
+        push_frame();
+    }
+}
+
+static void e131_data_packet(const pbuf* p, const uint8_t* h) {
+    if (p->tot_len < E131_DATA
+     || be32(&h[E131_FRAMING_VECTOR]) != E131_VECTOR_DATA_PACKET
+     || h[E131_DMP_VECTOR] != 0x02
+     || h[E131_ADDRESS_TYPE] != 0xA1) {
+        add_stat(&stats.invalid, 1);
+        return;
+    }
+    // スタートコード0以外 (チャンネルごとの優先度など) とプレビュー用のデータは表示しない
+    uint8_t options = h[E131_OPTIONS];
+    if (h[E131_START_CODE] != 0 || (options & E131_OPTION_PREVIEW)) {
+        return;
+    }
+    int index = (int)be16(&h[E131_UNIVERSE]) - e131_start_universe;
+    if (index < 0 || index >= e131_universe_count) {
+        add_stat(&stats.invalid, 1);
+        return;
+    }
+    if (options & E131_OPTION_TERMINATED) {
+        // 送信元が終了した: 待たずにエフェクトの表示に戻る
+        stream_active.store(false, std::memory_order_release);
+        e131_seq_valid[index] = false;
+        return;
+    }
+    if (!e131_sequence_ok(index, h[E131_SEQUENCE])) {
+        return;
+    }
+
+    uint16_t channels = be16(&h[E131_PROPERTY_COUNT]);
+    channels = channels > 0 ? channels - 1 : 0;
+    channels = MIN(channels, (uint16_t)E131_MAX_CHANNELS);
+    channels = MIN(channels, (uint16_t)(p->tot_len - E131_DATA));
+    channels = MIN(channels, (uint16_t)(LED_NET_E131_PIXELS_PER_UNIVERSE * 3));
+    write_channels(p, E131_DATA, (uint32_t)index * LED_NET_E131_PIXELS_PER_UNIVERSE * 3, channels);
+    add_stat(&stats.packets, 1);
+
+    uint16_t sync = be16(&h[E131_SYNC_ADDRESS]);
+    if (sync != 0) {
+        // 同期パケットが来るまで表示しない。同期パケットはそのアドレスのマルチキャストで届く
+        e131_sync_address = sync;
+        e131_pending = true;
+        if (e131_sync_joined != sync) {
+            if (e131_sync_member) {
+                e131_leave(e131_sync_joined);
+            }
+            e131_sync_member = e131_join(sync);
+            e131_sync_joined = sync;
+        }
+        return;
+    }
+    // 同期なし: 送信元はユニバースを順に送るので、これまでで最も後ろのユニバースでフレームの終わりとする
+    if (index >= e131_last_index) {
+        e131_last_index = index;
+        push_frame();
+    }
+}
+
+static void e131_recv(void* arg, udp_pcb* pcb, pbuf* p, const ip_addr_t* addr, u16_t port) {
+    check_stream_restart();
+    uint8_t copy[E131_DATA];
+    const uint8_t* h = packet_header(p, copy, MIN(p->tot_len, (uint16_t)E131_DATA));
+    if (h == nullptr || p->tot_len < E131_SYNC_LEN || memcmp(&h[E131_ACN_ID], e131_acn_id, sizeof(e131_acn_id)) != 0) {
+        add_stat(&stats.invalid, 1);
+    } else if (be32(&h[E131_ROOT_VECTOR]) == E131_VECTOR_ROOT_EXTENDED) {
+        e131_sync_packet(p, h);
+    } else if (be32(&h[E131_ROOT_VECTOR]) == E131_VECTOR_ROOT_DATA) {
+        e131_data_packet(p, h);
+    } else {
+        add_stat(&stats.invalid, 1);
+    }
+    pbuf_free(p);
+}
+
+// ===== 開始 =====
+
+// UDPの受信口を作る (lwIPのAPIはTCP/IPタスクから呼ぶ)
+static void net_setup(void* arg) {
+    udp_pcb* ddp = udp_new();
+    if (ddp == nullptr || udp_bind(ddp, IP_ANY_TYPE, LED_NET_DDP_PORT) != ERR_OK) {
+        ESP_LOGE(TAG, "DDP bind failed");
+    } else {
+        udp_recv(ddp, ddp_recv, nullptr);
+    }
+
+    udp_pcb* e131 = udp_new();
+    if (e131 == nullptr || udp_bind(e131, IP_ANY_TYPE, LED_NET_E131_PORT) != ERR_OK) {
+        ESP_LOGE(TAG, "E1.31 bind failed");
+    } else {
+        udp_recv(e131, e131_recv, nullptr);
+        e131_join_all(nullptr);  // アドレスの取得前なら、取得後に led_net_rejoin() で参加し直す
+    }
+    ESP_LOGI(TAG, "受信開始: DDP %d, E1.31 %d (ユニバース %d〜%d, %d LEDs)",
+             LED_NET_DDP_PORT, LED_NET_E131_PORT,
+             e131_start_universe, e131_start_universe + e131_universe_count - 1, frame_pixels);
+}
+
+bool led_net_start(uint16_t pixels, uint16_t start_universe, void (*on_frame)()) {
+    if (pixels == 0 || pixels > LED_MAX_PIXELS || start_universe == 0) {
+        return false;
+    }
+    for (int i = 0; i < 3; i++) {
+        frames[i] = (Rgb*)heap_caps_calloc(pixels, sizeof(Rgb), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        if (frames[i] == nullptr) {
+            ESP_LOGE(TAG, "フレーム確保失敗");
+            return false;
+        }
+    }
+    frame_pixels = pixels;
+    frame_callback = on_frame;
+    e131_start_universe = start_universe;
+    e131_universe_count = (pixels + LED_NET_E131_PIXELS_PER_UNIVERSE - 1) / LED_NET_E131_PIXELS_PER_UNIVERSE;
+    if (tcpip_callback(net_setup, nullptr) != ERR_OK) {
+        return false;
+    }
+    net_started.store(true, std::memory_order_release);
+    return true;
+}
+
+void led_net_rejoin() {
+    if (net_started.load(std::memory_order_acquire) && tcpip_callback(e131_join_all, nullptr) != ERR_OK) {
+        ESP_LOGE(TAG, "マルチキャストの参加し直しを登録できない");
+    }
+}
+
+const Rgb* led_net_frame() {
+    if (!stream_active.load(std::memory_order_acquire)) {
+        return nullptr;
+    }
+    if (now_ms() - last_frame_ms.load(std::memory_order_acquire) > LED_NET_TIMEOUT_MS) {
+        return nullptr;
+    }
+    if (ready.load(std::memory_order_acquire) & FRAME_NEW) {
+        read_index = ready.exchange(read_index, std::memory_order_acq_rel) & FRAME_INDEX;
+    }
+    return frames[read_index];
+}
+
+void led_net_get_stats(LedNetStats* out, bool reset) {
+    portENTER_CRITICAL(&stats_lock);
+    *out = stats;
+    if (reset) {
+        stats = {};
+    }
+    portEXIT_CRITICAL(&stats_lock);
+}
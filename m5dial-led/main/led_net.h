@@ -0,0 +1,44 @@
+/**
+ * ネットワークからの画素入力 (DDP / E1.31)
+ *
+ * 照明制御ソフトから送られる画素データを受け取り、LEDのフレームとして渡す。
+ * 受信はlwIPのUDPコールバック (TCP/IPタスク) で行い、パケットはpbufのまま解析して
+ * 画素データをpbufから受信用フレームへ直接書き込む (途中のバッファへの複写なし)。
+ *
+ * フレームは3面で受け渡す: 受信側が書き込む面、完成した最新の面、LEDタスクが出力中の面。
+ * DDPのPUSHフラグ、E1.31の同期パケット (同期なしの場合は最後のユニバース) でフレームが完成し、
+ * 完成を on_frame で通知する。受信が LED_NET_TIMEOUT_MS 途絶えるとエフェクトの表示に戻る。
+ */
+#pragma once
+
+#include <stdint.h>
+#include "led_color.h"
+
+#define LED_NET_DDP_PORT 4048
+#define LED_NET_E131_PORT 5568
+#define LED_NET_E131_PIXELS_PER_UNIVERSE 170  // 1ユニバース512チャンネルのうち510チャンネルを使う
+#define LED_NET_TIMEOUT_MS 2500               // E1.31のデータ喪失の判定時間
+
+// 受信の統計
+struct LedNetStats {
+    uint32_t packets;       // 受け付けたデータパケット
+    uint32_t frames;        // 完成したフレーム
+    uint32_t dropped;       // 連番の飛びから数えた失われたパケット
+    uint32_t out_of_order;  // 前後が入れ替わって届いた (捨てた) パケット
+    uint32_t invalid;       // 形式が不正、または対象外のパケット
+};
+
+// 受信を開始する。pixels は受け付けるLED数、start_universe はLED 0番を含むE1.31のユニバース
+// on_frame はフレームが完成するたびにTCP/IPタスクから呼ばれる (LEDタスクを起こす程度の処理にすること)
+bool led_net_start(uint16_t pixels, uint16_t start_universe, void (*on_frame)());
+
+// E1.31のマルチキャストに参加し直す。IPアドレスを取得するたびに呼ぶ
+// (アドレスの無いうちに参加したグループは、ルーターやスイッチに知られていないことがある)
+void led_net_rejoin();
+
+// 最新の受信フレーム (led_net_start() の pixels 個)。受信していない、または途絶えた場合はnullptr
+// LEDタスクからのみ呼ぶこと。返したフレームは次に呼ぶまで書き換えられない
+const Rgb* led_net_frame();
+
+// 統計を取得する。resetがtrueなら取得後に集計をやり直す
+void led_net_get_stats(LedNetStats* out, bool reset);
@@ -0,0 +1,19 @@
+#include "led_random.h"
+
+LedRandom led_rng;
+
+void LedRandom::seed(uint64_t seed) {
+    // splitmix64で種を広げる (近い種でも状態が似ないように)
+    for (int i = 0; i < 4; i += 2) {
+        seed += 0x9E3779B97F4A7C15ull;
+        uint64_t z = seed;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        z ^= z >> 31;
+        s[i] = (uint32_t)z;
+        s[i + 1] = (uint32_t)(z >> 32);
+    }
+    if ((s[0] | s[1] | s[2] | s[3]) == 0) {
+        s[0] = 1;  // 全て0の状態からは0しか出ない
+    }
+}
@@ -0,0 +1,60 @@
+/**
+ * エフェクト用の乱数
+ *
+ * esp_random() はハードウェア乱数のレジスタを読むため1回ごとに待ちが入る。
+ * エフェクトはLEDごと・フレームごとに乱数を使うので、xoshiro128++ (状態16バイト、
+ * 加算・シフト・回転のみ) を使い、起動時にハードウェア乱数で種を決める。
+ * 種を固定すれば同じ描画を再現できる (ホストでの確認やベンチマーク用)。
+ *
+ * led_rng はLEDタスク (エフェクトの描画) からのみ使うこと。
+ */
+#pragma once
+
+#include <stdint.h>
+
+class LedRandom {
+public:
+    // 種から状態を作る (同じ種なら同じ並び)
+    void seed(uint64_t seed);
+
+    // 32ビットの乱数
+    uint32_t next() {
+        uint32_t result = rotl(s[0] + s[3], 7) + s[0];
+        uint32_t t = s[1] << 9;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 11);
+        return result;
+    }
+
+    // 0〜n-1 の一様な乱数 (偏りなし: 余りの範囲に入った場合だけ引き直す)
+    uint32_t below(uint32_t n) {
+        uint64_t m = (uint64_t)next() * n;
+        uint32_t low = (uint32_t)m;
+        if (low < n) {
+            uint32_t reject = (0u - n) % n;  // 2^32 を n で割った余り
+            while (low < reject) {
+                m = (uint64_t)next() * n;
+                low = (uint32_t)m;
+            }
+        }
+        return (uint32_t)(m >> 32);
+    }
+
+    // threshold / 2^32 の確率でtrue
+    bool chance(uint32_t threshold) {
+        return next() < threshold;
+    }
+
+private:
+    static uint32_t rotl(uint32_t x, int k) {
+        return (x << k) | (x >> (32 - k));
+    }
+
+    uint32_t s[4] = { 1, 2, 3, 4 };
+};
+
+extern LedRandom led_rng;
@@ -5,6 +5,8 @@
  * - エンコーダー回転: 値を調整 (モードに応じて色相/明るさ/LED数)
  * - 短押し: モード切替
  * - 長押し: LED オン/オフ切替
+ * - 画面の外周をなぞる: エンコーダー回転と同じ (15度で1ステップ)
+ * - タップ: 短押しと同じ
  *
  * モード:
  * 1. 色相 - 色を変更
@@ -17,11 +19,11 @@
 #include <stdio.h>
 #include <string.h>
 #include <math.h>
+#include <atomic>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/event_groups.h"
 #include "driver/gpio.h"
-#include "driver/ledc.h"
 #include "esp_log.h"
 #include "esp_wifi.h"
 #include "esp_event.h"
@@ -30,13 +32,23 @@
 #include "esp_app_format.h"
 #include "nvs_flash.h"
 #include "mdns.h"
-#include "led_strip.h"
+#include "esp_timer.h"
 #include "esp_random.h"
 
 #define LGFX_USE_V1
 #include <LovyanGFX.hpp>
 
 #include "wifi_credentials.h"
+#include "m5dial_buzzer.h"
+#include "m5dial_encoder.h"
+#include "m5dial_gesture.h"
+#include "m5dial_input.h"
+#include "m5dial_latency.h"
+#include "m5dial_ws2812.h"
+#include "led_effects.h"
+#include "led_compositor.h"
+#include "led_random.h"
+#include "led_net.h"
 
 #ifndef MIN
 #define MIN(a, b) ((a) < (b) ? (a) : (b))
@@ -61,15 +73,75 @@ static const char *TAG = "M5Dial-LED";
 
 #define BUZZER_PIN 3
 
+// タッチパネル (FT3267, I2C)
+#define TOUCH_SDA_PIN 11
+#define TOUCH_SCL_PIN 12
+#define TOUCH_INT_PIN 14
+#define TOUCH_I2C_PORT 1
+
 // WS2812B設定
-#define LED_STRIP_PIN GPIO_NUM_15  // Grove Port A - GPIO15 (白線 / SCL)
-#define LED_STRIP_MAX_LEDS 150     // 最大LED数
+// 出力するストリップ (GPIOとLED数)。複数並べると順につながった1本の論理ストリップになる (最大4本)
+// 例: 4本 × 300個なら { {15, 300}, {13, 300}, {1, 300}, {2, 300} }
+// 合計は LED_MAX_PIXELS まで。メモリは1LEDあたり約32バイト (2048個で約64KB):
+// 合成 (層のフレーム2面 + 出力1面) 9 + エフェクトの状態2層6 + ネットワーク受信3面9 + 送信バッファ2面6 + 対応表2
+static const ws2812_strip_config_t led_strips[] = {
+    { GPIO_NUM_15, 150 },  // Grove Port A - GPIO15 (白線 / SCL)
+};
+// 1にすると起動時にLED数ごとの送信時間を計測してログ出力 (先頭のストリップのGPIOを使う)
+#ifndef LED_REFRESH_BENCHMARK
+#define LED_REFRESH_BENCHMARK 0
+#endif
+#define LOOP_PERIOD_MS 20          // メインループ (入力と画面) の周期
+
+// LEDタスク設定
+#ifndef LED_FRAME_RATE_HZ
+#define LED_FRAME_RATE_HZ 100      // LEDの更新レート (60/100/200)
+#endif
+#define LED_TASK_CORE 1            // LEDタスクを動かすコア (WiFiとメインループはコア0)
+#define LED_TASK_PRIORITY 5
+#define LED_MAX_FRAME_DT_US 100000 // 1フレームで進める時間の上限 (停止後にアニメーションが飛ばないように)
+#define LED_FADE_MS 400            // エフェクトと色の切り替えにかける時間 (0で即座に切り替え)
+#define LED_FADE_BUDGET_US (1000000 / LED_FRAME_RATE_HZ / 2)  // フェード中の1フレームの処理時間の上限
+#define LED_HIGHLIGHT_BLEND BLEND_ADD  // コントロールモードの位置の目印の重ね方 (BLEND_ADD / MAX / MULTIPLY)
+// エフェクトの乱数の種 (0なら起動ごとにハードウェア乱数で決める。固定すると毎回同じ動きになる)
+#ifndef LED_RANDOM_SEED
+#define LED_RANDOM_SEED 0
+#endif
+// LED出力の色補正 (ガンマ値0で白色点が全て255なら補正なし)
+#ifndef LED_GAMMA
+#define LED_GAMMA 0.0f             // 例: 2.2 で暗い側の階調を広げる
+#endif
+#define LED_WHITE_R 255            // 白色点 (各チャンネルの最大出力)。LEDの色味に合わせて下げる
+#define LED_WHITE_G 255
+#define LED_WHITE_B 255
+// ネットワークからの画素入力 (DDP: UDP 4048 / E1.31: UDP 5568)。受信中はエフェクトの代わりに表示する
+#ifndef LED_NET_ENABLE
+#define LED_NET_ENABLE 1
+#endif
+#define LED_NET_E131_UNIVERSE 1    // LED 0番を含むE1.31のユニバース (以降170個ずつ次のユニバース)
+// 1にするとLEDタスクのフレーム間隔の統計を定期的にログ出力
+#ifndef LED_FRAME_STATS_LOG
+#define LED_FRAME_STATS_LOG 0
+#endif
+// 1にすると入力 (割り込みの時刻) から、それを反映した画面の転送とLEDの送信の完了までの遅延を集計し、
+// 10秒ごとにログへ、HTTPの /latency (?reset で集計をやり直す) に出す
+#ifndef INPUT_LATENCY_TRACE
+#define INPUT_LATENCY_TRACE 0
+#endif
+
+// 日本語フォントのグリフ検索用索引の間隔 (0で索引なし)
+#define FONT_INDEX_STRIDE 16
+// 1にすると起動時に日本語文字列の描画時間を計測してログ出力
+#ifndef FONT_BENCHMARK
+#define FONT_BENCHMARK 0
+#endif
 
 // M5Dialディスプレイクラス
 class LGFX_M5Dial : public lgfx::LGFX_Device {
     lgfx::Panel_GC9A01 _panel_instance;
     lgfx::Bus_SPI _bus_instance;
     lgfx::Light_PWM _light_instance;
+    lgfx::Touch_FT5x06 _touch_instance;
 
 public:
     LGFX_M5Dial(void) {
@@ -102,6 +174,7 @@ public:
             cfg.rgb_order = false;
             cfg.bus_shared = true;
             _panel_instance.config(cfg);
+            _panel_instance.setRoundMask<240>();  // 円形表示部の外側は転送しない
         }
         {
             auto cfg = _light_instance.config();
@@ -112,26 +185,67 @@ public:
             _light_instance.config(cfg);
             _panel_instance.setLight(&_light_instance);
         }
+        {
+            // INTは触れている間Low。離している間はI2Cを読まない
+            auto cfg = _touch_instance.config();
+            cfg.x_min = 0;
+            cfg.x_max = 239;
+            cfg.y_min = 0;
+            cfg.y_max = 239;
+            cfg.pin_int = TOUCH_INT_PIN;
+            cfg.bus_shared = false;
+            cfg.offset_rotation = 0;
+            cfg.i2c_port = TOUCH_I2C_PORT;
+            cfg.i2c_addr = 0x38;
+            cfg.pin_sda = TOUCH_SDA_PIN;
+            cfg.pin_scl = TOUCH_SCL_PIN;
+            cfg.freq = 400000;
+            _touch_instance.config(cfg);
+            _panel_instance.setTouch(&_touch_instance);
+        }
         setPanel(&_panel_instance);
     }
 };
 
+// 日本語フォント (ビルド時にソース中の文字列で使う文字だけを抜き出したサブセット。main/CMakeLists.txt参照)
+extern "C" const uint8_t led_font_gothic_p_20[];
+extern "C" const uint8_t led_font_gothic_p_28[];
+static const lgfx::U8g2font font_jp_20 = { led_font_gothic_p_20 };
+static const lgfx::U8g2font font_jp_28 = { led_font_gothic_p_28 };
+
 // グローバルインスタンス
 LGFX_M5Dial display;
-LGFX_Sprite canvas(&display);
-led_strip_handle_t led_strip = NULL;
+LGFX_DisplayList canvas(&display);  // 描画命令を記録し、帯状に再生して転送
+LGFX_Layer ring_layer;       // 外周リング (メニュー/エフェクト/コントロール)
+LGFX_Layer arc_layer;        // 値調整の円弧
+LGFX_Layer hue_wheel_layer;  // カラーホイール (選択セグメントごと)
+lgfx::GlyphCache glyph_cache(2048);  // 描画済みの文字 (日本語フォントは矩形が多いため大きめ)
 
-// LED状態
+// LED状態 (LEDタスクはこれらを直接読まず、publish_led_settings() で公開した LedSettings を使う)
 uint16_t led_hue = 0;         // 0-359
 uint8_t led_saturation = 255; // 0-255
 uint8_t led_brightness = 128; // 0-255
-uint8_t led_count = 10;       // 点灯するLED数
+uint16_t led_count = 10;      // 点灯するLED数 (1〜led_pixel_count)
 uint8_t led_effect = 0;       // 現在のエフェクト
 uint8_t effect_speed = 5;     // エフェクト速度 1-9 (1=遅い, 9=速い)
 int16_t control_position = 0; // インタラクティブ制御位置 (0〜led_count-1, ラップ)
 bool control_active = false;  // コントロールモードレイヤー2の時true
 bool led_on = true;           // LED オン/オフ
 
+// LEDタスクのフレーム間隔の統計
+struct LedFrameStats {
+    uint32_t frames;           // 集計したフレーム数
+    uint32_t interval_min_us;  // フレーム間隔の最小
+    uint32_t interval_max_us;  // フレーム間隔の最大
+    uint32_t interval_avg_us;  // フレーム間隔の平均
+    uint32_t work_max_us;      // 1フレームの計算と送信開始にかかった時間の最大
+    uint32_t late_frames;      // 間隔が周期の1.5倍を超えたフレーム数
+    uint32_t fade_frames;      // エフェクトの切り替えで2つのエフェクトを描いたフレーム数
+    uint32_t fade_work_max_us; // そのフレームの処理時間の最大
+    uint32_t fades_cut;        // 処理時間が LED_FADE_BUDGET_US を超えて打ち切ったフェード
+    uint32_t net_frames;       // ネットワークの受信で周期の外に送信したフレーム数 (上の間隔には含めない)
+};
+
 // エフェクト名
 const char* effect_names[] = {
     "単色",
@@ -147,63 +261,6 @@ const char* effect_names[] = {
 };
 #define NUM_EFFECTS 10
 
-// Xmas Songメロディデータ (ジングルベル)
-// 注: 周波数はHz、0 = 休符
-struct MelodyNote {
-    uint16_t freq;    // 周波数 (Hz)
-    uint8_t duration; // 長さ (1単位 = 基本テンポ)
-    uint16_t hue;     // この音の色相
-};
-
-// 音階の周波数
-#define NOTE_C4  262
-#define NOTE_D4  294
-#define NOTE_E4  330
-#define NOTE_F4  349
-#define NOTE_G4  392
-#define NOTE_A4  440
-#define NOTE_B4  494
-#define NOTE_C5  523
-#define NOTE_REST 0
-
-// ジングルベルのメロディと色 (正確な楽譜)
-// ハ長調 - 色: C=赤, D=オレンジ, E=黄, F=緑, G=シアン
-// 注: VerseとChorusは同じメロディパターン
-const MelodyNote xmas_melody[] = {
-    // === 1番 ===
-    // 「走れそりよ」 (E E E-)
-    {NOTE_E4, 1, 60},  {NOTE_E4, 1, 60},  {NOTE_E4, 2, 60},
-    // 「風のように」 (E E E-)
-    {NOTE_E4, 1, 60},  {NOTE_E4, 1, 60},  {NOTE_E4, 2, 60},
-    // 「雪の中を」 (E G C D)
-    {NOTE_E4, 1, 60},  {NOTE_G4, 1, 180}, {NOTE_C4, 1, 0},   {NOTE_D4, 1, 30},
-    // 「軽く」 (E-)
-    {NOTE_E4, 2, 60},  {NOTE_REST, 1, 0},
-    // 「鈴が鳴る」 (F F F F)
-    {NOTE_F4, 1, 120}, {NOTE_F4, 1, 120}, {NOTE_F4, 1, 120}, {NOTE_F4, 1, 120},
-    // 「リンリンリン」 (F E E E)
-    {NOTE_F4, 1, 120}, {NOTE_E4, 1, 60},  {NOTE_E4, 1, 60},  {NOTE_E4, 1, 60},
-    // 「鈴が鳴る」 (E D D E)
-    {NOTE_E4, 1, 60},  {NOTE_D4, 1, 30},  {NOTE_D4, 1, 30},  {NOTE_E4, 1, 60},
-    // 「楽しいな」 (D- G-)
-    {NOTE_D4, 2, 30},  {NOTE_G4, 2, 180},
-    {NOTE_REST, 2, 0},
-    // === サビ ===
-    // 「ジングルベル」 (E E E-, E E E-)
-    {NOTE_E4, 1, 60},  {NOTE_E4, 1, 60},  {NOTE_E4, 2, 60},
-    {NOTE_E4, 1, 60},  {NOTE_E4, 1, 60},  {NOTE_E4, 2, 60},
-    // 「ジングルベル」 (E G C D E-)
-    {NOTE_E4, 1, 60},  {NOTE_G4, 1, 180}, {NOTE_C4, 1, 0},   {NOTE_D4, 1, 30}, {NOTE_E4, 2, 60},
-    {NOTE_REST, 1, 0},
-    // 「鈴が鳴る」 (F F F F F E E E)
-    {NOTE_F4, 1, 120}, {NOTE_F4, 1, 120}, {NOTE_F4, 1, 120}, {NOTE_F4, 1, 120},
-    {NOTE_F4, 1, 120}, {NOTE_E4, 1, 60},  {NOTE_E4, 1, 60},  {NOTE_E4, 1, 60},
-    // 「楽しいそり遊び」 (G G F D C-)
-    {NOTE_G4, 1, 180}, {NOTE_G4, 1, 180}, {NOTE_F4, 1, 120}, {NOTE_D4, 1, 30}, {NOTE_C4, 2, 0},
-    {NOTE_REST, 4, 0},
-};
-#define XMAS_MELODY_LENGTH (sizeof(xmas_melody) / sizeof(xmas_melody[0]))
-
 // コントロールモード
 enum ControlMode {
     MODE_HUE = 0,
@@ -227,16 +284,21 @@ const char* mode_names[] = {
 
 ControlMode current_mode = MODE_HUE;
 
-// エンコーダー状態
-volatile int32_t encoder_count = 0;
-static int8_t last_state = 0;
+// 調整モードでの回転の加速曲線 (モードごと)
+// 範囲の広いLED数とコントロール位置は、速く回すと1デテントで最大10進む
+static const input_accel_t mode_accel[] = {
+    { 10, 40, 3, 1 },   // 色相: 最大90度
+    INPUT_ACCEL_NONE,   // 明るさ (5段階)
+    { 6, 40, 10, 2 },   // LED数
+    INPUT_ACCEL_NONE,   // エフェクト
+    INPUT_ACCEL_NONE,   // スピード
+    { 6, 40, 10, 2 },   // コントロール
+};
+static_assert(sizeof(mode_accel) / sizeof(mode_accel[0]) == MODE_MAX, "mode_accel must cover every ControlMode");
 
-// ボタン状態
-static bool last_button_state = false;
-static uint32_t button_press_time = 0;
-static bool button_was_long_press = false;
-static bool button_just_released_short = false;
+// 入力 (回転とボタンは入力イベントキューで受け取る)
 static const uint32_t LONG_PRESS_MS = 300;
+static const size_t INPUT_BATCH = 16;  // 1回に取り出す入力イベントの数
 
 // WiFi状態
 static EventGroupHandle_t wifi_event_group;
@@ -245,555 +307,347 @@ static char ip_address[16] = "";
 static bool ota_in_progress = false;
 static int ota_progress = 0;
 
-// ===== HSVからRGBへの変換 =====
+// ===== LEDストリップ関数 =====
 
-void hsv_to_rgb(uint16_t h, uint8_t s, uint8_t v, uint8_t *r, uint8_t *g, uint8_t *b) {
-    if (s == 0) {
-        *r = *g = *b = v;
-        return;
+// エフェクト番号順 (effect_names[] と同じ並び)
+using LedEffectSet = LedEffects<
+    SolidEffect,
+    ChaseEffect,
+    BounceEffect,
+    CometEffect,
+    RainbowEffect,
+    RandomBlinkEffect,
+    FireflyEffect,
+    RandomFireflyEffect,
+    HeartbeatEffect,
+    XmasSongEffect
+>;
+static_assert(LedEffectSet::count == NUM_EFFECTS, "effect_names[] とエフェクトの数が合わない");
+
+// エフェクトを描く層とフレーム (大きさは接続したLED数で決まるため起動時に確保する)
+static LedCompositor<LedEffectSet> led_compositor;
+static uint16_t led_pixel_count = 0;  // フレームのLED数 (UIで選べるLED数の上限)
+
+#if LED_REFRESH_BENCHMARK
+// LED数ごとに1フレームの送信 (開始から完了まで) にかかる時間を計測する
+// WS2812は1LEDあたり30us + リセット300usが理論値で、RMTの補充が間に合わないと理論値より遅くなる
+static void led_refresh_benchmark() {
+    static const uint16_t lengths[] = { 50, 150, 300, 600, 1000, 2000 };
+    const int frames = 50;
+    for (uint16_t length : lengths) {
+        if (!ws2812_init(led_strips[0].gpio_num, length)) {
+            continue;
+        }
+        int64_t start = esp_timer_get_time();
+        for (int f = 0; f < frames; f++) {
+            // 毎回内容を変えて、同じフレームの送信の省略が起きないようにする
+            for (uint16_t i = 0; i < length; i++) {
+                ws2812_set_pixel(i, 0, 0, (uint8_t)(f & 1));
+            }
+            ws2812_submit();
+            ws2812_wait();
+        }
+        int64_t us = (esp_timer_get_time() - start) / frames;
+        ESP_LOGI(TAG, "LED refresh: %4d LEDs %6lld us/frame (%.1f fps, 理論値 %d us)",
+                 length, us, 1000000.0f / us, length * 30 + 300);
     }
+    ws2812_deinit();
+}
+#endif
 
-    uint8_t region = h / 60;
-    uint8_t remainder = (h - (region * 60)) * 255 / 60;
-
-    uint8_t p = (v * (255 - s)) >> 8;
-    uint8_t q = (v * (255 - ((s * remainder) >> 8))) >> 8;
-    uint8_t t = (v * (255 - ((s * (255 - remainder)) >> 8))) >> 8;
+bool led_strip_init() {
+#if LED_REFRESH_BENCHMARK
+    led_refresh_benchmark();
+#endif
 
-    switch (region) {
-        case 0:  *r = v; *g = t; *b = p; break;
-        case 1:  *r = q; *g = v; *b = p; break;
-        case 2:  *r = p; *g = v; *b = t; break;
-        case 3:  *r = p; *g = q; *b = v; break;
-        case 4:  *r = t; *g = p; *b = v; break;
-        default: *r = v; *g = p; *b = q; break;
+    // 2面の画素バッファを持ち、DMA送信中に次のフレームを書き込める
+    // 複数のストリップは並行して送信される。論理画素との対応は ws2812_map() で実行中に変更できる
+    if (!ws2812_init_strips(led_strips, sizeof(led_strips) / sizeof(led_strips[0]))) {
+        ESP_LOGE(TAG, "LED strip init failed");
+        return false;
     }
-}
 
-// ===== LEDストリップ関数 =====
+    uint16_t pixels = MIN(ws2812_logical_count(), LED_MAX_PIXELS);
+    if (!led_compositor.init(pixels, LED_FADE_MS, LED_FADE_BUDGET_US, LED_HIGHLIGHT_BLEND)) {
+        ESP_LOGE(TAG, "LED frame alloc failed (%d LEDs)", pixels);
+        return false;
+    }
+    led_pixel_count = pixels;
+    led_count = MIN(led_count, led_pixel_count);
 
-void led_strip_init() {
-    led_strip_config_t strip_config = {
-        .strip_gpio_num = LED_STRIP_PIN,
-        .max_leds = LED_STRIP_MAX_LEDS,
-        .led_pixel_format = LED_PIXEL_FORMAT_GRB,
-        .led_model = LED_MODEL_WS2812,
-        .flags = { .invert_out = false }
-    };
+    // 初期化時にLEDをクリア
+    ws2812_clear();
+    ws2812_submit();
+    return true;
+}
 
-    led_strip_rmt_config_t rmt_config = {
-        .clk_src = RMT_CLK_SRC_DEFAULT,
-        .resolution_hz = 10 * 1000 * 1000,
-        .mem_block_symbols = 64,
-        .flags = { .with_dma = false }
-    };
+static uint16_t led_sent_count = 0;  // 前回送信したLED数 (それより後ろは消灯済み)
 
-    esp_err_t ret = led_strip_new_rmt_device(&strip_config, &rmt_config, &led_strip);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "LED strip init failed: %s", esp_err_to_name(ret));
-        return;
+// フレームの先頭count個をLEDの書き込み側のバッファに移す
+static void output_frame(const Rgb* pixels, uint16_t count) {
+    // ガンマ補正とホワイトバランスはフレームには掛けず、出力するときに掛ける
+    // (描画を省略したエフェクトのフレームに二重に掛からないように)
+    const ColorCorrection* cc = led_color_correction();
+    if (cc) {
+        for (int i = 0; i < count; i++) {
+            ws2812_set_pixel(i, cc->r[pixels[i].r], cc->g[pixels[i].g], cc->b[pixels[i].b]);
+        }
+    } else {
+        for (int i = 0; i < count; i++) {
+            ws2812_set_pixel(i, pixels[i].r, pixels[i].g, pixels[i].b);
+        }
     }
-
-    // 初期化時にLEDをクリア
-    led_strip_clear(led_strip);
-    led_strip_refresh(led_strip);
+    // LED数を減らした場合だけ、はみ出た分を消す (書き込み側のバッファには前回の内容が残っている)
+    for (int i = count; i < led_sent_count; i++) {
+        ws2812_set_pixel(i, 0, 0, 0);
+    }
+    led_sent_count = count;
 }
 
-void update_leds() {
-    if (!led_on) {
-        led_strip_clear(led_strip);
-        led_strip_refresh(led_strip);
+// 1フレーム分のLEDを計算して送信する (LEDタスクから呼ばれる)
+// dt_usは前のフレームからの経過時間。アニメーションは呼び出し回数ではなく経過時間で進める
+void update_leds(const LedSettings& s, uint32_t dt_us) {
+    if (!s.on) {
+        ws2812_clear();
+        ws2812_submit();  // 消灯済みなら送信されない
+        led_sent_count = 0;
         return;
     }
 
-    static uint32_t effect_counter = 0;
-    effect_counter += effect_speed;  // 速度がエフェクトのアニメーション速度を制御
-
-    // Xmas Songエフェクト以外の時はブザーを停止
-    static uint8_t last_effect = 255;
-    if (led_effect != 9 && last_effect == 9) {
-        ledc_set_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0, 0);
-        ledc_update_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0);
+    // 経過時間を1ティック (EFFECT_TICK_MS) 単位に換算
+    // counterは1ティックで速度分進む (従来のループ1回あたり effect_counter += 速度 と同じ速さ)
+    static uint64_t elapsed_us = 0;
+    static uint64_t effect_progress = 0;
+    elapsed_us += dt_us;
+    effect_progress += (uint64_t)s.speed * dt_us;
+
+    // ネットワークから受信中ならエフェクトの代わりに受信したフレームを出す
+    const Rgb* net_frame = led_net_frame();
+    if (net_frame) {
+        output_frame(net_frame, led_pixel_count);
+        ws2812_submit();
+        return;
     }
-    last_effect = led_effect;
-
-    uint8_t r, g, b;
-
-    // 蛍の状態 (呼び出し間で永続)
-    static uint8_t firefly_brightness[LED_STRIP_MAX_LEDS] = {0};
-    static int8_t firefly_direction[LED_STRIP_MAX_LEDS] = {0};
-    static uint16_t firefly_hue[LED_STRIP_MAX_LEDS] = {0};  // ランダム蛍用
-
-    switch (led_effect) {
-        case 0: // 単色
-            hsv_to_rgb(led_hue, led_saturation, led_brightness, &r, &g, &b);
-            for (int i = 0; i < LED_STRIP_MAX_LEDS; i++) {
-                if (i < led_count) {
-                    if (control_active) {
-                        // コントロールモード: control_positionの位置だけ点灯
-                        if (i == control_position) {
-                            led_strip_set_pixel(led_strip, i, r, g, b);
-                        } else {
-                            led_strip_set_pixel(led_strip, i, r/15, g/15, b/15);
-                        }
-                    } else {
-                        led_strip_set_pixel(led_strip, i, r, g, b);
-                    }
-                } else {
-                    led_strip_set_pixel(led_strip, i, 0, 0, 0);
-                }
-            }
-            break;
-
-        case 1: // 追いかけ (複数の光が流れる)
-            {
-                hsv_to_rgb(led_hue, led_saturation, led_brightness, &r, &g, &b);
-                int num_chasers = 3;  // 追いかける光の数
-                int spacing = led_count / num_chasers;
-                int base_pos = control_active ? control_position : ((effect_counter / 2) % led_count);
-
-                for (int i = 0; i < LED_STRIP_MAX_LEDS; i++) {
-                    if (i < led_count) {
-                        bool is_chaser = false;
-                        for (int c = 0; c < num_chasers; c++) {
-                            int chaser_pos = (base_pos + c * spacing) % led_count;
-                            if (i == chaser_pos) {
-                                is_chaser = true;
-                                break;
-                            }
-                        }
-                        if (is_chaser) {
-                            led_strip_set_pixel(led_strip, i, r, g, b);
-                        } else {
-                            led_strip_set_pixel(led_strip, i, r/15, g/15, b/15);
-                        }
-                    } else {
-                        led_strip_set_pixel(led_strip, i, 0, 0, 0);
-                    }
-                }
-            }
-            break;
 
-        case 2: // 往復 (光が左右に跳ね返る)
-            {
-                hsv_to_rgb(led_hue, led_saturation, led_brightness, &r, &g, &b);
-                int bounce_pos;
-                if (control_active) {
-                    bounce_pos = control_position;
-                } else {
-                    int cycle = (led_count - 1) * 2;
-                    int pos_in_cycle = (effect_counter / 2) % cycle;
-                    bounce_pos = (pos_in_cycle < led_count) ? pos_in_cycle : (cycle - pos_in_cycle);
-                }
-
-                for (int i = 0; i < LED_STRIP_MAX_LEDS; i++) {
-                    if (i < led_count) {
-                        if (i == bounce_pos) {
-                            led_strip_set_pixel(led_strip, i, r, g, b);
-                        } else {
-                            led_strip_set_pixel(led_strip, i, r/15, g/15, b/15);
-                        }
-                    } else {
-                        led_strip_set_pixel(led_strip, i, 0, 0, 0);
-                    }
-                }
-            }
-            break;
+    EffectTime t;
+    t.dt_us = dt_us;
+    t.ticks = dt_us / (EFFECT_TICK_MS * 1000.0f);
+    t.tick = (uint32_t)(elapsed_us / (EFFECT_TICK_MS * 1000));
+    t.counter = (uint32_t)(effect_progress / (EFFECT_TICK_MS * 1000));
 
-        case 3: // コメット (明るい頭部と減衰する尾)
-            {
-                hsv_to_rgb(led_hue, led_saturation, led_brightness, &r, &g, &b);
-                int comet_head = control_active ? control_position : ((effect_counter / 2) % led_count);
-                int tail_length = 5;
-
-                for (int i = 0; i < LED_STRIP_MAX_LEDS; i++) {
-                    if (i < led_count) {
-                        int distance = (comet_head - i + led_count) % led_count;
-                        if (distance == 0) {
-                            // 頭部 - 最大輝度
-                            led_strip_set_pixel(led_strip, i, r, g, b);
-                        } else if (distance <= tail_length) {
-                            // 尾 - 減衰
-                            float fade = 1.0f - (float)distance / (tail_length + 1);
-                            led_strip_set_pixel(led_strip, i, (uint8_t)(r * fade), (uint8_t)(g * fade), (uint8_t)(b * fade));
-                        } else {
-                            led_strip_set_pixel(led_strip, i, 0, 0, 0);
-                        }
-                    } else {
-                        led_strip_set_pixel(led_strip, i, 0, 0, 0);
-                    }
-                }
-            }
-            break;
+    uint16_t count = MAX(1, MIN(led_pixel_count, s.count));
+    output_frame(led_compositor.render(count, t, s), count);
 
-        case 4: // レインボー (虹色が流れる)
-            {
-                int offset = control_active ? (control_position * 360 / led_count) : (effect_counter * 2);
-                for (int i = 0; i < LED_STRIP_MAX_LEDS; i++) {
-                    if (i < led_count) {
-                        uint16_t hue = (i * 360 / led_count + offset) % 360;
-                        hsv_to_rgb(hue, led_saturation, led_brightness, &r, &g, &b);
-                        led_strip_set_pixel(led_strip, i, r, g, b);
-                    } else {
-                        led_strip_set_pixel(led_strip, i, 0, 0, 0);
-                    }
-                }
-            }
-            break;
-
-        case 5: // ランダム点滅
-            {
-                // 速度が高いほど点滅が頻繁
-                int blink_threshold = 20 - effect_speed;  // 速度1=19, 速度9=11
-                for (int i = 0; i < LED_STRIP_MAX_LEDS; i++) {
-                    if (i < led_count) {
-                        if ((int)(esp_random() % blink_threshold) == 0) {
-                            // ランダムな色と位置
-                            uint16_t rand_hue = esp_random() % 360;
-                            hsv_to_rgb(rand_hue, led_saturation, led_brightness, &r, &g, &b);
-                            led_strip_set_pixel(led_strip, i, r, g, b);
-                        } else {
-                            led_strip_set_pixel(led_strip, i, 0, 0, 0);
-                        }
-                    } else {
-                        led_strip_set_pixel(led_strip, i, 0, 0, 0);
-                    }
-                }
-            }
-            break;
-
-        case 6: // 蛍 (ランダム位置でゆっくりフェードイン/アウト)
-            {
-                hsv_to_rgb(led_hue, led_saturation, led_brightness, &r, &g, &b);
-
-                // 速度が高いほどフェードが速く、開始が頻繁
-                int fade_step = effect_speed;  // 速度1=1, 速度9=9
-                int start_threshold = 110 - effect_speed * 10;  // 速度1=100, 速度9=20
-
-                for (int i = 0; i < led_count; i++) {
-                    // ランダムに光り始める
-                    if (firefly_brightness[i] == 0 && firefly_direction[i] == 0) {
-                        if ((int)(esp_random() % start_threshold) == 0) {
-                            firefly_direction[i] = 1;  // フェードイン開始
-                        }
-                    }
-
-                    // 輝度更新
-                    if (firefly_direction[i] == 1) {
-                        firefly_brightness[i] = (uint8_t)MIN(250, firefly_brightness[i] + fade_step);
-                        if (firefly_brightness[i] >= 250) {
-                            firefly_direction[i] = -1;  // フェードアウト開始
-                        }
-                    } else if (firefly_direction[i] == -1) {
-                        if (firefly_brightness[i] > fade_step) {
-                            firefly_brightness[i] -= fade_step;
-                        } else {
-                            firefly_brightness[i] = 0;
-                            firefly_direction[i] = 0;  // 完了
-                        }
-                    }
-
-                    float scale = firefly_brightness[i] / 255.0f;
-                    led_strip_set_pixel(led_strip, i, (uint8_t)(r * scale), (uint8_t)(g * scale), (uint8_t)(b * scale));
-                }
-
-                // 未使用LEDをクリア
-                for (int i = led_count; i < LED_STRIP_MAX_LEDS; i++) {
-                    led_strip_set_pixel(led_strip, i, 0, 0, 0);
-                }
-            }
-            break;
+    // 送信はDMAで行われ、ここでは待たない (前回と同じ内容なら送信しない)
+    ws2812_submit();
+}
 
-        case 7: // ランダム蛍 (ランダムな色の蛍)
-            {
-                // 速度が高いほどフェードが速く、開始が頻繁
-                int fade_step = effect_speed;
-                int start_threshold = 110 - effect_speed * 10;
-
-                for (int i = 0; i < led_count; i++) {
-                    // ランダムに光り始める (ランダムな色で)
-                    if (firefly_brightness[i] == 0 && firefly_direction[i] == 0) {
-                        if ((int)(esp_random() % start_threshold) == 0) {
-                            firefly_direction[i] = 1;
-                            firefly_hue[i] = esp_random() % 360;  // ランダムな色
-                        }
-                    }
-
-                    // 輝度更新
-                    if (firefly_direction[i] == 1) {
-                        firefly_brightness[i] = (uint8_t)MIN(250, firefly_brightness[i] + fade_step);
-                        if (firefly_brightness[i] >= 250) {
-                            firefly_direction[i] = -1;
-                        }
-                    } else if (firefly_direction[i] == -1) {
-                        if (firefly_brightness[i] > fade_step) {
-                            firefly_brightness[i] -= fade_step;
-                        } else {
-                            firefly_brightness[i] = 0;
-                            firefly_direction[i] = 0;
-                        }
-                    }
-
-                    // 各蛍に個別のランダム色相を使用
-                    float scale = firefly_brightness[i] / 255.0f;
-                    uint8_t bright = (uint8_t)(led_brightness * scale);
-                    hsv_to_rgb(firefly_hue[i], led_saturation, bright, &r, &g, &b);
-                    led_strip_set_pixel(led_strip, i, r, g, b);
-                }
-
-                // 未使用LEDをクリア
-                for (int i = led_count; i < LED_STRIP_MAX_LEDS; i++) {
-                    led_strip_set_pixel(led_strip, i, 0, 0, 0);
-                }
-            }
-            break;
+// ===== LEDタスク =====
+// 周期タイマーで起こされ、LED_FRAME_RATE_HZ でエフェクトを計算して送信する
+// ネットワークからフレームを受信した時は周期を待たずにも起こされ、受信したフレームを送信する
+// メインループ (入力と画面の描画) とは別のコアで動くため、描画に時間がかかってもLEDの動きが乱れない
+
+static TaskHandle_t led_task_handle = nullptr;
+
+// LEDタスクへの通知 (通知値のビット)。周期の外で起きたことを区別して、間隔の統計と経過時間から除く
+#define LED_NOTIFY_FRAME (1u << 0)  // 周期タイマー
+#define LED_NOTIFY_NET   (1u << 1)  // ネットワークから1フレーム受信した
+
+// 設定の受け渡し (シーケンスロック)
+// 書き込みはメインループのみ。番号が奇数の間は書き込み中
+static LedSettings led_settings_shared = {};
+static std::atomic<uint32_t> led_settings_seq(0);
+
+// フレーム間隔の集計 (LEDタスクが書き、メインループが読む)
+static portMUX_TYPE led_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t led_stats_frames = 0;
+static uint32_t led_stats_min_us = UINT32_MAX;
+static uint32_t led_stats_max_us = 0;
+static uint64_t led_stats_sum_us = 0;
+static uint32_t led_stats_work_max_us = 0;
+static uint32_t led_stats_late = 0;
+static uint32_t led_stats_fade_frames = 0;
+static uint32_t led_stats_fade_work_max_us = 0;
+static uint32_t led_stats_fades_cut = 0;
+static uint32_t led_stats_net_frames = 0;
+
+#if INPUT_LATENCY_TRACE
+static latency_hist_t display_latency;             // 入力から画面の転送完了まで
+static latency_hist_t led_latency;                 // 入力からLEDの送信完了まで
+static std::atomic<uint32_t> led_input_tag(0);     // LEDタスクがまだ反映していない最も古い入力
+#endif
 
-        case 8: // 心拍
-            {
-                // 心拍パターン: 素早い二重パルス、その後休止
-                int cycle = 100;
-                int pos = effect_counter % cycle;
-                float brightness_scale;
-
-                if (pos < 10) {
-                    // 第1拍 上昇
-                    brightness_scale = pos / 10.0f;
-                } else if (pos < 20) {
-                    // 第1拍 下降
-                    brightness_scale = 1.0f - (pos - 10) / 10.0f;
-                } else if (pos < 30) {
-                    // 第2拍 上昇
-                    brightness_scale = (pos - 20) / 10.0f;
-                } else if (pos < 40) {
-                    // 第2拍 下降
-                    brightness_scale = 1.0f - (pos - 30) / 10.0f;
-                } else {
-                    // 休止
-                    brightness_scale = 0.0f;
-                }
-
-                uint8_t bright = (uint8_t)(led_brightness * brightness_scale);
-                hsv_to_rgb(led_hue, led_saturation, bright, &r, &g, &b);
-
-                for (int i = 0; i < LED_STRIP_MAX_LEDS; i++) {
-                    if (i < led_count) {
-                        led_strip_set_pixel(led_strip, i, r, g, b);
-                    } else {
-                        led_strip_set_pixel(led_strip, i, 0, 0, 0);
-                    }
-                }
-            }
-            break;
+// 現在のLED状態をLEDタスクに公開する
+void publish_led_settings() {
+    LedSettings s;
+    s.hue = led_hue;
+    s.saturation = led_saturation;
+    s.brightness = led_brightness;
+    s.count = led_count;
+    s.effect = led_effect;
+    s.speed = effect_speed;
+    s.on = led_on;
+    s.control_active = control_active;
+    s.control_position = control_position;
+
+    uint32_t seq = led_settings_seq.load(std::memory_order_relaxed);
+    led_settings_seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    led_settings_shared = s;
+    led_settings_seq.store(seq + 2, std::memory_order_release);
+}
 
-        case 9: // クリスマスソング
-            {
-                // メロディ再生の状態
-                static int melody_index = 0;
-                static int note_timer = 0;
-                static int note_duration_ticks = 0;
-                static int current_led_pos = 0;
-                static int16_t led_hues[LED_STRIP_MAX_LEDS];  // -1 = 消灯, 0-359 = 色相
-                static bool xmas_initialized = false;
-                static int last_control_pos = -1;
-
-                // LED色相配列を初期化
-                if (!xmas_initialized) {
-                    for (int i = 0; i < LED_STRIP_MAX_LEDS; i++) {
-                        led_hues[i] = -1;  // 全て消灯
-                    }
-                    xmas_initialized = true;
-                    melody_index = 0;
-                    current_led_pos = 0;
-                    note_timer = 0;
-                    note_duration_ticks = 0;
-                }
-
-                // テンポ制御: 速度が高いほどテンポが速い
-                int base_duration = 15 - effect_speed;  // 速度1=14, 速度9=6 ティック/単位
-
-                // 音を鳴らしてLEDを点灯する関数
-                auto play_note = [&](int note_idx, int led_pos) {
-                    const MelodyNote* note = &xmas_melody[note_idx];
-
-                    // LED配列に色を保存 (以前の色を維持)
-                    if (note->freq > 0) {
-                        led_hues[led_pos] = note->hue;
-                    }
-
-                    // ブザーで音を鳴らす
-                    if (note->freq > 0) {
-                        ledc_set_freq(LEDC_LOW_SPEED_MODE, LEDC_TIMER_0, note->freq);
-                        ledc_set_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0, 256);
-                        ledc_update_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0);
-                    } else {
-                        ledc_set_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0, 0);
-                        ledc_update_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0);
-                    }
-                };
-
-                if (control_active) {
-                    // コントロールモード: ユーザーが手動でメロディを進める
-                    if (control_position != last_control_pos) {
-                        // ダイヤルが動いた - 次の音を再生
-                        int diff = control_position - last_control_pos;
-                        if (diff > led_count / 2) diff -= led_count;
-                        if (diff < -led_count / 2) diff += led_count;
-
-                        if (diff > 0) {
-                            // 前進 - 音を再生
-                            for (int j = 0; j < diff; j++) {
-                                melody_index = (melody_index + 1) % XMAS_MELODY_LENGTH;
-                                current_led_pos = (current_led_pos + 1) % led_count;
-                                play_note(melody_index, current_led_pos);
-                            }
-                            note_timer = 0;  // スタッカート用にタイマーリセット
-                        } else if (diff < 0) {
-                            // 後退 - LEDをクリア
-                            for (int j = 0; j < -diff; j++) {
-                                led_hues[current_led_pos] = -1;
-                                current_led_pos = (current_led_pos - 1 + led_count) % led_count;
-                                melody_index = (melody_index - 1 + XMAS_MELODY_LENGTH) % XMAS_MELODY_LENGTH;
-                            }
-                            ledc_set_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0, 0);
-                            ledc_update_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0);
-                        }
-                        last_control_pos = control_position;
-                    }
-                    // スタッカート - 短時間後にブザーを停止
-                    note_timer++;
-                    if (note_timer > 8) {
-                        ledc_set_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0, 0);
-                        ledc_update_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0);
-                    }
-                } else {
-                    // 自動モード: メロディを自動再生
-                    last_control_pos = control_position;  // コントロールモード移行時の同期用
-
-                    // 次の音を再生する必要があるか確認
-                    if (note_timer >= note_duration_ticks) {
-                        melody_index = (melody_index + 1) % XMAS_MELODY_LENGTH;
-                        current_led_pos = (current_led_pos + 1) % led_count;
-
-                        // 全LEDを巡ったらリセット
-                        if (current_led_pos == 0) {
-                            for (int i = 0; i < LED_STRIP_MAX_LEDS; i++) {
-                                led_hues[i] = -1;
-                            }
-                        }
-
-                        play_note(melody_index, current_led_pos);
-                        note_duration_ticks = xmas_melody[melody_index].duration * base_duration;
-                        note_timer = 0;
-                    }
-
-                    note_timer++;
-
-                    // スタッカート効果
-                    if (note_timer >= note_duration_ticks - 2) {
-                        ledc_set_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0, 0);
-                        ledc_update_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0);
-                    }
-                }
-
-                // 保存された色で全ての点灯LEDを表示
-                for (int i = 0; i < LED_STRIP_MAX_LEDS; i++) {
-                    if (i < led_count && led_hues[i] >= 0) {
-                        hsv_to_rgb(led_hues[i], led_saturation, led_brightness, &r, &g, &b);
-                        led_strip_set_pixel(led_strip, i, r, g, b);
-                    } else {
-                        led_strip_set_pixel(led_strip, i, 0, 0, 0);
-                    }
-                }
-            }
-            break;
+// 公開された設定を読む。書き込みと重なった場合はoutを変更せずfalse (前のフレームの設定を使い続ける)
+static bool read_led_settings(LedSettings* out) {
+    uint32_t seq = led_settings_seq.load(std::memory_order_acquire);
+    if (seq & 1) {
+        return false;
     }
-
-    led_strip_refresh(led_strip);
+    LedSettings s = led_settings_shared;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (led_settings_seq.load(std::memory_order_relaxed) != seq) {
+        return false;
+    }
+    *out = s;
+    return true;
 }
 
-// ===== エンコーダーISR =====
-// デテント位置でのみカウント (1クリック = 1ステップ)
-// 状態00への最終遷移で方向を判定
-
-static void IRAM_ATTR encoder_isr(void *arg) {
-    uint8_t a = gpio_get_level((gpio_num_t)ENCODER_A_PIN);
-    uint8_t b = gpio_get_level((gpio_num_t)ENCODER_B_PIN);
-    int8_t state = (a << 1) | b;
-
-    // デテント(00)に戻った時だけカウント
-    // どの状態から来たかで方向を判定
-    if (state == 0b00) {
-        if (last_state == 0b10) {
-            encoder_count++;   // 時計回り: 10 -> 00
-        } else if (last_state == 0b01) {
-            encoder_count--;   // 反時計回り: 01 -> 00
-        }
+static void record_frame_stats(uint32_t interval_us, uint32_t work_us, bool fading, uint32_t fades_cut) {
+    portENTER_CRITICAL(&led_stats_lock);
+    if (fading) {
+        led_stats_fade_frames++;
+        led_stats_fade_work_max_us = MAX(led_stats_fade_work_max_us, work_us);
     }
-
-    last_state = state;
+    led_stats_fades_cut += fades_cut;
+    led_stats_frames++;
+    led_stats_min_us = MIN(led_stats_min_us, interval_us);
+    led_stats_max_us = MAX(led_stats_max_us, interval_us);
+    led_stats_sum_us += interval_us;
+    led_stats_work_max_us = MAX(led_stats_work_max_us, work_us);
+    if (interval_us > 1500000 / LED_FRAME_RATE_HZ) {
+        led_stats_late++;
+    }
+    portEXIT_CRITICAL(&led_stats_lock);
 }
 
-// ===== ボタン処理 =====
-
-void update_button_state() {
-    uint32_t now = xTaskGetTickCount() * portTICK_PERIOD_MS;
-    bool current_button = (gpio_get_level((gpio_num_t)ENCODER_BTN_PIN) == 0);
-    button_just_released_short = false;
+static void record_net_frame(uint32_t fades_cut) {
+    portENTER_CRITICAL(&led_stats_lock);
+    led_stats_fades_cut += fades_cut;
+    led_stats_net_frames++;
+    portEXIT_CRITICAL(&led_stats_lock);
+}
 
-    if (current_button && !last_button_state) {
-        button_press_time = now;
-        button_was_long_press = false;
-    } else if (current_button && last_button_state) {
-        if (!button_was_long_press && (now - button_press_time) >= LONG_PRESS_MS) {
-            button_was_long_press = true;
-        }
-    } else if (!current_button && last_button_state) {
-        if (!button_was_long_press) {
-            button_just_released_short = true;
-        }
+// フレーム間隔の統計を取得する。resetがtrueなら取得後に集計をやり直す
+void get_led_frame_stats(LedFrameStats* out, bool reset) {
+    portENTER_CRITICAL(&led_stats_lock);
+    out->frames = led_stats_frames;
+    out->interval_min_us = led_stats_frames ? led_stats_min_us : 0;
+    out->interval_max_us = led_stats_max_us;
+    out->interval_avg_us = led_stats_frames ? (uint32_t)(led_stats_sum_us / led_stats_frames) : 0;
+    out->work_max_us = led_stats_work_max_us;
+    out->late_frames = led_stats_late;
+    out->fade_frames = led_stats_fade_frames;
+    out->fade_work_max_us = led_stats_fade_work_max_us;
+    out->fades_cut = led_stats_fades_cut;
+    out->net_frames = led_stats_net_frames;
+    if (reset) {
+        led_stats_frames = 0;
+        led_stats_min_us = UINT32_MAX;
+        led_stats_max_us = 0;
+        led_stats_sum_us = 0;
+        led_stats_work_max_us = 0;
+        led_stats_late = 0;
+        led_stats_fade_frames = 0;
+        led_stats_fade_work_max_us = 0;
+        led_stats_fades_cut = 0;
+        led_stats_net_frames = 0;
     }
-    last_button_state = current_button;
+    portEXIT_CRITICAL(&led_stats_lock);
 }
 
-bool is_button_held() {
-    return last_button_state && button_was_long_press;
+static void led_frame_timer_callback(void *arg) {
+    xTaskNotify(led_task_handle, LED_NOTIFY_FRAME, eSetBits);
 }
 
-bool was_short_press() {
-    return button_just_released_short;
+// ネットワークから1フレーム受信した (TCP/IPタスクから呼ばれる)
+// 次の周期を待たずに送信し、受信から表示までの遅れを減らす
+static void led_net_frame_ready() {
+    xTaskNotify(led_task_handle, LED_NOTIFY_NET, eSetBits);
 }
 
-// ===== ブザー =====
+static void led_task(void *arg) {
+    LedSettings settings = led_settings_shared;  // 起動前に公開済み
+    int64_t last_frame = esp_timer_get_time();
+    bool first = true;
 
-void buzzer_init() {
-    ledc_timer_config_t timer_conf = {
-        .speed_mode = LEDC_LOW_SPEED_MODE,
-        .duty_resolution = LEDC_TIMER_10_BIT,
-        .timer_num = LEDC_TIMER_0,
-        .freq_hz = 4000,
-        .clk_cfg = LEDC_AUTO_CLK
-    };
-    ledc_timer_config(&timer_conf);
-
-    ledc_channel_config_t channel_conf = {
-        .gpio_num = BUZZER_PIN,
-        .speed_mode = LEDC_LOW_SPEED_MODE,
-        .channel = LEDC_CHANNEL_0,
-        .intr_type = LEDC_INTR_DISABLE,
-        .timer_sel = LEDC_TIMER_0,
-        .duty = 0,
-        .hpoint = 0
-    };
-    ledc_channel_config(&channel_conf);
+    while (1) {
+        uint32_t notified = 0;
+        xTaskNotifyWait(0, UINT32_MAX, &notified, portMAX_DELAY);
+        int64_t start = esp_timer_get_time();
+        // 受信だけで起きたフレームは周期の間に割り込むので、間隔は周期のフレームどうしで測る
+        bool periodic = (notified & LED_NOTIFY_FRAME) != 0;
+        uint32_t interval_us = 0;
+        if (periodic) {
+            interval_us = (uint32_t)(start - last_frame);
+            last_frame = start;
+        }
+
+#if INPUT_LATENCY_TRACE
+        // 印は設定の公開の後に付くので、印を受け取ってから読んだ設定はその入力を反映している
+        uint32_t input_tag = led_input_tag.exchange(0, std::memory_order_acquire);
+        if (!read_led_settings(&settings) && input_tag) {
+            uint32_t none = 0;
+            led_input_tag.compare_exchange_strong(none, input_tag);  // 読めなかった: 次のフレームで計る
+            input_tag = 0;
+        }
+#else
+        read_led_settings(&settings);
+#endif
+        // フェードの始まりと終わりのフレームも2つのエフェクトを描くので、前後どちらかでフェード中なら数える
+        bool fading = led_compositor.fading();
+        uint32_t fades_cut = led_compositor.fades_cut();
+        // 受信だけのフレームではアニメーションを進めない (経過時間は次の周期のフレームでまとめて進める)
+        update_leds(settings, MIN(interval_us, (uint32_t)LED_MAX_FRAME_DT_US));
+        fading |= led_compositor.fading();
+        fades_cut = led_compositor.fades_cut() - fades_cut;
+#if INPUT_LATENCY_TRACE
+        if (input_tag) {
+            ws2812_wait();  // 入力を反映したフレームは送信完了まで待って計る (処理時間の統計に含まれる)
+            latency_record(&led_latency, latency_since(input_tag, esp_timer_get_time()));
+        }
+#endif
+
+        // 最初のフレームは間隔が定まらないので集計しない
+        if (!periodic) {
+            record_net_frame(fades_cut);
+        } else {
+            if (!first) {
+                record_frame_stats(interval_us, (uint32_t)(esp_timer_get_time() - start), fading, fades_cut);
+            }
+            first = false;
+        }
+    }
 }
 
-void buzzer_beep(uint32_t freq, uint32_t duration_ms) {
-    ledc_set_freq(LEDC_LOW_SPEED_MODE, LEDC_TIMER_0, freq);
-    ledc_set_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0, 512);
-    ledc_update_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0);
-    vTaskDelay(pdMS_TO_TICKS(duration_ms));
-    ledc_set_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0, 0);
-    ledc_update_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0);
+// LEDタスクと、それを周期的に起こすタイマーを開始する
+void led_task_start() {
+    publish_led_settings();
+    xTaskCreatePinnedToCore(led_task, "led", 4096, NULL, LED_TASK_PRIORITY, &led_task_handle, LED_TASK_CORE);
+
+    esp_timer_create_args_t timer_args = {
+        .callback = led_frame_timer_callback,
+        .arg = nullptr,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "led_frame",
+        .skip_unhandled_events = true
+    };
+    esp_timer_handle_t timer;
+    if (esp_timer_create(&timer_args, &timer) != ESP_OK) {
+        ESP_LOGE(TAG, "LED frame timer create failed");
+        return;
+    }
+    esp_timer_start_periodic(timer, 1000000 / LED_FRAME_RATE_HZ);
+    ESP_LOGI(TAG, "LEDタスク開始: %d Hz (コア%d)", LED_FRAME_RATE_HZ, LED_TASK_CORE);
 }
 
 // ===== ディスプレイ =====
@@ -813,6 +667,15 @@ static bool in_adjustment_mode = false;
 #define DOT_RADIUS_SMALL 5
 #define DOT_RADIUS_LARGE 8
 
+// 背景と外周リングを描画 (内容は固定のため初回のみレイヤーに描画して再利用)
+void draw_ring() {
+    if (ring_layer.isChanged(0)) {
+        ring_layer.fillScreen(UI_BLACK);
+        ring_layer.fillArc(CIRCLE_CENTER_X, CIRCLE_CENTER_Y, CIRCLE_RADIUS - 1, CIRCLE_RADIUS + 1, 0, 360, UI_WHITE);
+    }
+    ring_layer.pushLayer(&canvas);
+}
+
 // 円上の角度位置にドットを描画
 void draw_circle_dot(float angle_deg, int radius, bool is_large, bool is_filled) {
     float angle_rad = (angle_deg - 90) * 3.14159f / 180.0f;  // -90 to start from top
@@ -830,10 +693,7 @@ void draw_circle_dot(float angle_deg, int radius, bool is_large, bool is_filled)
 
 // レイヤー1を描画: メニュー選択
 void draw_menu_select() {
-    canvas.fillScreen(UI_BLACK);
-
-    // 円の輪郭を描画 (太くクリーンな線)
-    canvas.fillArc(CIRCLE_CENTER_X, CIRCLE_CENTER_Y, CIRCLE_RADIUS - 1, CIRCLE_RADIUS + 1, 0, 360, UI_WHITE);
+    draw_ring();
 
     // メニュードットを描画 (等間隔で配置)
     for (int i = 0; i < MODE_MAX; i++) {
@@ -844,7 +704,7 @@ void draw_menu_select() {
 
     // 中央: 現在のメニュー名
     canvas.setTextDatum(MC_DATUM);
-    canvas.setFont(&fonts::lgfxJapanGothicP_28);
+    canvas.setFont(&font_jp_28);
     canvas.setTextColor(UI_WHITE);
     canvas.drawString(mode_names[current_mode], CIRCLE_CENTER_X, CIRCLE_CENTER_Y);
 }
@@ -875,46 +735,45 @@ const char* get_color_name(uint16_t hue) {
     return "ROSE";
 }
 
-// 色相選択用カラーホイールを描画
-void draw_hue_wheel() {
-    canvas.fillScreen(UI_BLACK);
-
-    // 選択されたセグメントのインデックスを検索
-    int selected_segment = (led_hue * COLOR_WHEEL_SEGMENTS / 360) % COLOR_WHEEL_SEGMENTS;
+// カラーホイールをレイヤーに描画 (内容は選択セグメントのみで決まる)
+static void render_hue_wheel(LGFX_Layer& layer, int selected_segment) {
+    layer.fillScreen(UI_BLACK);
 
     // セグメント間のギャップ (度数)
     const float gap_angle = 6.0f;
     const float segment_angle = 360.0f / COLOR_WHEEL_SEGMENTS;
 
+    // 全セグメントの色をまとめて変換
+    Hsv hsv[COLOR_WHEEL_SEGMENTS];
+    uint16_t colors[COLOR_WHEEL_SEGMENTS];
+    for (int i = 0; i < COLOR_WHEEL_SEGMENTS; i++) {
+        hsv[i] = { (uint16_t)(i * 360 / COLOR_WHEEL_SEGMENTS), 255, 255 };
+    }
+    hsv_to_rgb565_n(hsv, colors, COLOR_WHEEL_SEGMENTS);
+
     // ギャップ付きでカラーホイールセグメントを描画
     for (int i = 0; i < COLOR_WHEEL_SEGMENTS; i++) {
-        int hue = (i * 360) / COLOR_WHEEL_SEGMENTS;
         float base_angle = (float)i * segment_angle - 90;  // -90 to start from top
 
         // ギャップを作るためにセグメントを縮小 (開始にgap/2を追加、終了からgap/2を減算)
         float start_angle = base_angle + gap_angle / 2.0f;
         float end_angle = base_angle + segment_angle - gap_angle / 2.0f;
 
-        // このセグメントのHSVをRGBに変換
-        uint8_t r, g, b;
-        hsv_to_rgb(hue, 255, 255, &r, &g, &b);
-        uint16_t color = ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
-
         // 塗りつぶし円弧セグメントを描画
-        canvas.fillArc(CIRCLE_CENTER_X, CIRCLE_CENTER_Y,
-                       COLOR_WHEEL_INNER_R, COLOR_WHEEL_OUTER_R,
-                       start_angle, end_angle, color);
+        layer.fillArc(CIRCLE_CENTER_X, CIRCLE_CENTER_Y,
+                      COLOR_WHEEL_INNER_R, COLOR_WHEEL_OUTER_R,
+                      start_angle, end_angle, colors[i]);
 
         // 選択セグメントに白枠を描画
         if (i == selected_segment) {
             // 太い白の円弧枠を描画 (内側と外側)
             for (int t = -1; t <= 1; t++) {
-                canvas.drawArc(CIRCLE_CENTER_X, CIRCLE_CENTER_Y,
-                               COLOR_WHEEL_INNER_R + t, COLOR_WHEEL_INNER_R + t + 1,
-                               start_angle, end_angle, UI_WHITE);
-                canvas.drawArc(CIRCLE_CENTER_X, CIRCLE_CENTER_Y,
-                               COLOR_WHEEL_OUTER_R + t - 1, COLOR_WHEEL_OUTER_R + t,
-                               start_angle, end_angle, UI_WHITE);
+                layer.drawArc(CIRCLE_CENTER_X, CIRCLE_CENTER_Y,
+                              COLOR_WHEEL_INNER_R + t, COLOR_WHEEL_INNER_R + t + 1,
+                              start_angle, end_angle, UI_WHITE);
+                layer.drawArc(CIRCLE_CENTER_X, CIRCLE_CENTER_Y,
+                              COLOR_WHEEL_OUTER_R + t - 1, COLOR_WHEEL_OUTER_R + t,
+                              start_angle, end_angle, UI_WHITE);
             }
             // 側面の線を描画 (太く)
             float rad1 = start_angle * 3.14159f / 180.0f;
@@ -926,12 +785,12 @@ void draw_hue_wheel() {
                 int oy1 = (int)(sin(perp1) * t);
                 int ox2 = (int)(cos(perp2) * t);
                 int oy2 = (int)(sin(perp2) * t);
-                canvas.drawLine(
+                layer.drawLine(
                     CIRCLE_CENTER_X + (int)(cos(rad1) * COLOR_WHEEL_INNER_R) + ox1,
                     CIRCLE_CENTER_Y + (int)(sin(rad1) * COLOR_WHEEL_INNER_R) + oy1,
                     CIRCLE_CENTER_X + (int)(cos(rad1) * COLOR_WHEEL_OUTER_R) + ox1,
                     CIRCLE_CENTER_Y + (int)(sin(rad1) * COLOR_WHEEL_OUTER_R) + oy1, UI_WHITE);
-                canvas.drawLine(
+                layer.drawLine(
                     CIRCLE_CENTER_X + (int)(cos(rad2) * COLOR_WHEEL_INNER_R) + ox2,
                     CIRCLE_CENTER_Y + (int)(sin(rad2) * COLOR_WHEEL_INNER_R) + oy2,
                     CIRCLE_CENTER_X + (int)(cos(rad2) * COLOR_WHEEL_OUTER_R) + ox2,
@@ -942,26 +801,33 @@ void draw_hue_wheel() {
 
     // 選択セグメントの色で中央円を描画 (ホイールと同じ色)
     int display_hue = (selected_segment * 360) / COLOR_WHEEL_SEGMENTS;
-    uint8_t r, g, b;
-    hsv_to_rgb(display_hue, 255, 255, &r, &g, &b);
-    uint16_t center_color = ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+    uint16_t center_color = colors[selected_segment];
 
     int center_radius = COLOR_WHEEL_INNER_R - 15;
-    canvas.fillCircle(CIRCLE_CENTER_X, CIRCLE_CENTER_Y, center_radius, center_color);
+    layer.fillCircle(CIRCLE_CENTER_X, CIRCLE_CENTER_Y, center_radius, center_color);
 
     // 中央に色名を描画 (明るい色でも見やすいよう黒文字)
-    canvas.setTextDatum(MC_DATUM);
-    canvas.setFont(&fonts::Font4);
-    canvas.setTextColor(UI_BLACK);
-    canvas.drawString(get_color_name(display_hue), CIRCLE_CENTER_X, CIRCLE_CENTER_Y);
+    layer.setTextDatum(MC_DATUM);
+    layer.setFont(&fonts::Font4);
+    layer.setTextColor(UI_BLACK);
+    layer.drawString(get_color_name(display_hue), CIRCLE_CENTER_X, CIRCLE_CENTER_Y);
+}
+
+// 色相選択用カラーホイールを描画
+void draw_hue_wheel() {
+    // 選択されたセグメントのインデックスを検索
+    int selected_segment = (led_hue * COLOR_WHEEL_SEGMENTS / 360) % COLOR_WHEEL_SEGMENTS;
+
+    // 選択セグメントが変わった時のみホイールを描き直す
+    if (hue_wheel_layer.isChanged(selected_segment)) {
+        render_hue_wheel(hue_wheel_layer, selected_segment);
+    }
+    hue_wheel_layer.pushLayer(&canvas);
 }
 
 // エフェクト選択を描画 (レイヤー1と同じスタイル)
 void draw_effect_select() {
-    canvas.fillScreen(UI_BLACK);
-
-    // 円の輪郭を描画 (太くクリーンな線)
-    canvas.fillArc(CIRCLE_CENTER_X, CIRCLE_CENTER_Y, CIRCLE_RADIUS - 1, CIRCLE_RADIUS + 1, 0, 360, UI_WHITE);
+    draw_ring();
 
     // エフェクトドットを描画 (等間隔で配置)
     for (int i = 0; i < NUM_EFFECTS; i++) {
@@ -981,17 +847,14 @@ void draw_effect_select() {
 
     // 中央: エフェクト名
     canvas.setTextDatum(MC_DATUM);
-    canvas.setFont(&fonts::lgfxJapanGothicP_28);
+    canvas.setFont(&font_jp_28);
     canvas.setTextColor(UI_WHITE);
     canvas.drawString(effect_names[led_effect], CIRCLE_CENTER_X, CIRCLE_CENTER_Y);
 }
 
 // コントロールモードUIを描画
 void draw_control_mode() {
-    canvas.fillScreen(UI_BLACK);
-
-    // 完全な円を描画
-    canvas.fillArc(CIRCLE_CENTER_X, CIRCLE_CENTER_Y, CIRCLE_RADIUS - 1, CIRCLE_RADIUS + 1, 0, 360, UI_WHITE);
+    draw_ring();
 
     // 円上に位置インジケーターを描画
     float angle_deg = (360.0f * control_position / led_count) - 90;  // -90 to start from top
@@ -1002,13 +865,13 @@ void draw_control_mode() {
 
     // 中央: エフェクト名と位置
     canvas.setTextDatum(MC_DATUM);
-    canvas.setFont(&fonts::lgfxJapanGothicP_20);
+    canvas.setFont(&font_jp_20);
     canvas.setTextColor(UI_WHITE);
     canvas.drawString(effect_names[led_effect], CIRCLE_CENTER_X, CIRCLE_CENTER_Y - 20);
 
     char pos_str[16];
     snprintf(pos_str, sizeof(pos_str), "%d / %d", control_position + 1, led_count);
-    canvas.setFont(&fonts::lgfxJapanGothicP_28);
+    canvas.setFont(&font_jp_28);
     canvas.drawString(pos_str, CIRCLE_CENTER_X, CIRCLE_CENTER_Y + 20);
 }
 
@@ -1032,13 +895,16 @@ void draw_value_adjust() {
         return;
     }
 
-    canvas.fillScreen(UI_BLACK);
-
     // 円弧を描画 (下部が開いている): 135°から45°まで上部を経由
-    canvas.drawArc(CIRCLE_CENTER_X, CIRCLE_CENTER_Y, CIRCLE_RADIUS - 1, CIRCLE_RADIUS + 1,
-                   ARC_START_ANGLE, 360, UI_WHITE);
-    canvas.drawArc(CIRCLE_CENTER_X, CIRCLE_CENTER_Y, CIRCLE_RADIUS - 1, CIRCLE_RADIUS + 1,
-                   0, ARC_END_ANGLE, UI_WHITE);
+    // 内容は固定のため初回のみレイヤーに描画して再利用
+    if (arc_layer.isChanged(0)) {
+        arc_layer.fillScreen(UI_BLACK);
+        arc_layer.drawArc(CIRCLE_CENTER_X, CIRCLE_CENTER_Y, CIRCLE_RADIUS - 1, CIRCLE_RADIUS + 1,
+                          ARC_START_ANGLE, 360, UI_WHITE);
+        arc_layer.drawArc(CIRCLE_CENTER_X, CIRCLE_CENTER_Y, CIRCLE_RADIUS - 1, CIRCLE_RADIUS + 1,
+                          0, ARC_END_ANGLE, UI_WHITE);
+    }
+    arc_layer.pushLayer(&canvas);
 
     // 現在値をパーセンテージで計算 (0.0 - 1.0)
     float value_pct = 0.0f;
@@ -1050,7 +916,7 @@ void draw_value_adjust() {
             snprintf(value_str, sizeof(value_str), "%d%%", led_brightness * 100 / 255);
             break;
         case MODE_COUNT:
-            value_pct = (led_count - 1) / (float)(LED_STRIP_MAX_LEDS - 1);
+            value_pct = (led_count - 1) / (float)MAX(1, led_pixel_count - 1);
             snprintf(value_str, sizeof(value_str), "%d", led_count);
             break;
         case MODE_SPEED:
@@ -1072,11 +938,11 @@ void draw_value_adjust() {
 
     // 中央: メニュー名 + 値
     canvas.setTextDatum(MC_DATUM);
-    canvas.setFont(&fonts::lgfxJapanGothicP_20);
+    canvas.setFont(&font_jp_20);
     canvas.setTextColor(UI_WHITE);
     canvas.drawString(mode_names[current_mode], CIRCLE_CENTER_X, CIRCLE_CENTER_Y - 15);
 
-    canvas.setFont(&fonts::lgfxJapanGothicP_28);
+    canvas.setFont(&font_jp_28);
     canvas.drawString(value_str, CIRCLE_CENTER_X, CIRCLE_CENTER_Y + 20);
 }
 
@@ -1085,7 +951,7 @@ void update_display() {
         canvas.fillScreen(UI_BLACK);
         canvas.setTextColor(UI_WHITE);
         canvas.setTextDatum(MC_DATUM);
-        canvas.setFont(&fonts::lgfxJapanGothicP_20);
+        canvas.setFont(&font_jp_20);
         canvas.drawString("更新中...", 120, 100);
         canvas.drawRoundRect(40, 130, 160, 12, 6, UI_WHITE);
         canvas.fillRoundRect(42, 132, (156 * ota_progress) / 100, 8, 4, UI_WHITE);
@@ -1095,7 +961,7 @@ void update_display() {
         draw_menu_select();
     }
 
-    canvas.pushSprite(0, 0);
+    canvas.pushList(0, 0);  // 記録した描画をバンドごとに展開して転送
 }
 
 // ===== WiFiとOTA =====
@@ -1112,6 +978,9 @@ static void wifi_event_handler(void* arg, esp_event_base_t event_base,
         snprintf(ip_address, sizeof(ip_address), IPSTR, IP2STR(&event->ip_info.ip));
         ESP_LOGI(TAG, "Got IP: %s", ip_address);
         xEventGroupSetBits(wifi_event_group, WIFI_CONNECTED_BIT);
+#if LED_NET_ENABLE
+        led_net_rejoin();
+#endif
     }
 }
 
@@ -1219,6 +1088,23 @@ static esp_err_t ota_post_handler(httpd_req_t *req) {
     return ESP_OK;
 }
 
+#if INPUT_LATENCY_TRACE
+static esp_err_t latency_get_handler(httpd_req_t *req) {
+    char text[256];
+    int len = MIN(latency_format(&display_latency, "display", text, sizeof(text)), (int)sizeof(text) - 2);
+    text[len++] = '\n';
+    latency_format(&led_latency, "led", text + len, sizeof(text) - len);
+    char query[16];
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK && strcmp(query, "reset") == 0) {
+        latency_reset(&display_latency);
+        latency_reset(&led_latency);
+    }
+    httpd_resp_set_type(req, "text/plain; charset=utf-8");
+    httpd_resp_sendstr(req, text);
+    return ESP_OK;
+}
+#endif
+
 static esp_err_t root_get_handler(httpd_req_t *req) {
     const char *html = "<html><body><h1>M5Dial LED Controller OTA</h1>"
         "<form method='POST' action='/update' enctype='multipart/form-data'>"
@@ -1237,9 +1123,110 @@ void start_ota_server() {
 
         httpd_uri_t ota_uri = {.uri = "/update", .method = HTTP_POST, .handler = ota_post_handler};
         httpd_register_uri_handler(server, &ota_uri);
+
+#if INPUT_LATENCY_TRACE
+        httpd_uri_t latency_uri = {.uri = "/latency", .method = HTTP_GET, .handler = latency_get_handler};
+        httpd_register_uri_handler(server, &latency_uri);
+#endif
     }
 }
 
+#if FONT_BENCHMARK
+// ===== フォント検索ベンチマーク =====
+
+// 索引の有無で日本語の文字列描画にかかる時間を比較 (グリフキャッシュは使わない)
+static void font_benchmark() {
+    const int repeat = 10;
+    canvas.setGlyphCache(nullptr);
+    canvas.setTextDatum(MC_DATUM);
+    for (auto font : { &font_jp_20, &font_jp_28 }) {
+        canvas.setFont(font);
+        for (int stride : { 0, FONT_INDEX_STRIDE }) {
+            font->setIndexStride(stride);
+            canvas.drawString(mode_names[0], CIRCLE_CENTER_X, CIRCLE_CENTER_Y);  // 索引作成を計測から除外
+            canvas.clearList();
+
+            int64_t start = esp_timer_get_time();
+            for (int i = 0; i < repeat; i++) {
+                for (auto name : effect_names) canvas.drawString(name, CIRCLE_CENTER_X, CIRCLE_CENTER_Y);
+                for (auto name : mode_names) canvas.drawString(name, CIRCLE_CENTER_X, CIRCLE_CENTER_Y);
+                canvas.clearList();
+            }
+            ESP_LOGI(TAG, "フォント描画 %dpx 索引間隔%d: %lld us",
+                     font == &font_jp_20 ? 20 : 28, stride,
+                     (long long)((esp_timer_get_time() - start) / repeat));
+        }
+    }
+    canvas.setGlyphCache(&glyph_cache);
+}
+#endif
+
+// ===== 入力処理 =====
+
+// 短押し: 調整モードに入る / 確定して戻る
+void handle_short_press() {
+    if (in_adjustment_mode) {
+        // レイヤー2 -> レイヤー1: 確定して戻る
+        in_adjustment_mode = false;
+        control_active = false;
+        buzzer_beep(1000, 30);
+    } else {
+        // レイヤー1 -> レイヤー2: 調整モードに入る
+        in_adjustment_mode = true;
+        if (current_mode == MODE_CONTROL) {
+            control_active = true;
+        }
+        buzzer_beep(1500, 30);
+    }
+}
+
+// エンコーダー回転 (diffステップ、調整モードでは加速済み)
+void handle_detent(int diff) {
+    if (in_adjustment_mode) {
+        // レイヤー2: 値を調整
+        switch (current_mode) {
+            case MODE_HUE:
+                // 12セグメント = 1ステップあたり30度 (360/12)
+                led_hue = (led_hue + diff * 30 + 360) % 360;
+                break;
+            case MODE_BRIGHTNESS:
+                // 20%ステップ (255 / 5 = 51)
+                led_brightness = (uint8_t)MAX(0, MIN(255, led_brightness + diff * 51));
+                break;
+            case MODE_COUNT:
+                led_count = (uint16_t)MAX(1, MIN(led_pixel_count, led_count + diff));
+                break;
+            case MODE_EFFECT:
+                led_effect = (led_effect + diff + NUM_EFFECTS) % NUM_EFFECTS;
+                break;
+            case MODE_SPEED:
+                effect_speed = (uint8_t)MAX(1, MIN(9, effect_speed + diff));
+                break;
+            case MODE_CONTROL:
+                // led_countに基づいてラップアラウンド
+                control_position = ((control_position + diff) % led_count + led_count) % led_count;
+                break;
+            default:
+                break;
+        }
+    } else {
+        // レイヤー1: メニュー選択を変更
+        int new_mode = (current_mode + diff + MODE_MAX) % MODE_MAX;
+        current_mode = (ControlMode)new_mode;
+    }
+}
+
+// タッチパネルの位置を読む (入力イベントキューから、触れている間だけ呼ばれる)
+static bool read_touch(int16_t* x, int16_t* y, void*) {
+    lgfx::touch_point_t tp;
+    if (display.getTouch(&tp, 1) == 0) {
+        return false;
+    }
+    *x = tp.x;
+    *y = tp.y;
+    return true;
+}
+
 // ===== メイン =====
 
 extern "C" void app_main(void) {
@@ -1257,49 +1244,63 @@ extern "C" void app_main(void) {
     display.init();
     display.setRotation(0);
     display.setBrightness(128);
-    canvas.createSprite(240, 240);
+    canvas.setColorDepth(16);
+    canvas.createList(240, 240, 24);
+    canvas.setGlyphCache(&glyph_cache);
+    for (auto layer : { &ring_layer, &arc_layer, &hue_wheel_layer }) {
+        layer->setColorDepth(16);
+        layer->createLayer(240, 240);
+        layer->setGlyphCache(&glyph_cache);
+    }
+    for (auto font : { &font_jp_20, &font_jp_28 }) {
+        font->setIndexStride(FONT_INDEX_STRIDE);
+    }
+#if FONT_BENCHMARK
+    font_benchmark();
+#endif
 
     // ブザー初期化
-    buzzer_init();
+    buzzer_init(BUZZER_PIN);
 
     // WiFiとOTAサーバー初期化
     wifi_init();
     start_ota_server();
 
     // LEDストリップ初期化
-    led_strip_init();
-
-    // エンコーダー初期化
-    gpio_config_t encoder_conf = {
-        .pin_bit_mask = (1ULL << ENCODER_A_PIN) | (1ULL << ENCODER_B_PIN),
-        .mode = GPIO_MODE_INPUT,
-        .pull_up_en = GPIO_PULLUP_ENABLE,
-        .pull_down_en = GPIO_PULLDOWN_DISABLE,
-        .intr_type = GPIO_INTR_ANYEDGE
-    };
-    gpio_config(&encoder_conf);
-
-    gpio_config_t button_conf = {
-        .pin_bit_mask = (1ULL << ENCODER_BTN_PIN),
-        .mode = GPIO_MODE_INPUT,
-        .pull_up_en = GPIO_PULLUP_ENABLE,
-        .pull_down_en = GPIO_PULLDOWN_DISABLE,
-        .intr_type = GPIO_INTR_DISABLE
-    };
-    gpio_config(&button_conf);
+    led_color_set_correction(LED_GAMMA, LED_WHITE_R, LED_WHITE_G, LED_WHITE_B);
+    if (LED_RANDOM_SEED) {
+        led_rng.seed(LED_RANDOM_SEED);
+    } else {
+        led_rng.seed(((uint64_t)esp_random() << 32) | esp_random());
+    }
+    if (led_strip_init()) {
+        led_task_start();
+#if LED_NET_ENABLE
+        if (!led_net_start(led_pixel_count, LED_NET_E131_UNIVERSE, led_net_frame_ready)) {
+            ESP_LOGE(TAG, "LED network input start failed");
+        }
+#endif
+    }
 
-    gpio_install_isr_service(0);
-    gpio_isr_handler_add((gpio_num_t)ENCODER_A_PIN, encoder_isr, NULL);
-    gpio_isr_handler_add((gpio_num_t)ENCODER_B_PIN, encoder_isr, NULL);
+    // エンコーダーとボタン、タッチパネル初期化 (回転はPCNTで数え、1クリック = 1ステップ)
+    encoder_init(ENCODER_A_PIN, ENCODER_B_PIN);
+    input_init(ENCODER_BTN_PIN, LONG_PRESS_MS);
+    input_touch_init(TOUCH_INT_PIN, read_touch, nullptr, GESTURE_CONFIG_M5DIAL);
 
     // 起動ビープ
     buzzer_beep(1000, 100);
 
-    int32_t last_encoder = 0;
+#if LED_FRAME_STATS_LOG
+    int64_t last_stats_log = esp_timer_get_time();
+#endif
+#if INPUT_LATENCY_TRACE
+    int64_t last_latency_log = esp_timer_get_time();
+#endif
 
-    // メインループ
+    // メインループ (入力は届いた時点で処理し、無ければ LOOP_PERIOD_MS ごとに画面を更新する)
     while (1) {
-        update_button_state();
+        input_event_t events[INPUT_BATCH];
+        size_t n = input_read(events, INPUT_BATCH, LOOP_PERIOD_MS);
 
         if (ota_in_progress) {
             update_display();
@@ -1307,69 +1308,70 @@ extern "C" void app_main(void) {
             continue;
         }
 
-        // ボタン押下処理
-        if (was_short_press()) {
-            if (in_adjustment_mode) {
-                // レイヤー2 -> レイヤー1: 確定して戻る
-                in_adjustment_mode = false;
-                control_active = false;
-                buzzer_beep(1000, 30);
-            } else {
-                // レイヤー1 -> レイヤー2: 調整モードに入る
-                in_adjustment_mode = true;
-                if (current_mode == MODE_CONTROL) {
-                    control_active = true;
-                }
-                buzzer_beep(1500, 30);
+        for (size_t i = 0; i < n; i++) {
+            if (events[i].type == INPUT_DETENT) {
+                handle_detent(input_accel_step(events[i], in_adjustment_mode ? mode_accel[current_mode] : INPUT_ACCEL_NONE));
+            } else if (events[i].type == INPUT_RING) {
+                handle_detent(events[i].value);
+            } else if ((events[i].type == INPUT_RELEASE && events[i].value) || events[i].type == INPUT_TAP) {
+                handle_short_press();
             }
         }
 
-        // エンコーダー回転処理
-        int32_t current_encoder = encoder_count;
-        if (current_encoder != last_encoder) {
-            int diff = current_encoder - last_encoder;
-            last_encoder = current_encoder;
-
-            if (in_adjustment_mode) {
-                // レイヤー2: 値を調整
-                switch (current_mode) {
-                    case MODE_HUE:
-                        // 12セグメント = 1ステップあたり30度 (360/12)
-                        led_hue = (led_hue + diff * 30 + 360) % 360;
-                        break;
-                    case MODE_BRIGHTNESS:
-                        // 20%ステップ (255 / 5 = 51)
-                        led_brightness = (uint8_t)MAX(0, MIN(255, led_brightness + diff * 51));
-                        break;
-                    case MODE_COUNT:
-                        led_count = (uint8_t)MAX(1, MIN(LED_STRIP_MAX_LEDS, led_count + diff));
-                        break;
-                    case MODE_EFFECT:
-                        led_effect = (led_effect + diff + NUM_EFFECTS) % NUM_EFFECTS;
-                        break;
-                    case MODE_SPEED:
-                        effect_speed = (uint8_t)MAX(1, MIN(9, effect_speed + diff));
-                        break;
-                    case MODE_CONTROL:
-                        // led_countに基づいてラップアラウンド
-                        control_position = (control_position + diff + led_count) % led_count;
-                        break;
-                    default:
-                        break;
-                }
-            } else {
-                // レイヤー1: メニュー選択を変更
-                int new_mode = (current_mode + diff + MODE_MAX) % MODE_MAX;
-                current_mode = (ControlMode)new_mode;
+        // LED設定をLEDタスクに渡す (LEDの更新はLEDタスクが一定周期で行う)
+        publish_led_settings();
+#if INPUT_LATENCY_TRACE
+        uint32_t input_tag = n > 0 ? latency_tag(events[0].time_us) : 0;
+        if (input_tag) {
+            uint32_t none = 0;
+            led_input_tag.compare_exchange_strong(none, input_tag, std::memory_order_release);
+        }
+        if (esp_timer_get_time() - last_latency_log >= 10 * 1000000) {
+            last_latency_log = esp_timer_get_time();
+            char line[128];
+            if (display_latency.count.load(std::memory_order_relaxed)) {
+                latency_format(&display_latency, "display", line, sizeof(line));
+                ESP_LOGI(TAG, "入力の遅延 %s", line);
+            }
+            if (led_latency.count.load(std::memory_order_relaxed)) {
+                latency_format(&led_latency, "led", line, sizeof(line));
+                ESP_LOGI(TAG, "入力の遅延 %s", line);
             }
         }
+#endif
 
-        // LED更新 (現在は常時オン、後でオン/オフ追加可能)
-        update_leds();
+#if LED_FRAME_STATS_LOG
+        if (esp_timer_get_time() - last_stats_log >= 10 * 1000000) {
+            last_stats_log = esp_timer_get_time();
+            LedFrameStats stats;
+            get_led_frame_stats(&stats, true);
+            ESP_LOGI(TAG, "LEDフレーム %lu回: 間隔 %lu/%lu/%lu us (最小/平均/最大), 遅延 %lu回, 処理最大 %lu us",
+                     (unsigned long)stats.frames, (unsigned long)stats.interval_min_us,
+                     (unsigned long)stats.interval_avg_us, (unsigned long)stats.interval_max_us,
+                     (unsigned long)stats.late_frames, (unsigned long)stats.work_max_us);
+            if (stats.fade_frames) {
+                ESP_LOGI(TAG, "切り替えのフェード %lu フレーム: 処理最大 %lu us (上限 %d us), 打ち切り %lu回",
+                         (unsigned long)stats.fade_frames, (unsigned long)stats.fade_work_max_us,
+                         LED_FADE_BUDGET_US, (unsigned long)stats.fades_cut);
+            }
+#if LED_NET_ENABLE
+            LedNetStats net;
+            led_net_get_stats(&net, true);
+            if (net.packets || net.invalid) {
+                ESP_LOGI(TAG, "ネットワーク入力: %lu パケット, %lu フレーム (周期外の送信 %lu), 欠落 %lu, 順序違い %lu, 不正 %lu",
+                         (unsigned long)net.packets, (unsigned long)net.frames, (unsigned long)stats.net_frames,
+                         (unsigned long)net.dropped, (unsigned long)net.out_of_order, (unsigned long)net.invalid);
+            }
+#endif
+        }
+#endif
 
-        // ディスプレイ更新
+        // ディスプレイ更新 (転送が終わってから戻る)
         update_display();
-
-        vTaskDelay(pdMS_TO_TICKS(20));
+#if INPUT_LATENCY_TRACE
+        if (input_tag) {
+            latency_record(&display_latency, latency_since(input_tag, esp_timer_get_time()));
+        }
+#endif
     }
 }
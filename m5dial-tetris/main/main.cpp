@@ -5,6 +5,9 @@
  * - エンコーダー回転: ピースを左右に移動
  * - エンコーダー押下: ピースを回転
  * - エンコーダー長押し: 高速落下
+ * - 画面の外周をなぞる: ピースを左右に移動 (15度で1列)
+ * - タップ / 上スワイプ: ピースを回転
+ * - 左右スワイプ: 1列移動、下スワイプ: 一番下まで落とす
  */
 
 #include <stdio.h>
@@ -14,7 +17,6 @@
 #include "freertos/task.h"
 #include "freertos/event_groups.h"
 #include "driver/gpio.h"
-#include "driver/ledc.h"
 #include "esp_log.h"
 #include "esp_wifi.h"
 #include "esp_event.h"
@@ -24,11 +26,17 @@
 #include "nvs_flash.h"
 #include "mdns.h"
 #include "esp_random.h"
+#include "esp_timer.h"
 
 #define LGFX_USE_V1
 #include <LovyanGFX.hpp>
 
 #include "wifi_credentials.h"
+#include "m5dial_buzzer.h"
+#include "m5dial_encoder.h"
+#include "m5dial_gesture.h"
+#include "m5dial_input.h"
+#include "m5dial_latency.h"
 
 #ifndef MIN
 #define MIN(a, b) ((a) < (b) ? (a) : (b))
@@ -50,6 +58,12 @@ static const char *TAG = "M5Dial-Tetris";
 
 #define BUZZER_PIN 3
 
+// タッチパネル (FT3267, I2C)
+#define TOUCH_SDA_PIN 11
+#define TOUCH_SCL_PIN 12
+#define TOUCH_INT_PIN 14
+#define TOUCH_I2C_PORT 1
+
 // テトリス定数
 #define BOARD_WIDTH 10
 #define BOARD_HEIGHT 20
@@ -57,6 +71,15 @@ static const char *TAG = "M5Dial-Tetris";
 #define BOARD_X ((240 - BOARD_WIDTH * BLOCK_SIZE) / 2)
 #define BOARD_Y 15
 
+// メインループ周期 (転送は描画と並行するので16ms待ちより短くできる)
+#define FRAME_INTERVAL_MS 10
+
+// 1にすると入力 (割り込みの時刻) から、それを反映した画面の転送完了までの遅延を集計し、
+// 10秒ごとにログへ、HTTPの /latency (?reset で集計をやり直す) に出す
+#ifndef INPUT_LATENCY_TRACE
+#define INPUT_LATENCY_TRACE 0
+#endif
+
 // テトロミノの形状 (各4回転)
 static const uint16_t TETROMINOES[7][4] = {
     // I
@@ -91,6 +114,7 @@ class LGFX_M5Dial : public lgfx::LGFX_Device {
     lgfx::Panel_GC9A01 _panel_instance;
     lgfx::Bus_SPI _bus_instance;
     lgfx::Light_PWM _light_instance;
+    lgfx::Touch_FT5x06 _touch_instance;
 
 public:
     LGFX_M5Dial(void) {
@@ -123,6 +147,7 @@ public:
             cfg.rgb_order = false;
             cfg.bus_shared = true;
             _panel_instance.config(cfg);
+            _panel_instance.setRoundMask<240>();  // 円形表示部の外側は転送しない
         }
         {
             auto cfg = _light_instance.config();
@@ -133,6 +158,24 @@ public:
             _light_instance.config(cfg);
             _panel_instance.setLight(&_light_instance);
         }
+        {
+            // INTは触れている間Low。離している間はI2Cを読まない
+            auto cfg = _touch_instance.config();
+            cfg.x_min = 0;
+            cfg.x_max = 239;
+            cfg.y_min = 0;
+            cfg.y_max = 239;
+            cfg.pin_int = TOUCH_INT_PIN;
+            cfg.bus_shared = false;
+            cfg.offset_rotation = 0;
+            cfg.i2c_port = TOUCH_I2C_PORT;
+            cfg.i2c_addr = 0x38;
+            cfg.pin_sda = TOUCH_SDA_PIN;
+            cfg.pin_scl = TOUCH_SCL_PIN;
+            cfg.freq = 400000;
+            _touch_instance.config(cfg);
+            _panel_instance.setTouch(&_touch_instance);
+        }
         setPanel(&_panel_instance);
     }
 };
@@ -140,9 +183,25 @@ public:
 // グローバルインスタンス
 LGFX_M5Dial display;
 LGFX_Sprite canvas(&display);
+LGFX_Presenter presenter(&canvas);  // 転送中に次フレームを描画するダブルバッファ
+LGFX_Layer board_layer;  // 枠線と配置済みブロック (盤面が変わった時のみ描き直す)
+lgfx::GlyphCache glyph_cache;  // スコア等の文字を矩形として保持し、毎フレームのフォント展開を省略
+
+#if INPUT_LATENCY_TRACE
+static latency_hist_t display_latency;  // 入力から画面の転送完了まで
+static uint32_t frame_input_tag = 0;    // 次に転送するフレームに反映した最も古い入力
+
+// 転送タスクから呼ばれる
+static void on_frame_presented(uint32_t tag) {
+    if (tag) {
+        latency_record(&display_latency, latency_since(tag, esp_timer_get_time()));
+    }
+}
+#endif
 
 // ゲーム状態
 uint8_t board[BOARD_HEIGHT][BOARD_WIDTH] = {0};
+uint32_t board_revision = 0;  // 盤面を変更するたびに加算
 int current_piece = 0;
 int current_rotation = 0;
 int piece_x = 3;
@@ -154,16 +213,9 @@ uint32_t level = 1;
 bool game_over = false;
 bool game_paused = false;
 
-// エンコーダー状態
-volatile int32_t encoder_count = 0;
-volatile int32_t encoder_raw = 0;
-// ボタン状態はメインループでポーリング
-static bool last_button_state = false;
-static uint32_t button_press_time = 0;
-static bool button_was_long_press = false;
-static bool button_just_released_short = false;
+// 入力 (回転とボタンは入力イベントキューで受け取る)
 static const uint32_t LONG_PRESS_MS = 150;
-static int8_t last_state = 0;
+static const size_t INPUT_BATCH = 16;  // 1回に取り出す入力イベントの数
 
 // WiFi状態
 static EventGroupHandle_t wifi_event_group;
@@ -172,59 +224,7 @@ static char ip_address[16] = "";
 static bool ota_in_progress = false;
 static int ota_progress = 0;
 
-// 直交デコード用状態テーブル
-static const int8_t quad_table[4][4] = {
-    {  0, +1,  0, -1 },
-    { -1,  0, +1,  0 },
-    {  0, -1,  0, +1 },
-    { +1,  0, -1,  0 },
-};
-
-// エンコーダーISR
-static void IRAM_ATTR encoder_isr(void* arg) {
-    int a = gpio_get_level((gpio_num_t)ENCODER_A_PIN);
-    int b = gpio_get_level((gpio_num_t)ENCODER_B_PIN);
-    int8_t state = (a << 1) | (a ^ b);
-    int8_t dir = quad_table[last_state][state];
-    encoder_raw += dir;
-    last_state = state;
-    encoder_count = encoder_raw / 4;
-}
-
-
-// ブザー関数
-void buzzer_init() {
-    ledc_timer_config_t timer_conf = {
-        .speed_mode = LEDC_LOW_SPEED_MODE,
-        .duty_resolution = LEDC_TIMER_10_BIT,
-        .timer_num = LEDC_TIMER_0,
-        .freq_hz = 4000,
-        .clk_cfg = LEDC_AUTO_CLK
-    };
-    ledc_timer_config(&timer_conf);
-
-    ledc_channel_config_t channel_conf = {
-        .gpio_num = BUZZER_PIN,
-        .speed_mode = LEDC_LOW_SPEED_MODE,
-        .channel = LEDC_CHANNEL_0,
-        .intr_type = LEDC_INTR_DISABLE,
-        .timer_sel = LEDC_TIMER_0,
-        .duty = 0,
-        .hpoint = 0,
-        .flags = {0}
-    };
-    ledc_channel_config(&channel_conf);
-}
-
-void buzzer_beep(uint32_t freq, uint32_t duration_ms) {
-    ledc_set_freq(LEDC_LOW_SPEED_MODE, LEDC_TIMER_0, freq);
-    ledc_set_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0, 512);
-    ledc_update_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0);
-    vTaskDelay(pdMS_TO_TICKS(duration_ms));
-    ledc_set_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0, 0);
-    ledc_update_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0);
-}
-
+// 効果音 (再生はブザーのタイマーで行われ、呼び出し側は待たない)
 void play_move_sound() {
     buzzer_beep(800, 5);
 }
@@ -237,42 +237,24 @@ void play_drop_sound() {
     buzzer_beep(400, 30);
 }
 
+static const buzzer_tone_t line_clear_sound[] = {
+    {1000, 50, BUZZER_DUTY_HALF}, {0, 30, 0},
+    {1200, 50, BUZZER_DUTY_HALF}, {0, 30, 0},
+    {1500, 100, BUZZER_DUTY_HALF},
+};
+
+static const buzzer_tone_t game_over_sound[] = {
+    {300, 200, BUZZER_DUTY_HALF}, {0, 100, 0},
+    {300, 200, BUZZER_DUTY_HALF}, {0, 100, 0},
+    {300, 200, BUZZER_DUTY_HALF}, {0, 100, 0},
+};
+
 void play_line_clear_sound() {
-    buzzer_beep(1000, 50);
-    vTaskDelay(pdMS_TO_TICKS(30));
-    buzzer_beep(1200, 50);
-    vTaskDelay(pdMS_TO_TICKS(30));
-    buzzer_beep(1500, 100);
+    buzzer_play(line_clear_sound, sizeof(line_clear_sound) / sizeof(line_clear_sound[0]));
 }
 
 void play_game_over_sound() {
-    for (int i = 0; i < 3; i++) {
-        buzzer_beep(300, 200);
-        vTaskDelay(pdMS_TO_TICKS(100));
-    }
-}
-
-// エンコーダー初期化
-void encoder_init() {
-    gpio_config_t io_conf = {};
-    io_conf.intr_type = GPIO_INTR_ANYEDGE;
-    io_conf.mode = GPIO_MODE_INPUT;
-    io_conf.pin_bit_mask = (1ULL << ENCODER_A_PIN) | (1ULL << ENCODER_B_PIN);
-    io_conf.pull_up_en = GPIO_PULLUP_ENABLE;
-    gpio_config(&io_conf);
-
-    io_conf.intr_type = GPIO_INTR_NEGEDGE;
-    io_conf.pin_bit_mask = (1ULL << ENCODER_BTN_PIN);
-    gpio_config(&io_conf);
-
-    int a = gpio_get_level((gpio_num_t)ENCODER_A_PIN);
-    int b = gpio_get_level((gpio_num_t)ENCODER_B_PIN);
-    last_state = (a << 1) | (a ^ b);
-
-    gpio_install_isr_service(0);
-    gpio_isr_handler_add((gpio_num_t)ENCODER_A_PIN, encoder_isr, NULL);
-    gpio_isr_handler_add((gpio_num_t)ENCODER_B_PIN, encoder_isr, NULL);
-    // ボタンはISRではなくポーリング
+    buzzer_play(game_over_sound, sizeof(game_over_sound) / sizeof(game_over_sound[0]));
 }
 
 // ===== テトリスゲームロジック =====
@@ -313,6 +295,31 @@ void lock_piece() {
             }
         }
     }
+    board_revision++;
+}
+
+// 左右に1列動かす (当たる場合は動かさない)
+void move_piece(int dx) {
+    int new_x = piece_x + dx;
+    if (!check_collision(current_piece, current_rotation, new_x, piece_y)) {
+        piece_x = new_x;
+        play_move_sound();
+    }
+}
+
+void rotate_piece() {
+    int new_rotation = (current_rotation + 1) % 4;
+    if (!check_collision(current_piece, new_rotation, piece_x, piece_y)) {
+        current_rotation = new_rotation;
+        play_rotate_sound();
+    }
+}
+
+// 当たる直前まで落とす (固定は次の落下の処理で行う)
+void drop_piece() {
+    while (!check_collision(current_piece, current_rotation, piece_x, piece_y + 1)) {
+        piece_y++;
+    }
 }
 
 int clear_lines() {
@@ -338,6 +345,9 @@ int clear_lines() {
             y++;  // 同じ行を再チェック
         }
     }
+    if (cleared) {
+        board_revision++;
+    }
     return cleared;
 }
 
@@ -355,39 +365,40 @@ void spawn_piece() {
 
 void new_game() {
     memset(board, 0, sizeof(board));
+    board_revision++;
     score = 0;
     lines = 0;
     level = 1;
     game_over = false;
     next_piece = esp_random() % 7;
     spawn_piece();
-    encoder_count = 0;
-    encoder_raw = 0;
 }
 
 // ===== 描画関数 =====
 
-void draw_block(int x, int y, uint16_t color) {
+void draw_block(LovyanGFX& gfx, int x, int y, uint16_t color) {
     int px = BOARD_X + x * BLOCK_SIZE;
     int py = BOARD_Y + y * BLOCK_SIZE;
-    canvas.fillRect(px + 1, py + 1, BLOCK_SIZE - 2, BLOCK_SIZE - 2, color);
-    canvas.drawRect(px, py, BLOCK_SIZE, BLOCK_SIZE, 0x4208);
+    gfx.fillRect(px + 1, py + 1, BLOCK_SIZE - 2, BLOCK_SIZE - 2, color);
+    gfx.drawRect(px, py, BLOCK_SIZE, BLOCK_SIZE, 0x4208);
 }
 
 void draw_board() {
-    // 枠線を描画
-    canvas.drawRect(BOARD_X - 1, BOARD_Y - 1,
-                    BOARD_WIDTH * BLOCK_SIZE + 2,
-                    BOARD_HEIGHT * BLOCK_SIZE + 2, TFT_WHITE);
+    // 枠線と配置済みブロックは盤面が変わった時のみレイヤーに描き直す
+    if (board_layer.isChanged(board_revision)) {
+        board_layer.drawRect(BOARD_X - 1, BOARD_Y - 1,
+                             BOARD_WIDTH * BLOCK_SIZE + 2,
+                             BOARD_HEIGHT * BLOCK_SIZE + 2, TFT_WHITE);
 
-    // 配置済みブロックを描画
-    for (int y = 0; y < BOARD_HEIGHT; y++) {
-        for (int x = 0; x < BOARD_WIDTH; x++) {
-            if (board[y][x] != 0) {
-                draw_block(x, y, TETRO_COLORS[board[y][x] - 1]);
+        for (int y = 0; y < BOARD_HEIGHT; y++) {
+            for (int x = 0; x < BOARD_WIDTH; x++) {
+                if (board[y][x] != 0) {
+                    draw_block(board_layer, x, y, TETRO_COLORS[board[y][x] - 1]);
+                }
             }
         }
     }
+    board_layer.pushLayer(&canvas);
 
     // 現在のピースを描画
     for (int y = 0; y < 4; y++) {
@@ -396,7 +407,7 @@ void draw_board() {
                 int bx = piece_x + x;
                 int by = piece_y + y;
                 if (by >= 0) {
-                    draw_block(bx, by, TETRO_COLORS[current_piece]);
+                    draw_block(canvas, bx, by, TETRO_COLORS[current_piece]);
                 }
             }
         }
@@ -494,7 +505,13 @@ void update_display() {
         draw_score();
     }
 
-    canvas.pushSprite(0, 0);
+    // 変化した領域を裏で転送し、すぐ次の描画へ戻る
+#if INPUT_LATENCY_TRACE
+    presenter.present(0, 0, frame_input_tag);
+    frame_input_tag = 0;
+#else
+    presenter.present(0, 0);
+#endif
 }
 
 // ===== WiFiとOTA関数 =====
@@ -608,6 +625,20 @@ static esp_err_t ota_post_handler(httpd_req_t *req) {
     return ESP_OK;
 }
 
+#if INPUT_LATENCY_TRACE
+static esp_err_t latency_get_handler(httpd_req_t *req) {
+    char line[128];
+    latency_format(&display_latency, "display", line, sizeof(line));
+    char query[16];
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK && strcmp(query, "reset") == 0) {
+        latency_reset(&display_latency);
+    }
+    httpd_resp_set_type(req, "text/plain; charset=utf-8");
+    httpd_resp_sendstr(req, line);
+    return ESP_OK;
+}
+#endif
+
 static esp_err_t root_get_handler(httpd_req_t *req) {
     const char *html = "<html><body><h1>M5Dial Tetris OTA</h1>"
         "<form method='POST' action='/update' enctype='multipart/form-data'>"
@@ -616,38 +647,6 @@ static esp_err_t root_get_handler(httpd_req_t *req) {
     return ESP_OK;
 }
 
-// ===== ボタン処理 =====
-
-void update_button_state() {
-    uint32_t now = xTaskGetTickCount() * portTICK_PERIOD_MS;
-    bool current_button = (gpio_get_level((gpio_num_t)ENCODER_BTN_PIN) == 0);
-    button_just_released_short = false;
-
-    if (current_button && !last_button_state) {
-        // ボタンが押された瞬間
-        button_press_time = now;
-        button_was_long_press = false;
-    } else if (current_button && last_button_state) {
-        // ボタンが押され続けている
-        if (!button_was_long_press && (now - button_press_time) >= LONG_PRESS_MS) {
-            button_was_long_press = true;
-        }
-    } else if (!current_button && last_button_state) {
-        // ボタンが離された瞬間
-        if (!button_was_long_press) {
-            button_just_released_short = true;
-        }
-    }
-    last_button_state = current_button;
-}
-
-bool is_button_held() {
-    return last_button_state && button_was_long_press;
-}
-
-bool was_short_press() {
-    return button_just_released_short;
-}
 void start_ota_server() {
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
     httpd_handle_t server = NULL;
@@ -658,9 +657,25 @@ void start_ota_server() {
 
         httpd_uri_t ota_uri = {.uri = "/update", .method = HTTP_POST, .handler = ota_post_handler};
         httpd_register_uri_handler(server, &ota_uri);
+
+#if INPUT_LATENCY_TRACE
+        httpd_uri_t latency_uri = {.uri = "/latency", .method = HTTP_GET, .handler = latency_get_handler};
+        httpd_register_uri_handler(server, &latency_uri);
+#endif
     }
 }
 
+// タッチパネルの位置を読む (入力イベントキューから、触れている間だけ呼ばれる)
+static bool read_touch(int16_t* x, int16_t* y, void*) {
+    lgfx::touch_point_t tp;
+    if (display.getTouch(&tp, 1) == 0) {
+        return false;
+    }
+    *x = tp.x;
+    *y = tp.y;
+    return true;
+}
+
 // ===== メイン =====
 
 extern "C" void app_main(void) {
@@ -679,10 +694,27 @@ extern "C" void app_main(void) {
     display.setBrightness(128);
     display.setRotation(0);
     canvas.createSprite(240, 240);
+    canvas.setDirtyTracking(true);
+    canvas.setGlyphCache(&glyph_cache);
+    board_layer.setColorDepth(canvas.getColorDepth());
+    board_layer.createLayer(240, 240);
+    {
+        auto cfg = presenter.config();
+        cfg.task_pinned_core = APP_CPU_NUM;  // 描画(app_main)とは別コアで転送
+#if INPUT_LATENCY_TRACE
+        cfg.on_presented = on_frame_presented;
+#endif
+        presenter.config(cfg);
+    }
+    if (!presenter.begin()) {
+        ESP_LOGW(TAG, "ダブルバッファ確保失敗、同期転送で動作");
+    }
 
     // 周辺機器初期化
-    buzzer_init();
-    encoder_init();
+    buzzer_init(BUZZER_PIN);
+    encoder_init(ENCODER_A_PIN, ENCODER_B_PIN);
+    input_init(ENCODER_BTN_PIN, LONG_PRESS_MS);
+    input_touch_init(TOUCH_INT_PIN, read_touch, nullptr, GESTURE_CONFIG_M5DIAL);
 
     // WiFiとOTA初期化
     wifi_init();
@@ -694,58 +726,78 @@ extern "C" void app_main(void) {
     new_game();
     buzzer_beep(1000, 100);
 
-    int32_t last_encoder = 0;
     uint32_t last_drop = 0;
     uint32_t drop_interval = 1000;
+    TickType_t last_frame = xTaskGetTickCount();
+    uint32_t wait_ms = 0;
+#if INPUT_LATENCY_TRACE
+    int64_t last_latency_log = esp_timer_get_time();
+#endif
 
     // メインループ
+    // 次のフレームの時刻まで入力を待ち、入力が届けばすぐに処理して描画する
     while (1) {
-        update_button_state();
+        input_event_t events[INPUT_BATCH];
+        size_t n = input_read(events, INPUT_BATCH, wait_ms);
+#if INPUT_LATENCY_TRACE
+        if (n > 0 && frame_input_tag == 0) {
+            frame_input_tag = latency_tag(events[0].time_us);
+        }
+        if (esp_timer_get_time() - last_latency_log >= 10 * 1000000) {
+            last_latency_log = esp_timer_get_time();
+            if (display_latency.count.load(std::memory_order_relaxed)) {
+                char line[128];
+                latency_format(&display_latency, "display", line, sizeof(line));
+                ESP_LOGI(TAG, "入力の遅延 %s", line);
+            }
+        }
+#endif
         if (ota_in_progress) {
             update_display();
             vTaskDelay(pdMS_TO_TICKS(100));
+            wait_ms = 0;
             continue;
         }
 
         if (game_over) {
-            if (was_short_press()) {
-                new_game();
-                buzzer_beep(1000, 100);
+            for (size_t i = 0; i < n; i++) {
+                if ((events[i].type == INPUT_RELEASE && events[i].value) || events[i].type == INPUT_TAP) {
+                    new_game();
+                    buzzer_beep(1000, 100);
+                    break;
+                }
             }
             update_display();
-            vTaskDelay(pdMS_TO_TICKS(50));
+            wait_ms = 50;
             continue;
         }
 
-        // 回転処理 (ボタン押下)
-        if (was_short_press()) {
-            int new_rotation = (current_rotation + 1) % 4;
-            if (!check_collision(current_piece, new_rotation, piece_x, piece_y)) {
-                current_rotation = new_rotation;
-                play_rotate_sound();
-            }
-        }
-
-        // 左右移動処理 (エンコーダー)
-        int32_t current_encoder = encoder_count;
-        if (current_encoder != last_encoder) {
-            int diff = current_encoder - last_encoder;
-            int new_x = piece_x + diff;
-            if (!check_collision(current_piece, current_rotation, new_x, piece_y)) {
-                piece_x = new_x;
-                play_move_sound();
+        bool dropped = false;
+        for (size_t i = 0; i < n; i++) {
+            const input_event_t& ev = events[i];
+            if (ev.type == INPUT_DETENT || ev.type == INPUT_RING) {
+                // 左右移動 (1デテントずつ当たり判定)
+                move_piece(ev.value);
+            } else if ((ev.type == INPUT_RELEASE && ev.value) || ev.type == INPUT_TAP) {
+                // 回転 (短押し)
+                rotate_piece();
+            } else if (ev.type == INPUT_SWIPE) {
+                if (ev.value == INPUT_SWIPE_LEFT || ev.value == INPUT_SWIPE_RIGHT) {
+                    move_piece(ev.value == INPUT_SWIPE_LEFT ? -1 : 1);
+                } else if (ev.value == INPUT_SWIPE_UP) {
+                    rotate_piece();
+                } else {
+                    drop_piece();
+                    dropped = true;
+                }
             }
-            last_encoder = current_encoder;
         }
 
-        // 高速落下処理 (ボタン長押し)
-        // ボタン状態はループ開始時に更新済み
-
-        // 自動落下
+        // 自動落下 (ボタン長押しの間は高速落下、下スワイプの後はすぐに固定)
         uint32_t now = xTaskGetTickCount() * portTICK_PERIOD_MS;
-        uint32_t interval = is_button_held() ? 50 : drop_interval;
+        uint32_t interval = input_button_held() ? 50 : drop_interval;
 
-        if (now - last_drop > interval) {
+        if (dropped || now - last_drop > interval) {
             last_drop = now;
 
             if (!check_collision(current_piece, current_rotation, piece_x, piece_y + 1)) {
@@ -772,6 +824,12 @@ extern "C" void app_main(void) {
         }
 
         update_display();
-        vTaskDelay(pdMS_TO_TICKS(16));  // ~60 FPS
+        // 転送は裏で進むので、描画時間を含めた一定周期で回す
+        TickType_t elapsed = xTaskGetTickCount() - last_frame;
+        if (elapsed >= pdMS_TO_TICKS(FRAME_INTERVAL_MS)) {
+            last_frame += elapsed;
+            elapsed = 0;
+        }
+        wait_ms = pdTICKS_TO_MS(pdMS_TO_TICKS(FRAME_INTERVAL_MS) - elapsed);
     }
 }
@@ -0,0 +1,286 @@
+// 円弧の塗りつぶし (LGFXBase::fill_arc_helper) のベンチマーク (Linux上で実行)
+// 以前の1画素ずつ浮動小数点で判定する実装をこのファイルに残し、LovyanGFXの現在の実装と並べて
+// m5dial-led の画面 (カラーホイール・値の円弧・外周リング) の1フレーム分の円弧を描く時間を比べます
+// あわせて様々な半径と角度で両方の描画結果を画素ごとに比べ、違いの数を表示します
+//
+// 使い方:
+//   S=m5dial-hello/components/LovyanGFX/src
+//   gcc -O2 -c -I$S $S/lgfx/utility/*.c
+//   g++ -std=gnu++17 -O2 -DLGFX_USE_V1 -I$S -ffunction-sections -fdata-sections -Wl,--gc-sections -o arc_bench tools/arc_bench.cpp $S/lgfx/v1/*.cpp $S/lgfx/v1/misc/*.cpp $S/lgfx/v1/panel/*.cpp lgfx_*.o miniz.o
+//   ./arc_bench
+
+#include <LovyanGFX.hpp>
+#include <math.h>
+#include <stdio.h>
+#include <time.h>
+#include <random>
+
+// ホストではGPIOと待ち時間は何もしない
+namespace lgfx {
+inline namespace v1 {
+void delay(unsigned long) {}
+void delayMicroseconds(unsigned int) {}
+void gpio_hi(uint32_t) {}
+void gpio_lo(uint32_t) {}
+void pinMode(int_fast16_t, pin_mode_t) {}
+}  // namespace v1
+}  // namespace lgfx
+
+static constexpr int SIZE = 240;
+static constexpr float deg_to_rad = 0.017453292519943295769236907684886f;
+
+// 以前の fill_arc_helper (描画先のクリップ範囲と水平線の描画だけをスプライトの公開関数に置き換えた)
+static void old_fill_arc_helper(LGFX_Sprite& gfx, int32_t cx, int32_t cy, int32_t oradius_x, int32_t iradius_x,
+                                int32_t oradius_y, int32_t iradius_y, float start, float end) {
+    int32_t clip_x, clip_y, clip_w, clip_h;
+    gfx.getClipRect(&clip_x, &clip_y, &clip_w, &clip_h);
+    int32_t _clip_l = clip_x, _clip_t = clip_y;
+    int32_t _clip_r = clip_x + clip_w - 1, _clip_b = clip_y + clip_h - 1;
+
+    float s_cos = (cosf(start * deg_to_rad));
+    float e_cos = (cosf(end * deg_to_rad));
+    float sslope = s_cos / (sinf(start * deg_to_rad));
+    float eslope = -1000000;
+    if (end != 360.0f) eslope = e_cos / (sinf(end * deg_to_rad));
+    float swidth = 0.5f / s_cos;
+    float ewidth = -0.5f / e_cos;
+
+    bool start180 = !(start < 180);
+    bool end180 = end < 180;
+    bool reversed = start + 180 < end || (end < start && start < end + 180);
+
+    int32_t xleft = -oradius_x;
+    int32_t xright = oradius_x + 1;
+    int32_t y = -oradius_y;
+    int32_t ye = oradius_y;
+    if (!reversed) {
+        if ((end >= 270 || end < 90) && (start >= 270 || start < 90)) xleft = 0;
+        else if (end < 270 && end >= 90 && start < 270 && start >= 90) xright = 1;
+        if (end >= 180 && start >= 180) ye = 0;
+        else if (end < 180 && start < 180) y = 0;
+    }
+    if (y < _clip_t - cy) y = _clip_t - cy;
+    if (ye > _clip_b - cy + 1) ye = _clip_b - cy + 1;
+
+    if (xleft < _clip_l - cx) xleft = _clip_l - cx;
+    if (xright > _clip_r - cx + 1) xright = _clip_r - cx + 1;
+
+    bool trueCircle = (oradius_x == oradius_y) && (iradius_x == iradius_y);
+
+    int32_t iradius_y2 = iradius_y * (iradius_y - 1);
+    int32_t iradius_x2 = iradius_x * (iradius_x - 1);
+    float irad_rate = iradius_x2 && iradius_y2 ? (float)iradius_x2 / (float)iradius_y2 : 0;
+
+    int32_t oradius_y2 = oradius_y * (oradius_y + 1);
+    int32_t oradius_x2 = oradius_x * (oradius_x + 1);
+    float orad_rate = oradius_x2 && oradius_y2 ? (float)oradius_x2 / (float)oradius_y2 : 0;
+
+    do {
+        int32_t y2 = y * y;
+        int32_t compare_o = oradius_y2 - y2;
+        int32_t compare_i = iradius_y2 - y2;
+        if (!trueCircle) {
+            compare_i = floorf(compare_i * irad_rate);
+            compare_o = ceilf(compare_o * orad_rate);
+        }
+        int32_t xe = ceilf(sqrtf(compare_o));
+        int32_t x = 1 - xe;
+
+        if (x < xleft) x = xleft;
+        if (xe > xright) xe = xright;
+        float ysslope = (y + swidth) * sslope;
+        float yeslope = (y + ewidth) * eslope;
+        int len = 0;
+        do {
+            bool flg1 = start180 != (x <= ysslope);
+            bool flg2 = end180 != (x <= yeslope);
+            int32_t x2 = x * x;
+            if (x2 >= compare_i && ((flg1 && flg2) || (reversed && (flg1 || flg2))) && x != xe && x2 < compare_o) {
+                ++len;
+            } else {
+                if (len) {
+                    gfx.writeFastHLine(cx + x - len, cy + y, len);
+                    len = 0;
+                }
+                if (x2 >= compare_o) break;
+                if (x < 0 && x2 < compare_i) {
+                    x = -x;
+                }
+            }
+        } while (++x <= xe);
+    } while (++y <= ye);
+}
+
+// 角度を 0〜360 に揃える (LGFXBase::fillEllipseArc / drawEllipseArc と同じ)
+static bool normalize_angles(float* start, float* end) {
+    bool ring = fabsf(*start - *end) >= 360;
+    *start = fmodf(*start, 360);
+    *end = fmodf(*end, 360);
+    if (*start < 0.0f) *start = fmodf(*start + 360.0f, 360);
+    if (*end < 0.0f) *end = fmodf(*end + 360.0f, 360);
+    return ring;
+}
+
+static void old_fill_arc(LGFX_Sprite& gfx, int32_t x, int32_t y, int32_t r0, int32_t r1, float start, float end, uint32_t color) {
+    if (r0 < r1) std::swap(r0, r1);
+    if (r1 < 0) return;
+    bool ring = normalize_angles(&start, &end);
+    if (ring && (fabsf(start - end) <= 0.0001f)) { start = .0f; end = 360.0f; }
+    gfx.setColor(color);
+    old_fill_arc_helper(gfx, x, y, r0, r1, r0, r1, start, end);
+}
+
+static void old_draw_arc(LGFX_Sprite& gfx, int32_t x, int32_t y, int32_t r0, int32_t r1, float start, float end, uint32_t color) {
+    if (r0 < r1) std::swap(r0, r1);
+    if (r1 < 0) return;
+    bool ring = normalize_angles(&start, &end);
+    gfx.setColor(color);
+    old_fill_arc_helper(gfx, x, y, r0, r1, r0, r1, start, start);
+    old_fill_arc_helper(gfx, x, y, r0, r1, r0, r1, end, end);
+    if (ring && (fabsf(start - end) <= 0.0001f)) { start = .0f; end = 360.0f; }
+    old_fill_arc_helper(gfx, x, y, r0, r0, r0, r0, start, end);
+    old_fill_arc_helper(gfx, x, y, r1, r1, r1, r1, start, end);
+}
+
+// m5dial-led と同じ大きさの円弧 (main.cpp の CIRCLE_* / COLOR_WHEEL_* / ARC_*_ANGLE)
+static constexpr int CENTER = 120;
+static constexpr int RADIUS = 90;
+static constexpr int WHEEL_INNER_R = 70;
+static constexpr int WHEEL_OUTER_R = 120;
+static constexpr int WHEEL_SEGMENTS = 12;
+
+// render_hue_wheel() の円弧 (12区間の塗りつぶしと、選んだ区間の白枠)
+template <typename Fill, typename Draw>
+static void hue_wheel(Fill fill, Draw draw, int selected) {
+    const float gap_angle = 6.0f;
+    const float segment_angle = 360.0f / WHEEL_SEGMENTS;
+    for (int i = 0; i < WHEEL_SEGMENTS; i++) {
+        float base_angle = (float)i * segment_angle - 90;
+        float start_angle = base_angle + gap_angle / 2.0f;
+        float end_angle = base_angle + segment_angle - gap_angle / 2.0f;
+        fill(WHEEL_INNER_R, WHEEL_OUTER_R, start_angle, end_angle, 1 + i);
+        if (i == selected) {
+            for (int t = -1; t <= 1; t++) {
+                draw(WHEEL_INNER_R + t, WHEEL_INNER_R + t + 1, start_angle, end_angle, 15);
+                draw(WHEEL_OUTER_R + t - 1, WHEEL_OUTER_R + t, start_angle, end_angle, 15);
+            }
+        }
+    }
+}
+
+// draw_value_adjust() の円弧 (下が開いた 135°→45°) と draw_ring() の外周リング
+template <typename Fill, typename Draw>
+static void value_arc(Fill fill, Draw draw) {
+    draw(RADIUS - 1, RADIUS + 1, 135, 360, 15);
+    draw(RADIUS - 1, RADIUS + 1, 0, 45, 15);
+    fill(RADIUS - 1, RADIUS + 1, 0, 360, 14);
+}
+
+static double now_us() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+// 1フレーム分の描画を繰り返し、1回あたりの時間 (us) を返す
+template <typename Frame>
+static double time_frame(Frame frame) {
+    const int rounds = 2000;
+    double best = 1e30;
+    for (int k = 0; k < 5; k++) {
+        double t0 = now_us();
+        for (int i = 0; i < rounds; i++) {
+            frame(i);
+        }
+        best = std::min(best, (now_us() - t0) / rounds);
+    }
+    return best;
+}
+
+int main() {
+    LGFX_Sprite old_sprite;
+    LGFX_Sprite new_sprite;
+    for (auto* s : { &old_sprite, &new_sprite }) {
+        s->setColorDepth(8);
+        s->createSprite(SIZE, SIZE);
+    }
+
+    auto old_fill = [&](int r0, int r1, float s, float e, uint32_t c) { old_fill_arc(old_sprite, CENTER, CENTER, r0, r1, s, e, c); };
+    auto old_draw = [&](int r0, int r1, float s, float e, uint32_t c) { old_draw_arc(old_sprite, CENTER, CENTER, r0, r1, s, e, c); };
+    auto new_fill = [&](int r0, int r1, float s, float e, uint32_t c) { new_sprite.fillArc(CENTER, CENTER, r0, r1, s, e, c); };
+    auto new_draw = [&](int r0, int r1, float s, float e, uint32_t c) { new_sprite.drawArc(CENTER, CENTER, r0, r1, s, e, c); };
+
+    printf("== 1フレームあたりの時間 (us)\n");
+    printf("%-24s %10s %10s %8s\n", "", "以前", "現在", "比");
+    double t_old = time_frame([&](int i) { hue_wheel(old_fill, old_draw, i % WHEEL_SEGMENTS); });
+    double t_new = time_frame([&](int i) { hue_wheel(new_fill, new_draw, i % WHEEL_SEGMENTS); });
+    printf("%-24s %10.1f %10.1f %7.2fx\n", "カラーホイール", t_old, t_new, t_old / t_new);
+    t_old = time_frame([&](int) { value_arc(old_fill, old_draw); });
+    t_new = time_frame([&](int) { value_arc(new_fill, new_draw); });
+    printf("%-24s %10.1f %10.1f %7.2fx\n", "値の円弧と外周リング", t_old, t_new, t_old / t_new);
+
+    // 画素の比較: 半径と角度の組み合わせ、および乱数で選んだ楕円の円弧
+    int cases = 0;
+    int differing = 0;
+    int max_pixels = 0;
+    int max_row_pixels = 0;
+    char worst[128] = "";
+    auto compare = [&](int ro, int ri, int roy, int riy, float s, float e) {
+        old_sprite.clear();
+        new_sprite.clear();
+        old_sprite.setColor(TFT_WHITE);
+        old_fill_arc_helper(old_sprite, CENTER, CENTER, ro, ri, roy, riy, s, e);
+        new_sprite.fillEllipseArc(CENTER, CENTER, ro, ri, roy, riy, s, e, TFT_WHITE);
+        auto* a = (const uint8_t*)old_sprite.getBuffer();
+        auto* b = (const uint8_t*)new_sprite.getBuffer();
+        int pixels = 0;
+        for (int y = 0; y < SIZE; y++) {
+            int row = 0;
+            for (int x = 0; x < SIZE; x++) {
+                row += (a[y * SIZE + x] != 0) != (b[y * SIZE + x] != 0);
+            }
+            pixels += row;
+            max_row_pixels = std::max(max_row_pixels, row);
+        }
+        cases++;
+        if (pixels) {
+            differing++;
+            if (pixels > max_pixels) {
+                max_pixels = pixels;
+                snprintf(worst, sizeof(worst), "ro=%d ri=%d roy=%d riy=%d %.2f°→%.2f°", ro, ri, roy, riy, s, e);
+            }
+        }
+    };
+    static const float angles[] = { 0, 45, 90, 135, 180, 225, 270, 315, 359.9f, 0.1f };
+    for (int ro : { 5, 20, 60, 90, 106, 119 }) {
+        for (int ri : { 0, 3, 50, 80, 100 }) {
+            if (ri > ro) continue;
+            for (float s : angles) {
+                for (float e : angles) {
+                    compare(ro, ri, ro, ri, s, e);
+                }
+            }
+        }
+    }
+    std::mt19937 rng(1);
+    for (int k = 0; k < 20000; k++) {
+        int ro = rng() % 118 + 1;
+        int ri = rng() % (ro + 1);
+        int roy = ro;
+        int riy = ri;
+        if (k & 1) {
+            roy = rng() % 118 + 1;
+            riy = rng() % (roy + 1);
+        }
+        float s = (rng() % 36000) / 100.f;
+        float e = (rng() % 36000) / 100.f;
+        compare(ro, ri, roy, riy, s, e);
+    }
+
+    printf("== 描画結果の比較\n");
+    printf("%d通り中 %d通りで違いあり\n", cases, differing);
+    if (differing) {
+        printf("最大 %d画素 (%s)、1行あたり最大 %d画素\n", max_pixels, worst, max_row_pixels);
+    }
+    return 0;
+}
@@ -0,0 +1,106 @@
+// ブザーの再生キューの確認 (Linux上で実行)
+// m5dial_buzzer をモック (LEDCとesp_timerの代わりに時刻を進める) でビルドし、音の順序と
+// buzzer_stop() の直後に積んだ音が捨てられないことを確かめます。1つでも違えば終了コード1を返します
+//
+// 使い方:
+//   g++ -std=gnu++17 -O2 -I m5dial-hello/components/m5dial/include -o buzzer_queue_check tools/buzzer_queue_check.cpp m5dial-hello/components/m5dial/m5dial_buzzer.cpp
+//   ./buzzer_queue_check
+
+#include <stdio.h>
+#include "m5dial_buzzer.h"
+
+static int failures = 0;
+
+static void expect_freq(const char* what, uint32_t expected) {
+    uint32_t freq = buzzer_mock_freq();
+    if (freq != expected) {
+        printf("  NG %s: %luHz (期待 %luHz)\n", what, (unsigned long)freq, (unsigned long)expected);
+        failures++;
+    }
+}
+
+// キューが空になるまで進める
+static void drain() {
+    for (int i = 0; i < 100000 && buzzer_is_busy(); i++) {
+        buzzer_mock_advance(1000);
+    }
+}
+
+static void check_order() {
+    printf("== 順に鳴る\n");
+    buzzer_tone(1000, 100);
+    buzzer_tone(1100, 50);
+    buzzer_mock_advance(10);
+    expect_freq("1音目", 1000);
+    buzzer_mock_advance(100000);
+    expect_freq("2音目", 1100);
+    buzzer_mock_advance(50000);
+    expect_freq("終了後", 0);
+    drain();
+}
+
+static void check_stop_then_tone() {
+    printf("== 再生中に停止してすぐ次の音\n");
+    buzzer_tone(1000, 100);
+    buzzer_tone(1100, 100);
+    buzzer_mock_advance(10000);
+    buzzer_stop();
+    buzzer_tone(1500, 50);  // 停止の処理 (タイマーのコールバック) より先に積む
+    buzzer_mock_advance(10);
+    expect_freq("停止後の音", 1500);
+    buzzer_mock_advance(50000);
+    expect_freq("停止前に積んだ音は鳴らない", 0);
+    drain();
+}
+
+static void check_stop_idle() {
+    printf("== 止まっている時に停止してすぐ次の音\n");
+    buzzer_stop();
+    buzzer_tone(800, 20);
+    buzzer_mock_advance(10);
+    expect_freq("停止後の音", 800);
+    drain();
+}
+
+static void check_note_sequence() {
+    printf("== 1音ごとに停止してから鳴らす (XmasSongEffect と同じ呼び方)\n");
+    static const uint32_t notes[] = { 659, 659, 659, 523, 784, 392, 523, 392, 330, 440 };
+    for (uint32_t f : notes) {
+        buzzer_stop();
+        buzzer_tone(f, 120);
+        buzzer_mock_advance(100);
+        expect_freq("音符", f);
+        buzzer_mock_advance(80000);  // 音の途中で次の音符に切り替える
+    }
+    drain();
+}
+
+static void check_stop_sequence() {
+    printf("== 音の列を停止し、後に積んだ2音は順に鳴る\n");
+    static const buzzer_tone_t melody[] = { { 400, 100, BUZZER_DUTY_HALF }, { 500, 100, BUZZER_DUTY_HALF } };
+    buzzer_play(melody, 2);
+    buzzer_tone(600, 100);
+    buzzer_mock_advance(10000);
+    expect_freq("列の1音目", 400);
+    buzzer_stop();
+    buzzer_tone(700, 30);
+    buzzer_tone(900, 30);
+    buzzer_mock_advance(10);
+    expect_freq("停止後の1音目", 700);
+    buzzer_mock_advance(30000);
+    expect_freq("停止後の2音目", 900);
+    buzzer_mock_advance(30000);
+    expect_freq("終了後", 0);
+    drain();
+}
+
+int main() {
+    buzzer_init(0);
+    check_order();
+    check_stop_then_tone();
+    check_stop_idle();
+    check_note_sequence();
+    check_stop_sequence();
+    printf(failures ? "%d件の不一致\n" : "すべて一致\n", failures);
+    return failures ? 1 : 0;
+}
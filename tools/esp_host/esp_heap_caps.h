@@ -0,0 +1,10 @@
+// ホストでのビルド用: 普通のcallocで確保する
+#pragma once
+#include <stdlib.h>
+
+#define MALLOC_CAP_8BIT     (1 << 2)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+
+static inline void* heap_caps_calloc(size_t n, size_t size, unsigned caps) {
+    return calloc(n, size);
+}
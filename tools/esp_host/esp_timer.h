@@ -0,0 +1,5 @@
+// ホストでのビルド用: 時刻はツールが与える (esp_timer_get_time() はツール側で定義)
+#pragma once
+#include <stdint.h>
+
+int64_t esp_timer_get_time();
@@ -0,0 +1,7 @@
+// ホストでのビルド用: 確認は1スレッドで動くため排他は何もしない
+#pragma once
+
+typedef int portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED 0
+#define portENTER_CRITICAL(mux) ((void)(mux))
+#define portEXIT_CRITICAL(mux) ((void)(mux))
@@ -0,0 +1,6 @@
+// ホストでのビルド用: 参加したグループはツールが記録する
+#pragma once
+#include "lwip/udp.h"
+
+err_t igmp_joingroup(const ip4_addr_t* ifaddr, const ip4_addr_t* groupaddr);
+err_t igmp_leavegroup(const ip4_addr_t* ifaddr, const ip4_addr_t* groupaddr);
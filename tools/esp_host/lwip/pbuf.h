@@ -0,0 +1,22 @@
+// ホストでのビルド用: lwIPのpbufのうち led_net.cpp が使う部分
+#pragma once
+#include <stdint.h>
+
+typedef uint8_t u8_t;
+typedef uint16_t u16_t;
+typedef int8_t err_t;
+
+#define ERR_OK   0
+#define ERR_MEM  -1
+#define ERR_VAL  -6
+#define ERR_USE  -8
+
+struct pbuf {
+    pbuf* next;
+    void* payload;
+    u16_t tot_len;  // このpbuf以降の合計
+    u16_t len;      // このpbufの長さ
+};
+
+u16_t pbuf_copy_partial(const pbuf* p, void* dataptr, u16_t len, u16_t offset);
+u8_t pbuf_free(pbuf* p);
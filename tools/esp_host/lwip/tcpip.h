@@ -0,0 +1,7 @@
+// ホストでのビルド用: TCP/IPタスクの代わりに、受信と同じスレッドですぐに呼ぶ
+#pragma once
+#include "lwip/pbuf.h"
+
+typedef void (*tcpip_callback_fn)(void* ctx);
+
+err_t tcpip_callback(tcpip_callback_fn function, void* ctx);
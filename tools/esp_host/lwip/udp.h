@@ -0,0 +1,21 @@
+// ホストでのビルド用: UDPの受信口はツールがループバックのソケットで用意する
+#pragma once
+#include "lwip/pbuf.h"
+
+struct ip_addr_t {
+    uint32_t addr;
+};
+typedef ip_addr_t ip4_addr_t;
+
+struct udp_pcb;
+typedef void (*udp_recv_fn)(void* arg, udp_pcb* pcb, pbuf* p, const ip_addr_t* addr, u16_t port);
+
+extern const ip_addr_t ip_addr_any;
+#define IP_ANY_TYPE (&ip_addr_any)
+#define IP4_ADDR_ANY4 (&ip_addr_any)
+#define IP4_ADDR(ipaddr, a, b, c, d) \
+    ((ipaddr)->addr = ((uint32_t)(a) << 24) | ((uint32_t)(b) << 16) | ((uint32_t)(c) << 8) | (uint32_t)(d))
+
+udp_pcb* udp_new();
+err_t udp_bind(udp_pcb* pcb, const ip_addr_t* ipaddr, u16_t port);
+void udp_recv(udp_pcb* pcb, udp_recv_fn recv, void* recv_arg);
@@ -0,0 +1,429 @@
+// 文字のキャッシュ (lgfx::GlyphCache) の確認とベンチマーク (Linux上で実行)
+// LovyanGFXをホスト向けにビルドし、キャッシュを付けたスプライトと付けないスプライトに同じ文字列を描いて
+// 画素を比べます。フォントはGLCD・BMP・RLE・GFX・U8g2 (日本語を含む) で、位置 (画面外へのはみ出しを含む)・
+// 色・基準位置・背景色あり・拡大といったキャッシュの対象外の描画、16/8ビットのスプライトでの共有、
+// 容量を小さくして破棄と詰め直しが起きる場合を試します。あわせてフォントごとに文字列の描画時間を比べます
+// 画素に違いがあれば終了コード1を返します
+//
+// 使い方:
+//   S=m5dial-hello/components/LovyanGFX/src
+//   gcc -O2 -c -I$S $S/lgfx/utility/*.c
+//   g++ -std=gnu++17 -O2 -DLGFX_USE_V1 -I$S -ffunction-sections -fdata-sections -Wl,--gc-sections -o glyph_cache_check tools/glyph_cache_check.cpp $S/lgfx/v1/*.cpp $S/lgfx/v1/misc/*.cpp $S/lgfx/v1/panel/*.cpp lgfx_*.o miniz.o
+//   ./glyph_cache_check
+
+#include <LovyanGFX.hpp>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <random>
+#include <vector>
+
+// ホストではGPIOと待ち時間は何もしない
+namespace lgfx {
+inline namespace v1 {
+void delay(unsigned long) {}
+void delayMicroseconds(unsigned int) {}
+void gpio_hi(uint32_t) {}
+void gpio_lo(uint32_t) {}
+void pinMode(int_fast16_t, pin_mode_t) {}
+}  // namespace v1
+}  // namespace lgfx
+
+static constexpr int SIZE = 240;
+
+// ===== U8g2形式のフォント =====
+// アプリの日本語フォント (IPAフォントのU8g2形式) はリポジトリに含まれないため、同じ形式のフォントをここで作る
+// ASCIIは FreeSans9pt7b の字形をそのまま移し、0x100以上は文字コードから作る16x16の模様とする
+// (漢字と同じく1文字あたりの矩形が多い)
+
+static constexpr int U8G2_BITS_0 = 4;     // 0の連続数のビット数
+static constexpr int U8G2_BITS_1 = 4;     // 1の連続数のビット数
+static constexpr int U8G2_BITS_SIZE = 6;  // 幅・高さ・位置・送り幅のビット数
+static const char* const U8G2_TEXT[] = { "明るさ 速度 色相 12345", "エフェクト 更新中..." };
+
+struct Glyph {
+    uint16_t code;
+    int w, h, x, y, dx;  // y はベースラインから字形の下端まで (上が正)
+    std::vector<uint8_t> pixels;
+};
+
+// U8g2の符号は下位ビットから詰める
+class BitWriter {
+public:
+    explicit BitWriter(std::vector<uint8_t>& out) : out(out) {}
+
+    void put(uint32_t value, int bits) {
+        for (int i = 0; i < bits; i++) {
+            if (pos == 0) {
+                out.push_back(0);
+            }
+            out.back() |= ((value >> i) & 1) << pos;
+            pos = (pos + 1) & 7;
+        }
+    }
+    void put_signed(int value, int bits) { put((uint32_t)(value + (1 << (bits - 1))), bits); }
+
+private:
+    std::vector<uint8_t>& out;
+    int pos = 0;
+};
+
+// 1文字を符号化する: 大きさと位置に続けて0の数と1の数の組を並べる (組の後の1ビットは繰り返しの指定で、常に0)
+static std::vector<uint8_t> encode_glyph(const Glyph& g) {
+    std::vector<uint8_t> out;
+    BitWriter bits(out);
+    bits.put(g.w, U8G2_BITS_SIZE);
+    bits.put(g.h, U8G2_BITS_SIZE);
+    bits.put_signed(g.x, U8G2_BITS_SIZE);
+    bits.put_signed(g.y, U8G2_BITS_SIZE);
+    bits.put_signed(g.dx, U8G2_BITS_SIZE);
+    for (size_t i = 0; i < g.pixels.size();) {
+        uint32_t zeros = 0;
+        uint32_t ones = 0;
+        while (i < g.pixels.size() && !g.pixels[i] && zeros < (1u << U8G2_BITS_0) - 1) {
+            zeros++;
+            i++;
+        }
+        while (i < g.pixels.size() && g.pixels[i] && ones < (1u << U8G2_BITS_1) - 1) {
+            ones++;
+            i++;
+        }
+        bits.put(zeros, U8G2_BITS_0);
+        bits.put(ones, U8G2_BITS_1);
+        bits.put(0, 1);
+    }
+    return out;
+}
+
+static Glyph gfx_glyph(const lgfx::GFXfont& font, uint16_t code) {
+    const lgfx::GFXglyph& src = font.glyph[code - font.first];
+    Glyph g{ code, src.width, src.height, src.xOffset, -(src.yOffset + src.height), src.xAdvance, {} };
+    for (int k = 0; k < g.w * g.h; k++) {
+        g.pixels.push_back((font.bitmap[src.bitmapOffset + k / 8] >> (7 - k % 8)) & 1);
+    }
+    return g;
+}
+
+static Glyph pattern_glyph(uint16_t code) {
+    std::mt19937 rng(code);
+    Glyph g{ code, 16, 16, 1, -2, 18, {} };
+    for (int y = 0; y < g.h; y++) {
+        for (int x = 0; x < g.w; x++) {
+            bool edge = x == 0 || y == 0 || x == g.w - 1 || y == g.h - 1;
+            g.pixels.push_back(edge ? (x + y) % 3 != 0 : rng() % 100 < 35);
+        }
+    }
+    return g;
+}
+
+// UTF-8の文字列に含まれる0x100以上の文字
+static std::vector<uint16_t> unicode_chars() {
+    std::vector<uint16_t> codes;
+    for (const char* text : U8G2_TEXT) {
+        for (const uint8_t* p = (const uint8_t*)text; *p;) {
+            uint16_t c = *p++;
+            if (c >= 0xE0) {
+                c = (c & 0x0F) << 12 | (p[0] & 0x3F) << 6 | (p[1] & 0x3F);
+                p += 2;
+            } else if (c >= 0xC0) {
+                c = (c & 0x1F) << 6 | (p[0] & 0x3F);
+                p += 1;
+            }
+            if (c >= 0x100) {
+                codes.push_back(c);
+            }
+        }
+    }
+    std::sort(codes.begin(), codes.end());
+    codes.erase(std::unique(codes.begin(), codes.end()), codes.end());
+    return codes;
+}
+
+static void put_glyph(std::vector<uint8_t>& font, const Glyph& g, bool unicode) {
+    std::vector<uint8_t> data = encode_glyph(g);
+    size_t size = data.size() + (unicode ? 3 : 2);
+    if (size > UINT8_MAX) {
+        printf("U8g2の文字 %04X が大きすぎる\n", g.code);
+        exit(1);
+    }
+    if (unicode) {
+        font.push_back(g.code >> 8);
+    }
+    font.push_back(g.code & 0xFF);
+    font.push_back((uint8_t)size);
+    font.insert(font.end(), data.begin(), data.end());
+}
+
+// ヘッダ (23バイト)、ASCIIの文字、0x100以上の文字の検索表と文字を並べる
+static std::vector<uint8_t> build_u8g2() {
+    std::vector<Glyph> ascii;
+    for (uint16_t c = 0x20; c <= 0x7E; c++) {
+        ascii.push_back(gfx_glyph(fonts::FreeSans9pt7b, c));
+    }
+    std::vector<Glyph> unicode;
+    for (uint16_t c : unicode_chars()) {
+        unicode.push_back(pattern_glyph(c));
+    }
+    int max_w = 0, top = 0, bottom = 0, left = 0;
+    for (const std::vector<Glyph>* list : { &ascii, &unicode }) {
+        for (const Glyph& g : *list) {
+            max_w = std::max(max_w, g.w);
+            top = std::max(top, g.y + g.h);
+            bottom = std::min(bottom, g.y);
+            left = std::min(left, g.x);
+        }
+    }
+
+    std::vector<uint8_t> font(23, 0);
+    font[0] = (uint8_t)ascii.size();
+    font[2] = U8G2_BITS_0;
+    font[3] = U8G2_BITS_1;
+    for (int i = 4; i <= 8; i++) {
+        font[i] = U8G2_BITS_SIZE;
+    }
+    font[9] = (uint8_t)max_w;
+    font[10] = (uint8_t)(top - bottom);
+    font[11] = (uint8_t)left;
+    font[12] = (uint8_t)bottom;
+    font[13] = font[15] = (uint8_t)top;
+    font[14] = font[16] = (uint8_t)bottom;
+    for (const Glyph& g : ascii) {
+        size_t at = font.size() - 23;
+        if (g.code == 'A' || g.code == 'a') {
+            font[g.code == 'A' ? 17 : 19] = at >> 8;
+            font[g.code == 'A' ? 18 : 20] = at & 0xFF;
+        }
+        put_glyph(font, g, false);
+    }
+    font.insert(font.end(), { 0, 0 });
+
+    size_t lut = font.size() - 23;
+    font[21] = lut >> 8;
+    font[22] = lut & 0xFF;
+    font.insert(font.end(), { 0, 4, 0xFF, 0xFF });  // 検索表は1区間だけ (文字の並びは検索表のすぐ後)
+    for (const Glyph& g : unicode) {
+        put_glyph(font, g, true);
+    }
+    font.insert(font.end(), { 0, 0, 0 });
+    return font;
+}
+
+static const std::vector<uint8_t> u8g2_data = build_u8g2();
+static const lgfx::U8g2font u8g2_font(u8g2_data.data());
+
+struct Font {
+    const char* name;
+    const lgfx::IFont* font;
+    const char* text;
+};
+
+// アプリで使っているフォントと同じ種類
+static const Font test_fonts[] = {
+    { "GLCD Font0", &fonts::Font0, "SCORE 12345 Hello, gjpqy!" },
+    { "BMP Font2", &fonts::Font2, "SCORE 12345 Hello, gjpqy!" },
+    { "RLE Font4", &fonts::Font4, "SCORE 12345 Hello" },
+    { "GFX Sans12", &fonts::FreeSans12pt7b, "SCORE 12345 gjpqy" },
+    { "GFX SansB18", &fonts::FreeSansBold18pt7b, "SCORE 12345" },
+    { "U8g2 ASCII", &u8g2_font, "SCORE 12345 gjpqy" },
+    { "U8g2 JA", &u8g2_font, "明るさ 速度 色相 12345" },
+    { "U8g2 JA2", &u8g2_font, "エフェクト 更新中..." },
+};
+static constexpr size_t FONT_COUNT = sizeof(test_fonts) / sizeof(test_fonts[0]);
+
+static int failures = 0;
+
+// 2つのスプライトに同じ描画をして画素を比べる (cached だけにキャッシュを付ける)
+struct Pair {
+    LGFX_Sprite cached;
+    LGFX_Sprite plain;
+
+    Pair(int depth, lgfx::GlyphCache* cache) {
+        for (LGFX_Sprite* s : { &cached, &plain }) {
+            s->setColorDepth(depth);
+            s->createSprite(SIZE, SIZE);
+        }
+        cached.setGlyphCache(cache);
+    }
+
+    template <typename Draw>
+    void draw(Draw f) {
+        f(cached);
+        f(plain);
+    }
+
+    // 違う画素の数
+    int compare() {
+        int bytes = cached.bufferLength();
+        int bpp = cached.getColorDepth() >> 3;
+        const uint8_t* a = (const uint8_t*)cached.getBuffer();
+        const uint8_t* b = (const uint8_t*)plain.getBuffer();
+        int bad = 0;
+        for (int i = 0; i < bytes; i += bpp) {
+            bad += memcmp(a + i, b + i, bpp) != 0;
+        }
+        return bad;
+    }
+
+    void check(const char* what) {
+        int bad = compare();
+        if (bad) {
+            printf("  NG %s: %d画素の違い\n", what, bad);
+            failures++;
+        }
+    }
+};
+
+// 1つのフォントで、位置・色・基準位置・描画の方法を変えて描き、描くたびに比べる
+static void draw_font(Pair& p, const Font& f, uint32_t seed) {
+    std::mt19937 rng(seed);
+    char what[96];
+    p.draw([&](LGFX_Sprite& s) {
+        s.fillScreen(TFT_BLACK);
+        s.setFont(f.font);
+        s.setTextSize(1);
+    });
+    for (int i = 0; i < 24; i++) {
+        int x = (int)(rng() % (SIZE + 80)) - 40;  // 画面の外へはみ出す位置も含める
+        int y = (int)(rng() % (SIZE + 40)) - 20;
+        uint16_t fg = (uint16_t)rng();
+        uint8_t datum = (uint8_t)(rng() % 9);
+        int mode = i % 6;
+        p.draw([&](LGFX_Sprite& s) {
+            s.setTextDatum(datum);
+            if (mode == 3) {
+                s.setTextColor(fg, TFT_NAVY);  // 背景色あり: キャッシュの対象外
+            } else {
+                s.setTextColor(fg);
+            }
+            s.setTextSize(mode == 4 ? 2 : 1);  // 拡大: キャッシュの対象外
+            if (mode == 5) {
+                s.setCursor(x, y);
+                s.print(f.text);
+            } else {
+                s.drawString(f.text, x, y);
+            }
+        });
+        snprintf(what, sizeof(what), "%s %dbit %d回目 (%d, %d) 描き方%d", f.name, p.cached.getColorDepth(), i, x, y, mode);
+        p.check(what);
+    }
+}
+
+// 全フォントを混ぜて描く (容量が小さいと文字の破棄と詰め直しが起きる)
+static void draw_mixed(Pair& p, uint32_t seed, int steps) {
+    std::mt19937 rng(seed);
+    char what[96];
+    p.draw([](LGFX_Sprite& s) { s.fillScreen(TFT_BLACK); });
+    for (int i = 0; i < steps; i++) {
+        const Font& f = test_fonts[rng() % FONT_COUNT];
+        int x = (int)(rng() % SIZE) - 20;
+        int y = (int)(rng() % SIZE);
+        uint16_t fg = (uint16_t)rng();
+        p.draw([&](LGFX_Sprite& s) {
+            s.setFont(f.font);
+            s.setTextSize(1);
+            s.setTextDatum(lgfx::middle_left);
+            s.setTextColor(fg);
+            s.drawString(f.text, x, y);
+        });
+        if (i % 8 == 0) {
+            p.draw([](LGFX_Sprite& s) { s.fillScreen(TFT_BLACK); });
+        }
+        snprintf(what, sizeof(what), "混在 %d回目 %s", i, f.name);
+        p.check(what);
+    }
+}
+
+static double now_us() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+// 文字列を繰り返し描き、1回あたりの時間 (us) を返す
+static double time_text(LGFX_Sprite& s, const Font& f) {
+    const int rounds = 2000;
+    s.setFont(f.font);
+    s.setTextSize(1);
+    s.setTextDatum(lgfx::middle_center);
+    double best = 1e30;
+    for (int k = 0; k < 5; k++) {
+        double t0 = now_us();
+        for (int i = 0; i < rounds; i++) {
+            s.setTextColor(i & 1 ? TFT_WHITE : TFT_YELLOW);
+            s.drawString(f.text, SIZE / 2, SIZE / 2);
+        }
+        best = std::min(best, (now_us() - t0) / rounds);
+    }
+    return best;
+}
+
+// 作ったU8g2フォントで漢字の模様がそのまま描けること (文字が無い場合の代わりの枠になっていないこと)
+static void check_u8g2_font() {
+    LGFX_Sprite s;
+    s.setColorDepth(16);
+    s.createSprite(40, 40);
+    s.setFont(&u8g2_font);
+    s.setTextColor(TFT_WHITE);
+    s.drawString("明", 10, 10);
+    Glyph g = pattern_glyph(0x660E);
+    int expected = (int)std::count(g.pixels.begin(), g.pixels.end(), 1);
+    int drawn = 0;
+    for (int y = 0; y < 40; y++) {
+        for (int x = 0; x < 40; x++) {
+            drawn += s.readPixel(x, y) != 0;
+        }
+    }
+    if (drawn != expected) {
+        printf("  NG U8g2の文字の画素: %d (期待 %d)\n", drawn, expected);
+        failures++;
+    }
+}
+
+int main() {
+    check_u8g2_font();
+    printf("== フォントごとの描画 (既定の容量、16/8ビットのスプライトで共有)\n");
+    lgfx::GlyphCache cache;
+    for (int depth : { 16, 8 }) {
+        Pair p(depth, &cache);
+        for (size_t i = 0; i < FONT_COUNT; i++) {
+            draw_font(p, test_fonts[i], 100 + i);
+        }
+    }
+    printf("   ヒット %lu, ミス %lu\n", (unsigned long)cache.getHitCount(), (unsigned long)cache.getMissCount());
+
+    printf("== 容量を変えて全フォントを混ぜて描く\n");
+    struct Capacity {
+        size_t rects;
+        uint_fast16_t entries;
+    };
+    const Capacity capacities[] = { { 2048, 128 }, { 256, 16 }, { 64, 8 }, { 16, 4 }, { 4, 2 } };
+    uint32_t default_miss = 0;
+    for (const Capacity& c : capacities) {
+        lgfx::GlyphCache small(c.rects, c.entries);
+        Pair p(16, &small);
+        draw_mixed(p, 7, 400);
+        uint32_t miss = small.getMissCount();
+        printf("   矩形 %4zu, 文字 %3u: ヒット %5lu, ミス %5lu\n", c.rects, (unsigned)c.entries,
+               (unsigned long)small.getHitCount(), (unsigned long)miss);
+        if (c.rects == 2048) {
+            default_miss = miss;
+        } else if (miss <= default_miss) {
+            printf("  NG 容量が小さいのに破棄が起きていない\n");
+            failures++;
+        }
+    }
+
+    printf("== 文字列の描画時間 (us)\n");
+    printf("%-12s %10s %10s %8s  %s\n", "font", "no cache", "cache", "ratio", "text");
+    lgfx::GlyphCache bench_cache;
+    Pair p(16, &bench_cache);
+    for (const Font& f : test_fonts) {
+        double plain = time_text(p.plain, f);
+        double cached = time_text(p.cached, f);
+        printf("%-12s %10.2f %10.2f %7.1fx  %s\n", f.name, plain, cached, plain / cached, f.text);
+    }
+    p.check("描画時間の計測後");
+
+    printf(failures ? "%d件の不一致\n" : "すべて一致\n", failures);
+    return failures ? 1 : 0;
+}
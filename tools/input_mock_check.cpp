@@ -0,0 +1,364 @@
+// エンコーダーと入力イベントキューのモックの確認 (Linux上で実行)
+// m5dial_encoder / m5dial_input をモック (PCNTとGPIOの割り込みの代わりに encoder_mock_turn() や
+// input_mock_*() で入力を与える) でビルドし、デテントの数え方 (ジッタ・逆転・リセット・
+// 割り込みが遅れて上下限の事象がまとまった場合) と、
+// キューに積まれる事象 (時刻・回転速度・ボタンとチャタリング除去の後の読み直し・タッチ) を確かめます。1つでも違えば終了コード1を返します
+//
+// 使い方:
+//   C=m5dial-hello/components/m5dial
+//   g++ -std=gnu++17 -O2 -I $C/include -o input_mock_check tools/input_mock_check.cpp $C/m5dial_encoder.cpp $C/m5dial_input.cpp $C/m5dial_gesture.cpp
+//   ./input_mock_check
+
+#include <stdio.h>
+#include "m5dial_encoder.h"
+#include "m5dial_gesture.h"
+#include "m5dial_input.h"
+
+static int failures = 0;
+
+static void expect(const char* what, long actual, long expected) {
+    if (actual != expected) {
+        printf("  NG %s: %ld (期待 %ld)\n", what, actual, expected);
+        failures++;
+    }
+}
+
+// encoder_set_callback() の通知を数える
+static int callback_calls = 0;
+static int callback_sum = 0;
+
+static bool on_step(int step, void*) {
+    callback_calls++;
+    callback_sum += step;
+    return false;
+}
+
+static void start_encoder() {
+    encoder_reset();
+    callback_calls = 0;
+    callback_sum = 0;
+}
+
+static void check_detents() {
+    printf("== 4カウントで1デテント\n");
+    start_encoder();
+    encoder_mock_turn(3);
+    expect("3カウント", encoder_detents(), 0);
+    expect("3カウントの端数", encoder_mock_count(), 3);
+    expect("3カウントの通知", callback_calls, 0);
+    encoder_mock_turn(1);
+    expect("4カウント", encoder_detents(), 1);
+    expect("4カウントの端数", encoder_mock_count(), 0);
+    expect("4カウントの通知", callback_calls, 1);
+    encoder_mock_turn(-12);
+    expect("反時計回りに3デテント", encoder_detents(), -2);
+    encoder_mock_turn(42);
+    expect("10デテントと2カウント", encoder_detents(), 8);
+    expect("端数", encoder_mock_count(), 2);
+    expect("通知の合計", callback_sum, 8);
+}
+
+static void check_jitter() {
+    printf("== デテントの間と境目でのジッタ\n");
+    start_encoder();
+    encoder_mock_turn(2);
+    for (int i = 0; i < 100; i++) {
+        encoder_mock_turn(1);
+        encoder_mock_turn(-1);
+    }
+    expect("デテントの間", encoder_detents(), 0);
+    expect("デテントの間の通知", callback_calls, 0);
+
+    encoder_mock_turn(1);  // 境目の手前 (3カウント)
+    for (int i = 0; i < 100; i++) {
+        encoder_mock_turn(1);
+        encoder_mock_turn(-1);
+    }
+    expect("境目を行き来", encoder_detents(), 1);
+    expect("境目を行き来した通知", callback_calls, 1);
+}
+
+static void check_reversal() {
+    printf("== 逆転\n");
+    start_encoder();
+    encoder_mock_turn(2);
+    encoder_mock_turn(-2);
+    expect("半分回して戻す", encoder_detents(), 0);
+    expect("半分回して戻した通知", callback_calls, 0);
+
+    encoder_mock_turn(6);
+    expect("1デテント半", encoder_detents(), 1);
+    encoder_mock_turn(-6);
+    expect("1デテント半戻す", encoder_detents(), 0);
+    expect("戻した後の端数", encoder_mock_count(), 0);
+    expect("逆転の通知", callback_calls, 2);
+    expect("逆転の通知の合計", callback_sum, 0);
+}
+
+static void check_reset() {
+    printf("== リセット\n");
+    start_encoder();
+    encoder_mock_turn(13);
+    encoder_reset();
+    expect("リセット後のデテント", encoder_detents(), 0);
+    expect("リセット後の端数", encoder_mock_count(), 0);
+    encoder_mock_turn(3);
+    expect("リセット前の端数は捨てる", encoder_detents(), 0);
+    encoder_mock_turn(1);
+    expect("リセット後の1デテント", encoder_detents(), 1);
+}
+
+static void check_deferred_isr() {
+    printf("== 割り込みが遅れる間に何度も上下限を越える\n");
+    start_encoder();
+    encoder_mock_hold_isr(true);
+    encoder_mock_turn(4 * 5);
+    expect("止めている間のデテント", encoder_detents(), 0);
+    encoder_mock_hold_isr(false);
+    expect("再開後のデテント", encoder_detents(), 5);
+    expect("再開後の通知", callback_calls, 5);
+
+    encoder_mock_hold_isr(true);
+    encoder_mock_turn(-4 * 3 - 2);
+    encoder_mock_turn(1);
+    encoder_mock_hold_isr(false);
+    expect("逆向きに3デテント", encoder_detents(), 2);
+    expect("逆向きの通知の合計", callback_sum, 2);
+    expect("逆向きの端数", encoder_mock_count(), -1);
+
+    // 境目をまたいで行き来しても、再開後に数えるのは越えたままの分だけ
+    encoder_mock_hold_isr(true);
+    encoder_mock_turn(-3);
+    encoder_mock_turn(3);
+    encoder_mock_turn(-3);
+    encoder_mock_hold_isr(false);
+    expect("境目を行き来した後", encoder_detents(), 1);
+}
+
+static input_event_t events[INPUT_QUEUE_LENGTH];
+
+static size_t read_all() {
+    return input_read(events, INPUT_QUEUE_LENGTH, 0);
+}
+
+static void check_queue_detents() {
+    printf("== キューのデテントと回転速度\n");
+    read_all();
+    int64_t t = 1000000;
+    for (int i = 0; i < 4; i++) {
+        input_mock_set_time(t + i * 10000);  // 10msごと = 100デテント/秒
+        encoder_mock_turn(4);
+    }
+    input_mock_set_time(t + 40000);
+    encoder_mock_turn(-4);
+    size_t n = read_all();
+    expect("事象の数", (long)n, 5);
+    if (n == 5) {
+        expect("1件目の時刻", (long)events[0].time_us, (long)t);
+        expect("1件目の向き", events[0].value, 1);
+        expect("回し始めの速度", events[0].speed, 0);
+        expect("4件目の速度", events[3].speed, 100);
+        expect("逆転した時の向き", events[4].value, -1);
+        expect("逆転した時の速度", events[4].speed, 0);
+        expect("加速 (100デテント/秒で最大)", input_accel_step(events[3], input_accel_t{ 20, 100, 8, 1 }), 8);
+        expect("加速なし", input_accel_step(events[3], INPUT_ACCEL_NONE), 1);
+    }
+
+    // ジッタはキューにも積まれない
+    encoder_mock_turn(2);
+    for (int i = 0; i < 50; i++) {
+        encoder_mock_turn(1);
+        encoder_mock_turn(-1);
+    }
+    encoder_mock_turn(-2);
+    expect("ジッタの事象", (long)read_all(), 0);
+
+    // 割り込みが遅れた分はまとめて積まれる
+    input_mock_set_time(t + 100000);
+    encoder_mock_hold_isr(true);
+    encoder_mock_turn(4 * 3);
+    encoder_mock_hold_isr(false);
+    n = read_all();
+    expect("遅れた割り込みの事象", (long)n, 3);
+    for (size_t i = 0; i < n; i++) {
+        expect("遅れた割り込みの向き", events[i].value, 1);
+    }
+}
+
+static void check_button() {
+    printf("== ボタンのチャタリングと長押し\n");
+    input_mock_set_time(2000000);
+    input_mock_button(true);
+    input_mock_set_time(2001000);
+    input_mock_button(false);  // チャタリング除去の時間内なので無視する
+    input_mock_set_time(2002000);
+    input_mock_button(true);
+    input_mock_set_time(2100000);
+    input_mock_button(false);
+    size_t n = read_all();
+    expect("短押しの事象", (long)n, 2);
+    if (n == 2) {
+        expect("押下", events[0].type, INPUT_PRESS);
+        expect("解放", events[1].type, INPUT_RELEASE);
+        expect("長押しにならずに離した", events[1].value, 1);
+    }
+
+    input_mock_set_time(3000000);
+    input_mock_button(true);
+    read_all();
+    input_mock_set_time(3299999);
+    expect("長押しの手前", (long)read_all(), 0);
+    input_mock_set_time(3300000);
+    n = read_all();
+    expect("長押し", (long)n, 1);
+    if (n == 1) {
+        expect("長押しの事象", events[0].type, INPUT_LONG_PRESS);
+        expect("長押しの時刻", (long)events[0].time_us, 3300000);
+    }
+    expect("長押し中", input_button_held(), true);
+    input_mock_set_time(3500000);
+    input_mock_button(false);
+    n = read_all();
+    expect("長押し後の解放", (long)n, 1);
+    if (n == 1) {
+        expect("長押しの後に離した", events[0].value, 0);
+    }
+    expect("解放後", input_button_held(), false);
+}
+
+static void check_button_recheck() {
+    printf("== チャタリング除去の時間内に離した・押し直したボタンの読み直し\n");
+    int64_t t = 5000000;
+    input_mock_set_time(t);
+    input_mock_button(true);
+    input_mock_set_time(t + 1000);
+    input_mock_button(false);  // 除去の時間内の解放は割り込みでは捨てる
+    input_mock_set_time(t + INPUT_DEBOUNCE_US - 1);
+    size_t n = read_all();
+    expect("除去の時間内", (long)n, 1);
+    if (n == 1) {
+        expect("押下", events[0].type, INPUT_PRESS);
+    }
+    input_mock_set_time(t + INPUT_DEBOUNCE_US);
+    n = read_all();
+    expect("読み直した解放", (long)n, 1);
+    if (n == 1) {
+        expect("解放", events[0].type, INPUT_RELEASE);
+        expect("解放の時刻", (long)events[0].time_us, (long)(t + INPUT_DEBOUNCE_US));
+        expect("短押し", events[0].value, 1);
+    }
+    input_mock_set_time(t + 2 * INPUT_DEBOUNCE_US);
+    expect("読み直した解放の後", (long)read_all(), 0);
+
+    // 除去の時間内に離して押し直した: 押したままなので何も返さない
+    t += 1000000;
+    input_mock_set_time(t);
+    input_mock_button(true);
+    input_mock_set_time(t + 1000);
+    input_mock_button(false);
+    input_mock_set_time(t + 2000);
+    input_mock_button(true);
+    input_mock_set_time(t + INPUT_DEBOUNCE_US);
+    n = read_all();
+    expect("押し直した", (long)n, 1);
+    if (n == 1) {
+        expect("押下のみ", events[0].type, INPUT_PRESS);
+    }
+
+    // 読み直しで受け付けた変化の後も除去の時間は同じように働く
+    input_mock_set_time(t + 100000);
+    input_mock_button(false);
+    input_mock_set_time(t + 101000);
+    input_mock_button(true);  // 捨てる
+    input_mock_set_time(t + 102000);
+    input_mock_button(false);  // 捨てる
+    input_mock_set_time(t + 103000);
+    input_mock_button(true);  // 捨てる (押したまま)
+    input_mock_set_time(t + 100000 + INPUT_DEBOUNCE_US);
+    n = read_all();
+    expect("解放と読み直した押下", (long)n, 2);
+    if (n == 2) {
+        expect("解放", events[0].type, INPUT_RELEASE);
+        expect("読み直した押下", events[1].type, INPUT_PRESS);
+    }
+    input_mock_set_time(t + 100000 + 2 * INPUT_DEBOUNCE_US - 1);
+    input_mock_button(false);  // 読み直した押下の除去の時間内: 捨てる
+    input_mock_set_time(t + 100000 + 2 * INPUT_DEBOUNCE_US);
+    n = read_all();
+    expect("2回目の読み直し", (long)n, 1);
+    if (n == 1) {
+        expect("2回目の読み直しの解放", events[0].type, INPUT_RELEASE);
+    }
+    expect("解放後", input_button_held(), false);
+}
+
+// タッチパネルの代わり: touch_down の間は touch_x, touch_y を返す
+static bool touch_down = false;
+static int16_t touch_x = 0;
+static int16_t touch_y = 0;
+static int touch_reads = 0;
+
+static bool read_touch(int16_t* x, int16_t* y, void*) {
+    touch_reads++;
+    if (!touch_down) {
+        return false;
+    }
+    *x = touch_x;
+    *y = touch_y;
+    return true;
+}
+
+static void check_touch() {
+    printf("== タッチのタップ\n");
+    input_touch_init(14, read_touch, nullptr, GESTURE_CONFIG_M5DIAL);
+    int64_t t = 4000000;
+    for (int i = 0; i < 10; i++) {
+        input_mock_set_time(t += INPUT_TOUCH_POLL_US);
+        read_all();
+    }
+    expect("触れていない間の読み取り", touch_reads, 0);
+
+    touch_down = true;
+    touch_x = 100;
+    touch_y = 110;
+    input_mock_touch(true);
+    read_all();
+    for (int i = 0; i < 3; i++) {
+        input_mock_set_time(t += INPUT_TOUCH_POLL_US);
+        read_all();
+    }
+    touch_down = false;
+    input_mock_touch(false);
+    size_t n = read_all();
+    expect("タップの事象", (long)n, 1);
+    if (n == 1) {
+        expect("タップ", events[0].type, INPUT_TAP);
+        expect("タップのx", events[0].x, 100);
+        expect("タップのy", events[0].y, 110);
+    }
+    int reads = touch_reads;
+    for (int i = 0; i < 10; i++) {
+        input_mock_set_time(t += INPUT_TOUCH_POLL_US);
+        read_all();
+    }
+    expect("離した後の読み取り", touch_reads - reads, 0);
+}
+
+int main() {
+    encoder_init(40, 41);
+    encoder_set_callback(on_step, nullptr);
+    check_detents();
+    check_jitter();
+    check_reversal();
+    check_reset();
+    check_deferred_isr();
+
+    input_init(42, 300);  // エンコーダーの通知先はキューに替わる
+    check_queue_detents();
+    check_button();
+    check_button_recheck();
+    check_touch();
+    expect("あふれた事象", input_overflows(), 0);
+    printf(failures ? "%d件の不一致\n" : "すべて一致\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,131 @@
+// LED色変換のベンチマーク (Linux上で実行)
+// 従来の1画素ずつのhsv_to_rgb()と、表引きによる一括変換 hsv_to_rgb_n() の1画素あたりの時間と誤差を比較します
+// エフェクトの切り替えで使う重ね合わせ (線形補間と各合成モード) の1画素あたりの時間も計測します
+//
+// 使い方:
+//   g++ -std=gnu++17 -O2 -I m5dial-led/main -o led_color_bench tools/led_color_bench.cpp m5dial-led/main/led_color.cpp
+//   ./led_color_bench
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <algorithm>
+#include <vector>
+#include "led_color.h"
+
+// 以前の変換 (区間ごとに60で割る)
+static void hsv_to_rgb_reference(uint16_t h, uint8_t s, uint8_t v, uint8_t *r, uint8_t *g, uint8_t *b) {
+    if (s == 0) {
+        *r = *g = *b = v;
+        return;
+    }
+
+    uint8_t region = h / 60;
+    uint8_t remainder = (h - (region * 60)) * 255 / 60;
+
+    uint8_t p = (v * (255 - s)) >> 8;
+    uint8_t q = (v * (255 - ((s * remainder) >> 8))) >> 8;
+    uint8_t t = (v * (255 - ((s * (255 - remainder)) >> 8))) >> 8;
+
+    switch (region) {
+        case 0:  *r = v; *g = t; *b = p; break;
+        case 1:  *r = q; *g = v; *b = p; break;
+        case 2:  *r = p; *g = v; *b = t; break;
+        case 3:  *r = p; *g = q; *b = v; break;
+        case 4:  *r = t; *g = p; *b = v; break;
+        default: *r = v; *g = p; *b = q; break;
+    }
+}
+
+static double now_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int main() {
+    const int pixels = 150;   // 1フレーム分
+    const int frames = 200000;
+
+    std::vector<Hsv> in(pixels);
+    std::vector<Rgb> out(pixels);
+    srand(1);
+    for (auto& p : in) {
+        p = { (uint16_t)(rand() % 360), (uint8_t)(rand() & 255), (uint8_t)(rand() & 255) };
+    }
+
+    // 誤差 (全ての色相・彩度・明度の組み合わせ)
+    int max_error = 0;
+    for (int h = 0; h < 360; h++) {
+        for (int s = 0; s < 256; s++) {
+            for (int v = 0; v < 256; v++) {
+                uint8_t r, g, b;
+                hsv_to_rgb_reference(h, s, v, &r, &g, &b);
+                Rgb c = hsv_to_rgb(h, s, v);
+                max_error = std::max(max_error, abs(r - c.r));
+                max_error = std::max(max_error, abs(g - c.g));
+                max_error = std::max(max_error, abs(b - c.b));
+            }
+        }
+    }
+
+    unsigned sum = 0;  // 最適化で消されないように結果を使う
+    double start = now_ns();
+    for (int f = 0; f < frames; f++) {
+        for (int i = 0; i < pixels; i++) {
+            hsv_to_rgb_reference(in[i].h, in[i].s, in[i].v, &out[i].r, &out[i].g, &out[i].b);
+        }
+        sum += out[f % pixels].r;
+    }
+    double reference_ns = (now_ns() - start) / ((double)frames * pixels);
+
+    start = now_ns();
+    for (int f = 0; f < frames; f++) {
+        hsv_to_rgb_n(in.data(), out.data(), pixels);
+        sum += out[f % pixels].r;
+    }
+    double batch_ns = (now_ns() - start) / ((double)frames * pixels);
+
+    std::vector<uint16_t> out565(pixels);
+    start = now_ns();
+    for (int f = 0; f < frames; f++) {
+        hsv_to_rgb565_n(in.data(), out565.data(), pixels);
+        sum += out565[f % pixels];
+    }
+    double rgb565_ns = (now_ns() - start) / ((double)frames * pixels);
+
+    // フェード中は2つのエフェクトのフレームを毎フレーム補間する
+    std::vector<Rgb> a(pixels), b(pixels), mixed(pixels);
+    hsv_to_rgb_n(in.data(), a.data(), pixels);
+    std::reverse_copy(a.begin(), a.end(), b.begin());
+    start = now_ns();
+    for (int f = 0; f < frames; f++) {
+        blend_lerp_n(a.data(), b.data(), mixed.data(), pixels, (uint16_t)(f & 255));
+        sum += mixed[f % pixels].r;
+    }
+    double lerp_ns = (now_ns() - start) / ((double)frames * pixels);
+
+    const char* mode_names[] = { "add", "max", "multiply" };
+    double blend_ns[3];
+    for (int m = 0; m < 3; m++) {
+        start = now_ns();
+        for (int f = 0; f < frames; f++) {
+            for (int i = 0; i < pixels; i++) {
+                mixed[i] = blend(a[i], b[i], (BlendMode)m);
+            }
+            sum += mixed[f % pixels].r;
+        }
+        blend_ns[m] = (now_ns() - start) / ((double)frames * pixels);
+    }
+
+    printf("hsv_to_rgb (従来)   : %6.2f ns/pixel\n", reference_ns);
+    printf("hsv_to_rgb_n        : %6.2f ns/pixel\n", batch_ns);
+    printf("hsv_to_rgb565_n     : %6.2f ns/pixel\n", rgb565_ns);
+    printf("blend_lerp_n        : %6.2f ns/pixel\n", lerp_ns);
+    for (int m = 0; m < 3; m++) {
+        printf("blend (%-8s)    : %6.2f ns/pixel\n", mode_names[m], blend_ns[m]);
+    }
+    printf("従来との最大誤差    : %d\n", max_error);
+    printf("(%u)\n", sum & 1);
+    return 0;
+}
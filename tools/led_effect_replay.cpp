@@ -0,0 +1,492 @@
+// LEDエフェクトの再生の確認 (Linux上で実行)
+// エフェクト (led_effects.cpp) と合成 (led_compositor.h) を tools/esp_host/ の代わりのヘッダでビルドし、
+// 乱数の種を固定して決まった設定の変化と時刻の列で描きます
+// - エフェクト・LED数 (1〜2000)・フレームレート (50/100/200Hz)・コントロールモードの有無ごとに
+//   3秒分の全フレームのハッシュを取り、tools/led_effect_hashes.txt と比べる
+//   (描画を変えずに作りを変えたときの確認。描画を意図して変えたときは --update で書き直す)
+// - 点灯中のLEDの外 (フレームとLEDごとの状態の領域の後ろ) に書き込んでいないか
+// - 合成: 色のグライド、フェードの割合、フェード中の戻し・さらに切り替え、目印の折り返し、処理時間の上限での打ち切り
+// - 600 LED・100Hzで全エフェクトを1秒ごとに切り替えたときの、フェード中と通常のフレームの処理時間
+// 1つでも違えば終了コード1を返します
+//
+// 使い方 (リポジトリの最上位で):
+//   C=m5dial-hello/components/m5dial
+//   g++ -std=gnu++17 -O2 -I tools/esp_host -I m5dial-led/main -I $C/include -o led_effect_replay tools/led_effect_replay.cpp m5dial-led/main/led_effects.cpp m5dial-led/main/led_color.cpp m5dial-led/main/led_random.cpp $C/m5dial_buzzer.cpp
+//   ./led_effect_replay [--update]
+
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+#include "led_compositor.h"
+#include "led_effects.h"
+#include "led_random.h"
+#include "m5dial_buzzer.h"
+
+// main.cpp と同じ並び
+using LedEffectSet = LedEffects<
+    SolidEffect,
+    ChaseEffect,
+    BounceEffect,
+    CometEffect,
+    RainbowEffect,
+    RandomBlinkEffect,
+    FireflyEffect,
+    RandomFireflyEffect,
+    HeartbeatEffect,
+    XmasSongEffect
+>;
+
+static const char* effect_names[] = {
+    "solid", "chase", "bounce", "comet", "rainbow", "random_blink", "firefly", "random_firefly", "heartbeat", "xmas",
+};
+static_assert(sizeof(effect_names) / sizeof(effect_names[0]) == LedEffectSet::count, "effect_names[] とエフェクトの数が合わない");
+
+static const char* HASH_FILE = "tools/led_effect_hashes.txt";
+static constexpr uint32_t SEED = 1;
+static constexpr int CANARY = 16;  // 点灯中の範囲の後ろに置く見張りの画素・バイトの数
+static constexpr uint8_t CANARY_BYTE = 0xA5;
+
+// 合成の処理時間の計測に使う時計。fake_step_us が0以外なら呼ぶたびにその分だけ進む
+static int64_t fake_step_us = 0;
+static int64_t fake_now_us = 0;
+
+int64_t esp_timer_get_time() {
+    if (fake_step_us) {
+        return fake_now_us += fake_step_us;
+    }
+    using namespace std::chrono;
+    return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+static int failures = 0;
+
+static void expect(const char* what, long actual, long expected) {
+    if (actual != expected) {
+        printf("  NG %s: %ld (期待 %ld)\n", what, actual, expected);
+        failures++;
+    }
+}
+
+static void expect_frame(const char* what, const Rgb* actual, const Rgb* expected, int n) {
+    for (int i = 0; i < n; i++) {
+        if (memcmp(&actual[i], &expected[i], sizeof(Rgb)) != 0) {
+            printf("  NG %s: %d番目 (%d,%d,%d) (期待 (%d,%d,%d))\n", what, i, actual[i].r, actual[i].g, actual[i].b,
+                   expected[i].r, expected[i].g, expected[i].b);
+            failures++;
+            return;
+        }
+    }
+}
+
+static void expect_color(const char* what, const Rgb& actual, const Rgb& expected) {
+    expect_frame(what, &actual, &expected, 1);
+}
+
+// main.cpp の update_leds() と同じ方法でフレームの時刻を作る
+struct Clock {
+    uint64_t elapsed_us = 0;
+    uint64_t progress = 0;
+
+    EffectTime next(uint32_t dt_us, uint8_t speed) {
+        elapsed_us += dt_us;
+        progress += (uint64_t)speed * dt_us;
+        EffectTime t;
+        t.dt_us = dt_us;
+        t.ticks = dt_us / (EFFECT_TICK_MS * 1000.0f);
+        t.tick = (uint32_t)(elapsed_us / (EFFECT_TICK_MS * 1000));
+        t.counter = (uint32_t)(progress / (EFFECT_TICK_MS * 1000));
+        return t;
+    }
+};
+
+static LedSettings base_settings(uint8_t effect, uint16_t count) {
+    LedSettings s = {};
+    s.hue = 0;
+    s.saturation = 255;
+    s.brightness = 255;
+    s.count = count;
+    s.effect = effect;
+    s.speed = 5;
+    s.on = true;
+    return s;
+}
+
+// ===== 再生とハッシュ =====
+
+static uint64_t fnv1a(uint64_t h, const void* data, size_t n) {
+    const uint8_t* p = (const uint8_t*)data;
+    for (size_t i = 0; i < n; i++) {
+        h = (h ^ p[i]) * 0x100000001b3ULL;
+    }
+    return h;
+}
+
+static bool canary_intact(const uint8_t* p, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        if (p[i] != CANARY_BYTE) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 1つのエフェクトを3秒分描き、全フレームのハッシュを返す
+// 1秒ごとに色と速度を変え、コントロールモードでは位置を50msごとに1つ進める
+static uint64_t replay(size_t effect, uint16_t leds, uint32_t hz, bool control, bool* overrun) {
+    led_rng.seed(SEED);
+    LedEffectSet effects;
+    std::vector<Rgb> pixels(leds + CANARY);
+    std::vector<uint8_t> state(leds * EFFECT_STATE_BYTES_PER_LED + CANARY);
+    memset(pixels.data(), 0, leds * sizeof(Rgb));
+    memset(pixels.data() + leds, CANARY_BYTE, CANARY * sizeof(Rgb));
+    memset(state.data() + leds * EFFECT_STATE_BYTES_PER_LED, CANARY_BYTE, CANARY);
+
+    LedSettings s = base_settings((uint8_t)effect, leds);
+    s.hue = 200;
+    s.brightness = 200;
+    s.control_active = control;
+    effects.enter(effect, state.data(), leds);
+
+    Clock clock;
+    uint32_t dt_us = 1000000 / hz;
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (uint32_t frame = 0; frame < 3 * hz; frame++) {
+        if (frame == hz) {
+            s.hue = 30;
+            s.saturation = 180;
+            s.speed = 9;
+        } else if (frame == 2 * hz) {
+            s.hue = 300;
+            s.brightness = 80;
+            s.speed = 1;
+        }
+        EffectTime t = clock.next(dt_us, s.speed);
+        s.control_position = (int16_t)((clock.elapsed_us / 50000) % leds);
+        effects.render(effect, { pixels.data(), leds }, t, s);
+        buzzer_mock_advance(dt_us);
+        h = fnv1a(h, pixels.data(), leds * sizeof(Rgb));
+    }
+    effects.leave(effect);
+
+    *overrun = !canary_intact((const uint8_t*)(pixels.data() + leds), CANARY * sizeof(Rgb)) ||
+               !canary_intact(state.data() + leds * EFFECT_STATE_BYTES_PER_LED, CANARY);
+    return h;
+}
+
+static std::map<std::string, uint64_t> load_hashes() {
+    std::map<std::string, uint64_t> hashes;
+    FILE* f = fopen(HASH_FILE, "r");
+    if (f == nullptr) {
+        return hashes;
+    }
+    char line[160];
+    while (fgets(line, sizeof(line), f)) {
+        char name[32];
+        unsigned leds, hz, control;
+        unsigned long long h;
+        if (line[0] != '#' && sscanf(line, "%31s %u %u %u %llx", name, &leds, &hz, &control, &h) == 5) {
+            char key[64];
+            snprintf(key, sizeof(key), "%s %u %u %u", name, leds, hz, control);
+            hashes[key] = h;
+        }
+    }
+    fclose(f);
+    return hashes;
+}
+
+static void check_replay(bool update) {
+    printf("== エフェクトの再生 (種 %u)\n", (unsigned)SEED);
+    std::map<std::string, uint64_t> golden = load_hashes();
+    if (golden.empty() && !update) {
+        printf("  NG %s を読めない\n", HASH_FILE);
+        failures++;
+        return;
+    }
+    FILE* out = nullptr;
+    if (update) {
+        out = fopen(HASH_FILE, "w");
+        if (out == nullptr) {
+            printf("  NG %s に書けない\n", HASH_FILE);
+            failures++;
+            return;
+        }
+        fprintf(out, "# tools/led_effect_replay の描画のハッシュ (種 %u)。描画を意図して変えたときは --update で書き直す\n", (unsigned)SEED);
+        fprintf(out, "# エフェクト LED数 Hz コントロールモード FNV-1a\n");
+    }
+
+    int runs = 0, mismatches = 0;
+    for (size_t e = 0; e < LedEffectSet::count; e++) {
+        for (uint16_t leds : { 1, 2, 37, 150, 300, 2000 }) {
+            for (uint32_t hz : { 50, 100, 200 }) {
+                for (int control = 0; control < 2; control++) {
+                    char key[64];
+                    snprintf(key, sizeof(key), "%s %u %u %d", effect_names[e], (unsigned)leds, (unsigned)hz, control);
+                    bool overrun = false;
+                    uint64_t h = replay(e, leds, hz, control, &overrun);
+                    runs++;
+                    if (overrun) {
+                        printf("  NG %s: 点灯中の範囲の外に書き込んだ\n", key);
+                        failures++;
+                    }
+                    if (out) {
+                        fprintf(out, "%s %016llx\n", key, (unsigned long long)h);
+                        continue;
+                    }
+                    auto it = golden.find(key);
+                    if (it == golden.end() || it->second != h) {
+                        printf("  NG %s: %016llx (期待 %s)\n", key, (unsigned long long)h,
+                               it == golden.end() ? "なし" : "別の値");
+                        mismatches++;
+                    }
+                }
+            }
+        }
+    }
+    if (out) {
+        fclose(out);
+        printf("  %d件を %s に書き込んだ\n", runs, HASH_FILE);
+    } else {
+        printf("  %d件中 %d件が不一致\n", runs, mismatches);
+        failures += mismatches;
+    }
+}
+
+// ===== 合成 =====
+
+static constexpr uint16_t N = 16;
+static constexpr uint32_t DT_US = 10000;  // 100Hz
+static constexpr uint32_t FADE_MS = 400;  // 40フレームでフェードが終わる
+
+// 状態を持たないエフェクトを合成と同じ時刻で別に描き、期待するフレームを作る
+struct Reference {
+    LedEffectSet effects;
+    Rgb a[N], b[N], blended[N];
+    uint8_t state[2][N * EFFECT_STATE_BYTES_PER_LED];
+
+    const Rgb* fade(size_t from, size_t to, const EffectTime& t, const LedSettings& s, uint16_t weight) {
+        effects.enter(from, state[0], N);
+        effects.enter(to, state[1], N);
+        effects.render(from, { a, N }, t, s);
+        effects.render(to, { b, N }, t, s);
+        blend_lerp_n(a, b, blended, N, weight);
+        return blended;
+    }
+};
+
+static uint16_t weight_after(uint32_t elapsed_us) {
+    return (uint16_t)((uint64_t)elapsed_us * 256 / (FADE_MS * 1000));
+}
+
+static void check_glide() {
+    printf("== 色のグライド\n");
+    LedCompositor<LedEffectSet> c;
+    c.init(N, FADE_MS, 1000000, BLEND_ADD);
+    Clock clock;
+    LedSettings s = base_settings(0, N);
+    c.render(N, clock.next(DT_US, s.speed), s);
+
+    s.hue = 120;
+    const Rgb* out = nullptr;
+    for (int i = 1; i <= 20; i++) {
+        out = c.render(N, clock.next(DT_US, s.speed), s);
+    }
+    expect_color("0→120 の半分", out[0], hsv_to_rgb(60, 255, 255));
+    for (int i = 21; i <= 40; i++) {
+        out = c.render(N, clock.next(DT_US, s.speed), s);
+    }
+    expect_color("0→120 の終わり", out[0], hsv_to_rgb(120, 255, 255));
+
+    // 350→10 は0をまたいで近い方へ回る
+    s.hue = 350;
+    for (int i = 0; i < 40; i++) {
+        c.render(N, clock.next(DT_US, s.speed), s);
+    }
+    s.hue = 10;
+    for (int i = 1; i <= 10; i++) {
+        out = c.render(N, clock.next(DT_US, s.speed), s);
+    }
+    expect_color("350→10 の1/4", out[0], hsv_to_rgb(355, 255, 255));
+    for (int i = 11; i <= 20; i++) {
+        out = c.render(N, clock.next(DT_US, s.speed), s);
+    }
+    expect_color("350→10 の半分", out[0], hsv_to_rgb(0, 255, 255));
+    for (int i = 21; i <= 40; i++) {
+        c.render(N, clock.next(DT_US, s.speed), s);
+    }
+    s.hue = 350;
+    for (int i = 1; i <= 10; i++) {
+        out = c.render(N, clock.next(DT_US, s.speed), s);
+    }
+    expect_color("10→350 の1/4", out[0], hsv_to_rgb(5, 255, 255));
+}
+
+static void check_fade() {
+    printf("== エフェクトのフェード\n");
+    LedCompositor<LedEffectSet> c;
+    c.init(N, FADE_MS, 1000000, BLEND_ADD);
+    Reference ref;
+    Clock clock;
+    LedSettings s = base_settings(0, N);
+    for (int i = 0; i < 5; i++) {
+        c.render(N, clock.next(DT_US, s.speed), s);
+    }
+
+    // 単色 → 追いかけ
+    s.effect = 1;
+    for (int k = 1; k <= 40; k++) {
+        EffectTime t = clock.next(DT_US, s.speed);
+        const Rgb* out = c.render(N, t, s);
+        expect_frame("単色→追いかけ", out, ref.fade(0, 1, t, s, weight_after(k * DT_US)), N);
+        expect("フェード中", c.fading(), k < 40);
+    }
+
+    // 100msで単色に戻すと、残り300msの位置から逆向きにフェードする
+    s.effect = 0;
+    for (int k = 1; k <= 10; k++) {
+        c.render(N, clock.next(DT_US, s.speed), s);
+    }
+    s.effect = 1;
+    for (int k = 1; k <= 10; k++) {
+        EffectTime t = clock.next(DT_US, s.speed);
+        const Rgb* out = c.render(N, t, s);
+        if (k == 1) {
+            expect_frame("戻した直後", out, ref.fade(0, 1, t, s, weight_after(310000)), N);
+        }
+        expect("戻した後のフェード中", c.fading(), k < 10);
+    }
+
+    // 新しい方が半分未満のうちにさらに切り替えると、前のエフェクト (追いかけ) を残す
+    s.effect = 2;
+    for (int k = 1; k <= 10; k++) {
+        c.render(N, clock.next(DT_US, s.speed), s);
+    }
+    s.effect = 3;
+    EffectTime t = clock.next(DT_US, s.speed);
+    expect_frame("半分未満で切り替え", c.render(N, t, s), ref.fade(1, 3, t, s, weight_after(DT_US)), N);
+    for (int k = 2; k <= 40; k++) {
+        c.render(N, clock.next(DT_US, s.speed), s);
+    }
+    expect("フェードの終わり", c.fading(), false);
+
+    // 半分を超えてから切り替えると、新しい方 (レインボー) を前のエフェクトとして残す
+    s.effect = 4;
+    for (int k = 1; k <= 30; k++) {
+        c.render(N, clock.next(DT_US, s.speed), s);
+    }
+    s.effect = 8;
+    t = clock.next(DT_US, s.speed);
+    expect_frame("半分以上で切り替え", c.render(N, t, s), ref.fade(4, 8, t, s, weight_after(DT_US)), N);
+}
+
+static void check_highlight() {
+    printf("== コントロールモードの目印\n");
+    LedCompositor<LedEffectSet> c;
+    c.init(N, 0, 1000000, BLEND_ADD);
+    Clock clock;
+    LedSettings s = base_settings(8, N);  // 心拍は速度0なら消灯したまま
+    s.speed = 0;
+    s.control_active = true;
+
+    Rgb black = { 0, 0, 0 };
+    Rgb full = hsv_to_rgb(s.hue, s.saturation, s.brightness);
+    Rgb half = scale_q8(full, 128);
+    for (int pos : { 0, N - 1 }) {
+        s.control_position = (int16_t)pos;
+        const Rgb* out = c.render(N, clock.next(DT_US, s.speed), s);
+        Rgb expected[N];
+        for (int i = 0; i < N; i++) {
+            expected[i] = black;
+        }
+        expected[pos] = full;
+        expected[(pos + 1) % N] = half;
+        expected[(pos + N - 1) % N] = half;
+        expect_frame(pos == 0 ? "先頭の目印 (末尾へ折り返す)" : "末尾の目印 (先頭へ折り返す)", out, expected, N);
+    }
+
+    // 目印は層のフレームに残らない
+    s.control_active = false;
+    const Rgb* out = c.render(N, clock.next(DT_US, s.speed), s);
+    Rgb expected[N] = {};
+    expect_frame("コントロールモードの後", out, expected, N);
+}
+
+static void check_budget() {
+    printf("== 処理時間の上限でのフェードの打ち切り\n");
+    LedCompositor<LedEffectSet> c;
+    c.init(N, FADE_MS, 5, BLEND_ADD);
+    Reference ref;
+    Clock clock;
+    LedSettings s = base_settings(0, N);
+    c.render(N, clock.next(DT_US, s.speed), s);
+
+    fake_step_us = 10;  // フェードのフレームは10us かかったことにする
+    s.effect = 1;
+    c.render(N, clock.next(DT_US, s.speed), s);
+    fake_step_us = 0;
+    expect("打ち切ったフェード", c.fades_cut(), 1);
+    expect("打ち切った後のフェード中", c.fading(), false);
+    EffectTime t = clock.next(DT_US, s.speed);
+    expect_frame("打ち切った後", c.render(N, t, s), ref.fade(0, 1, t, s, 256), N);
+}
+
+// ===== フェードの処理時間 =====
+
+static void time_fades() {
+    printf("== 600 LED・100Hzで全エフェクトを1秒ごとに切り替えたときの1フレームの処理時間\n");
+    static constexpr uint16_t LEDS = 600;
+    led_rng.seed(SEED);
+    LedCompositor<LedEffectSet> c;
+    c.init(LEDS, FADE_MS, 1000000, BLEND_ADD);
+    Clock clock;
+    LedSettings s = base_settings(0, LEDS);
+    s.brightness = 200;
+
+    double fade_sum = 0, plain_sum = 0;
+    int64_t fade_max = 0, plain_max = 0;
+    int fade_frames = 0, plain_frames = 0;
+    for (int round = 0; round < 3; round++) {
+        for (size_t e = 0; e < LedEffectSet::count; e++) {
+            s.effect = (uint8_t)e;
+            s.hue = (uint16_t)((e * 37 + round * 120) % 360);
+            for (int frame = 0; frame < 100; frame++) {
+                EffectTime t = clock.next(DT_US, s.speed);
+                bool fading = frame == 0 || c.fading();
+                int64_t start = esp_timer_get_time();
+                c.render(LEDS, t, s);
+                int64_t us = esp_timer_get_time() - start;
+                buzzer_mock_advance(DT_US);
+                if (round == 0 && e == 0) {
+                    continue;  // 最初の1周目の単色は立ち上がり (フェードなし)
+                }
+                if (fading) {
+                    fade_sum += us;
+                    fade_max = std::max(fade_max, us);
+                    fade_frames++;
+                } else {
+                    plain_sum += us;
+                    plain_max = std::max(plain_max, us);
+                    plain_frames++;
+                }
+            }
+        }
+    }
+    printf("  %-12s %8s %10s %10s\n", "", "frames", "avg us", "max us");
+    printf("  %-12s %8d %10.1f %10lld\n", "fade", fade_frames, fade_sum / fade_frames, (long long)fade_max);
+    printf("  %-12s %8d %10.1f %10lld\n", "no fade", plain_frames, plain_sum / plain_frames, (long long)plain_max);
+    expect("打ち切ったフェード", c.fades_cut(), 0);
+}
+
+int main(int argc, char** argv) {
+    bool update = argc > 1 && strcmp(argv[1], "--update") == 0;
+    check_replay(update);
+    check_glide();
+    check_fade();
+    check_highlight();
+    check_budget();
+    time_fades();
+    printf(failures ? "%d件の不一致\n" : "すべて一致\n", failures);
+    return failures ? 1 : 0;
+}
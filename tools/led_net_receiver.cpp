@@ -0,0 +1,587 @@
+// LEDのネットワーク入力 (led_net.cpp) の受信の確認とベンチマーク (Linux上で実行)
+// lwIPのUDP・IGMP・pbufを tools/esp_host/ の代わりのヘッダに置き換えて led_net.cpp をビルドし、
+// ループバックのソケットで受けたパケットをpbufの列にして受信コールバックへ渡します
+// DDP・E1.31・E1.31 (同期あり) で600 LEDのフレームを40fpsで送り、全フレームが届いて画素が一致するかと
+// 受信処理の時間を測ります。あわせて欠落・順序違い・pbufをまたぐヘッダ・停止フラグ・途絶・
+// マルチキャストの参加し直しを確かめます。1つでも違えば終了コード1を返します
+// --listen 秒数 を付けると送信はせずに受信だけを行い、統計を表示します (led_net_send.py の相手)
+//
+// 使い方:
+//   g++ -std=gnu++17 -O2 -I tools/esp_host -I m5dial-led/main -o led_net_receiver tools/led_net_receiver.cpp m5dial-led/main/led_net.cpp
+//   ./led_net_receiver
+//   ./led_net_receiver --listen 12 & tools/led_net_send.py 127.0.0.1 --leds 600 --fps 40
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <thread>
+#include <vector>
+#include "esp_timer.h"
+#include "lwip/igmp.h"
+#include "lwip/tcpip.h"
+#include "lwip/udp.h"
+#include "led_net.h"
+
+using Clock = std::chrono::steady_clock;
+
+static constexpr uint16_t LEDS = 600;
+static constexpr uint16_t UNIVERSE = 1;
+static constexpr uint16_t SYNC_ADDRESS = 7;
+static constexpr double FPS = 40;
+
+static int failures = 0;
+
+static void expect(const char* what, long actual, long expected) {
+    if (actual != expected) {
+        printf("  NG %s: %ld (期待 %ld)\n", what, actual, expected);
+        failures++;
+    }
+}
+
+static double elapsed_us(Clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+}
+
+// ===== ESP-IDFとlwIPの代わり =====
+
+static int64_t time_offset_us = 0;  // 途絶を試すために時計を進める
+
+int64_t esp_timer_get_time() {
+    return (int64_t)(std::chrono::duration<double, std::micro>(Clock::now().time_since_epoch()).count()) + time_offset_us;
+}
+
+const ip_addr_t ip_addr_any = { 0 };
+
+struct udp_pcb {
+    int fd;
+    udp_recv_fn recv;
+    void* arg;
+};
+
+static std::vector<udp_pcb*> pcbs;
+
+udp_pcb* udp_new() {
+    udp_pcb* pcb = new udp_pcb{ socket(AF_INET, SOCK_DGRAM, 0), nullptr, nullptr };
+    pcbs.push_back(pcb);
+    return pcb;
+}
+
+err_t udp_bind(udp_pcb* pcb, const ip_addr_t*, u16_t port) {
+    int on = 1;
+    int size = 1 << 20;
+    setsockopt(pcb->fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    setsockopt(pcb->fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    return bind(pcb->fd, (sockaddr*)&addr, sizeof(addr)) == 0 ? ERR_OK : ERR_USE;
+}
+
+void udp_recv(udp_pcb* pcb, udp_recv_fn recv, void* recv_arg) {
+    pcb->recv = recv;
+    pcb->arg = recv_arg;
+}
+
+u16_t pbuf_copy_partial(const pbuf* p, void* dataptr, u16_t len, u16_t offset) {
+    u16_t copied = 0;
+    for (; p != nullptr && copied < len; p = p->next) {
+        if (offset >= p->len) {
+            offset -= p->len;
+            continue;
+        }
+        u16_t n = std::min<u16_t>(p->len - offset, len - copied);
+        memcpy((uint8_t*)dataptr + copied, (const uint8_t*)p->payload + offset, n);
+        copied += n;
+        offset = 0;
+    }
+    return copied;
+}
+
+static int pbuf_frees = 0;
+
+u8_t pbuf_free(pbuf*) {
+    pbuf_frees++;
+    return 1;
+}
+
+// 参加中のマルチキャスト (グループ → 参加の回数)。igmp_fail の間はインターフェイスが無いものとして失敗する
+static std::map<uint32_t, int> groups;
+static bool igmp_fail = false;
+
+err_t igmp_joingroup(const ip4_addr_t*, const ip4_addr_t* group) {
+    if (igmp_fail) {
+        return ERR_VAL;
+    }
+    groups[group->addr]++;
+    return ERR_OK;
+}
+
+err_t igmp_leavegroup(const ip4_addr_t*, const ip4_addr_t* group) {
+    auto it = groups.find(group->addr);
+    if (it == groups.end()) {
+        return ERR_VAL;
+    }
+    if (--it->second == 0) {
+        groups.erase(it);
+    }
+    return ERR_OK;
+}
+
+err_t tcpip_callback(tcpip_callback_fn function, void* ctx) {
+    function(ctx);
+    return ERR_OK;
+}
+
+// ===== 受信 (TCP/IPタスクの代わり) =====
+
+static int frames_done = 0;
+
+static void on_frame() {
+    frames_done++;
+}
+
+// 受信したパケットを、先頭 split_first バイトと以降 split_segment バイトごとのpbufに分ける (0なら分けない)
+static u16_t split_first = 0;
+static u16_t split_segment = 0;
+static double recv_us = 0;  // 受信コールバックの時間の合計
+
+static void deliver(udp_pcb* pcb, uint8_t* data, u16_t len) {
+    std::vector<pbuf> chain;
+    for (u16_t at = 0; at < len;) {
+        u16_t n = len - at;
+        u16_t limit = chain.empty() ? split_first : split_segment;
+        if (limit) {
+            n = std::min(n, limit);
+        }
+        chain.push_back(pbuf{ nullptr, data + at, 0, n });
+        at += n;
+    }
+    u16_t rest = len;
+    for (size_t i = 0; i < chain.size(); i++) {
+        chain[i].next = i + 1 < chain.size() ? &chain[i + 1] : nullptr;
+        chain[i].tot_len = rest;
+        rest -= chain[i].len;
+    }
+
+    int frees = pbuf_frees;
+    Clock::time_point start = Clock::now();
+    pcb->recv(pcb->arg, pcb, &chain[0], &ip_addr_any, 0);
+    recv_us += elapsed_us(start);
+    expect("pbufの解放", pbuf_frees - frees, 1);
+}
+
+// フレームが want 個完成するか、timeout_ms の間パケットが来なくなるまで受信する
+static void pump(int timeout_ms, int want = 1 << 30) {
+    pollfd fds[2];
+    for (size_t i = 0; i < pcbs.size(); i++) {
+        fds[i] = pollfd{ pcbs[i]->fd, POLLIN, 0 };
+    }
+    uint8_t buf[2048];
+    while (frames_done < want && poll(fds, pcbs.size(), timeout_ms) > 0) {
+        for (size_t i = 0; i < pcbs.size(); i++) {
+            ssize_t n;
+            while ((n = recv(fds[i].fd, buf, sizeof(buf), MSG_DONTWAIT)) > 0) {
+                deliver(pcbs[i], buf, (u16_t)n);
+            }
+        }
+    }
+}
+
+// ===== 送信 (led_net_send.py と同じパケット) =====
+
+struct Packet {
+    std::vector<uint8_t> data;
+    uint16_t port;
+};
+
+static void put16(std::vector<uint8_t>& p, uint16_t v) {
+    p.push_back(v >> 8);
+    p.push_back(v & 0xFF);
+}
+
+static void put32(std::vector<uint8_t>& p, uint32_t v) {
+    put16(p, v >> 16);
+    put16(p, v & 0xFFFF);
+}
+
+class Sender {
+public:
+    virtual ~Sender() {}
+    virtual const char* name() const = 0;
+    virtual std::vector<Packet> packets(const std::vector<uint8_t>& frame) = 0;
+};
+
+class DdpSender : public Sender {
+public:
+    static constexpr uint32_t MAX_DATA = 1440;
+
+    const char* name() const override { return "DDP"; }
+
+    std::vector<Packet> packets(const std::vector<uint8_t>& frame) override {
+        std::vector<Packet> out;
+        for (uint32_t offset = 0; offset < frame.size(); offset += MAX_DATA) {
+            uint32_t len = std::min<uint32_t>(MAX_DATA, frame.size() - offset);
+            seq = seq % 15 + 1;
+            std::vector<uint8_t> p = { (uint8_t)(0x40 | (offset + len >= frame.size() ? 0x01 : 0)), seq, 0x0B, 1 };
+            put32(p, offset);
+            put16(p, len);
+            p.insert(p.end(), frame.begin() + offset, frame.begin() + offset + len);
+            out.push_back(Packet{ p, LED_NET_DDP_PORT });
+        }
+        return out;
+    }
+
+private:
+    uint8_t seq = 0;
+};
+
+class E131Sender : public Sender {
+public:
+    uint8_t options = 0;
+
+    E131Sender(uint16_t universe, uint16_t sync) : universe(universe), sync(sync) {}
+
+    const char* name() const override { return sync ? "E1.31 sync" : "E1.31"; }
+
+    std::vector<Packet> packets(const std::vector<uint8_t>& frame) override {
+        std::vector<Packet> out;
+        uint32_t step = LED_NET_E131_PIXELS_PER_UNIVERSE * 3;
+        for (uint32_t offset = 0, i = 0; offset < frame.size(); offset += step, i++) {
+            uint16_t channels = std::min<uint32_t>(step, frame.size() - offset);
+            uint16_t length = 126 + channels;
+            std::vector<uint8_t> p = root(0x00000004, length);
+            put16(p, 0x7000 | (length - 38));
+            put32(p, 0x00000002);
+            p.resize(p.size() + 64);  // 送信元の名前
+            p.push_back(100);         // 優先度
+            put16(p, sync);
+            p.push_back(seq[universe + i]++);
+            p.push_back(options);
+            put16(p, universe + i);
+            put16(p, 0x7000 | (length - 115));
+            p.push_back(0x02);
+            p.push_back(0xA1);
+            put16(p, 0);
+            put16(p, 1);
+            put16(p, channels + 1);
+            p.push_back(0);  // スタートコード
+            p.insert(p.end(), frame.begin() + offset, frame.begin() + offset + channels);
+            out.push_back(Packet{ p, LED_NET_E131_PORT });
+        }
+        if (sync) {
+            std::vector<uint8_t> p = root(0x00000008, 49);
+            put16(p, 0x7000 | (49 - 38));
+            put32(p, 0x00000001);
+            p.push_back(seq[0]++);
+            put16(p, sync);
+            put16(p, 0);
+            out.push_back(Packet{ p, LED_NET_E131_PORT });
+        }
+        return out;
+    }
+
+private:
+    uint16_t universe;
+    uint16_t sync;
+    std::map<uint16_t, uint8_t> seq;  // ユニバースごとの連番 (0は同期パケット)
+
+    static std::vector<uint8_t> root(uint32_t vector, uint16_t length) {
+        static const char acn_id[12] = { 'A', 'S', 'C', '-', 'E', '1', '.', '1', '7', 0, 0, 0 };
+        std::vector<uint8_t> p;
+        put16(p, 0x0010);
+        put16(p, 0);
+        p.insert(p.end(), acn_id, acn_id + sizeof(acn_id));
+        put16(p, 0x7000 | (length - 16));
+        put32(p, vector);
+        p.resize(p.size() + 16, 0x5A);  // CID
+        return p;
+    }
+};
+
+static int send_fd = -1;
+
+static void send_packet(const Packet& p) {
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(p.port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    sendto(send_fd, p.data.data(), p.data.size(), 0, (sockaddr*)&addr, sizeof(addr));
+}
+
+// フレーム番号ごとに異なる画素 (どのフレームが表示されたかを内容で見分ける)
+static std::vector<uint8_t> make_frame(int frame) {
+    std::vector<uint8_t> out(LEDS * 3);
+    for (size_t i = 0; i < out.size(); i++) {
+        out[i] = (uint8_t)(i * 7 + frame * 13 + (i >> 8) * frame);
+    }
+    return out;
+}
+
+// LEDタスクの代わりに最新のフレームを受け取り、フレーム frame と同じか確かめる
+static bool frame_matches(int frame) {
+    const Rgb* f = led_net_frame();
+    return f != nullptr && memcmp(f, make_frame(frame).data(), LEDS * 3) == 0;
+}
+
+// 受信が途絶えた後の新しいストリームとして始める (連番の記録と統計を捨てる)
+static void new_stream() {
+    LedNetStats stats;
+    time_offset_us += (LED_NET_TIMEOUT_MS + 100) * 1000LL;
+    led_net_get_stats(&stats, true);
+}
+
+static LedNetStats take_stats() {
+    LedNetStats stats;
+    led_net_get_stats(&stats, true);
+    return stats;
+}
+
+// ===== 確認 =====
+
+// fps で frames 枚を送る (fps が0なら待たずに次を送る)。一致しないフレームがあれば数える
+// 同期なしのE1.31はストリームの最初のフレームでは最も後ろのユニバースが分からず、ユニバースごとに
+// 完成するため、1枚送ってから測り始める
+static void run(Sender& sender, int frames, double fps) {
+    new_stream();
+    for (const Packet& p : sender.packets(make_frame(-1))) {
+        send_packet(p);
+    }
+    pump(20);
+    take_stats();
+    int done = frames_done;
+    int matched = 0;
+    double us = recv_us;
+    Clock::time_point start = Clock::now();
+    for (int k = 0; k < frames; k++) {
+        int before = frames_done;
+        for (const Packet& p : sender.packets(make_frame(k))) {
+            send_packet(p);
+        }
+        pump(200, before + 1);
+        if (frames_done == before + 1 && frame_matches(k)) {
+            matched++;
+        }
+        if (fps > 0) {
+            std::this_thread::sleep_until(start + std::chrono::microseconds((int64_t)((k + 1) * 1e6 / fps)));
+        }
+    }
+    double seconds = elapsed_us(start) / 1e6;
+    int completed = frames_done - done;
+    LedNetStats stats = take_stats();
+    printf("%-11s %6d %6d %6d %8.1f %12.1f %8lu %6lu\n", sender.name(), frames, completed, matched,
+           completed / seconds, (recv_us - us) / std::max(completed, 1),
+           (unsigned long)stats.dropped, (unsigned long)stats.out_of_order);
+    expect("完成したフレーム", completed, frames);
+    expect("一致したフレーム", matched, frames);
+    expect("欠落", stats.dropped, 0);
+    expect("順序違い", stats.out_of_order, 0);
+}
+
+static void check_rates() {
+    DdpSender ddp;
+    E131Sender e131(UNIVERSE, 0);
+    E131Sender e131_sync(UNIVERSE, SYNC_ADDRESS);
+    Sender* senders[] = { &ddp, &e131, &e131_sync };
+
+    printf("== %d LEDを%.0ffpsで3秒\n", LEDS, FPS);
+    printf("%-11s %6s %6s %6s %8s %12s %8s %6s\n", "protocol", "送信", "完成", "一致", "fps", "受信us/枚", "欠落", "順序");
+    for (Sender* s : senders) {
+        run(*s, (int)(FPS * 3), FPS);
+    }
+    printf("== %d LEDを待たずに2000枚 (受信側の処理の上限)\n", LEDS);
+    for (Sender* s : senders) {
+        run(*s, 2000, 0);
+    }
+}
+
+// 1フレームを送る。drop は送らないパケット、late は最後にもう一度送るパケット (-1ならなし)
+static void send_frame(Sender& sender, int frame, int drop = -1, int late = -1, bool swap_first = false) {
+    std::vector<Packet> out = sender.packets(make_frame(frame));
+    if (swap_first) {
+        std::swap(out[0], out[1]);
+    }
+    for (int i = 0; i < (int)out.size(); i++) {
+        if (i != drop) {
+            send_packet(out[i]);
+        }
+    }
+    if (late >= 0) {
+        send_packet(out[late]);
+    }
+    pump(20);
+}
+
+static void check_impairments() {
+    printf("== 欠落と順序違い\n");
+    DdpSender ddp;  // 600 LEDは2パケット (2つ目にPUSH)
+    new_stream();
+    int done = frames_done;
+    send_frame(ddp, 0);
+    expect("DDP 通常", frame_matches(0), true);
+    send_frame(ddp, 1, 0);  // 1つ目が届かない: 前半は前のフレームのまま表示する
+    send_frame(ddp, 2);
+    expect("DDP 欠落の後", frame_matches(2), true);
+    send_frame(ddp, 3, -1, 0);  // 1つ目が遅れてもう一度届く: 捨てる
+    expect("DDP 遅れたパケットを捨てる", frame_matches(3), true);
+    send_frame(ddp, 4, -1, -1, true);  // PUSHが先に届く
+    send_frame(ddp, 5);
+    expect("DDP 入れ替わりの後", frame_matches(5), true);
+    LedNetStats stats = take_stats();
+    expect("DDP 完成したフレーム", frames_done - done, 6);
+    expect("DDP 欠落", stats.dropped, 2);
+    expect("DDP 順序違い", stats.out_of_order, 2);
+
+    E131Sender e131(UNIVERSE, 0);  // 600 LEDは4ユニバース
+    new_stream();
+    done = frames_done;
+    send_frame(e131, 0);  // 最初のフレームはユニバースごとに完成する
+    expect("E1.31 通常", frame_matches(0), true);
+    send_frame(e131, 1, 1);  // 2つ目のユニバースが届かない
+    send_frame(e131, 2);
+    expect("E1.31 欠落の後", frame_matches(2), true);
+    send_frame(e131, 3, -1, 0);  // 1つ目のユニバースがもう一度届く: 捨ててフレームも完成させない
+    expect("E1.31 遅れたパケットを捨てる", frame_matches(3), true);
+    stats = take_stats();
+    expect("E1.31 完成したフレーム", frames_done - done, 4 + 3);
+    expect("E1.31 欠落", stats.dropped, 1);
+    expect("E1.31 順序違い", stats.out_of_order, 1);
+
+    send_packet(Packet{ std::vector<uint8_t>(60, 0x11), LED_NET_E131_PORT });
+    send_packet(Packet{ std::vector<uint8_t>{ 0x80, 1, 0x0B, 1, 0, 0, 0, 0, 0, 3, 1, 2, 3 }, LED_NET_DDP_PORT });
+    pump(20);
+    expect("不正なパケット", take_stats().invalid, 2);
+}
+
+static void check_sync() {
+    printf("== E1.31の同期パケット\n");
+    E131Sender e131(UNIVERSE, SYNC_ADDRESS);
+    new_stream();
+    send_frame(e131, 0);
+    std::vector<Packet> out = e131.packets(make_frame(1));
+    int done = frames_done;
+    for (size_t i = 0; i + 1 < out.size(); i++) {
+        send_packet(out[i]);
+    }
+    pump(20);
+    expect("同期パケットの前", frames_done - done, 0);
+    expect("同期パケットの前の表示", frame_matches(0), true);
+    send_packet(out.back());
+    pump(20);
+    expect("同期パケットで完成", frames_done - done, 1);
+    expect("同期パケットの後の表示", frame_matches(1), true);
+
+    ip4_addr_t group;
+    IP4_ADDR(&group, 239, 255, 0, SYNC_ADDRESS);
+    expect("同期アドレスのマルチキャスト", groups.count(group.addr), 1);
+}
+
+static void check_split() {
+    printf("== pbufをまたぐヘッダ\n");
+    DdpSender ddp;
+    E131Sender e131(UNIVERSE, SYNC_ADDRESS);
+    Sender* senders[] = { &ddp, &e131 };
+    split_first = 4;
+    split_segment = 100;
+    for (Sender* s : senders) {
+        new_stream();
+        int matched = 0;
+        for (int k = 0; k < 20; k++) {
+            send_frame(*s, k);
+            matched += frame_matches(k);
+        }
+        expect(s->name(), matched, 20);
+    }
+    split_first = 0;
+    split_segment = 0;
+}
+
+static void check_stop() {
+    printf("== 停止フラグと途絶\n");
+    E131Sender e131(UNIVERSE, 0);
+    new_stream();
+    send_frame(e131, 0);
+    expect("停止の前", frame_matches(0), true);
+    e131.options = 0x40;
+    send_frame(e131, 1);
+    expect("停止フラグでエフェクトに戻る", led_net_frame() == nullptr, true);
+
+    DdpSender ddp;
+    new_stream();
+    send_frame(ddp, 2);
+    expect("途絶の前", frame_matches(2), true);
+    time_offset_us += (LED_NET_TIMEOUT_MS + 1) * 1000LL;
+    expect("途絶でエフェクトに戻る", led_net_frame() == nullptr, true);
+}
+
+// マルチキャストに1回ずつ参加しているグループの数
+static long joined_once() {
+    return std::count_if(groups.begin(), groups.end(), [](const std::pair<const uint32_t, int>& g) { return g.second == 1; });
+}
+
+static void check_rejoin(size_t expected) {
+    led_net_rejoin();
+    expect("参加しているグループ", groups.size(), expected);
+    expect("1回ずつ参加", joined_once(), expected);
+}
+
+// 送信はせずに受信だけを行う
+static void listen(int seconds) {
+    printf("== %d秒間受信 (%d LED, ユニバース %d〜)\n", seconds, LEDS, UNIVERSE);
+    Clock::time_point start = Clock::now();
+    Clock::time_point first, last;
+    int done = frames_done;
+    while (elapsed_us(start) < seconds * 1e6) {
+        int before = frames_done;
+        pump(100, before + 1);
+        if (frames_done > before) {
+            last = Clock::now();
+            if (before == done) {
+                first = last;
+            }
+        }
+    }
+    int frames = frames_done - done;
+    double span = std::chrono::duration<double>(last - first).count();
+    LedNetStats stats = take_stats();
+    printf("%d フレーム (%.1f fps), %lu パケット, 欠落 %lu, 順序違い %lu, 不正 %lu, 受信 %.1f us/フレーム\n",
+           frames, frames > 1 ? (frames - 1) / span : 0.0, (unsigned long)stats.packets,
+           (unsigned long)stats.dropped, (unsigned long)stats.out_of_order, (unsigned long)stats.invalid,
+           recv_us / std::max(frames, 1));
+}
+
+int main(int argc, char** argv) {
+    send_fd = socket(AF_INET, SOCK_DGRAM, 0);
+
+    printf("== 起動とマルチキャストの参加し直し\n");
+    igmp_fail = true;  // 起動時はまだアドレスが無く、参加に失敗する
+    expect("受信開始", led_net_start(LEDS, UNIVERSE, on_frame), true);
+    expect("受信口", (long)pcbs.size(), 2);
+    expect("起動時に参加できたグループ", groups.size(), 0);
+    igmp_fail = false;
+    int universes = (LEDS + LED_NET_E131_PIXELS_PER_UNIVERSE - 1) / LED_NET_E131_PIXELS_PER_UNIVERSE;
+    check_rejoin(universes);  // アドレスを取得した
+    check_rejoin(universes);  // アドレスが変わった: 抜けてから参加するので回数は増えない
+
+    if (argc == 3 && strcmp(argv[1], "--listen") == 0) {
+        listen(atoi(argv[2]));
+        return 0;
+    }
+
+    check_rates();
+    check_impairments();
+    check_sync();
+    check_split();
+    check_stop();
+    check_rejoin(universes + 1);  // 同期アドレスのグループも参加し直す
+    printf(failures ? "%d件の不一致\n" : "すべて一致\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,135 @@
+#!/usr/bin/env python3
+# LEDのネットワーク入力 (DDP / E1.31) の送信テスト
+# 流れる虹色のフレームを指定したレートで送り続け、実際に送れたフレームレートを表示します
+#
+# 使い方:
+#   led_net_send.py 192.168.1.50 --leds 600 --fps 40                  # DDP
+#   led_net_send.py 192.168.1.50 --protocol e131 --leds 600 --sync 7  # E1.31 (同期パケットあり)
+#   led_net_send.py 127.0.0.1 --leds 600 --drop 0.01 --reorder 0.01   # 欠落と順序違いを混ぜる
+#
+# 受信側の統計は LED_FRAME_STATS_LOG=1 でビルドすると10秒ごとにログに出ます
+
+import argparse
+import colorsys
+import random
+import socket
+import struct
+import sys
+import time
+import uuid
+
+DDP_PORT = 4048
+E131_PORT = 5568
+DDP_MAX_DATA = 1440          # 1パケットのデータ (480 LED, MTUに収まる大きさ)
+E131_PIXELS_PER_UNIVERSE = 170
+
+
+def rainbow(leds, frame):
+    out = bytearray()
+    for i in range(leds):
+        r, g, b = colorsys.hsv_to_rgb(((i + frame) % leds) / leds, 1.0, 0.5)
+        out += bytes((int(r * 255), int(g * 255), int(b * 255)))
+    return out
+
+
+class DdpSender:
+    def __init__(self):
+        self.seq = 0
+
+    def packets(self, data):
+        """1フレームをDDPのパケットに分け、最後のパケットにPUSHを付ける"""
+        out = []
+        for offset in range(0, len(data), DDP_MAX_DATA):
+            chunk = data[offset:offset + DDP_MAX_DATA]
+            self.seq = self.seq % 15 + 1
+            flags = 0x40 | (0x01 if offset + DDP_MAX_DATA >= len(data) else 0)
+            header = struct.pack('>BBBBIH', flags, self.seq, 0x0B, 1, offset, len(chunk))
+            out.append((header + chunk, DDP_PORT))
+        return out
+
+
+class E131Sender:
+    def __init__(self, universe, sync):
+        self.universe = universe
+        self.sync = sync
+        self.seq = {}
+        self.cid = uuid.uuid4().bytes
+
+    def next_seq(self, universe):
+        self.seq[universe] = (self.seq.get(universe, -1) + 1) & 0xFF
+        return self.seq[universe]
+
+    def root(self, vector, length):
+        return (struct.pack('>HH12s', 0x0010, 0, b'ASC-E1.17\0\0\0')
+                + struct.pack('>HI16s', 0x7000 | (length - 16), vector, self.cid))
+
+    def data(self, universe, channels):
+        length = 126 + len(channels)
+        packet = self.root(0x00000004, length)
+        packet += struct.pack('>HI64sBHBBH', 0x7000 | (length - 38), 0x00000002,
+                              b'led_net_send', 100, self.sync, self.next_seq(universe), 0, universe)
+        packet += struct.pack('>HBBHHHB', 0x7000 | (length - 115), 0x02, 0xA1, 0, 1, len(channels) + 1, 0)
+        return packet + channels
+
+    def sync_packet(self):
+        packet = self.root(0x00000008, 49)
+        return packet + struct.pack('>HIBHH', 0x7000 | (49 - 38), 0x00000001,
+                                    self.next_seq(-1), self.sync, 0)
+
+    def packets(self, data):
+        out = []
+        step = E131_PIXELS_PER_UNIVERSE * 3
+        for i, offset in enumerate(range(0, len(data), step)):
+            out.append((self.data(self.universe + i, data[offset:offset + step]), E131_PORT))
+        if self.sync:
+            out.append((self.sync_packet(), E131_PORT))
+        return out
+
+
+def main():
+    parser = argparse.ArgumentParser(description='DDP / E1.31 でLEDのフレームを送る')
+    parser.add_argument('host')
+    parser.add_argument('--protocol', choices=('ddp', 'e131'), default='ddp')
+    parser.add_argument('--leds', type=int, default=150)
+    parser.add_argument('--fps', type=float, default=40)
+    parser.add_argument('--seconds', type=float, default=10)
+    parser.add_argument('--universe', type=int, default=1, help='E1.31の先頭のユニバース')
+    parser.add_argument('--sync', type=int, default=0, help='E1.31の同期アドレス (0で同期なし)')
+    parser.add_argument('--drop', type=float, default=0, help='わざと送らないパケットの割合')
+    parser.add_argument('--reorder', type=float, default=0, help='次のパケットと入れ替える割合')
+    args = parser.parse_args()
+
+    if args.protocol == 'ddp':
+        sender = DdpSender()
+    else:
+        sender = E131Sender(args.universe, args.sync)
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+
+    period = 1.0 / args.fps
+    frames = 0
+    packets = 0
+    start = time.monotonic()
+    next_time = start
+    while time.monotonic() - start < args.seconds:
+        out = sender.packets(rainbow(args.leds, frames))
+        for i in range(len(out) - 1):
+            if random.random() < args.reorder:
+                out[i], out[i + 1] = out[i + 1], out[i]
+        for packet, port in out:
+            if random.random() < args.drop:
+                continue
+            sock.sendto(packet, (args.host, port))
+            packets += 1
+        frames += 1
+        next_time += period
+        delay = next_time - time.monotonic()
+        if delay > 0:
+            time.sleep(delay)
+
+    elapsed = time.monotonic() - start
+    print(f'{frames} フレーム / {packets} パケット, {frames / elapsed:.1f} fps')
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,64 @@
+// エフェクト用乱数 (LedRandom) のベンチマーク (Linux上で実行)
+// 1回あたりの時間と、below() の偏り、同じ種で同じ並びになることを確認します
+//
+// 使い方:
+//   g++ -std=gnu++17 -O2 -I m5dial-led/main -o led_random_bench tools/led_random_bench.cpp m5dial-led/main/led_random.cpp
+//   ./led_random_bench
+
+#include <stdio.h>
+#include <time.h>
+#include <vector>
+#include "led_random.h"
+
+static double now_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int main() {
+    const int count = 10000000;
+    LedRandom rng;
+    rng.seed(1);
+
+    unsigned sum = 0;  // 最適化で消されないように結果を使う
+    double start = now_ns();
+    for (int i = 0; i < count; i++) {
+        sum += rng.next();
+    }
+    double next_ns = (now_ns() - start) / count;
+
+    start = now_ns();
+    for (int i = 0; i < count; i++) {
+        sum += rng.below(360);
+    }
+    double below_ns = (now_ns() - start) / count;
+
+    // below(360) の各値の出現回数 (カイ二乗値。自由度359なので400程度までなら偏りなし)
+    std::vector<int> histogram(360);
+    const int samples = 3600000;
+    for (int i = 0; i < samples; i++) {
+        histogram[rng.below(360)]++;
+    }
+    double expected = samples / 360.0;
+    double chi2 = 0;
+    for (int n : histogram) {
+        chi2 += (n - expected) * (n - expected) / expected;
+    }
+
+    // 同じ種なら同じ並び
+    LedRandom a, b;
+    a.seed(12345);
+    b.seed(12345);
+    bool same = true;
+    for (int i = 0; i < 1000; i++) {
+        same &= a.next() == b.next();
+    }
+
+    printf("next()      : %6.2f ns\n", next_ns);
+    printf("below(360)  : %6.2f ns\n", below_ns);
+    printf("below(360) のカイ二乗値: %.1f (自由度359)\n", chi2);
+    printf("同じ種で同じ並び: %s\n", same ? "OK" : "NG");
+    printf("(%u)\n", sum & 1);
+    return same ? 0 : 1;
+}
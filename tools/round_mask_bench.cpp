@@ -0,0 +1,258 @@
+// 円形マスク (Panel_GC9A01::setRoundMask) の転送量のベンチマーク (Linux上で実行)
+// LovyanGFXをホスト向けにビルドし、送ったコマンドと画素を記録するバスで GC9A01 への転送を数えます
+// 全画面の転送 (pushSprite) と変更領域の転送 (pushSpriteDirty) について、マスクの有無での
+// 1フレームあたりのバイト数を比べ、見える画素がマスク無しと同じで、見えない画素には
+// 何も書いていないことを確かめます。違いがあれば終了コード1を返します
+//
+// 使い方:
+//   S=m5dial-hello/components/LovyanGFX/src
+//   gcc -O2 -c -I$S $S/lgfx/utility/*.c
+//   g++ -std=gnu++17 -O2 -DLGFX_USE_V1 -I$S -ffunction-sections -fdata-sections -Wl,--gc-sections -o round_mask_bench tools/round_mask_bench.cpp $S/lgfx/v1/*.cpp $S/lgfx/v1/misc/*.cpp $S/lgfx/v1/panel/*.cpp lgfx_*.o miniz.o
+//   ./round_mask_bench
+
+#include <LovyanGFX.hpp>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+// ホストではGPIOと待ち時間は何もしない (パネルのリセット端子などは使わない)
+namespace lgfx {
+inline namespace v1 {
+void delay(unsigned long) {}
+void delayMicroseconds(unsigned int) {}
+void gpio_hi(uint32_t) {}
+void gpio_lo(uint32_t) {}
+void pinMode(int_fast16_t, pin_mode_t) {}
+}  // namespace v1
+}  // namespace lgfx
+
+static constexpr int SIZE = 240;
+static constexpr uint16_t UNTOUCHED = 0xA5A5;  // 転送されていない画素
+
+static constexpr uint8_t CMD_CASET = 0x2A;
+static constexpr uint8_t CMD_RASET = 0x2B;
+static constexpr uint8_t CMD_RAMWR = 0x2C;
+
+// 送られたバイトを数え、CASET/RASET/RAMWR を解釈してパネルのメモリを再現するバス
+class RecordBus : public lgfx::IBus {
+public:
+    uint16_t ram[SIZE * SIZE];
+    uint32_t command_bytes = 0;  // コマンドと引数 (ウィンドウの設定を含む)
+    uint32_t pixel_bytes = 0;
+
+    void reset_counts() {
+        command_bytes = 0;
+        pixel_bytes = 0;
+    }
+
+    lgfx::bus_type_t busType() const override { return lgfx::bus_spi; }
+    bool init() override { return true; }
+    void release() override {}
+    void beginTransaction() override {}
+    void endTransaction() override {}
+    void wait() override {}
+    bool busy() const override { return false; }
+    void initDMA() override {}
+    void addDMAQueue(const uint8_t* data, uint32_t length) override { data_bytes(data, length); }
+    void execDMAQueue() override {}
+    uint8_t* getDMABuffer(uint32_t length) override {
+        dma_buffer.resize(length);
+        return dma_buffer.data();
+    }
+    void flush() override {}
+
+    bool writeCommand(uint32_t data, uint_fast8_t bit_length) override {
+        command_bytes += bit_length >> 3;
+        command = (uint8_t)data;
+        param_count = 0;
+        if (command == CMD_RAMWR) {
+            cursor_x = win_xs;
+            cursor_y = win_ys;
+            half = false;
+        }
+        return true;
+    }
+    void writeData(uint32_t data, uint_fast8_t bit_length) override {
+        uint8_t bytes[4];
+        uint32_t n = bit_length >> 3;
+        for (uint32_t i = 0; i < n; i++) {
+            bytes[i] = (uint8_t)(data >> (i * 8));
+        }
+        data_bytes(bytes, n);
+    }
+    void writeDataRepeat(uint32_t data, uint_fast8_t bit_length, uint32_t count) override {
+        while (count--) {
+            writeData(data, bit_length);
+        }
+    }
+    void writePixels(lgfx::pixelcopy_t* pc, uint32_t length) override {
+        std::vector<uint8_t> buf(length * pc->dst_bits >> 3);
+        pc->fp_copy(buf.data(), 0, length, pc);
+        data_bytes(buf.data(), buf.size());
+    }
+    void writeBytes(const uint8_t* data, uint32_t length, bool, bool) override { data_bytes(data, length); }
+
+    void beginRead() override {}
+    void endRead() override {}
+    uint32_t readData(uint_fast8_t) override { return 0; }
+    bool readBytes(uint8_t*, uint32_t, bool) override { return false; }
+    void readPixels(void*, lgfx::pixelcopy_t*, uint32_t) override {}
+
+private:
+    std::vector<uint8_t> dma_buffer;
+    uint8_t command = 0;
+    uint8_t params[4];
+    uint32_t param_count = 0;
+    int win_xs = 0, win_ys = 0, win_xe = 0, win_ye = 0;
+    int cursor_x = 0, cursor_y = 0;
+    bool half = false;
+    uint8_t first = 0;
+
+    void data_bytes(const uint8_t* data, uint32_t length) {
+        if (command != CMD_RAMWR) {
+            command_bytes += length;
+            for (uint32_t i = 0; i < length && param_count < 4; i++) {
+                params[param_count++] = data[i];
+            }
+            if (param_count == 4 && (command == CMD_CASET || command == CMD_RASET)) {
+                int s = params[0] << 8 | params[1];
+                int e = params[2] << 8 | params[3];
+                if (command == CMD_CASET) {
+                    win_xs = s;
+                    win_xe = e;
+                } else {
+                    win_ys = s;
+                    win_ye = e;
+                }
+            }
+            return;
+        }
+        pixel_bytes += length;
+        for (uint32_t i = 0; i < length; i++) {
+            if (!half) {
+                first = data[i];
+                half = true;
+                continue;
+            }
+            half = false;
+            if (cursor_y <= win_ye && cursor_x < SIZE && cursor_y < SIZE) {
+                ram[cursor_y * SIZE + cursor_x] = (uint16_t)(first << 8 | data[i]);
+            }
+            if (++cursor_x > win_xe) {
+                cursor_x = win_xs;
+                cursor_y++;
+            }
+        }
+    }
+};
+
+class Device : public lgfx::LGFX_Device {
+public:
+    lgfx::Panel_GC9A01 panel;
+    RecordBus bus;
+
+    Device() {
+        auto cfg = panel.config();
+        cfg.panel_width = SIZE;
+        cfg.panel_height = SIZE;
+        cfg.invert = true;
+        panel.config(cfg);
+        panel.setBus(&bus);
+        setPanel(&panel);
+    }
+};
+
+struct Result {
+    uint32_t full_bytes;
+    uint32_t dirty_bytes;
+    std::vector<uint16_t> full_ram;
+    std::vector<uint16_t> dirty_ram;
+};
+
+static uint32_t frame_bytes(const RecordBus& bus) {
+    return bus.command_bytes + bus.pixel_bytes;
+}
+
+// 画面の更新1回分 (アプリの画面に近い変更領域: 中央のブロック、上部の文字、四隅、右端)
+static void draw_update(LGFX_Sprite& s) {
+    s.fillRect(100, 100, 40, 40, TFT_RED);
+    s.fillRect(60, 20, 120, 24, TFT_BLUE);
+    s.fillRect(0, 0, 40, 40, TFT_GREEN);
+    s.fillRect(200, 110, 40, 20, TFT_YELLOW);
+    s.fillRect(180, 190, 50, 40, TFT_CYAN);
+}
+
+static Result run(Device& d, int depth, bool mask) {
+    d.panel.setRoundMask<SIZE>(mask);
+    LGFX_Sprite s(&d);
+    s.setColorDepth(depth);
+    s.createSprite(SIZE, SIZE);
+    s.setDirtyTracking(true);
+    for (int y = 0; y < SIZE; y++) {
+        for (int x = 0; x < SIZE; x++) {
+            s.drawPixel(x, y, (uint16_t)(x * 7 + y * 13 + 1));
+        }
+    }
+
+    // 直前のウィンドウが残っていると設定のコマンドが省かれるため、毎回同じ状態から測る
+    d.startWrite();
+    d.setWindow(0, 0, 0, 0);
+    d.endWrite();
+
+    Result r;
+    std::fill(d.bus.ram, d.bus.ram + SIZE * SIZE, UNTOUCHED);
+    d.bus.reset_counts();
+    s.pushSprite(0, 0);
+    r.full_bytes = frame_bytes(d.bus);
+    r.full_ram.assign(d.bus.ram, d.bus.ram + SIZE * SIZE);
+    s.clearDirty();
+
+    draw_update(s);
+    std::fill(d.bus.ram, d.bus.ram + SIZE * SIZE, UNTOUCHED);
+    d.bus.reset_counts();
+    s.pushSpriteDirty(0, 0);
+    r.dirty_bytes = frame_bytes(d.bus);
+    r.dirty_ram.assign(d.bus.ram, d.bus.ram + SIZE * SIZE);
+    return r;
+}
+
+// マスクありの結果が、見える画素はマスク無しと同じで、見えない画素は書いていないか数える
+static int count_mismatch(const std::vector<uint16_t>& plain, const std::vector<uint16_t>& masked) {
+    auto span = lgfx::round_span_t<SIZE>::value;
+    int bad = 0;
+    for (int y = 0; y < SIZE; y++) {
+        for (int x = 0; x < SIZE; x++) {
+            bool visible = x >= span[y] && x <= SIZE - 1 - span[y];
+            uint16_t m = masked[y * SIZE + x];
+            if (visible ? m != plain[y * SIZE + x] : m != UNTOUCHED) {
+                bad++;
+            }
+        }
+    }
+    return bad;
+}
+
+int main() {
+    Device d;
+    d.init();
+    d.setColorDepth(16);
+
+    int failures = 0;
+    printf("%-8s %-6s %12s %12s %12s\n", "sprite", "push", "mask off", "mask on", "saved");
+    for (int depth : { 16, 8 }) {
+        Result plain = run(d, depth, false);
+        Result masked = run(d, depth, true);
+        int full_bad = count_mismatch(plain.full_ram, masked.full_ram);
+        int dirty_bad = count_mismatch(plain.dirty_ram, masked.dirty_ram);
+        printf("%2dbit    %-6s %12lu %12lu %11.1f%%\n", depth, "full", (unsigned long)plain.full_bytes,
+               (unsigned long)masked.full_bytes, 100.0 * (1.0 - (double)masked.full_bytes / plain.full_bytes));
+        printf("%2dbit    %-6s %12lu %12lu %11.1f%%\n", depth, "dirty", (unsigned long)plain.dirty_bytes,
+               (unsigned long)masked.dirty_bytes, 100.0 * (1.0 - (double)masked.dirty_bytes / plain.dirty_bytes));
+        if (full_bad || dirty_bad) {
+            printf("  NG 画素の不一致: 全画面 %d, 変更領域 %d\n", full_bad, dirty_bad);
+            failures++;
+        }
+    }
+    printf(failures ? "画素の不一致あり\n" : "見える画素はすべて一致\n");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,110 @@
+// タッチのジェスチャー認識の再生 (Linux上で実行)
+// 記録したタッチパネルの読み取りの列を m5dial_gesture に与え、認識した事象を表示します
+// トレースに "# expect:" の行があれば結果と比べ、1つでも違えば終了コード1を返します
+//
+// トレースの形式: 1行に1件 "時刻(us) 触れているか(0/1) x y"。# から行末まではコメント
+//   実機のログの "touch: 時刻 触れているか x y" の行もそのまま読めます
+//   (menuconfigでログの最大レベルをDebugにし、esp_log_level_set("input", ESP_LOG_DEBUG) で出る)
+// 期待する事象: "# expect: TAP SWIPE_LEFT RING+ RING-" のように空白区切りで並べる (無ければ比べない)
+//
+// 使い方:
+//   g++ -std=gnu++17 -O2 -I m5dial-hello/components/m5dial/include -o touch_gesture_replay tools/touch_gesture_replay.cpp m5dial-hello/components/m5dial/m5dial_gesture.cpp
+//   ./touch_gesture_replay tools/touch_traces/*.txt
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "m5dial_gesture.h"
+
+static std::string event_name(const input_event_t& ev) {
+    static const char* const swipe_names[] = { "SWIPE_RIGHT", "SWIPE_DOWN", "SWIPE_LEFT", "SWIPE_UP" };
+    switch (ev.type) {
+        case INPUT_TAP:   return "TAP";
+        case INPUT_SWIPE: return ev.value >= 0 && ev.value < 4 ? swipe_names[ev.value] : "SWIPE_?";
+        case INPUT_RING:  return ev.value > 0 ? "RING+" : "RING-";
+        default:          return "?";
+    }
+}
+
+// トレースを1つ再生し、期待と一致すればtrueを返す
+static bool replay(const char* path, const gesture_config_t& config) {
+    FILE* fp = fopen(path, "r");
+    if (fp == nullptr) {
+        fprintf(stderr, "%s: 開けません\n", path);
+        return false;
+    }
+    printf("== %s\n", path);
+
+    gesture_state_t state;
+    gesture_reset(&state);
+    std::vector<std::string> expected;
+    std::vector<std::string> actual;
+    bool has_expect = false;
+    int samples = 0;
+    char line[256];
+    while (fgets(line, sizeof(line), fp)) {
+        const char* expect = strstr(line, "# expect:");
+        if (expect != nullptr) {
+            has_expect = true;
+            char name[32];
+            int used = 0;
+            for (const char* p = expect + 9; sscanf(p, "%31s%n", name, &used) == 1; p += used) {
+                expected.push_back(name);
+            }
+            continue;
+        }
+        char* comment = strchr(line, '#');
+        if (comment != nullptr) {
+            *comment = '\0';
+        }
+        const char* p = strstr(line, "touch:");
+        p = p ? p + 6 : line;
+        long long time_us;
+        int touching, x, y;
+        if (sscanf(p, "%lld %d %d %d", &time_us, &touching, &x, &y) != 4) {
+            continue;
+        }
+        samples++;
+        input_event_t out[GESTURE_MAX_EVENTS];
+        int n = gesture_feed(&state, config, time_us, touching != 0, (int16_t)x, (int16_t)y, out);
+        for (int i = 0; i < n; i++) {
+            std::string name = event_name(out[i]);
+            printf("  %8.1fms %-12s (%d, %d)\n", out[i].time_us / 1000.0, name.c_str(), out[i].x, out[i].y);
+            actual.push_back(name);
+        }
+    }
+    fclose(fp);
+
+    if (!has_expect) {
+        printf("  %d件の読み取り\n", samples);
+        return true;
+    }
+    bool ok = expected == actual;
+    if (ok) {
+        printf("  OK (%d件の読み取り)\n", samples);
+    } else {
+        printf("  NG 期待:");
+        for (const auto& name : expected) {
+            printf(" %s", name.c_str());
+        }
+        printf("\n");
+    }
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "使い方: %s トレース...\n", argv[0]);
+        return 2;
+    }
+    const gesture_config_t config = GESTURE_CONFIG_M5DIAL;
+    int failed = 0;
+    for (int i = 1; i < argc; i++) {
+        if (!replay(argv[i], config)) {
+            failed++;
+        }
+    }
+    printf("%d/%d 一致\n", argc - 1 - failed, argc - 1);
+    return failed ? 1 : 0;
+}
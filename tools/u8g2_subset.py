@@ -0,0 +1,244 @@
+#!/usr/bin/env python3
+# U8g2形式フォントのサブセット生成スクリプト
+# アプリのソースに書かれた文字列リテラルを調べ、使用している文字だけを含むフォントを出力します
+# 0x100以上の文字だけを絞り込み、ASCII部分(数字や記号など実行時に組み立てる文字)はそのまま残します
+#
+# 使い方:
+#   u8g2_subset.py --source main.cpp --output fonts.c \
+#       --font path/to/lgfx_font_japan_gothic_p_20.c=app_font_p_20 [--font ...] [--chars "追加の文字"]
+#
+# ソースで使われている文字がフォントに無い場合はエラー終了し、ビルドを止めます
+
+import argparse
+import re
+import sys
+
+# ログ出力の文字列は画面に描画しないため対象外とする
+SKIP_CALL = re.compile(r'\b(ESP_LOG[EWIDV]|ESP_DRAM_LOG[EWIDV]|printf)\s*\(')
+
+SIMPLE_ESCAPES = {
+    'n': 0x0a, 't': 0x09, 'r': 0x0d, '0': 0x00, 'a': 0x07, 'b': 0x08,
+    'f': 0x0c, 'v': 0x0b, '\\': 0x5c, '\'': 0x27, '"': 0x22, '?': 0x3f,
+}
+
+
+def read_literal(text, pos):
+    """text[pos] の '"' から始まる文字列リテラルを読み、(バイト列, 終端の次の位置) を返す"""
+    out = bytearray()
+    i = pos + 1
+    while text[i] != '"':
+        c = text[i]
+        if c != '\\':
+            out += c.encode('utf-8')
+            i += 1
+            continue
+        c = text[i + 1]
+        if c in '01234567':
+            m = re.match(r'[0-7]{1,3}', text[i + 1:])
+            out.append(int(m.group(0), 8) & 0xff)
+            i += 1 + len(m.group(0))
+        elif c == 'x':
+            m = re.match(r'[0-9a-fA-F]+', text[i + 2:])
+            out.append(int(m.group(0), 16) & 0xff)
+            i += 2 + len(m.group(0))
+        elif c in SIMPLE_ESCAPES:
+            out.append(SIMPLE_ESCAPES[c])
+            i += 2
+        else:
+            raise ValueError('unsupported escape \\%s' % c)
+    return bytes(out), i + 1
+
+
+def strip_comments(text):
+    """文字列と文字リテラルを保ったままコメントを空白に置き換える"""
+    out = []
+    i = 0
+    n = len(text)
+    while i < n:
+        c = text[i]
+        if c == '"' or c == '\'':
+            j = i + 1
+            while text[j] != c:
+                j += 2 if text[j] == '\\' else 1
+            out.append(text[i:j + 1])
+            i = j + 1
+        elif text.startswith('//', i):
+            j = text.find('\n', i)
+            i = n if j < 0 else j
+        elif text.startswith('/*', i):
+            j = text.find('*/', i + 2)
+            j = n if j < 0 else j + 2
+            out.append(' ' + '\n' * text.count('\n', i, j))
+            i = j
+        else:
+            out.append(c)
+            i += 1
+    return ''.join(out)
+
+
+def skip_ranges(text):
+    """ログ出力関数の呼出し範囲 (開き括弧から閉じ括弧まで) の一覧"""
+    ranges = []
+    for m in SKIP_CALL.finditer(text):
+        depth = 0
+        i = m.end() - 1
+        while i < len(text):
+            c = text[i]
+            if c == '"':
+                i = read_literal(text, i)[1]
+                continue
+            if c == '(':
+                depth += 1
+            elif c == ')':
+                depth -= 1
+                if depth == 0:
+                    break
+            i += 1
+        ranges.append((m.start(), i))
+    return ranges
+
+
+def collect_chars(paths):
+    """ソース中の文字列リテラルに含まれる 0x100 以上の文字と、その出現位置"""
+    chars = {}
+    for path in paths:
+        with open(path, encoding='utf-8') as f:
+            text = strip_comments(f.read())
+        ranges = skip_ranges(text)
+        i = 0
+        while True:
+            i = text.find('"', i)
+            if i < 0:
+                break
+            # 文字リテラル '"' は文字列の開始ではない
+            if text[i - 1] == '\'' and text[i + 1] == '\'' or text[i - 2:i] == '\'\\':
+                i += 1
+                continue
+            value, end = read_literal(text, i)
+            if not any(s <= i < e for s, e in ranges):
+                line = text.count('\n', 0, i) + 1
+                for ch in value.decode('utf-8'):
+                    if ord(ch) >= 0x100:
+                        chars.setdefault(ord(ch), '%s:%d' % (path, line))
+            i = end
+    return chars
+
+
+def load_font(path, symbol):
+    """フォントのCソースから symbol[] の初期値をバイト列として読む (文字列形式と配列形式に対応)"""
+    with open(path, encoding='utf-8', errors='replace') as f:
+        text = strip_comments(f.read())
+    m = re.search(r'\b%s\s*\[[^\]]*\][^=;]*=' % re.escape(symbol), text)
+    if m is None:
+        raise ValueError('%s not found in %s' % (symbol, path))
+    i = m.end()
+    data = bytearray()
+    while True:
+        while text[i].isspace():
+            i += 1
+        if text[i] == '"':
+            value, i = read_literal(text, i)
+            data += value
+        elif text[i] == '{':
+            end = text.index('}', i)
+            for v in text[i + 1:end].split(','):
+                v = v.strip()
+                if v:
+                    data.append(int(v, 0) & 0xff)
+            return bytes(data)
+        else:
+            # 文字列形式では終端のNULも配列に含まれるが、フォントの解析には不要
+            return bytes(data)
+
+
+def word(data, pos):
+    return (data[pos] << 8) | data[pos + 1]
+
+
+def subset_font(data, codes):
+    """codes に含まれる 0x100 以上のグリフだけを残したフォントと、見つからなかった文字の一覧を返す"""
+    unicode_pos = word(data, 21)
+    if unicode_pos == 0:
+        return data, sorted(codes)
+
+    lut = 23 + unicode_pos
+    pos = lut + word(data, lut)
+    glyphs = {}
+    while True:
+        e = word(data, pos)
+        if e == 0:
+            break
+        size = data[pos + 2]
+        if size == 0:
+            raise ValueError('broken glyph record at %d' % pos)
+        glyphs[e] = data[pos:pos + size]
+        pos += size
+
+    missing = sorted(c for c in codes if c not in glyphs)
+    out = bytearray(data[:lut])
+    # LUTは全グリフを1つのブロックとする。先頭要素はLUT自身の大きさ、終端の文字コードは0xFFFF
+    out += bytes((0x00, 0x04, 0xff, 0xff))
+    for c in sorted(c for c in codes if c in glyphs):
+        out += glyphs[c]
+    out += bytes((0x00, 0x00))
+
+    ascii_count = 0
+    pos = 23
+    while data[pos + 1]:
+        ascii_count += 1
+        pos += data[pos + 1]
+    out[0] = min(255, ascii_count + len(codes) - len(missing))
+    return bytes(out), missing
+
+
+def write_c(path, fonts, total_codes):
+    lines = [
+        '// tools/u8g2_subset.py により生成 (編集しないこと)',
+        '// 収録文字: ' + ''.join(chr(c) for c in sorted(total_codes)),
+        '#include <stdint.h>',
+        '',
+    ]
+    for name, data in fonts:
+        lines.append('const uint8_t %s[%d] = {' % (name, len(data)))
+        for i in range(0, len(data), 16):
+            lines.append('  ' + ','.join('%d' % b for b in data[i:i + 16]) + ',')
+        lines.append('};')
+        lines.append('')
+    with open(path, 'w', encoding='utf-8') as f:
+        f.write('\n'.join(lines))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='U8g2 font subsetter')
+    parser.add_argument('--source', action='append', required=True, help='文字列を調べるソースファイル')
+    parser.add_argument('--font', action='append', required=True, help='フォントのCソース=出力するシンボル名')
+    parser.add_argument('--chars', default='', help='ソースに現れない追加の文字')
+    parser.add_argument('--output', required=True, help='出力するCソース')
+    args = parser.parse_args()
+
+    chars = collect_chars(args.source)
+    for ch in args.chars:
+        if ord(ch) >= 0x100:
+            chars.setdefault(ord(ch), '--chars')
+
+    fonts = []
+    failed = False
+    for spec in args.font:
+        path, name = spec.rsplit('=', 1)
+        symbol = re.sub(r'\.c$', '', path.replace('\\', '/').split('/')[-1])
+        src = load_font(path, symbol)
+        data, missing = subset_font(src, chars)
+        for c in missing:
+            print('ERROR: %s has no glyph for U+%04X "%s" (%s)' % (symbol, c, chr(c), chars[c]), file=sys.stderr)
+            failed = True
+        print('%s: %d -> %d bytes' % (name, len(src), len(data)))
+        fonts.append((name, data))
+
+    if failed:
+        return 1
+    write_c(args.output, fonts, chars)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())